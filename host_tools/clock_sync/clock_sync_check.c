@@ -0,0 +1,250 @@
+// Host check of the leaf clock discipline (main/clock_sync.c) against a
+// simulated clock that slews like ESP-IDF's adjtime(): at 1/64 of elapsed
+// time, a new call replacing whatever the previous one had not applied yet.
+// Probes follow the firmware schedule (2 s until the window is full, then
+// 16 s), so early slews are cut short. Runs the firmware flow, which books
+// the unapplied part back with ClockSyncNoteUnapplied(), and checks that the
+// estimator's window matches the clock, the residual offset and the drift
+// estimate. The same run with olddelta dropped is reported for comparison.
+// Exits non-zero when a limit is exceeded.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "clock_sync.h"
+
+static const int64_t kStepThresholdUs = 128000;
+static const int64_t kFastPeriodUs = 2000000;
+static const int64_t kPeriodUs = 16000000;
+static const int64_t kRunUs = 2LL * 3600 * 1000000;
+static const int64_t kSettleUs = 30LL * 60 * 1000000;
+// ESP-IDF adjtime() slews by 1/2^6 of elapsed time.
+static const int kSlewShift = 6;
+static const int64_t kHopDelayUs = 5000;
+static const int64_t kRootTurnaroundUs = 1000;
+
+typedef struct
+{
+  const char* name;
+  int64_t initial_offset_us; // root minus leaf at start
+  double drift_ppm;          // + = leaf slow
+  int64_t jitter_us;         // per hop, uniform
+  // Whole run: window offsets against the clock they describe. A slew in
+  // progress during a probe skews its midpoint by about delay / 128.
+  int64_t max_booking_error_us;
+  // After kSettleUs.
+  int64_t max_offset_us;
+  double max_drift_error_ppm;
+} clock_case_t;
+
+static const clock_case_t kCases[] = {
+  { "slew 100 ms, +50 ppm", 100000, 50.0, 0, 200, 100, 1.0 },
+  { "slew -120 ms, -30 ppm", -120000, -30.0, 0, 200, 100, 1.0 },
+  { "slew 20 ms, +5 ppm", 20000, 5.0, 0, 200, 100, 1.0 },
+  { "step 2 s, +80 ppm", 2000000, 80.0, 0, 200, 100, 1.0 },
+  // Jitter: each offset is off by up to half the round trip asymmetry.
+  { "slew 100 ms, jitter 2 ms", 100000, 50.0, 2000, 2000, 2000, 10.0 },
+};
+
+// Leaf clock: free-running oscillator plus the corrections applied so far.
+typedef struct
+{
+  int64_t true_us;      // root (reference) time
+  double oscillator_us; // leaf oscillator reading
+  double rate;          // leaf seconds per root second
+  int64_t applied_us;   // steps and finished slew
+  int64_t pending_us;   // slew still to apply
+} sim_clock_t;
+
+static uint32_t g_random = 12345u;
+
+static int64_t
+Jitter(int64_t jitter_us)
+{
+  if (jitter_us <= 0) {
+    return 0;
+  }
+  g_random = g_random * 1103515245u + 12345u;
+  return (int64_t)((g_random >> 8) % (uint32_t)jitter_us);
+}
+
+static int64_t
+LeafNow(const sim_clock_t* clock)
+{
+  return (int64_t)clock->oscillator_us + clock->applied_us;
+}
+
+static void
+Advance(sim_clock_t* clock, int64_t dt_us)
+{
+  clock->true_us += dt_us;
+  clock->oscillator_us += (double)dt_us * clock->rate;
+  const int64_t budget_us = dt_us >> kSlewShift;
+  int64_t slewed_us = clock->pending_us;
+  if (slewed_us > budget_us) {
+    slewed_us = budget_us;
+  } else if (slewed_us < -budget_us) {
+    slewed_us = -budget_us;
+  }
+  clock->applied_us += slewed_us;
+  clock->pending_us -= slewed_us;
+}
+
+// adjtime(): replaces the pending slew, returns what it had left.
+static int64_t
+Slew(sim_clock_t* clock, int64_t delta_us)
+{
+  const int64_t unapplied_us = clock->pending_us;
+  clock->pending_us = delta_us;
+  return unapplied_us;
+}
+
+static void
+Step(sim_clock_t* clock, int64_t delta_us)
+{
+  clock->applied_us += delta_us;
+  clock->pending_us = 0;
+}
+
+static int64_t
+AbsI64(int64_t value)
+{
+  return (value < 0) ? -value : value;
+}
+
+typedef struct
+{
+  int64_t max_booking_error_us;
+  int64_t max_offset_us; // |root - leaf| at each probe after settling
+  double drift_ppm;
+} run_result_t;
+
+// Every window entry claims what root minus leaf will be once the handed
+// out corrections are applied, as of its own t4. Aged by the true drift it
+// must match the clock: its offset now, less the slew still pending.
+static int64_t
+BookingError(const clock_sync_t* sync,
+             const sim_clock_t* clock,
+             int64_t root_offset_us,
+             double drift_ppm)
+{
+  const int64_t leaf_us = LeafNow(clock);
+  const int64_t residual_us =
+    root_offset_us + clock->true_us - leaf_us - clock->pending_us;
+  int64_t worst_us = 0;
+  for (uint32_t index = 0; index < sync->window_count; ++index) {
+    const clock_sync_entry_t* entry = &sync->window[index];
+    const int64_t aged_us =
+      entry->offset_us +
+      (int64_t)(drift_ppm * (double)(leaf_us - entry->t4_us) / 1e6);
+    const int64_t error_us = AbsI64(aged_us - residual_us);
+    if (error_us > worst_us) {
+      worst_us = error_us;
+    }
+  }
+  return worst_us;
+}
+
+// note_unapplied: the firmware flow; false drops olddelta as it used to.
+static run_result_t
+Run(const clock_case_t* test, bool note_unapplied)
+{
+  g_random = 12345u;
+  sim_clock_t clock = {
+    .true_us = 0,
+    .oscillator_us = 1.7e15,
+    .rate = 1.0 - test->drift_ppm / 1e6,
+  };
+  // Root epoch starts initial_offset_us ahead of the leaf.
+  const int64_t root_epoch_us = (int64_t)clock.oscillator_us +
+                                test->initial_offset_us;
+  clock_sync_t sync;
+  ClockSyncInit(&sync, kStepThresholdUs);
+  run_result_t result = { 0 };
+
+  while (clock.true_us < kRunUs) {
+    clock_sync_sample_t sample;
+    sample.t1_us = LeafNow(&clock);
+    Advance(&clock, kHopDelayUs + Jitter(test->jitter_us));
+    sample.t2_us = root_epoch_us + clock.true_us;
+    Advance(&clock, kRootTurnaroundUs);
+    sample.t3_us = root_epoch_us + clock.true_us;
+    Advance(&clock, kHopDelayUs + Jitter(test->jitter_us));
+    sample.t4_us = LeafNow(&clock);
+
+    const int64_t unapplied_us = Slew(&clock, 0);
+    if (note_unapplied) {
+      ClockSyncNoteUnapplied(&sync, unapplied_us);
+    }
+    int64_t correction_us = 0;
+    const clock_sync_action_t action =
+      ClockSyncAddSample(&sync, &sample, kPeriodUs, &correction_us);
+    if (action == CLOCK_SYNC_ACTION_STEP) {
+      Step(&clock, correction_us);
+    } else if (action == CLOCK_SYNC_ACTION_SLEW) {
+      (void)Slew(&clock, correction_us);
+    } else {
+      (void)Slew(&clock, unapplied_us);
+      if (note_unapplied) {
+        ClockSyncNoteUnapplied(&sync, -unapplied_us);
+      }
+    }
+
+    const int64_t booking_error_us =
+      BookingError(&sync, &clock, root_epoch_us, test->drift_ppm);
+    if (booking_error_us > result.max_booking_error_us) {
+      result.max_booking_error_us = booking_error_us;
+    }
+
+    const bool window_full = sync.window_count >= CLOCK_SYNC_WINDOW;
+    Advance(&clock, window_full ? kPeriodUs : kFastPeriodUs);
+    if (clock.true_us >= kSettleUs) {
+      const int64_t offset_us =
+        AbsI64(root_epoch_us + clock.true_us - LeafNow(&clock));
+      if (offset_us > result.max_offset_us) {
+        result.max_offset_us = offset_us;
+      }
+    }
+  }
+  result.drift_ppm = sync.drift_ppm;
+  return result;
+}
+
+static bool
+CheckCase(const clock_case_t* test)
+{
+  const run_result_t fixed = Run(test, true);
+  const run_result_t legacy = Run(test, false);
+  const double drift_error_ppm = fixed.drift_ppm - test->drift_ppm;
+  const bool ok = fixed.max_booking_error_us <= test->max_booking_error_us &&
+                  fixed.max_offset_us <= test->max_offset_us &&
+                  drift_error_ppm <= test->max_drift_error_ppm &&
+                  drift_error_ppm >= -test->max_drift_error_ppm;
+  printf("%-26s booking_err=%6lld us offset=%5lld us drift=%6.2f ppm "
+         "(true %6.2f)  %s\n",
+         test->name,
+         (long long)fixed.max_booking_error_us,
+         (long long)fixed.max_offset_us,
+         fixed.drift_ppm,
+         test->drift_ppm,
+         ok ? "ok" : "FAIL");
+  printf("%-26s booking_err=%6lld us offset=%5lld us drift=%6.2f ppm "
+         "(olddelta dropped)\n",
+         "",
+         (long long)legacy.max_booking_error_us,
+         (long long)legacy.max_offset_us,
+         legacy.drift_ppm);
+  return ok;
+}
+
+int
+main(void)
+{
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(kCases) / sizeof(kCases[0]); ++i) {
+    ok = CheckCase(&kCases[i]) && ok;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
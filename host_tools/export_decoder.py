@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+"""
+Decode the binary data-port stream (`data format binary`) and store records
+into the same SQLite table as mesh_ingest.py.
+
+Wire format (see main/export_frame.h): each frame is COBS-encoded and ends
+with 0x00. Decoded, it is
+
+  u8 version, u8 type, u16 count, u32 sequence     (little endian)
+  count entries
+  u32 CRC-32 (zlib) over header + entries
+
+  type 1 (records): u8 node_index + 48-byte log_record_t
+  type 2 (nodes):   u8 node_index + 6-byte MAC
+  type 3 (alarms):  u8 node_index + 21-byte alarm_event_t
+
+Alarms are printed to stderr as they arrive and counted; they are not
+stored in the database.
+
+Records whose node index has not been announced yet are held until the next
+nodes frame (the device repeats it every 10 s and whenever a node joins).
+"""
+
+from __future__ import annotations
+
+import argparse
+import binascii
+import struct
+import sys
+import zlib
+from pathlib import Path
+from typing import Any, BinaryIO, Dict, Iterator, List, Optional
+
+from mesh_ingest import init_db, insert_samples
+
+try:
+    import serial  # pip install pyserial
+except ImportError:  # only needed for --port
+    serial = None
+
+
+FRAME_VERSION = 1
+FRAME_TYPE_RECORDS = 1
+FRAME_TYPE_NODES = 2
+FRAME_TYPE_ALARMS = 3
+
+HEADER = struct.Struct("<BBHI")
+RECORD = struct.Struct("<IIIQqiiiiHH")  # log_record_t, packed
+NODE_LEN = 7
+ALARM = struct.Struct("<BqiiHBBB")  # node_index + alarm_event_t, packed
+ALARM_KINDS = {1: "high", 2: "low", 3: "rate", 4: "sensor_fault"}
+RECORD_MAGIC = 0x544C4F47
+MAX_PENDING_RECORDS = 10000
+
+
+def cobs_decode(data: bytes) -> Optional[bytes]:
+    out = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        if code == 0 or index + code > len(data):
+            return None
+        out += data[index + 1 : index + code]
+        index += code
+        if code != 0xFF and index < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class ExportDecoder:
+    """Feed raw bytes; collects decoded samples in mesh_ingest dict form."""
+
+    def __init__(self) -> None:
+        self.buffer = bytearray()
+        self.nodes: Dict[int, str] = {}
+        self.pending: Dict[int, List[Dict[str, Any]]] = {}
+        self.next_sequence: Optional[int] = None
+        self.stats = {
+            "frames": 0,
+            "records": 0,
+            "bad_frames": 0,
+            "lost_frames": 0,
+            "bad_records": 0,
+            "unmapped_dropped": 0,
+            "alarms": 0,
+        }
+
+    def feed(self, data: bytes) -> List[Dict[str, Any]]:
+        samples: List[Dict[str, Any]] = []
+        self.buffer += data
+        while True:
+            end = self.buffer.find(b"\x00")
+            if end < 0:
+                break
+            chunk = bytes(self.buffer[:end])
+            del self.buffer[: end + 1]
+            if chunk:
+                samples.extend(self._handle_frame(chunk))
+        return samples
+
+    def _handle_frame(self, encoded: bytes) -> List[Dict[str, Any]]:
+        frame = cobs_decode(encoded)
+        if frame is None or len(frame) < HEADER.size + 4:
+            self.stats["bad_frames"] += 1
+            return []
+        body, crc = frame[:-4], struct.unpack_from("<I", frame, len(frame) - 4)[0]
+        if zlib.crc32(body) != crc:
+            self.stats["bad_frames"] += 1
+            return []
+        version, frame_type, count, sequence = HEADER.unpack_from(body)
+        if version != FRAME_VERSION:
+            self.stats["bad_frames"] += 1
+            return []
+
+        if self.next_sequence is not None and sequence != self.next_sequence:
+            self.stats["lost_frames"] += (sequence - self.next_sequence) & 0xFFFFFFFF
+        self.next_sequence = (sequence + 1) & 0xFFFFFFFF
+        self.stats["frames"] += 1
+
+        payload = body[HEADER.size :]
+        if frame_type == FRAME_TYPE_NODES:
+            return self._handle_nodes(payload, count)
+        if frame_type == FRAME_TYPE_RECORDS:
+            return self._handle_records(payload, count)
+        if frame_type == FRAME_TYPE_ALARMS:
+            self._handle_alarms(payload, count)
+        return []
+
+    def _handle_nodes(self, payload: bytes, count: int) -> List[Dict[str, Any]]:
+        released: List[Dict[str, Any]] = []
+        for i in range(min(count, len(payload) // NODE_LEN)):
+            entry = payload[i * NODE_LEN : (i + 1) * NODE_LEN]
+            index = entry[0]
+            node_id = ":".join(f"{b:02X}" for b in entry[1:])
+            self.nodes[index] = node_id
+            for sample in self.pending.pop(index, []):
+                sample["node"] = node_id
+                released.append(sample)
+        return released
+
+    def _handle_records(self, payload: bytes, count: int) -> List[Dict[str, Any]]:
+        samples: List[Dict[str, Any]] = []
+        entry_len = 1 + RECORD.size
+        for i in range(min(count, len(payload) // entry_len)):
+            entry = payload[i * entry_len : (i + 1) * entry_len]
+            index, raw = entry[0], entry[1:]
+            fields = RECORD.unpack(raw)
+            (magic, _schema, sequence, record_id, ts, _millis,
+             raw_milli_c, temp_milli_c, r_milli_ohm, flags, crc) = fields
+            if magic != RECORD_MAGIC or binascii.crc_hqx(raw[:-2], 0xFFFF) != crc:
+                self.stats["bad_records"] += 1
+                continue
+            sample = {
+                "type": "temp",
+                "node": self.nodes.get(index, ""),
+                "ts": ts,
+                "temp_c": temp_milli_c / 1000.0,
+                "raw_c": raw_milli_c / 1000.0,
+                "r_ohm": r_milli_ohm / 1000.0,
+                "seq": sequence,
+                "record_id": record_id,
+                "flags": flags,
+            }
+            self.stats["records"] += 1
+            if index in self.nodes:
+                samples.append(sample)
+            elif sum(len(v) for v in self.pending.values()) < MAX_PENDING_RECORDS:
+                self.pending.setdefault(index, []).append(sample)
+            else:
+                self.stats["unmapped_dropped"] += 1
+        return samples
+
+
+    def _handle_alarms(self, payload: bytes, count: int) -> None:
+        for i in range(min(count, len(payload) // ALARM.size)):
+            (index, epoch_ms, value, limit, sequence, kind, active,
+             channel) = ALARM.unpack_from(payload, i * ALARM.size)
+            self.stats["alarms"] += 1
+            print(
+                f"alarm {self.nodes.get(index, f'#{index}')} ch{channel} "
+                f"{ALARM_KINDS.get(kind, 'unknown')} "
+                f"{'raise' if active else 'clear'} epoch_ms={epoch_ms} "
+                f"value={value / 1000.0:.3f} limit={limit / 1000.0:.3f} seq={sequence}",
+                file=sys.stderr,
+            )
+
+
+def read_chunks(stream: BinaryIO, size: int = 4096) -> Iterator[bytes]:
+    while True:
+        data = stream.read(size)
+        if data is None:
+            continue
+        if not data:
+            return
+        yield data
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="Serial port, e.g. COM7 or /dev/ttyUSB0")
+    source.add_argument("--file", type=Path, help="Decode a captured stream instead")
+    parser.add_argument("--baud", type=int, default=921600)
+    parser.add_argument("--db", type=Path, default=Path("pt100_mesh.sqlite3"))
+    parser.add_argument("--echo", action="store_true", help="Print decoded samples to stdout")
+    args = parser.parse_args()
+
+    decoder = ExportDecoder()
+    connection = init_db(args.db)
+
+    def store(data: bytes) -> None:
+        samples = decoder.feed(data)
+        insert_samples(connection, samples)
+        if args.echo:
+            for sample in samples:
+                print(sample)
+
+    try:
+        if args.file is not None:
+            with args.file.open("rb") as stream:
+                for data in read_chunks(stream):
+                    store(data)
+        else:
+            if serial is None:
+                print("pyserial is required for --port: pip install pyserial", file=sys.stderr)
+                return 2
+            with serial.Serial(args.port, args.baud, timeout=0.2) as serial_port:
+                print(f"Listening on {args.port} @ {args.baud} baud. DB={args.db}")
+                while True:
+                    data = serial_port.read(max(1, serial_port.in_waiting))
+                    if data:
+                        store(data)
+    except KeyboardInterrupt:
+        pass
+
+    print(" ".join(f"{k}={v}" for k, v in decoder.stats.items()), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -14,9 +14,12 @@ import sqlite3
 import sys
 import time
 from pathlib import Path
-from typing import Any, Dict
+from typing import Any, Dict, Iterable, List, Tuple
 
-import serial  # pip install pyserial
+try:
+    import serial  # pip install pyserial
+except ImportError:  # only needed for live capture
+    serial = None
 
 
 CREATE_SQL = """
@@ -28,7 +31,9 @@ CREATE TABLE IF NOT EXISTS temp_samples (
   raw_c REAL,
   r_ohm REAL,
   seq INTEGER,
-  received_epoch INTEGER NOT NULL
+  received_epoch INTEGER NOT NULL,
+  channel INTEGER NOT NULL DEFAULT 0,
+  compressed INTEGER NOT NULL DEFAULT 0
 );
 
 CREATE INDEX IF NOT EXISTS idx_temp_samples_node_ts
@@ -39,14 +44,72 @@ CREATE INDEX IF NOT EXISTS idx_temp_samples_node_ts
 def init_db(db_path: Path) -> sqlite3.Connection:
     connection = sqlite3.connect(str(db_path))
     connection.executescript(CREATE_SQL)
+    columns = {row[1] for row in connection.execute("PRAGMA table_info(temp_samples)")}
+    # Databases created before multi-channel nodes / record compression.
+    for column in ("channel", "compressed"):
+        if column not in columns:
+            connection.execute(
+                f"ALTER TABLE temp_samples ADD COLUMN {column} INTEGER NOT NULL DEFAULT 0"
+            )
     connection.commit()
     return connection
 
 
-def insert_sample(connection: sqlite3.Connection, sample: Dict[str, Any]) -> None:
-    connection.execute(
-        "INSERT INTO temp_samples(node_id, ts_epoch, temp_c, raw_c, r_ohm, seq, received_epoch) "
-        "VALUES(?,?,?,?,?,?,?)",
+def sample_channel(sample: Dict[str, Any]) -> int:
+    """RTD channel: an explicit "channel" key, else bits 12..15 of the flags."""
+    if "channel" in sample:
+        return int(sample["channel"])
+    return (int(sample.get("flags", 0)) >> 12) & 0xF
+
+
+# log_record_t flag: the record belongs to a compressed series (see
+# main/record_compressor.h); the records dropped in between are recovered by
+# linear interpolation.
+FLAG_COMPRESSED = 1 << 6
+
+
+def sample_compressed(sample: Dict[str, Any]) -> bool:
+    return bool(int(sample.get("flags", 0)) & FLAG_COMPRESSED)
+
+
+def interpolate_compressed(
+    samples: Iterable[Dict[str, Any]], step_s: int
+) -> List[Dict[str, Any]]:
+    """
+    Refill the gaps of compressed series: between two consecutive compressed
+    samples of the same node and channel, add linearly interpolated samples
+    every step_s seconds (marked "interpolated": True). Samples must be in
+    time order per series; other samples pass through unchanged.
+    """
+    out: List[Dict[str, Any]] = []
+    last: Dict[Tuple[str, int], Dict[str, Any]] = {}
+    for sample in samples:
+        key = (sample.get("node", ""), sample_channel(sample))
+        previous = last.get(key)
+        if sample_compressed(sample):
+            if previous is not None and step_s > 0:
+                t0, t1 = int(previous.get("ts", 0)), int(sample.get("ts", 0))
+                for ts in range(t0 + step_s, t1, step_s):
+                    weight = (ts - t0) / (t1 - t0)
+                    filled = dict(sample, ts=ts, interpolated=True)
+                    for field in ("temp_c", "raw_c", "r_ohm"):
+                        a, b = previous.get(field), sample.get(field)
+                        if a is not None and b is not None:
+                            filled[field] = a + (b - a) * weight
+                    out.append(filled)
+            last[key] = sample
+        else:
+            last.pop(key, None)
+        out.append(sample)
+    return out
+
+
+def insert_samples(
+    connection: sqlite3.Connection, samples: Iterable[Dict[str, Any]], commit: bool = True
+) -> int:
+    """Insert samples in one transaction; returns the number inserted."""
+    received_epoch = int(time.time())
+    rows = [
         (
             sample.get("node", ""),
             int(sample.get("ts", 0)),
@@ -54,10 +117,27 @@ def insert_sample(connection: sqlite3.Connection, sample: Dict[str, Any]) -> Non
             float(sample.get("raw_c", "nan")),
             float(sample.get("r_ohm", "nan")),
             int(sample.get("seq", 0)),
-            int(time.time()),
-        ),
+            received_epoch,
+            sample_channel(sample),
+            1 if sample_compressed(sample) else 0,
+        )
+        for sample in samples
+    ]
+    if not rows:
+        return 0
+    connection.executemany(
+        "INSERT INTO temp_samples"
+        "(node_id, ts_epoch, temp_c, raw_c, r_ohm, seq, received_epoch, channel,"
+        " compressed) VALUES(?,?,?,?,?,?,?,?,?)",
+        rows,
     )
-    connection.commit()
+    if commit:
+        connection.commit()
+    return len(rows)
+
+
+def insert_sample(connection: sqlite3.Connection, sample: Dict[str, Any]) -> None:
+    insert_samples(connection, (sample,))
 
 
 def main() -> int:
@@ -68,6 +148,10 @@ def main() -> int:
     parser.add_argument("--echo", action="store_true", help="Print decoded samples to stdout")
     args = parser.parse_args()
 
+    if serial is None:
+        print("pyserial is required: pip install pyserial", file=sys.stderr)
+        return 2
+
     connection = init_db(args.db)
 
     with serial.Serial(args.port, args.baud, timeout=1) as serial_port:
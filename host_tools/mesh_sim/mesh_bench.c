@@ -0,0 +1,1124 @@
+// Drives many simulated leaves through the real mesh_transport.c into a
+// real root RX path (reorder window -> node table -> export ring -> CSV
+// formatting) over the in-process Mesh-Lite stand-in, and reports where
+// throughput and latency run out. See README.md in this directory.
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "data_csv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mesh_lite_sim.h"
+#include "mesh_transport.h"
+#include "node_table.h"
+#include "mesh_credit.h"
+#include "record_ring.h"
+#include "time_sync.h"
+#include "uplink.h"
+
+static const char* kTag = "bench";
+
+static const int64_t kReorderTickUs = 250 * 1000;
+static const int64_t kLeafMaxPollUs = 50 * 1000;
+static const int64_t kRootPollUs = 10 * 1000;
+static const uint32_t kLatencyBucketsMs = 60000;
+#define BENCH_ALARM_QUEUE_LEN 64u
+
+typedef struct
+{
+  uint32_t leaves;
+  double rate_hz; // records per second per leaf
+  uint32_t duration_s;
+  uint32_t drain_s;
+  uint32_t hop_latency_ms;
+  uint32_t jitter_ms;
+  double loss_pct;
+  uint32_t max_level;
+  uint32_t fanout; // children per relay below level 2
+  uint32_t ring_records;
+  uint32_t export_rate; // records/s, 0 = unlimited
+  uint32_t history_records;
+  uint32_t backfill_rate;
+  uint32_t ack_period_ms;
+  bool no_credit; // root grants without limit
+  uint32_t seed;
+  bool single;
+  char uplink_host[UPLINK_HOST_MAX_LEN]; // empty = no uplink
+  uint16_t uplink_port;
+  bool uplink_csv;
+  uint32_t alarm_every; // records between alarms per leaf, 0 = none
+} bench_options_t;
+
+// One leaf: a stand-in for StorageTask's mesh cursor over the FRAM ring,
+// with the FRAM ring reduced to an in-memory history of recent records.
+typedef struct
+{
+  int node;
+  uint8_t mac[6];
+  bool allow_children; // has children (a relay)
+  pthread_t thread;
+  mesh_transport_t mesh;
+
+  log_record_t* history;
+  uint64_t next_record_id;
+  uint64_t cursor_record_id;
+  uint64_t cursor_at_last_ack;
+  uint64_t acked_record_id; // written by the leaf, read by main
+  uint32_t backfill_tokens;
+  int64_t backfill_refill_us;
+  int64_t next_sample_us;
+  uint32_t rewinds;
+  uint32_t gaps_sent;
+
+  // Export side: which record_ids reached the CSV formatter.
+  uint8_t* exported;
+  uint64_t exported_capacity;
+} bench_leaf_t;
+
+typedef struct
+{
+  bench_options_t options;
+  bench_leaf_t* leaves;
+  int root_node;
+  pthread_t root_thread;
+  pthread_t export_thread;
+  mesh_transport_t root_mesh; // owned by the root thread
+  mesh_credit_t credit;
+  uint32_t credit_budget_min; // lowest budget (records/min) while generating
+  node_table_t node_table;
+  record_ring_t ring;
+  uint32_t ring_consumer;
+  uplink_t uplink;
+
+  bool generating;
+  bool stop_leaves;
+  bool stop_root;
+  bool stop_export;
+
+  uint64_t generated;
+  uint64_t root_delivered;
+  uint64_t root_untracked;
+  uint64_t exported;
+  uint64_t exported_duplicates;
+  uint64_t exported_unknown;
+  uint32_t* latency_ms_histogram;
+  uint64_t latency_max_ms;
+
+  // Alarm lane: the root callback queues, ExportThread drains ahead of the
+  // ring (as ExportAlarms does).
+  pthread_mutex_t alarm_lock;
+  alarm_event_t alarm_queue[BENCH_ALARM_QUEUE_LEN];
+  uint32_t alarm_queued;
+  uint64_t alarms_sent;
+  uint64_t alarms_send_failed;
+  uint64_t alarms_dropped;
+  uint64_t alarms_exported;
+  uint32_t* alarm_latency_ms_histogram;
+  uint64_t alarm_latency_max_ms;
+} bench_t;
+
+static bench_t g_bench = { .alarm_lock = PTHREAD_MUTEX_INITIALIZER };
+
+static bool
+LoadFlag(const bool* flag)
+{
+  return __atomic_load_n(flag, __ATOMIC_ACQUIRE);
+}
+
+static void
+StoreFlag(bool* flag, bool value)
+{
+  __atomic_store_n(flag, value, __ATOMIC_RELEASE);
+}
+
+static uint64_t
+LoadCounter(const uint64_t* counter)
+{
+  return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static void
+AddCounter(uint64_t* counter, uint64_t value)
+{
+  __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static void
+SleepUs(int64_t us)
+{
+  struct timespec delay;
+  delay.tv_sec = (time_t)(us / 1000000);
+  delay.tv_nsec = (long)((us % 1000000) * 1000);
+  nanosleep(&delay, NULL);
+}
+
+static void
+LeafMac(uint32_t leaf_index, uint8_t mac_out[6])
+{
+  const uint32_t id = leaf_index + 1u;
+  mac_out[0] = 0x02; // locally administered
+  mac_out[1] = 0x50;
+  mac_out[2] = 0x54;
+  mac_out[3] = (uint8_t)(id >> 16);
+  mac_out[4] = (uint8_t)(id >> 8);
+  mac_out[5] = (uint8_t)id;
+}
+
+static bench_leaf_t*
+LeafFromAddr(const pt100_mesh_addr_t* addr)
+{
+  if (addr->addr[0] != 0x02 || addr->addr[1] != 0x50 || addr->addr[2] != 0x54) {
+    return NULL;
+  }
+  const uint32_t id = ((uint32_t)addr->addr[3] << 16) |
+                      ((uint32_t)addr->addr[4] << 8) | addr->addr[5];
+  if (id == 0 || id > g_bench.options.leaves) {
+    return NULL;
+  }
+  return &g_bench.leaves[id - 1u];
+}
+
+// ---------------------------------------------------------------------------
+// Leaf
+// ---------------------------------------------------------------------------
+
+static void
+LeafMakeRecord(bench_leaf_t* leaf, log_record_t* record_out)
+{
+  memset(record_out, 0, sizeof(*record_out));
+  record_out->record_id = leaf->next_record_id;
+  record_out->sequence = (uint32_t)leaf->next_record_id;
+  // log_record_t is packed: go through locals, not pointers to its fields.
+  int64_t epoch_sec = 0;
+  int32_t millis = 0;
+  TimeSyncGetNow(&epoch_sec, &millis);
+  record_out->timestamp_epoch_sec = epoch_sec;
+  record_out->timestamp_millis = millis;
+  // A slow wander around 21 C, enough to exercise the delta codec.
+  const int32_t wander = (int32_t)((leaf->next_record_id * 37u) % 200u) - 100;
+  record_out->raw_temp_milli_c = 21000 + wander;
+  record_out->temp_milli_c = 21050 + wander;
+  record_out->resistance_milli_ohm = 108200 + wander * 4;
+  record_out->flags =
+    LOG_RECORD_FLAG_TIME_VALID | LOG_RECORD_FLAG_MESH_CONNECTED;
+  LogRecordSeal(record_out);
+}
+
+static esp_err_t
+LeafSend(bench_leaf_t* leaf, const log_record_t* record)
+{
+  if (g_bench.options.single) {
+    return MeshTransportSendRecord(&leaf->mesh, record);
+  }
+  return MeshTransportQueueRecord(&leaf->mesh, record);
+}
+
+static uint64_t
+LeafOldestRetained(const bench_leaf_t* leaf)
+{
+  const uint64_t capacity = g_bench.options.history_records;
+  return (leaf->next_record_id > capacity) ? leaf->next_record_id - capacity
+                                           : 1u;
+}
+
+// Alternates raise and clear, timestamped like the sample that caused it.
+static void
+LeafSendAlarm(bench_leaf_t* leaf, const log_record_t* record)
+{
+  const uint32_t index = (uint32_t)(record->record_id /
+                                    g_bench.options.alarm_every);
+  const alarm_event_t event = {
+    .epoch_ms = record->timestamp_epoch_sec * 1000 + record->timestamp_millis,
+    .value = record->temp_milli_c,
+    .limit = 21000,
+    .sequence = (uint16_t)index,
+    .kind = ALARM_KIND_HIGH,
+    .active = (uint8_t)(index & 1u),
+  };
+  if (MeshTransportSendAlarm(&leaf->mesh, &event) == ESP_OK) {
+    AddCounter(&g_bench.alarms_sent, 1);
+  } else {
+    AddCounter(&g_bench.alarms_send_failed, 1);
+  }
+}
+
+static void
+LeafGenerate(bench_leaf_t* leaf, int64_t now_us)
+{
+  const int64_t period_us = (int64_t)(1e6 / g_bench.options.rate_hz);
+  while (now_us >= leaf->next_sample_us) {
+    log_record_t record;
+    LeafMakeRecord(leaf, &record);
+    leaf->history[record.record_id % g_bench.options.history_records] = record;
+    leaf->next_record_id++;
+    AddCounter(&g_bench.generated, 1);
+    // MeshForwardLiveRecord: send from memory only when caught up.
+    if (leaf->cursor_record_id == record.record_id &&
+        LeafSend(leaf, &record) == ESP_OK) {
+      leaf->cursor_record_id++;
+    }
+    if (g_bench.options.alarm_every > 0 &&
+        record.record_id % g_bench.options.alarm_every == 0) {
+      LeafSendAlarm(leaf, &record);
+    }
+    leaf->next_sample_us += period_us;
+  }
+}
+
+// Same policy as MeshApplyAck in runtime_manager.c.
+static void
+LeafApplyAck(bench_leaf_t* leaf)
+{
+  uint64_t acked = 0;
+  if (!MeshTransportTakeAck(&leaf->mesh, &acked)) {
+    return;
+  }
+  __atomic_store_n(&leaf->acked_record_id, acked, __ATOMIC_RELAXED);
+  const uint64_t resume = acked + 1u;
+  if (resume < leaf->cursor_at_last_ack) {
+    if (resume < leaf->cursor_record_id) {
+      leaf->cursor_record_id = resume;
+      leaf->rewinds++;
+    }
+  }
+  leaf->cursor_at_last_ack = leaf->cursor_record_id;
+}
+
+// Same as MeshBackfillRate: the backfill limit, lowered to the credit grant.
+static uint32_t
+LeafBackfillRate(bench_leaf_t* leaf)
+{
+  const uint32_t limit = g_bench.options.backfill_rate;
+  const uint32_t grant = MeshTransportCreditGrant(&leaf->mesh);
+  if (grant == MESH_TRANSPORT_CREDIT_UNLIMITED) {
+    return limit;
+  }
+  const uint32_t granted_per_s = (grant + 59u) / 60u;
+  return (granted_per_s < limit) ? granted_per_s : limit;
+}
+
+// Same policy as MeshBackfillPump, against the in-memory history.
+static void
+LeafBackfill(bench_leaf_t* leaf, int64_t now_us)
+{
+  const uint32_t rate = LeafBackfillRate(leaf);
+  const int64_t elapsed_us = now_us - leaf->backfill_refill_us;
+  const uint32_t refill = (uint32_t)((elapsed_us * rate) / 1000000);
+  if (refill > 0) {
+    leaf->backfill_tokens += refill;
+    if (leaf->backfill_tokens > rate) {
+      leaf->backfill_tokens = rate;
+    }
+    leaf->backfill_refill_us = now_us;
+  }
+  while (leaf->backfill_tokens > 0 &&
+         leaf->cursor_record_id < leaf->next_record_id) {
+    const uint64_t oldest = LeafOldestRetained(leaf);
+    if (leaf->cursor_record_id < oldest) {
+      if (MeshTransportSendGap(&leaf->mesh, oldest) != ESP_OK) {
+        break;
+      }
+      leaf->gaps_sent++;
+      leaf->cursor_record_id = oldest;
+      continue;
+    }
+    const log_record_t* record =
+      &leaf->history[leaf->cursor_record_id % g_bench.options.history_records];
+    if (LeafSend(leaf, record) != ESP_OK) {
+      break;
+    }
+    leaf->cursor_record_id++;
+    leaf->backfill_tokens--;
+  }
+}
+
+static void*
+LeafThread(void* arg)
+{
+  bench_leaf_t* leaf = (bench_leaf_t*)arg;
+  MeshLiteSimBindThread(leaf->node);
+  esp_err_t start_result = MeshTransportStart(
+    &leaf->mesh, false, leaf->allow_children, NULL, NULL, NULL, NULL, NULL);
+  if (start_result != ESP_OK) {
+    ESP_LOGE(kTag, "leaf start failed: %s", esp_err_to_name(start_result));
+    return NULL;
+  }
+
+  const int64_t start_us = esp_timer_get_time();
+  const int64_t period_us = (int64_t)(1e6 / g_bench.options.rate_hz);
+  // Spread the first samples so leaves do not fire in lockstep.
+  leaf->next_sample_us = start_us + (int64_t)(leaf->node % 1000) * period_us / 1000;
+  leaf->next_record_id = 1;
+  leaf->cursor_record_id = 1;
+  leaf->cursor_at_last_ack = 1;
+  leaf->backfill_refill_us = start_us;
+
+  while (!LoadFlag(&g_bench.stop_leaves)) {
+    int64_t now_us = esp_timer_get_time();
+    if (LoadFlag(&g_bench.generating)) {
+      LeafGenerate(leaf, now_us);
+    } else {
+      leaf->next_sample_us = now_us + period_us;
+    }
+    LeafApplyAck(leaf);
+    LeafBackfill(leaf, now_us);
+    (void)MeshTransportFlushIfDue(&leaf->mesh);
+
+    int64_t wait_us = kLeafMaxPollUs;
+    if (LoadFlag(&g_bench.generating) && leaf->next_sample_us - now_us < wait_us) {
+      wait_us = leaf->next_sample_us - now_us;
+    }
+    const uint32_t flush_due_ms = MeshTransportMsUntilFlushDue(&leaf->mesh);
+    if ((int64_t)flush_due_ms * 1000 < wait_us) {
+      wait_us = (int64_t)flush_due_ms * 1000;
+    }
+    (void)MeshLiteSimPoll((wait_us > 0) ? wait_us : 0);
+  }
+
+  (void)MeshTransportFlushRecords(&leaf->mesh);
+  // Frees the relay buffers; the stats stay for PrintReport.
+  (void)MeshTransportStop(&leaf->mesh);
+  return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Root
+// ---------------------------------------------------------------------------
+
+// Mirrors RootRecordRxCallback + EnqueueExportRecord.
+static bool
+RootRecordRx(const pt100_mesh_addr_t* from,
+             const log_record_t* record,
+             void* context)
+{
+  bench_t* bench = (bench_t*)context;
+  uint8_t node_index = 0;
+  if (NodeTableIntern(&bench->node_table, from, &node_index) != ESP_OK) {
+    AddCounter(&bench->root_delivered, 1);
+    AddCounter(&bench->root_untracked, 1);
+    return true;
+  }
+  const esp_err_t push_result =
+    RecordRingPush(&bench->ring, node_index, record);
+  NodeTableNoteRecord(&bench->node_table,
+                      node_index,
+                      record,
+                      push_result != ESP_OK,
+                      esp_timer_get_time());
+  if (push_result != ESP_OK) {
+    return false;
+  }
+  AddCounter(&bench->root_delivered, 1);
+  return true;
+}
+
+// Mirrors RootAlarmRxCallback + QueueAlarmForExport.
+static void
+RootAlarmRx(const pt100_mesh_addr_t* from,
+            const alarm_event_t* event,
+            void* context)
+{
+  (void)from;
+  bench_t* bench = (bench_t*)context;
+  pthread_mutex_lock(&bench->alarm_lock);
+  if (bench->alarm_queued < BENCH_ALARM_QUEUE_LEN) {
+    bench->alarm_queue[bench->alarm_queued++] = *event;
+  } else {
+    bench->alarms_dropped++;
+  }
+  pthread_mutex_unlock(&bench->alarm_lock);
+}
+
+static void*
+RootThread(void* arg)
+{
+  bench_t* bench = (bench_t*)arg;
+  MeshLiteSimBindThread(bench->root_node);
+  esp_err_t start_result = MeshTransportStart(
+    &bench->root_mesh, true, true, NULL, NULL, RootRecordRx, bench, NULL);
+  if (start_result != ESP_OK) {
+    ESP_LOGE(kTag, "root start failed: %s", esp_err_to_name(start_result));
+    return NULL;
+  }
+  MeshTransportSetAlarmCallback(&bench->root_mesh, RootAlarmRx, bench);
+
+  MeshCreditInit(&bench->credit, &bench->ring);
+  int64_t last_tick_us = esp_timer_get_time();
+  int64_t last_ack_us = last_tick_us;
+  while (!LoadFlag(&bench->stop_root)) {
+    (void)MeshLiteSimPoll(kRootPollUs);
+    const int64_t now_us = esp_timer_get_time();
+    if (now_us - last_tick_us >= kReorderTickUs) {
+      MeshTransportReorderTick(&bench->root_mesh);
+      last_tick_us = now_us;
+    }
+    if (now_us - last_ack_us >= (int64_t)bench->options.ack_period_ms * 1000) {
+      if (!bench->options.no_credit) {
+        const uint32_t budget = MeshCreditUpdate(
+          &bench->credit, &bench->ring, bench->options.ack_period_ms);
+        MeshTransportSetCreditBudget(&bench->root_mesh, budget);
+        if (LoadFlag(&bench->generating) && budget < bench->credit_budget_min) {
+          bench->credit_budget_min = budget;
+        }
+      }
+      (void)MeshTransportBroadcastAcks(&bench->root_mesh);
+      last_ack_us = now_us;
+    }
+  }
+  return NULL;
+}
+
+static void
+NoteLatency(uint32_t* histogram, uint64_t* max_ms, int64_t stamped_us)
+{
+  int64_t latency_ms = (TimeSyncGetEpochUs() - stamped_us) / 1000;
+  if (latency_ms < 0) {
+    latency_ms = 0;
+  }
+  if ((uint64_t)latency_ms > *max_ms) {
+    *max_ms = (uint64_t)latency_ms;
+  }
+  if (latency_ms >= (int64_t)kLatencyBucketsMs) {
+    latency_ms = kLatencyBucketsMs - 1;
+  }
+  histogram[latency_ms]++;
+}
+
+// ExportAlarms: every queued alarm goes out before the next record.
+static void
+ExportAlarms(bench_t* bench, char* line, size_t line_size)
+{
+  alarm_event_t alarms[BENCH_ALARM_QUEUE_LEN];
+  pthread_mutex_lock(&bench->alarm_lock);
+  const uint32_t count = bench->alarm_queued;
+  memcpy(alarms, bench->alarm_queue, count * sizeof(alarms[0]));
+  bench->alarm_queued = 0;
+  pthread_mutex_unlock(&bench->alarm_lock);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    size_t written = 0;
+    (void)CsvFormatAlarm(&alarms[i], "", line, line_size, &written);
+    AddCounter(&bench->alarms_exported, 1);
+    NoteLatency(bench->alarm_latency_ms_histogram,
+                &bench->alarm_latency_max_ms,
+                alarms[i].epoch_ms * 1000);
+  }
+}
+
+// Stands in for ExportTask: drain the ring and format each row as CSV.
+static void*
+ExportThread(void* arg)
+{
+  bench_t* bench = (bench_t*)arg;
+  const uint32_t rate = bench->options.export_rate;
+  int64_t budget_us = esp_timer_get_time();
+  char line[256];
+
+  while (!LoadFlag(&bench->stop_export)) {
+    ExportAlarms(bench, line, sizeof(line));
+    record_ring_item_t item;
+    if (!RecordRingPop(&bench->ring, bench->ring_consumer, &item)) {
+      SleepUs(1000);
+      continue;
+    }
+    const node_table_entry_t* entry =
+      NodeTableGet(&bench->node_table, item.node_index);
+    size_t written = 0;
+    (void)CsvFormatRow(&item.record,
+                       (entry != NULL) ? entry->id_string : "",
+                       line,
+                       sizeof(line),
+                       &written);
+    AddCounter(&bench->exported, 1);
+
+    bench_leaf_t* leaf = (entry != NULL) ? LeafFromAddr(&entry->addr) : NULL;
+    const uint64_t record_id = item.record.record_id;
+    if (leaf == NULL || record_id >= leaf->exported_capacity) {
+      AddCounter(&bench->exported_unknown, 1);
+    } else if (leaf->exported[record_id]) {
+      AddCounter(&bench->exported_duplicates, 1);
+    } else {
+      leaf->exported[record_id] = 1;
+    }
+
+    const int64_t stamped_us = item.record.timestamp_epoch_sec * 1000000 +
+                               (int64_t)item.record.timestamp_millis * 1000;
+    NoteLatency(
+      bench->latency_ms_histogram, &bench->latency_max_ms, stamped_us);
+
+    if (rate > 0) {
+      budget_us += 1000000 / rate;
+      const int64_t ahead_us = budget_us - esp_timer_get_time();
+      if (ahead_us > 0) {
+        SleepUs(ahead_us);
+      } else if (ahead_us < -1000000) {
+        budget_us = esp_timer_get_time() - 1000000; // cap burst credit
+      }
+    }
+  }
+  return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Main
+// ---------------------------------------------------------------------------
+
+static void
+PrintUsage(const char* argv0)
+{
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  -n, --leaves N          simulated leaves (default 200)\n"
+          "  -r, --rate HZ           records/s per leaf (default 1)\n"
+          "  -t, --duration S        generation time (default 20)\n"
+          "  -d, --drain S           max time to settle afterwards (default 15)\n"
+          "  -l, --hop-latency MS    one-way latency per hop (default 5)\n"
+          "  -j, --jitter MS         extra random latency per hop (default 10)\n"
+          "  -p, --loss PCT          loss per hop per attempt (default 0)\n"
+          "  -L, --max-level N       deepest leaf level, root is 1 (default 3)\n"
+          "  -F, --fanout N          children per relay below level 2 (default 4)\n"
+          "  -R, --ring N            export ring records (default 1024)\n"
+          "  -e, --export-rate N     export records/s, 0 = unlimited (default 0)\n"
+          "  -H, --history N         leaf replay history records (default 4096)\n"
+          "  -b, --backfill-rate N   leaf backfill records/s (default 20)\n"
+          "  -a, --ack-ms MS         root ACK period (default 5000)\n"
+          "  -N, --no-credit         root grants no send credits (no flow control)\n"
+          "  -s, --seed N            loss/jitter seed (default 1)\n"
+          "  -S, --single            one mesh message per record (no aggregation)\n"
+          "  -U, --uplink HOST:PORT  also stream the ring to a TCP collector\n"
+          "  -C, --uplink-csv        uplink sends CSV rows instead of frames\n"
+          "  -A, --alarm-every N     each leaf raises/clears an alarm every N\n"
+          "                          records (default 0 = none)\n"
+          "  -v, --verbose           transport logs at INFO\n",
+          argv0);
+}
+
+static bool
+ParseOptions(int argc, char** argv, bench_options_t* options)
+{
+  static const struct option kLongOptions[] = {
+    { "leaves", required_argument, NULL, 'n' },
+    { "rate", required_argument, NULL, 'r' },
+    { "duration", required_argument, NULL, 't' },
+    { "drain", required_argument, NULL, 'd' },
+    { "hop-latency", required_argument, NULL, 'l' },
+    { "jitter", required_argument, NULL, 'j' },
+    { "loss", required_argument, NULL, 'p' },
+    { "max-level", required_argument, NULL, 'L' },
+    { "fanout", required_argument, NULL, 'F' },
+    { "ring", required_argument, NULL, 'R' },
+    { "export-rate", required_argument, NULL, 'e' },
+    { "history", required_argument, NULL, 'H' },
+    { "backfill-rate", required_argument, NULL, 'b' },
+    { "ack-ms", required_argument, NULL, 'a' },
+    { "no-credit", no_argument, NULL, 'N' },
+    { "seed", required_argument, NULL, 's' },
+    { "single", no_argument, NULL, 'S' },
+    { "uplink", required_argument, NULL, 'U' },
+    { "uplink-csv", no_argument, NULL, 'C' },
+    { "alarm-every", required_argument, NULL, 'A' },
+    { "verbose", no_argument, NULL, 'v' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 },
+  };
+
+  *options = (bench_options_t){
+    .leaves = 200,
+    .rate_hz = 1.0,
+    .duration_s = 20,
+    .drain_s = 15,
+    .hop_latency_ms = 5,
+    .jitter_ms = 10,
+    .loss_pct = 0.0,
+    .max_level = 3,
+    .fanout = 4,
+    .ring_records = 1024,
+    .export_rate = 0,
+    .history_records = 4096,
+    .backfill_rate = 20,
+    .ack_period_ms = 5000,
+    .seed = 1,
+    .single = false,
+  };
+
+  int option = 0;
+  while ((option = getopt_long(
+            argc, argv, "n:r:t:d:l:j:p:L:F:R:e:H:b:a:Ns:SU:CA:vh", kLongOptions, NULL)) !=
+         -1) {
+    switch (option) {
+      case 'n':
+        options->leaves = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        options->rate_hz = strtod(optarg, NULL);
+        break;
+      case 't':
+        options->duration_s = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'd':
+        options->drain_s = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'l':
+        options->hop_latency_ms = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'j':
+        options->jitter_ms = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'p':
+        options->loss_pct = strtod(optarg, NULL);
+        break;
+      case 'L':
+        options->max_level = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'F':
+        options->fanout = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'R':
+        options->ring_records = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'e':
+        options->export_rate = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'H':
+        options->history_records = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'b':
+        options->backfill_rate = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'a':
+        options->ack_period_ms = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'N':
+        options->no_credit = true;
+        break;
+      case 's':
+        options->seed = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'S':
+        options->single = true;
+        break;
+      case 'U': {
+        const char* colon = strrchr(optarg, ':');
+        if (colon == NULL || colon == optarg ||
+            (size_t)(colon - optarg) >= sizeof(options->uplink_host)) {
+          fprintf(stderr, "--uplink expects HOST:PORT\n");
+          return false;
+        }
+        memcpy(options->uplink_host, optarg, (size_t)(colon - optarg));
+        options->uplink_host[colon - optarg] = '\0';
+        options->uplink_port = (uint16_t)strtoul(colon + 1, NULL, 0);
+        break;
+      }
+      case 'C':
+        options->uplink_csv = true;
+        break;
+      case 'A':
+        options->alarm_every = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'v':
+        g_sim_log_level = ESP_LOG_INFO;
+        break;
+      default:
+        return false;
+    }
+  }
+  if (options->leaves == 0 || options->leaves > 0xFFFFFFu ||
+      options->rate_hz <= 0.0 || options->rate_hz > 1000.0 ||
+      options->max_level < 2 || options->max_level > 15 ||
+      options->fanout == 0 ||
+      options->history_records == 0 || options->ack_period_ms == 0 ||
+      options->loss_pct < 0.0 || options->loss_pct >= 100.0) {
+    fprintf(stderr, "invalid option value\n");
+    return false;
+  }
+  return true;
+}
+
+static uint64_t
+LatencyPercentileMs(const uint32_t* histogram, uint64_t total, double fraction)
+{
+  const uint64_t target = (uint64_t)((double)total * fraction);
+  uint64_t seen = 0;
+  for (uint32_t bucket = 0; bucket < kLatencyBucketsMs; ++bucket) {
+    seen += histogram[bucket];
+    if (seen > target) {
+      return bucket;
+    }
+  }
+  return kLatencyBucketsMs;
+}
+
+// Single-record messages bypass the reorder window and are never ACKed.
+static bool
+AllLeavesAcked(void)
+{
+  for (uint32_t index = 0; index < g_bench.options.leaves; ++index) {
+    const bench_leaf_t* leaf = &g_bench.leaves[index];
+    const uint64_t generated_through = leaf->next_record_id - 1u;
+    if (__atomic_load_n(&leaf->acked_record_id, __ATOMIC_RELAXED) <
+        generated_through) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void
+PrintProgress(int64_t elapsed_us, uint64_t* last_exported)
+{
+  const uint64_t exported = LoadCounter(&g_bench.exported);
+  printf("t=%5.1fs generated=%" PRIu64 " root_rx=%" PRIu64
+         " exported=%" PRIu64 " (+%" PRIu64 "/s) ring_pending=%u\n",
+         (double)elapsed_us / 1e6,
+         LoadCounter(&g_bench.generated),
+         LoadCounter(&g_bench.root_delivered),
+         exported,
+         exported - *last_exported,
+         (unsigned)RecordRingPending(&g_bench.ring, g_bench.ring_consumer));
+  fflush(stdout);
+  *last_exported = exported;
+}
+
+static void
+PrintReport(double generate_s)
+{
+  mesh_lite_sim_stats_t sim;
+  MeshLiteSimGetStats(&sim);
+  const mesh_transport_stats_t* root = &g_bench.root_mesh.stats;
+  mesh_reorder_stats_t reorder;
+  uint32_t tracked_nodes = 0;
+  uint32_t buffered = 0;
+  MeshTransportGetReorderStats(
+    &g_bench.root_mesh, &reorder, &tracked_nodes, &buffered);
+
+  uint64_t leaf_frames = 0;
+  uint64_t leaf_records = 0;
+  uint64_t leaf_dropped = 0;
+  uint64_t rewinds = 0;
+  uint64_t gaps = 0;
+  uint64_t missing = 0;
+  uint64_t generated_total = 0;
+  uint32_t relays = 0;
+  uint64_t relay_in = 0;
+  uint64_t relay_out = 0;
+  uint64_t relay_sections = 0;
+  uint64_t relay_records = 0;
+  uint64_t relay_passthrough = 0;
+  uint64_t credit_deferred = 0;
+  for (uint32_t index = 0; index < g_bench.options.leaves; ++index) {
+    const bench_leaf_t* leaf = &g_bench.leaves[index];
+    relays += leaf->allow_children ? 1u : 0u;
+    relay_in += leaf->mesh.stats.relay_frames_in;
+    relay_out += leaf->mesh.stats.relay_frames_sent;
+    relay_sections += leaf->mesh.stats.relay_sections_sent;
+    relay_records += leaf->mesh.stats.relay_records_sent;
+    relay_passthrough += leaf->mesh.stats.relay_passthrough;
+    leaf_frames += leaf->mesh.stats.frames_sent;
+    leaf_records += leaf->mesh.stats.records_sent;
+    leaf_dropped += leaf->mesh.stats.records_dropped;
+    credit_deferred += leaf->mesh.stats.credit_deferred;
+    rewinds += leaf->rewinds;
+    gaps += leaf->gaps_sent;
+    for (uint64_t record_id = 1; record_id < leaf->next_record_id; ++record_id) {
+      generated_total++;
+      if (record_id >= leaf->exported_capacity || !leaf->exported[record_id]) {
+        missing++;
+      }
+    }
+  }
+
+  uint64_t histogram_total = 0;
+  for (uint32_t bucket = 0; bucket < kLatencyBucketsMs; ++bucket) {
+    histogram_total += g_bench.latency_ms_histogram[bucket];
+  }
+
+  printf("\n== mesh_bench: %u leaves x %.2f rec/s, %s%s, levels 2..%u, "
+         "hop %u+%u ms, loss %.2f%%\n",
+         (unsigned)g_bench.options.leaves,
+         g_bench.options.rate_hz,
+         g_bench.options.single ? "single records" : "aggregated frames",
+         MESH_TRANSPORT_RELAY_AGGREGATION ? " + relay aggregation" : "",
+         (unsigned)g_bench.options.max_level,
+         (unsigned)g_bench.options.hop_latency_ms,
+         (unsigned)g_bench.options.jitter_ms,
+         g_bench.options.loss_pct);
+  printf("offered load:      %.0f records/s\n",
+         (double)g_bench.options.leaves * g_bench.options.rate_hz);
+  printf("generated:         %" PRIu64 " in %.1f s\n", generated_total, generate_s);
+  printf("leaf tx:           frames=%" PRIu64 " records=%" PRIu64
+         " (%.1f rec/frame) dropped=%" PRIu64 " rewinds=%" PRIu64
+         " gaps=%" PRIu64 "\n",
+         leaf_frames,
+         leaf_records,
+         (leaf_frames > 0) ? (double)leaf_records / (double)leaf_frames : 0.0,
+         leaf_dropped,
+         rewinds,
+         gaps);
+  printf("mesh:              attempts=%" PRIu64 " retries=%" PRIu64
+         " delivered=%" PRIu64 " lost=%" PRIu64 " bytes=%" PRIu64 "\n",
+         sim.attempts,
+         sim.retries,
+         sim.delivered,
+         sim.dropped,
+         sim.bytes_delivered);
+  printf("airtime:           hop_tx=%" PRIu64 " hop_bytes=%" PRIu64 "\n",
+         sim.hop_transmissions,
+         sim.hop_bytes);
+  if (MESH_TRANSPORT_RELAY_AGGREGATION) {
+    printf("relay:             relays=%u frames_in=%" PRIu64 " frames_out=%" PRIu64
+           " sections=%" PRIu64 " records=%" PRIu64 " passthrough=%" PRIu64 "\n",
+           (unsigned)relays,
+           relay_in,
+           relay_out,
+           relay_sections,
+           relay_records,
+           relay_passthrough);
+  }
+  if (g_bench.options.no_credit) {
+    printf("credit:            off\n");
+  } else {
+    printf("credit:            budget_min=%u rec/min deferred=%" PRIu64 "\n",
+           (unsigned)g_bench.credit_budget_min,
+           credit_deferred);
+  }
+  printf("root rx:           frames=%u records=%u decode_errors=%u "
+         "untracked=%u refused=%u acks_sent=%u\n",
+         (unsigned)root->frames_received,
+         (unsigned)root->records_received,
+         (unsigned)root->decode_errors,
+         (unsigned)root->records_untracked,
+         (unsigned)root->records_refused,
+         (unsigned)root->acks_sent);
+  printf("reorder:           nodes=%u buffered=%u delivered=%u dup=%u "
+         "reordered=%u skipped=%u late=%u lost=%u\n",
+         (unsigned)tracked_nodes,
+         (unsigned)buffered,
+         (unsigned)reorder.delivered,
+         (unsigned)reorder.duplicates,
+         (unsigned)reorder.reordered,
+         (unsigned)reorder.gaps_skipped,
+         (unsigned)reorder.late_recovered,
+         (unsigned)reorder.lost);
+  printf("export ring:       capacity=%u high_water=%u dropped=%u "
+         "untracked_nodes=%" PRIu64 "\n",
+         (unsigned)g_bench.ring.capacity,
+         (unsigned)atomic_load(&g_bench.ring.high_water),
+         (unsigned)atomic_load(&g_bench.ring.dropped),
+         LoadCounter(&g_bench.root_untracked));
+  printf("exported:          %" PRIu64 " (%.0f rec/s) duplicates=%" PRIu64
+         " unknown=%" PRIu64 " missing=%" PRIu64 "\n",
+         LoadCounter(&g_bench.exported),
+         (double)LoadCounter(&g_bench.exported) / generate_s,
+         LoadCounter(&g_bench.exported_duplicates),
+         LoadCounter(&g_bench.exported_unknown),
+         missing);
+  printf("latency (ms):      p50=%" PRIu64 " p99=%" PRIu64 " max=%" PRIu64 "\n",
+         LatencyPercentileMs(g_bench.latency_ms_histogram, histogram_total, 0.50),
+         LatencyPercentileMs(g_bench.latency_ms_histogram, histogram_total, 0.99),
+         g_bench.latency_max_ms);
+  if (g_bench.options.alarm_every > 0) {
+    uint64_t alarm_total = 0;
+    for (uint32_t bucket = 0; bucket < kLatencyBucketsMs; ++bucket) {
+      alarm_total += g_bench.alarm_latency_ms_histogram[bucket];
+    }
+    printf("alarms:            sent=%" PRIu64 " send_failed=%" PRIu64
+           " exported=%" PRIu64 " dropped=%" PRIu64 "\n",
+           g_bench.alarms_sent,
+           g_bench.alarms_send_failed,
+           g_bench.alarms_exported,
+           g_bench.alarms_dropped);
+    printf("alarm latency (ms): p50=%" PRIu64 " p99=%" PRIu64 " max=%" PRIu64
+           "\n",
+           LatencyPercentileMs(
+             g_bench.alarm_latency_ms_histogram, alarm_total, 0.50),
+           LatencyPercentileMs(
+             g_bench.alarm_latency_ms_histogram, alarm_total, 0.99),
+           g_bench.alarm_latency_max_ms);
+  }
+  if (g_bench.options.uplink_host[0] != '\0') {
+    uplink_stats_t uplink;
+    UplinkGetStats(&g_bench.uplink, &uplink);
+    printf("uplink:            connects=%u fails=%u disconnects=%u "
+           "frames=%u bytes=%" PRIu64 "\n",
+           (unsigned)uplink.connects,
+           (unsigned)uplink.connect_failures,
+           (unsigned)uplink.disconnects,
+           (unsigned)uplink.frames_sent,
+           uplink.bytes_sent);
+    printf("uplink records:    sent=%u replayed=%u skipped=%u dropped=%u "
+           "pending=%u\n",
+           (unsigned)uplink.records_sent,
+           (unsigned)uplink.records_replayed,
+           (unsigned)uplink.records_skipped,
+           (unsigned)uplink.records_dropped,
+           (unsigned)uplink.window_pending);
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  bench_t* bench = &g_bench;
+  if (!ParseOptions(argc, argv, &bench->options)) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+  const bench_options_t* options = &bench->options;
+
+  mesh_lite_sim_config_t sim_config = {
+    .hop_latency_us = options->hop_latency_ms * 1000u,
+    .jitter_us = options->jitter_ms * 1000u,
+    .loss = options->loss_pct / 100.0,
+    .seed = options->seed,
+  };
+  if (MeshLiteSimInit(&sim_config, options->leaves + 1u) != ESP_OK ||
+      RecordRingInit(&bench->ring, options->ring_records) != ESP_OK ||
+      RecordRingAttachConsumer(&bench->ring, &bench->ring_consumer) != ESP_OK) {
+    fprintf(stderr, "init failed\n");
+    return 1;
+  }
+  NodeTableInit(&bench->node_table);
+  bench->credit_budget_min = UINT32_MAX;
+  bench->latency_ms_histogram =
+    (uint32_t*)calloc(kLatencyBucketsMs, sizeof(uint32_t));
+  bench->alarm_latency_ms_histogram =
+    (uint32_t*)calloc(kLatencyBucketsMs, sizeof(uint32_t));
+  bench->leaves = (bench_leaf_t*)calloc(options->leaves, sizeof(bench_leaf_t));
+  if (bench->latency_ms_histogram == NULL ||
+      bench->alarm_latency_ms_histogram == NULL || bench->leaves == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  static const uint8_t kRootMac[6] = { 0x02, 0x50, 0x54, 0xFF, 0xFF, 0xFF };
+  bench->root_node = MeshLiteSimAddNode(kRootMac, 1, -1);
+
+  if (options->uplink_host[0] != '\0') {
+    uplink_config_t uplink_config = {
+      .port = options->uplink_port,
+      .format = options->uplink_csv ? UPLINK_FORMAT_CSV : UPLINK_FORMAT_BINARY,
+      .retain_records = 65536,
+    };
+    memcpy(uplink_config.host,
+           options->uplink_host,
+           sizeof(uplink_config.host));
+    const pt100_mesh_addr_t root_addr = Pt100MeshAddrFromMac(kRootMac);
+    if (UplinkInit(&bench->uplink,
+                   &uplink_config,
+                   &bench->ring,
+                   &bench->node_table,
+                   &root_addr) != ESP_OK ||
+        UplinkStart(&bench->uplink) != ESP_OK) {
+      fprintf(stderr, "uplink start failed\n");
+      return 1;
+    }
+  }
+
+  const uint64_t expected_records =
+    (uint64_t)(options->rate_hz * (options->duration_s + 1u)) + 16u;
+  for (uint32_t index = 0; index < options->leaves; ++index) {
+    bench_leaf_t* leaf = &bench->leaves[index];
+    LeafMac(index, leaf->mac);
+    // Spread leaves evenly over levels 2..max_level. Below level 2, the
+    // k-th leaf of a level hangs off the (k / fanout)-th leaf one level up.
+    const uint32_t levels = options->max_level - 1u;
+    const uint8_t level = (uint8_t)(2u + index % levels);
+    int parent = bench->root_node;
+    if (level > 2) {
+      const uint32_t parent_index = (index / levels / options->fanout) * levels +
+                                    (uint32_t)(level - 3u);
+      bench->leaves[parent_index].allow_children = true;
+      parent = bench->leaves[parent_index].node;
+    }
+    leaf->node = MeshLiteSimAddNode(leaf->mac, level, parent);
+    leaf->history =
+      (log_record_t*)calloc(options->history_records, sizeof(log_record_t));
+    leaf->exported_capacity = expected_records;
+    leaf->exported = (uint8_t*)calloc(expected_records, 1);
+    if (leaf->node < 0 || leaf->history == NULL || leaf->exported == NULL) {
+      fprintf(stderr, "out of memory at leaf %u\n", (unsigned)index);
+      return 1;
+    }
+  }
+
+  pthread_create(&bench->export_thread, NULL, ExportThread, bench);
+  pthread_create(&bench->root_thread, NULL, RootThread, bench);
+  SleepUs(50 * 1000); // root registers its actions first
+  StoreFlag(&bench->generating, true);
+  for (uint32_t index = 0; index < options->leaves; ++index) {
+    if (pthread_create(
+          &bench->leaves[index].thread, NULL, LeafThread, &bench->leaves[index]) !=
+        0) {
+      fprintf(stderr, "cannot start leaf thread %u\n", (unsigned)index);
+      return 1;
+    }
+  }
+
+  const int64_t start_us = esp_timer_get_time();
+  uint64_t last_exported = 0;
+  while (esp_timer_get_time() - start_us < (int64_t)options->duration_s * 1000000) {
+    SleepUs(1000000);
+    PrintProgress(esp_timer_get_time() - start_us, &last_exported);
+  }
+  StoreFlag(&bench->generating, false);
+  const double generate_s = (double)(esp_timer_get_time() - start_us) / 1e6;
+
+  // Let ACKs, backfill and the export ring settle.
+  const int64_t drain_start_us = esp_timer_get_time();
+  while (esp_timer_get_time() - drain_start_us < (int64_t)options->drain_s * 1000000) {
+    SleepUs(1000000);
+    PrintProgress(esp_timer_get_time() - start_us, &last_exported);
+    if (AllLeavesAcked() &&
+        RecordRingPending(&bench->ring, bench->ring_consumer) == 0) {
+      break;
+    }
+  }
+
+  StoreFlag(&bench->stop_leaves, true);
+  MeshLiteSimWakeAll();
+  for (uint32_t index = 0; index < options->leaves; ++index) {
+    pthread_join(bench->leaves[index].thread, NULL);
+  }
+  StoreFlag(&bench->stop_root, true);
+  pthread_join(bench->root_thread, NULL);
+  while (RecordRingPending(&bench->ring, bench->ring_consumer) > 0 &&
+         options->export_rate == 0) {
+    SleepUs(1000);
+  }
+  StoreFlag(&bench->stop_export, true);
+  pthread_join(bench->export_thread, NULL);
+  if (options->uplink_host[0] != '\0') {
+    // Give the uplink the drain budget to empty its window.
+    uplink_stats_t uplink;
+    const int64_t uplink_start_us = esp_timer_get_time();
+    do {
+      SleepUs(100 * 1000);
+      UplinkGetStats(&bench->uplink, &uplink);
+    } while ((uplink.window_pending > 0 || !uplink.connected) &&
+             esp_timer_get_time() - uplink_start_us <
+               (int64_t)options->drain_s * 1000000);
+    SleepUs(200 * 1000); // last bytes leave the socket
+    UplinkStop(&bench->uplink);
+  }
+
+  PrintReport(generate_s);
+  (void)MeshTransportStop(&bench->root_mesh);
+
+  for (uint32_t index = 0; index < options->leaves; ++index) {
+    free(bench->leaves[index].history);
+    free(bench->leaves[index].exported);
+  }
+  free(bench->leaves);
+  free(bench->latency_ms_histogram);
+  free(bench->alarm_latency_ms_histogram);
+  UplinkDeinit(&bench->uplink);
+  RecordRingDeinit(&bench->ring);
+  MeshLiteSimDeinit();
+  return 0;
+}
@@ -0,0 +1,574 @@
+#include "mesh_lite_sim.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_mesh_lite.h"
+#include "esp_timer.h"
+
+typedef struct
+{
+  int64_t deliver_us;
+  uint64_t order; // FIFO among messages due at the same time
+  uint32_t msg_id;
+  int src;
+  uint32_t len;
+  uint8_t data[];
+} sim_message_t;
+
+typedef struct
+{
+  uint8_t mac[6];
+  uint8_t level;
+  int parent;
+  const esp_mesh_lite_raw_msg_action_t* actions;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  sim_message_t** heap;
+  uint32_t heap_count;
+  uint32_t heap_capacity;
+} sim_node_t;
+
+typedef struct
+{
+  mesh_lite_sim_config_t config;
+  sim_node_t* nodes;
+  uint32_t max_nodes;
+  uint32_t node_count;
+  bool shutting_down;
+  uint64_t next_order;
+  mesh_lite_sim_stats_t stats;
+} sim_state_t;
+
+static sim_state_t g_sim;
+
+static _Thread_local int g_bound_node = -1;
+static _Thread_local uint64_t g_rng_state;
+// Retry policy of the esp_mesh_lite_send_msg() call in progress.
+static _Thread_local uint32_t g_send_max_retry;
+static _Thread_local uint32_t g_send_retry_interval_ms;
+
+static void
+StatAdd(uint64_t* counter, uint64_t value)
+{
+  __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static uint64_t
+NextRandom(void)
+{
+  if (g_rng_state == 0) {
+    g_rng_state = 0x9E3779B97F4A7C15ull ^
+                  ((uint64_t)g_sim.config.seed << 16) ^
+                  (uint64_t)(g_bound_node + 1);
+  }
+  // xorshift64*
+  g_rng_state ^= g_rng_state >> 12;
+  g_rng_state ^= g_rng_state << 25;
+  g_rng_state ^= g_rng_state >> 27;
+  return g_rng_state * 0x2545F4914F6CDD1Dull;
+}
+
+static double
+RandomUnit(void)
+{
+  return (double)(NextRandom() >> 11) / (double)(1ull << 53);
+}
+
+static sim_node_t*
+BoundNode(void)
+{
+  if (g_bound_node < 0 || (uint32_t)g_bound_node >= g_sim.node_count) {
+    return NULL;
+  }
+  return &g_sim.nodes[g_bound_node];
+}
+
+static bool
+MessageBefore(const sim_message_t* a, const sim_message_t* b)
+{
+  if (a->deliver_us != b->deliver_us) {
+    return a->deliver_us < b->deliver_us;
+  }
+  return a->order < b->order;
+}
+
+// Caller holds node->lock.
+static bool
+HeapPush(sim_node_t* node, sim_message_t* message)
+{
+  if (node->heap_count == node->heap_capacity) {
+    const uint32_t capacity =
+      (node->heap_capacity == 0) ? 64u : node->heap_capacity * 2u;
+    sim_message_t** heap =
+      (sim_message_t**)realloc(node->heap, capacity * sizeof(*heap));
+    if (heap == NULL) {
+      return false;
+    }
+    node->heap = heap;
+    node->heap_capacity = capacity;
+  }
+  uint32_t index = node->heap_count++;
+  while (index > 0) {
+    const uint32_t parent = (index - 1u) / 2u;
+    if (!MessageBefore(message, node->heap[parent])) {
+      break;
+    }
+    node->heap[index] = node->heap[parent];
+    index = parent;
+  }
+  node->heap[index] = message;
+  return true;
+}
+
+// Caller holds node->lock and has checked heap_count > 0.
+static sim_message_t*
+HeapPop(sim_node_t* node)
+{
+  sim_message_t* top = node->heap[0];
+  sim_message_t* last = node->heap[--node->heap_count];
+  uint32_t index = 0;
+  for (;;) {
+    const uint32_t left = index * 2u + 1u;
+    if (left >= node->heap_count) {
+      break;
+    }
+    uint32_t child = left;
+    if (left + 1u < node->heap_count &&
+        MessageBefore(node->heap[left + 1u], node->heap[left])) {
+      child = left + 1u;
+    }
+    if (!MessageBefore(node->heap[child], last)) {
+      break;
+    }
+    node->heap[index] = node->heap[child];
+    index = child;
+  }
+  if (node->heap_count > 0) {
+    node->heap[index] = last;
+  }
+  return top;
+}
+
+static uint32_t
+HopsBetween(int src, int dst)
+{
+  const uint8_t src_level = g_sim.nodes[src].level;
+  const uint8_t dst_level = g_sim.nodes[dst].level;
+  const uint32_t hops = (src_level > dst_level) ? (uint32_t)(src_level - dst_level)
+                                                : (uint32_t)(dst_level - src_level);
+  return (hops == 0) ? 1u : hops;
+}
+
+// Queues one framed message for dst, applying loss, retries and latency.
+static esp_err_t
+Deliver(int src, int dst, uint32_t msg_id, const uint8_t* data, size_t len)
+{
+  const uint32_t hops = HopsBetween(src, dst);
+  int64_t delay_us = 0;
+  bool lost = true;
+  for (uint32_t attempt = 0; attempt <= g_send_max_retry; ++attempt) {
+    StatAdd(&g_sim.stats.attempts, 1);
+    if (attempt > 0) {
+      StatAdd(&g_sim.stats.retries, 1);
+      delay_us += (int64_t)g_send_retry_interval_ms * 1000;
+    }
+    bool attempt_lost = false;
+    for (uint32_t hop = 0; hop < hops; ++hop) {
+      StatAdd(&g_sim.stats.hop_transmissions, 1);
+      StatAdd(&g_sim.stats.hop_bytes, len);
+      if (g_sim.config.loss > 0.0 && RandomUnit() < g_sim.config.loss) {
+        attempt_lost = true;
+        break;
+      }
+    }
+    if (!attempt_lost) {
+      lost = false;
+      break;
+    }
+  }
+  if (lost) {
+    StatAdd(&g_sim.stats.dropped, 1);
+    return ESP_OK; // the radio does not report end-to-end loss either
+  }
+  for (uint32_t hop = 0; hop < hops; ++hop) {
+    delay_us += g_sim.config.hop_latency_us;
+    if (g_sim.config.jitter_us > 0) {
+      delay_us += (int64_t)(NextRandom() % (g_sim.config.jitter_us + 1u));
+    }
+  }
+
+  sim_message_t* message = (sim_message_t*)malloc(sizeof(*message) + len);
+  if (message == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  message->deliver_us = esp_timer_get_time() + delay_us;
+  message->order = __atomic_fetch_add(&g_sim.next_order, 1, __ATOMIC_RELAXED);
+  message->msg_id = msg_id;
+  message->src = src;
+  message->len = (uint32_t)len;
+  memcpy(message->data, data, len);
+
+  sim_node_t* node = &g_sim.nodes[dst];
+  pthread_mutex_lock(&node->lock);
+  const bool pushed = HeapPush(node, message);
+  if (pushed && node->heap[0] == message) {
+    pthread_cond_signal(&node->cond);
+  }
+  pthread_mutex_unlock(&node->lock);
+  if (!pushed) {
+    free(message);
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+// Frames are [msg_id (4, LE)][payload], as built by esp_mesh_lite_send_msg.
+static bool
+ParseFrame(const uint8_t* data,
+           size_t size,
+           uint32_t* msg_id_out,
+           const uint8_t** payload_out,
+           size_t* payload_size_out)
+{
+  if (data == NULL || size < sizeof(uint32_t)) {
+    return false;
+  }
+  memcpy(msg_id_out, data, sizeof(uint32_t));
+  *payload_out = data + sizeof(uint32_t);
+  *payload_size_out = size - sizeof(uint32_t);
+  return true;
+}
+
+static void
+Dispatch(sim_node_t* node, sim_message_t* message)
+{
+  const esp_mesh_lite_raw_msg_action_t* action = node->actions;
+  while (action != NULL && action->raw_process != NULL &&
+         action->msg_id != message->msg_id) {
+    ++action;
+  }
+  if (action == NULL || action->raw_process == NULL) {
+    StatAdd(&g_sim.stats.unhandled, 1);
+    return;
+  }
+  StatAdd(&g_sim.stats.delivered, 1);
+  StatAdd(&g_sim.stats.bytes_delivered, message->len);
+
+  uint8_t* out_data = NULL;
+  uint32_t out_len = 0;
+  (void)action->raw_process(
+    message->data, message->len, &out_data, &out_len, (uint32_t)message->order);
+  if (out_data != NULL) {
+    if (out_len > 0 && action->resp_msg_id != 0) {
+      g_send_max_retry = 0;
+      (void)Deliver(
+        g_bound_node, message->src, action->resp_msg_id, out_data, out_len);
+    }
+    free(out_data);
+  }
+}
+
+esp_err_t
+MeshLiteSimInit(const mesh_lite_sim_config_t* config, uint32_t max_nodes)
+{
+  if (config == NULL || max_nodes == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(&g_sim, 0, sizeof(g_sim));
+  g_sim.config = *config;
+  g_sim.nodes = (sim_node_t*)calloc(max_nodes, sizeof(sim_node_t));
+  if (g_sim.nodes == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  g_sim.max_nodes = max_nodes;
+  return ESP_OK;
+}
+
+void
+MeshLiteSimDeinit(void)
+{
+  for (uint32_t index = 0; index < g_sim.node_count; ++index) {
+    sim_node_t* node = &g_sim.nodes[index];
+    while (node->heap_count > 0) {
+      free(HeapPop(node));
+    }
+    free(node->heap);
+    pthread_cond_destroy(&node->cond);
+    pthread_mutex_destroy(&node->lock);
+  }
+  free(g_sim.nodes);
+  memset(&g_sim, 0, sizeof(g_sim));
+}
+
+int
+MeshLiteSimAddNode(const uint8_t mac[6], uint8_t level, int parent)
+{
+  if (mac == NULL || level == 0 || g_sim.node_count >= g_sim.max_nodes) {
+    return -1;
+  }
+  if (level > 1 && (parent < 0 || (uint32_t)parent >= g_sim.node_count ||
+                    g_sim.nodes[parent].level != level - 1u)) {
+    return -1;
+  }
+  sim_node_t* node = &g_sim.nodes[g_sim.node_count];
+  memcpy(node->mac, mac, sizeof(node->mac));
+  node->level = level;
+  node->parent = (level > 1) ? parent : -1;
+  pthread_mutex_init(&node->lock, NULL);
+  pthread_condattr_t cond_attr;
+  pthread_condattr_init(&cond_attr);
+  pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&node->cond, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+  return (int)g_sim.node_count++;
+}
+
+void
+MeshLiteSimBindThread(int node)
+{
+  g_bound_node = node;
+  g_rng_state = 0;
+}
+
+int
+MeshLiteSimBoundNode(void)
+{
+  return g_bound_node;
+}
+
+esp_err_t
+MeshLiteSimNodeMac(int node, uint8_t mac_out[6])
+{
+  if (node < 0 || (uint32_t)node >= g_sim.node_count || mac_out == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  memcpy(mac_out, g_sim.nodes[node].mac, sizeof(g_sim.nodes[node].mac));
+  return ESP_OK;
+}
+
+uint32_t
+MeshLiteSimPoll(int64_t timeout_us)
+{
+  sim_node_t* node = BoundNode();
+  if (node == NULL) {
+    return 0;
+  }
+  const int64_t deadline_us = esp_timer_get_time() + timeout_us;
+  uint32_t dispatched = 0;
+
+  pthread_mutex_lock(&node->lock);
+  for (;;) {
+    const int64_t now_us = esp_timer_get_time();
+    if (node->heap_count > 0 && node->heap[0]->deliver_us <= now_us) {
+      sim_message_t* message = HeapPop(node);
+      pthread_mutex_unlock(&node->lock);
+      Dispatch(node, message);
+      free(message);
+      dispatched++;
+      pthread_mutex_lock(&node->lock);
+      continue;
+    }
+    if (dispatched > 0 || now_us >= deadline_us || g_sim.shutting_down) {
+      break;
+    }
+    int64_t wake_us = deadline_us;
+    if (node->heap_count > 0 && node->heap[0]->deliver_us < wake_us) {
+      wake_us = node->heap[0]->deliver_us;
+    }
+    struct timespec wake;
+    wake.tv_sec = (time_t)(wake_us / 1000000);
+    wake.tv_nsec = (long)((wake_us % 1000000) * 1000);
+    const int wait_result = pthread_cond_timedwait(&node->cond, &node->lock, &wake);
+    if (wait_result != 0 && wait_result != ETIMEDOUT) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&node->lock);
+  return dispatched;
+}
+
+void
+MeshLiteSimWakeAll(void)
+{
+  __atomic_store_n(&g_sim.shutting_down, true, __ATOMIC_RELEASE);
+  for (uint32_t index = 0; index < g_sim.node_count; ++index) {
+    pthread_mutex_lock(&g_sim.nodes[index].lock);
+    pthread_cond_broadcast(&g_sim.nodes[index].cond);
+    pthread_mutex_unlock(&g_sim.nodes[index].lock);
+  }
+}
+
+void
+MeshLiteSimGetStats(mesh_lite_sim_stats_t* out)
+{
+  if (out == NULL) {
+    return;
+  }
+  out->attempts = __atomic_load_n(&g_sim.stats.attempts, __ATOMIC_RELAXED);
+  out->retries = __atomic_load_n(&g_sim.stats.retries, __ATOMIC_RELAXED);
+  out->delivered = __atomic_load_n(&g_sim.stats.delivered, __ATOMIC_RELAXED);
+  out->dropped = __atomic_load_n(&g_sim.stats.dropped, __ATOMIC_RELAXED);
+  out->unhandled = __atomic_load_n(&g_sim.stats.unhandled, __ATOMIC_RELAXED);
+  out->bytes_delivered =
+    __atomic_load_n(&g_sim.stats.bytes_delivered, __ATOMIC_RELAXED);
+  out->hop_transmissions =
+    __atomic_load_n(&g_sim.stats.hop_transmissions, __ATOMIC_RELAXED);
+  out->hop_bytes = __atomic_load_n(&g_sim.stats.hop_bytes, __ATOMIC_RELAXED);
+}
+
+// ---------------------------------------------------------------------------
+// Mesh-Lite API, acting as the node bound to the calling thread.
+// ---------------------------------------------------------------------------
+
+void
+esp_mesh_lite_init(esp_mesh_lite_config_t* config)
+{
+  (void)config;
+}
+
+void
+esp_mesh_lite_start(void)
+{
+}
+
+esp_err_t
+esp_mesh_lite_set_router_config(mesh_lite_sta_config_t* config)
+{
+  (void)config;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_mesh_lite_set_allowed_level(uint8_t level)
+{
+  (void)level;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_mesh_lite_set_disallowed_level(uint8_t level)
+{
+  (void)level;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_mesh_lite_allow_others_to_join(bool enable)
+{
+  (void)enable;
+  return ESP_OK;
+}
+
+void
+esp_mesh_lite_set_wifi_reconnect_interval(uint32_t parent_interval,
+                                          uint32_t parent_count,
+                                          uint32_t reconnect_interval)
+{
+  (void)parent_interval;
+  (void)parent_count;
+  (void)reconnect_interval;
+}
+
+uint8_t
+esp_mesh_lite_get_level(void)
+{
+  const sim_node_t* node = BoundNode();
+  return (node != NULL) ? node->level : 0;
+}
+
+esp_err_t
+esp_mesh_lite_raw_msg_action_list_register(
+  const esp_mesh_lite_raw_msg_action_t* actions)
+{
+  sim_node_t* node = BoundNode();
+  if (node == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  node->actions = actions;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_mesh_lite_send_msg(int type, esp_mesh_lite_msg_config_t* config)
+{
+  if (type != ESP_MESH_LITE_RAW_MSG || config == NULL ||
+      config->raw_msg.raw_resend == NULL) {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  const esp_mesh_lite_raw_msg_config_t* raw = &config->raw_msg;
+  const size_t frame_size = sizeof(uint32_t) + raw->size;
+  uint8_t* frame = (uint8_t*)malloc(frame_size);
+  if (frame == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(frame, &raw->msg_id, sizeof(uint32_t));
+  if (raw->size > 0) {
+    memcpy(frame + sizeof(uint32_t), raw->data, raw->size);
+  }
+  g_send_max_retry = raw->max_retry;
+  g_send_retry_interval_ms = raw->retry_interval;
+  const esp_err_t result = raw->raw_resend(frame, frame_size);
+  g_send_max_retry = 0;
+  g_send_retry_interval_ms = 0;
+  free(frame);
+  return result;
+}
+
+esp_err_t
+esp_mesh_lite_send_raw_msg_to_root(const uint8_t* data, size_t size)
+{
+  uint32_t msg_id = 0;
+  const uint8_t* payload = NULL;
+  size_t payload_size = 0;
+  if (BoundNode() == NULL || g_sim.node_count == 0 ||
+      !ParseFrame(data, size, &msg_id, &payload, &payload_size)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (g_bound_node == 0) {
+    return ESP_ERR_INVALID_STATE; // the root has nowhere to send
+  }
+  return Deliver(g_bound_node, 0, msg_id, payload, payload_size);
+}
+
+esp_err_t
+esp_mesh_lite_send_raw_msg_to_parent(const uint8_t* data, size_t size)
+{
+  uint32_t msg_id = 0;
+  const uint8_t* payload = NULL;
+  size_t payload_size = 0;
+  const sim_node_t* self = BoundNode();
+  if (self == NULL || self->parent < 0 ||
+      !ParseFrame(data, size, &msg_id, &payload, &payload_size)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  return Deliver(g_bound_node, self->parent, msg_id, payload, payload_size);
+}
+
+esp_err_t
+esp_mesh_lite_send_broadcast_raw_msg_to_child(const uint8_t* data,
+                                              size_t size)
+{
+  uint32_t msg_id = 0;
+  const uint8_t* payload = NULL;
+  size_t payload_size = 0;
+  const sim_node_t* self = BoundNode();
+  if (self == NULL || !ParseFrame(data, size, &msg_id, &payload, &payload_size)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  esp_err_t result = ESP_OK;
+  for (uint32_t index = 0; index < g_sim.node_count; ++index) {
+    if (g_sim.nodes[index].level <= self->level) {
+      continue;
+    }
+    const esp_err_t deliver_result =
+      Deliver(g_bound_node, (int)index, msg_id, payload, payload_size);
+    if (deliver_result != ESP_OK) {
+      result = deliver_result;
+    }
+  }
+  return result;
+}
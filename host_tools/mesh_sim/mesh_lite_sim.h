@@ -0,0 +1,74 @@
+#ifndef PT100_MESH_SIM_MESH_LITE_SIM_H_
+#define PT100_MESH_SIM_MESH_LITE_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // In-process Mesh-Lite: every simulated node owns an inbox (a min-heap on
+  // delivery time). Sends from a leaf to the root cross (level - 1) hops;
+  // each hop adds hop_latency_us plus up to jitter_us and drops the message
+  // with probability loss. A send through esp_mesh_lite_send_msg() is
+  // retried up to max_retry times, each retry costing retry_interval ms.
+  //
+  // Mesh-Lite callbacks for a node run on the thread bound to that node
+  // (MeshLiteSimBindThread) from inside MeshLiteSimPoll(), which is how the
+  // firmware sees them too: one RX context per device.
+  typedef struct
+  {
+    uint32_t hop_latency_us;
+    uint32_t jitter_us;
+    double loss; // per hop, per attempt
+    uint32_t seed;
+  } mesh_lite_sim_config_t;
+
+  typedef struct
+  {
+    uint64_t attempts;  // per destination, including retries
+    uint64_t retries;
+    uint64_t delivered; // dispatched to a registered action
+    uint64_t dropped;   // every attempt lost
+    uint64_t unhandled; // no action registered for the msg_id
+    uint64_t bytes_delivered;
+    uint64_t hop_transmissions; // every hop of every attempt (airtime)
+    uint64_t hop_bytes;
+  } mesh_lite_sim_stats_t;
+
+  esp_err_t MeshLiteSimInit(const mesh_lite_sim_config_t* config,
+                            uint32_t max_nodes);
+
+  void MeshLiteSimDeinit(void);
+
+  // Adds a node and returns its id (the first node added is the root and
+  // must use level 1, parent -1). level is the hop count reported by
+  // get_level(); parent (level - 1) is where send_raw_msg_to_parent goes.
+  int MeshLiteSimAddNode(const uint8_t mac[6], uint8_t level, int parent);
+
+  // Binds the calling thread to a node; all Mesh-Lite calls made from this
+  // thread act as that node.
+  void MeshLiteSimBindThread(int node);
+
+  int MeshLiteSimBoundNode(void);
+
+  esp_err_t MeshLiteSimNodeMac(int node, uint8_t mac_out[6]);
+
+  // Dispatches every message due for the bound node, waiting up to
+  // timeout_us for the first one. Returns the number dispatched.
+  uint32_t MeshLiteSimPoll(int64_t timeout_us);
+
+  // Wakes every node blocked in MeshLiteSimPoll (used for shutdown).
+  void MeshLiteSimWakeAll(void);
+
+  void MeshLiteSimGetStats(mesh_lite_sim_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_MESH_LITE_SIM_H_
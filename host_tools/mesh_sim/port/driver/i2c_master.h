@@ -0,0 +1,10 @@
+#ifndef PT100_MESH_SIM_I2C_MASTER_H_
+#define PT100_MESH_SIM_I2C_MASTER_H_
+
+// Only the handle types that time_sync.h / i2c_bus.h mention.
+
+typedef struct sim_i2c_bus* i2c_master_bus_handle_t;
+typedef struct sim_i2c_dev* i2c_master_dev_handle_t;
+typedef int i2c_port_t;
+
+#endif // PT100_MESH_SIM_I2C_MASTER_H_
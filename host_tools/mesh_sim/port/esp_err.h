@@ -0,0 +1,36 @@
+#ifndef PT100_MESH_SIM_ESP_ERR_H_
+#define PT100_MESH_SIM_ESP_ERR_H_
+
+// Host stand-in for the subset of ESP-IDF error codes the mesh code uses.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+#define ESP_ERR_INVALID_RESPONSE 0x108
+#define ESP_ERR_INVALID_CRC 0x109
+#define ESP_ERR_NOT_ALLOWED 0x10D
+#define ESP_ERR_WIFI_BASE 0x3000
+#define ESP_ERR_WIFI_SSID (ESP_ERR_WIFI_BASE + 10)
+
+  const char* esp_err_to_name(esp_err_t code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_ESP_ERR_H_
@@ -0,0 +1,33 @@
+#ifndef PT100_MESH_SIM_ESP_HEAP_CAPS_H_
+#define PT100_MESH_SIM_ESP_HEAP_CAPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT (1u << 2)
+#define MALLOC_CAP_SPIRAM (1u << 10)
+#define MALLOC_CAP_INTERNAL (1u << 11)
+
+// The host has no separate PSRAM heap; every capability maps to malloc.
+static inline void*
+heap_caps_malloc(size_t size, uint32_t caps)
+{
+  (void)caps;
+  return malloc(size);
+}
+
+static inline void*
+heap_caps_calloc(size_t count, size_t size, uint32_t caps)
+{
+  (void)caps;
+  return calloc(count, size);
+}
+
+static inline void
+heap_caps_free(void* ptr)
+{
+  free(ptr);
+}
+
+#endif // PT100_MESH_SIM_ESP_HEAP_CAPS_H_
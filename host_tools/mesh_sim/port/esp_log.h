@@ -0,0 +1,48 @@
+#ifndef PT100_MESH_SIM_ESP_LOG_H_
+#define PT100_MESH_SIM_ESP_LOG_H_
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef enum
+  {
+    ESP_LOG_NONE = 0,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+  } esp_log_level_t;
+
+  // Global threshold for the simulator (default ESP_LOG_WARN).
+  extern esp_log_level_t g_sim_log_level;
+
+  void esp_log_level_set(const char* tag, esp_log_level_t level);
+
+#define SIM_LOG(level, letter, tag, format, ...)                              \
+  do {                                                                        \
+    if ((level) <= g_sim_log_level) {                                         \
+      fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__);       \
+    }                                                                         \
+  } while (0)
+
+#define ESP_LOGE(tag, format, ...)                                            \
+  SIM_LOG(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)                                            \
+  SIM_LOG(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)                                            \
+  SIM_LOG(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)                                            \
+  SIM_LOG(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)                                            \
+  SIM_LOG(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_ESP_LOG_H_
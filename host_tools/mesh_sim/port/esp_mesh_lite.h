@@ -0,0 +1,6 @@
+#ifndef PT100_MESH_SIM_ESP_MESH_LITE_H_
+#define PT100_MESH_SIM_ESP_MESH_LITE_H_
+
+#include "esp_mesh_lite_core.h"
+
+#endif // PT100_MESH_SIM_ESP_MESH_LITE_H_
@@ -0,0 +1,110 @@
+#ifndef PT100_MESH_SIM_ESP_MESH_LITE_CORE_H_
+#define PT100_MESH_SIM_ESP_MESH_LITE_CORE_H_
+
+// Host stand-in for the slice of the Mesh-Lite API used by mesh_transport.c.
+// Implemented over in-process queues by mesh_lite_sim.c; every call acts on
+// the simulated node bound to the calling thread (MeshLiteSimBindThread).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef struct
+  {
+    const char* softap_ssid;
+    const char* softap_password;
+    bool join_mesh_ignore_router_status;
+    bool join_mesh_without_configured_wifi;
+  } esp_mesh_lite_config_t;
+
+#define ESP_MESH_LITE_DEFAULT_INIT() { 0 }
+
+  typedef struct
+  {
+    uint8_t ssid[33];
+    uint8_t password[65];
+  } mesh_lite_sta_config_t;
+
+  typedef esp_err_t (*raw_msg_process_cb_t)(uint8_t* data,
+                                            uint32_t len,
+                                            uint8_t** out_data,
+                                            uint32_t* out_len,
+                                            uint32_t seq);
+
+  typedef struct esp_mesh_lite_raw_msg_action
+  {
+    uint32_t msg_id;
+    uint32_t resp_msg_id;
+    raw_msg_process_cb_t raw_process;
+  } esp_mesh_lite_raw_msg_action_t;
+
+#define ESP_MESH_LITE_RAW_MSG_ACTION_END { 0, 0, NULL }
+
+  typedef struct
+  {
+    uint32_t msg_id;
+    uint32_t expect_resp_msg_id;
+    uint32_t max_retry;
+    uint16_t retry_interval;
+    const uint8_t* data;
+    size_t size;
+    esp_err_t (*raw_resend)(const uint8_t* data, size_t size);
+    void (*raw_send_fail)(void* arg);
+  } esp_mesh_lite_raw_msg_config_t;
+
+  typedef union
+  {
+    esp_mesh_lite_raw_msg_config_t raw_msg;
+  } esp_mesh_lite_msg_config_t;
+
+  enum
+  {
+    ESP_MESH_LITE_JSON_MSG = 0,
+    ESP_MESH_LITE_RAW_MSG,
+  };
+
+  void esp_mesh_lite_init(esp_mesh_lite_config_t* config);
+
+  void esp_mesh_lite_start(void);
+
+  esp_err_t esp_mesh_lite_set_router_config(mesh_lite_sta_config_t* config);
+
+  esp_err_t esp_mesh_lite_set_allowed_level(uint8_t level);
+
+  esp_err_t esp_mesh_lite_set_disallowed_level(uint8_t level);
+
+  esp_err_t esp_mesh_lite_allow_others_to_join(bool enable);
+
+  void esp_mesh_lite_set_wifi_reconnect_interval(uint32_t parent_interval,
+                                                 uint32_t parent_count,
+                                                 uint32_t reconnect_interval);
+
+  uint8_t esp_mesh_lite_get_level(void);
+
+  esp_err_t esp_mesh_lite_raw_msg_action_list_register(
+    const esp_mesh_lite_raw_msg_action_t* actions);
+
+  esp_err_t esp_mesh_lite_send_msg(int type,
+                                   esp_mesh_lite_msg_config_t* config);
+
+  esp_err_t esp_mesh_lite_send_raw_msg_to_root(const uint8_t* data,
+                                               size_t size);
+
+  esp_err_t esp_mesh_lite_send_raw_msg_to_parent(const uint8_t* data,
+                                                 size_t size);
+
+  esp_err_t esp_mesh_lite_send_broadcast_raw_msg_to_child(const uint8_t* data,
+                                                          size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_ESP_MESH_LITE_CORE_H_
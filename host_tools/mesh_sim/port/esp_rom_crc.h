@@ -0,0 +1,18 @@
+#ifndef PT100_MESH_SIM_ESP_ROM_CRC_H_
+#define PT100_MESH_SIM_ESP_ROM_CRC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // Same convention as the ROM: crc32_le(0, ...) equals zlib's crc32().
+  uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_ESP_ROM_CRC_H_
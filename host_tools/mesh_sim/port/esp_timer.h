@@ -0,0 +1,18 @@
+#ifndef PT100_MESH_SIM_ESP_TIMER_H_
+#define PT100_MESH_SIM_ESP_TIMER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // Microseconds on CLOCK_MONOTONIC.
+  int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_ESP_TIMER_H_
@@ -0,0 +1,74 @@
+#ifndef PT100_MESH_SIM_ESP_WIFI_H_
+#define PT100_MESH_SIM_ESP_WIFI_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef enum
+  {
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP,
+  } wifi_interface_t;
+
+  typedef enum
+  {
+    WIFI_SECOND_CHAN_NONE = 0,
+  } wifi_second_chan_t;
+
+  typedef enum
+  {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WPA2_PSK = 3,
+  } wifi_auth_mode_t;
+
+  typedef struct
+  {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    uint8_t ssid_len;
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+    uint8_t ssid_hidden;
+    uint8_t max_connection;
+    uint16_t beacon_interval;
+  } wifi_ap_config_t;
+
+  typedef struct
+  {
+    uint8_t ssid[32];
+    uint8_t password[64];
+  } wifi_sta_config_t;
+
+  typedef union
+  {
+    wifi_ap_config_t ap;
+    wifi_sta_config_t sta;
+  } wifi_config_t;
+
+  // Returns the MAC of the simulated node bound to the calling thread.
+  esp_err_t esp_wifi_get_mac(wifi_interface_t interface, uint8_t mac[6]);
+
+  esp_err_t esp_wifi_get_config(wifi_interface_t interface,
+                                wifi_config_t* config);
+
+  esp_err_t esp_wifi_set_config(wifi_interface_t interface,
+                                wifi_config_t* config);
+
+  esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second);
+
+  esp_err_t esp_wifi_scan_stop(void);
+
+  esp_err_t esp_wifi_connect(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_ESP_WIFI_H_
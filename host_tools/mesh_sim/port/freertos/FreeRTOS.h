@@ -0,0 +1,63 @@
+#ifndef PT100_MESH_SIM_FREERTOS_H_
+#define PT100_MESH_SIM_FREERTOS_H_
+
+// Host stand-in for the FreeRTOS subset used by the mesh code. Ticks are
+// milliseconds; critical sections are process-wide spinlocks.
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef uint32_t TickType_t;
+  typedef int BaseType_t;
+  typedef unsigned UBaseType_t;
+
+  typedef struct
+  {
+    volatile int locked;
+  } portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdTICKS_TO_MS(ticks) ((uint32_t)(ticks))
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+
+  static inline void
+  SimMuxEnter(portMUX_TYPE* mux)
+  {
+    while (__atomic_test_and_set(&mux->locked, __ATOMIC_ACQUIRE)) {
+      sched_yield();
+    }
+  }
+
+  static inline void
+  SimMuxExit(portMUX_TYPE* mux)
+  {
+    __atomic_clear(&mux->locked, __ATOMIC_RELEASE);
+  }
+
+#define portENTER_CRITICAL(mux) SimMuxEnter(mux)
+#define portEXIT_CRITICAL(mux) SimMuxExit(mux)
+#define taskENTER_CRITICAL(mux) SimMuxEnter(mux)
+#define taskEXIT_CRITICAL(mux) SimMuxExit(mux)
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_FREERTOS_H_
@@ -0,0 +1,33 @@
+#ifndef PT100_MESH_SIM_FREERTOS_SEMPHR_H_
+#define PT100_MESH_SIM_FREERTOS_SEMPHR_H_
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // Mutexes, backed by pthread_mutex_t.
+  typedef struct sim_semaphore* SemaphoreHandle_t;
+
+  SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+  void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+  BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+
+  BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+  // No binary semaphores (MAX31865 DRDY): creation fails, so the reader
+  // keeps polling.
+  SemaphoreHandle_t xSemaphoreCreateBinary(void);
+
+  BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore,
+                                   BaseType_t* woken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_FREERTOS_SEMPHR_H_
@@ -0,0 +1,32 @@
+#ifndef PT100_MESH_SIM_FREERTOS_TASK_H_
+#define PT100_MESH_SIM_FREERTOS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // Tasks are detached pthreads; vTaskDelete() only supports NULL (self).
+  typedef struct sim_task* TaskHandle_t;
+  typedef void (*TaskFunction_t)(void* arg);
+
+  BaseType_t xTaskCreate(TaskFunction_t function,
+                         const char* name,
+                         uint32_t stack_depth,
+                         void* arg,
+                         UBaseType_t priority,
+                         TaskHandle_t* handle_out);
+
+  void vTaskDelete(TaskHandle_t task);
+
+  void vTaskDelay(TickType_t ticks);
+
+  TickType_t xTaskGetTickCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_MESH_SIM_FREERTOS_TASK_H_
@@ -0,0 +1,6 @@
+#ifndef PT100_MESH_SIM_LWIP_NETDB_H_
+#define PT100_MESH_SIM_LWIP_NETDB_H_
+
+#include <netdb.h>
+
+#endif // PT100_MESH_SIM_LWIP_NETDB_H_
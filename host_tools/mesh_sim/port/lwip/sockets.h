@@ -0,0 +1,11 @@
+#ifndef PT100_MESH_SIM_LWIP_SOCKETS_H_
+#define PT100_MESH_SIM_LWIP_SOCKETS_H_
+
+// lwIP exposes the BSD socket API; on the host the system one stands in.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+#endif // PT100_MESH_SIM_LWIP_SOCKETS_H_
@@ -0,0 +1,28 @@
+#ifndef PT100_MESH_SIM_SDKCONFIG_H_
+#define PT100_MESH_SIM_SDKCONFIG_H_
+
+// Kconfig values for the host simulator. Each one can be overridden from
+// the CMake command line, e.g. -DCONFIG_APP_MESH_MAX_NODES=64.
+
+#ifndef CONFIG_APP_MESH_MAX_NODES
+#define CONFIG_APP_MESH_MAX_NODES 255
+#endif
+#ifndef CONFIG_APP_MESH_FRAME_MAX_BYTES
+#define CONFIG_APP_MESH_FRAME_MAX_BYTES 1024
+#endif
+#ifndef CONFIG_APP_MESH_AGG_MAX_LATENCY_MS
+#define CONFIG_APP_MESH_AGG_MAX_LATENCY_MS 2000
+#endif
+#ifndef CONFIG_APP_MESH_REORDER_SLOTS
+#define CONFIG_APP_MESH_REORDER_SLOTS 16
+#endif
+#ifndef CONFIG_APP_MESH_REORDER_MAX_DELAY_MS
+#define CONFIG_APP_MESH_REORDER_MAX_DELAY_MS 3000
+#endif
+#ifndef CONFIG_APP_MESH_AP_PASSWORD
+#define CONFIG_APP_MESH_AP_PASSWORD ""
+#endif
+#define CONFIG_APP_MESH_DISABLE_ROUTER 1
+#define CONFIG_APP_MESH_CHANNEL 6
+
+#endif // PT100_MESH_SIM_SDKCONFIG_H_
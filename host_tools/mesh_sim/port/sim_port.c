@@ -0,0 +1,354 @@
+// Host implementations of the ESP-IDF / FreeRTOS calls and the firmware
+// services (Wi-Fi service, time sync) that the mesh modules link against.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mesh_lite_sim.h"
+#include "time_sync.h"
+#include "wifi_service.h"
+
+esp_log_level_t g_sim_log_level = ESP_LOG_WARN;
+
+struct sim_semaphore
+{
+  pthread_mutex_t mutex;
+};
+
+struct sim_task
+{
+  pthread_t thread;
+  TaskFunction_t function;
+  void* arg;
+};
+
+static _Thread_local struct sim_task* g_current_task = NULL;
+
+static wifi_service_mode_t g_wifi_mode = WIFI_SERVICE_MODE_NONE;
+
+const char*
+esp_err_to_name(esp_err_t code)
+{
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+      return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+      return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+      return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:
+      return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:
+      return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_NOT_ALLOWED:
+      return "ESP_ERR_NOT_ALLOWED";
+    default:
+      return "ESP_ERR_UNKNOWN";
+  }
+}
+
+void
+esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+  (void)tag;
+  (void)level; // per-tag levels are not modelled
+}
+
+uint32_t
+esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+  crc = ~crc;
+  for (uint32_t index = 0; index < len; ++index) {
+    crc ^= buf[index];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+int64_t
+esp_timer_get_time(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void
+vTaskDelay(TickType_t ticks)
+{
+  struct timespec delay;
+  delay.tv_sec = (time_t)(ticks / 1000u);
+  delay.tv_nsec = (long)(ticks % 1000u) * 1000000L;
+  while (nanosleep(&delay, &delay) != 0) {
+  }
+}
+
+static void*
+SimTaskEntry(void* context)
+{
+  g_current_task = (struct sim_task*)context;
+  g_current_task->function(g_current_task->arg);
+  vTaskDelete(NULL); // a FreeRTOS task must not return
+  return NULL;
+}
+
+BaseType_t
+xTaskCreate(TaskFunction_t function,
+            const char* name,
+            uint32_t stack_depth,
+            void* arg,
+            UBaseType_t priority,
+            TaskHandle_t* handle_out)
+{
+  (void)name;
+  (void)stack_depth;
+  (void)priority;
+  struct sim_task* task = (struct sim_task*)calloc(1, sizeof(*task));
+  if (task == NULL) {
+    return pdFAIL;
+  }
+  task->function = function;
+  task->arg = arg;
+  if (handle_out != NULL) {
+    *handle_out = task;
+  }
+  if (pthread_create(&task->thread, NULL, SimTaskEntry, task) != 0) {
+    if (handle_out != NULL) {
+      *handle_out = NULL;
+    }
+    free(task);
+    return pdFAIL;
+  }
+  pthread_detach(task->thread);
+  return pdPASS;
+}
+
+void
+vTaskDelete(TaskHandle_t task)
+{
+  if (task != NULL && task != g_current_task) {
+    abort(); // deleting another task is not modelled
+  }
+  free(g_current_task);
+  g_current_task = NULL;
+  pthread_exit(NULL);
+}
+
+TickType_t
+xTaskGetTickCount(void)
+{
+  return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+SemaphoreHandle_t
+xSemaphoreCreateMutex(void)
+{
+  SemaphoreHandle_t semaphore =
+    (SemaphoreHandle_t)calloc(1, sizeof(struct sim_semaphore));
+  if (semaphore != NULL) {
+    pthread_mutex_init(&semaphore->mutex, NULL);
+  }
+  return semaphore;
+}
+
+void
+vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+  if (semaphore == NULL) {
+    return;
+  }
+  pthread_mutex_destroy(&semaphore->mutex);
+  free(semaphore);
+}
+
+BaseType_t
+xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+  if (ticks == portMAX_DELAY) {
+    return (pthread_mutex_lock(&semaphore->mutex) == 0) ? pdTRUE : pdFALSE;
+  }
+  const int64_t deadline_us = esp_timer_get_time() + (int64_t)ticks * 1000;
+  while (pthread_mutex_trylock(&semaphore->mutex) != 0) {
+    if (esp_timer_get_time() >= deadline_us) {
+      return pdFALSE;
+    }
+    sched_yield();
+  }
+  return pdTRUE;
+}
+
+BaseType_t
+xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+  return (pthread_mutex_unlock(&semaphore->mutex) == 0) ? pdTRUE : pdFALSE;
+}
+
+SemaphoreHandle_t
+xSemaphoreCreateBinary(void)
+{
+  return NULL;
+}
+
+BaseType_t
+xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* woken)
+{
+  (void)semaphore;
+  if (woken != NULL) {
+    *woken = pdFALSE;
+  }
+  return pdFALSE;
+}
+
+esp_err_t
+esp_wifi_get_mac(wifi_interface_t interface, uint8_t mac[6])
+{
+  (void)interface;
+  return MeshLiteSimNodeMac(MeshLiteSimBoundNode(), mac);
+}
+
+esp_err_t
+esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* config)
+{
+  (void)interface;
+  memset(config, 0, sizeof(*config));
+  return ESP_OK;
+}
+
+esp_err_t
+esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* config)
+{
+  (void)interface;
+  (void)config;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+  (void)primary;
+  (void)second;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_wifi_scan_stop(void)
+{
+  return ESP_OK;
+}
+
+esp_err_t
+esp_wifi_connect(void)
+{
+  return ESP_OK;
+}
+
+esp_err_t
+WifiServiceInitOnce(void)
+{
+  return ESP_OK;
+}
+
+esp_err_t
+WifiServiceAcquire(wifi_service_mode_t mode)
+{
+  g_wifi_mode = mode;
+  return ESP_OK;
+}
+
+esp_err_t
+WifiServiceRelease(void)
+{
+  g_wifi_mode = WIFI_SERVICE_MODE_NONE;
+  return ESP_OK;
+}
+
+wifi_service_mode_t
+WifiServiceActiveMode(void)
+{
+  return g_wifi_mode;
+}
+
+// Every simulated node shares the host clock, which is never changed: time
+// sync messages are exercised end to end but their corrections are dropped.
+
+int64_t
+TimeSyncGetEpochUs(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+bool
+TimeSyncIsSystemTimeValid(void)
+{
+  return true;
+}
+
+void
+TimeSyncGetNow(int64_t* epoch_seconds_out, int32_t* millis_out)
+{
+  const int64_t now_us = TimeSyncGetEpochUs();
+  if (epoch_seconds_out != NULL) {
+    *epoch_seconds_out = now_us / 1000000;
+  }
+  if (millis_out != NULL) {
+    *millis_out = (int32_t)((now_us % 1000000) / 1000);
+  }
+}
+
+esp_err_t
+TimeSyncSetSystemEpoch(int64_t epoch_seconds,
+                       bool update_rtc,
+                       const time_sync_t* time_sync)
+{
+  (void)epoch_seconds;
+  (void)update_rtc;
+  (void)time_sync;
+  return ESP_OK;
+}
+
+esp_err_t
+TimeSyncStepSystemUs(int64_t delta_us,
+                     bool update_rtc,
+                     const time_sync_t* time_sync)
+{
+  (void)delta_us;
+  (void)update_rtc;
+  (void)time_sync;
+  return ESP_OK;
+}
+
+esp_err_t
+TimeSyncSlewSystemUs(int64_t delta_us, int64_t* unapplied_us_out)
+{
+  (void)delta_us;
+  if (unapplied_us_out != NULL) {
+    *unapplied_us_out = 0;
+  }
+  return ESP_OK;
+}
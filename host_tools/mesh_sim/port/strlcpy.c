@@ -0,0 +1,15 @@
+#include "strlcpy.h"
+
+#include <string.h>
+
+size_t
+strlcpy(char* dst, const char* src, size_t size)
+{
+  const size_t length = strlen(src);
+  if (size > 0) {
+    const size_t copy = (length >= size) ? size - 1u : length;
+    memcpy(dst, src, copy);
+    dst[copy] = '\0';
+  }
+  return length;
+}
@@ -0,0 +1,10 @@
+#ifndef PT100_MESH_SIM_STRLCPY_H_
+#define PT100_MESH_SIM_STRLCPY_H_
+
+// Older glibc lacks strlcpy(); the firmware sources use it (newlib has it).
+
+#include <stddef.h>
+
+size_t strlcpy(char* dst, const char* src, size_t size);
+
+#endif // PT100_MESH_SIM_STRLCPY_H_
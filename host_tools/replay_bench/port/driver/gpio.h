@@ -0,0 +1,70 @@
+#ifndef PT100_REPLAY_BENCH_GPIO_H_
+#define PT100_REPLAY_BENCH_GPIO_H_
+
+// No DRDY line on the host; the reader polls.
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define IRAM_ATTR
+
+typedef int gpio_num_t;
+typedef void (*gpio_isr_t)(void* arg);
+
+typedef enum
+{
+  GPIO_MODE_INPUT = 1,
+} gpio_mode_t;
+
+typedef enum
+{
+  GPIO_PULLUP_DISABLE = 0,
+  GPIO_PULLUP_ENABLE = 1,
+} gpio_pullup_t;
+
+typedef enum
+{
+  GPIO_PULLDOWN_DISABLE = 0,
+  GPIO_PULLDOWN_ENABLE = 1,
+} gpio_pulldown_t;
+
+typedef enum
+{
+  GPIO_INTR_DISABLE = 0,
+  GPIO_INTR_NEGEDGE = 2,
+} gpio_int_type_t;
+
+typedef struct
+{
+  uint64_t pin_bit_mask;
+  gpio_mode_t mode;
+  gpio_pullup_t pull_up_en;
+  gpio_pulldown_t pull_down_en;
+  gpio_int_type_t intr_type;
+} gpio_config_t;
+
+static inline esp_err_t
+gpio_config(const gpio_config_t* config)
+{
+  (void)config;
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+static inline esp_err_t
+gpio_install_isr_service(int flags)
+{
+  (void)flags;
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+static inline esp_err_t
+gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void* arg)
+{
+  (void)gpio;
+  (void)handler;
+  (void)arg;
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // PT100_REPLAY_BENCH_GPIO_H_
@@ -0,0 +1,713 @@
+// Replays a recorded trace through the firmware's acquisition and storage
+// path on Linux: main/max31865_reader.c on a trace player
+// (main/max31865_replay.c) -> sample filter -> calibration -> record
+// compressor -> FRAM log (in RAM) -> CSV batches, in the order SensorTask
+// and StorageTask run them. Reports throughput, the cost of each stage and
+// the error against the trace. See README.md in this directory.
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calibration.h"
+#include "data_csv.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "fram_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "log_record.h"
+#include "max31865_reader.h"
+#include "max31865_replay.h"
+#include "record_compressor.h"
+#include "sample_filter.h"
+
+static const char* kNodeId = "02:00:00:00:00:00";
+// StorageTask's flush pass limit (kSdFlushMaxRecordsPerPass).
+static const uint32_t kFlushMaxRecordsPerPass = 100;
+
+typedef struct
+{
+  const char* input;
+  const char* output; // NULL: rows are formatted and dropped
+  uint32_t speed;     // 0 = one row per sample, as fast as it runs
+  uint32_t period_ms; // sample period with speed > 0
+  int channel;        // -1 = every row
+  bool continuous;
+  uint64_t max_samples; // 0 = whole trace
+  sample_filter_config_t filter;
+  record_compression_config_t compression;
+  calibration_model_t calibration;
+  uint32_t fram_bytes;
+  uint32_t batch_bytes;
+  uint32_t watermark_records;
+  uint32_t flush_period_ms; // trace time
+} bench_options_t;
+
+typedef struct
+{
+  uint64_t count;
+  double sum_sq;
+  int64_t max_abs;
+} error_stats_t;
+
+typedef struct
+{
+  uint64_t count;
+  int64_t total_us;
+  int64_t max_us;
+} cost_stats_t;
+
+typedef struct
+{
+  bench_options_t options;
+  max31865_reader_t reader;
+  max31865_replay_t replay;
+  sample_filter_t filter;
+  calibration_fixed_t calibration;
+  record_compressor_t compressor;
+  uint32_t decimation_phase;
+  bool fault_pending;
+  esp_err_t fault_result;
+  max31865_sample_t fault_sample;
+
+  uint8_t* fram;
+  fram_log_t fram_log;
+  uint8_t* batch;
+  FILE* output;
+  bool flush_pending;
+  int64_t last_flush_trace_ms;
+
+  uint64_t samples;
+  uint64_t faulted;
+  uint64_t records;
+  uint64_t stored;
+  uint32_t fram_high_water;
+  uint64_t csv_rows;
+  uint64_t csv_bytes;
+  error_stats_t sample_error; // conversion vs raw_temp_c of the trace
+  error_stats_t record_error; // filtered record vs raw_temp_c
+  cost_stats_t read_cost;
+  cost_stats_t pipeline_cost; // filter, calibration, compression, FRAM
+  cost_stats_t batch_cost;    // one flush pass: format and write
+} bench_t;
+
+static bench_t g_bench;
+
+static void
+ErrorAdd(error_stats_t* stats, int64_t error)
+{
+  const int64_t magnitude = (error < 0) ? -error : error;
+  stats->count++;
+  stats->sum_sq += (double)error * (double)error;
+  if (magnitude > stats->max_abs) {
+    stats->max_abs = magnitude;
+  }
+}
+
+static void
+CostAdd(cost_stats_t* stats, int64_t us)
+{
+  stats->count++;
+  stats->total_us += us;
+  if (us > stats->max_us) {
+    stats->max_us = us;
+  }
+}
+
+static esp_err_t
+RamFramRead(void* context, uint32_t addr, void* out, size_t len)
+{
+  bench_t* bench = (bench_t*)context;
+  if ((uint64_t)addr + len > bench->options.fram_bytes) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memcpy(out, bench->fram + addr, len);
+  return ESP_OK;
+}
+
+static esp_err_t
+RamFramWrite(void* context, uint32_t addr, const void* data, size_t len)
+{
+  bench_t* bench = (bench_t*)context;
+  if ((uint64_t)addr + len > bench->options.fram_bytes) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memcpy(bench->fram + addr, data, len);
+  return ESP_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Storage: StorageTask's FRAM append and flush passes.
+
+static void
+StoreRecord(bench_t* bench, log_record_t* record)
+{
+  if (FramLogAssignRecordIds(&bench->fram_log, record) != ESP_OK ||
+      FramLogAppend(&bench->fram_log, record) != ESP_OK) {
+    fprintf(stderr, "FRAM append failed\n");
+    return;
+  }
+  bench->stored++;
+  const uint32_t buffered = FramLogGetBufferedRecords(&bench->fram_log);
+  if (buffered > bench->fram_high_water) {
+    bench->fram_high_water = buffered;
+  }
+}
+
+// One flush pass: up to kFlushMaxRecordsPerPass records into one batch.
+// Returns whether records are left.
+static bool
+FlushPass(bench_t* bench)
+{
+  const int64_t start_us = esp_timer_get_time();
+  const uint32_t buffered = FramLogGetBufferedRecords(&bench->fram_log);
+  size_t used = 0;
+  uint32_t rows = 0;
+  uint64_t last_record_id = 0;
+  for (uint32_t offset = 0;
+       offset < buffered && rows < kFlushMaxRecordsPerPass;
+       ++offset) {
+    log_record_t record;
+    if (FramLogPeekOffset(&bench->fram_log, offset, &record) != ESP_OK) {
+      break;
+    }
+    char line[256];
+    size_t line_len = 0;
+    if (!CsvFormatRow(&record, kNodeId, line, sizeof(line), &line_len) ||
+        used + line_len > bench->options.batch_bytes) {
+      break;
+    }
+    memcpy(bench->batch + used, line, line_len);
+    used += line_len;
+    rows++;
+    last_record_id = record.record_id;
+  }
+  if (rows == 0) {
+    return false;
+  }
+  if (bench->output != NULL &&
+      fwrite(bench->batch, 1, used, bench->output) != used) {
+    fprintf(stderr, "output write failed\n");
+  }
+  uint32_t consumed = 0;
+  (void)FramLogConsumeUpToRecordId(
+    &bench->fram_log, last_record_id, &consumed);
+  bench->csv_rows += rows;
+  bench->csv_bytes += used;
+  CostAdd(&bench->batch_cost, esp_timer_get_time() - start_us);
+  return FramLogGetBufferedRecords(&bench->fram_log) > 0;
+}
+
+static void
+StorageTick(bench_t* bench, int64_t trace_ms)
+{
+  if (trace_ms - bench->last_flush_trace_ms >=
+      (int64_t)bench->options.flush_period_ms) {
+    bench->flush_pending = true;
+    bench->last_flush_trace_ms = trace_ms;
+  }
+  if (FramLogGetBufferedRecords(&bench->fram_log) >=
+      bench->options.watermark_records) {
+    bench->flush_pending = true;
+  }
+  if (bench->flush_pending) {
+    bench->flush_pending = FlushPass(bench);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Sensor: SensorTask's per-channel steps for one unaligned sample.
+
+// FilterChannelSample() of the sensor task.
+static bool
+FilterSample(bench_t* bench,
+             esp_err_t result,
+             const max31865_sample_t* sample,
+             bool record_due,
+             esp_err_t* record_result_out,
+             max31865_sample_t* record_sample)
+{
+  sample_filter_value_t filtered = { 0 };
+  bool filtered_ready = false;
+  if (result == ESP_OK && !sample->fault_present) {
+    const sample_filter_value_t input = {
+      .temp_milli_c = sample->temp_milli_c,
+      .resistance_milli_ohm = sample->resistance_milli_ohm,
+    };
+    filtered_ready = SampleFilterPush(&bench->filter, &input, &filtered);
+    if (record_due && !filtered_ready) {
+      SampleFilterRestartBlock(&bench->filter);
+    }
+  } else {
+    SampleFilterReset(&bench->filter);
+    bench->fault_pending = true;
+    bench->fault_result = result;
+    bench->fault_sample = *sample;
+  }
+  if (!record_due) {
+    return false;
+  }
+  if (bench->fault_pending) {
+    bench->fault_pending = false;
+    *record_result_out = bench->fault_result;
+    *record_sample = bench->fault_sample;
+    return true;
+  }
+  if (!filtered_ready) {
+    return false;
+  }
+  *record_result_out = ESP_OK;
+  *record_sample = *sample;
+  record_sample->temp_milli_c = filtered.temp_milli_c;
+  record_sample->resistance_milli_ohm = filtered.resistance_milli_ohm;
+  return true;
+}
+
+static void
+SensorStep(bench_t* bench, esp_err_t result, const max31865_sample_t* sample)
+{
+  const int64_t trace_ms = bench->replay.trace_ms;
+  const int32_t trace_temp = bench->replay.trace_temp_milli_c;
+  bench->samples++;
+  if (result != ESP_OK || sample->fault_present) {
+    bench->faulted++;
+  } else if (trace_temp != INT32_MIN) {
+    ErrorAdd(&bench->sample_error,
+             (int64_t)sample->temp_milli_c - trace_temp);
+  }
+
+  bool record_due = true;
+  if (bench->filter.config.decimation > 1) {
+    bench->decimation_phase =
+      (bench->decimation_phase + 1u) % bench->filter.config.decimation;
+    record_due = bench->decimation_phase == 0;
+  }
+  esp_err_t record_result = ESP_OK;
+  max31865_sample_t record_sample;
+  if (!FilterSample(
+        bench, result, sample, record_due, &record_result, &record_sample)) {
+    return;
+  }
+
+  log_record_t record;
+  memset(&record, 0, sizeof(record));
+  record.timestamp_epoch_sec = trace_ms / 1000;
+  record.timestamp_millis = (int32_t)(trace_ms % 1000);
+  record.flags = LOG_RECORD_FLAG_TIME_VALID;
+  if (bench->options.channel > 0) {
+    record.flags |=
+      (uint16_t)((unsigned)bench->options.channel << LOG_RECORD_CHANNEL_SHIFT);
+  }
+  if (bench->options.calibration.is_valid) {
+    record.flags |= LOG_RECORD_FLAG_CAL_VALID;
+  }
+  if (record_result != ESP_OK || record_sample.fault_present) {
+    record.flags |= LOG_RECORD_FLAG_SENSOR_FAULT;
+  }
+  if (record_result == ESP_OK) {
+    record.raw_temp_milli_c = record_sample.temp_milli_c;
+    record.temp_milli_c = CalibrationFixedEvaluate(
+      &bench->calibration, record_sample.temp_milli_c);
+    record.resistance_milli_ohm = record_sample.resistance_milli_ohm;
+  }
+  bench->records++;
+  if ((record.flags & LOG_RECORD_FLAG_SENSOR_FAULT) == 0 &&
+      trace_temp != INT32_MIN) {
+    ErrorAdd(&bench->record_error,
+             (int64_t)record.raw_temp_milli_c - trace_temp);
+  }
+
+  log_record_t kept[RECORD_COMPRESSION_MAX_OUT];
+  const size_t count =
+    RecordCompressorPush(&bench->compressor, &record, trace_ms, kept);
+  for (size_t i = 0; i < count; ++i) {
+    StoreRecord(bench, &kept[i]);
+  }
+}
+
+// ---------------------------------------------------------------------------
+
+static void
+PrintUsage(const char* argv0)
+{
+  fprintf(stderr,
+          "usage: %s -i TRACE.csv [options]\n"
+          "  -i, --input FILE        trace (a logger CSV, e.g. "
+          "host_tools/2025-12-26.csv)\n"
+          "  -o, --output FILE       write the CSV the logger would store\n"
+          "  -s, --speed N           x real time; 0 = one row per sample, as\n"
+          "                          fast as it runs (default 0)\n"
+          "  -p, --period MS         sample period with --speed > 0 "
+          "(default 1000)\n"
+          "  -C, --channel N         replay channel N's rows (default: all)\n"
+          "  -c, --continuous        auto-convert reads instead of one-shot\n"
+          "  -n, --samples N         stop after N samples (default: whole "
+          "trace)\n"
+          "  -m, --median N          median window, odd (default 1 = off)\n"
+          "  -e, --ema ALPHA         EMA weight 0..1 (default 0 = off)\n"
+          "  -d, --decimate R[:K]    CIC decimation R, order K (default 1)\n"
+          "  -z, --compress M:E[:H]  sdt|deadband, error E mC, heartbeat H s\n"
+          "  -k, --cal C0,C1[,C2,C3] calibration polynomial in degC\n"
+          "  -f, --fram BYTES        FRAM size (default 32768)\n"
+          "  -b, --batch BYTES       SD batch target (default 8192)\n"
+          "  -w, --watermark N       flush watermark, records (default 1024)\n"
+          "  -F, --flush-ms MS       periodic flush, trace time (default "
+          "3600000)\n"
+          "  -v, --verbose           firmware logs at INFO\n",
+          argv0);
+}
+
+static bool
+ParseCompression(const char* text, record_compression_config_t* config)
+{
+  char mode[16] = "";
+  long error = 0;
+  long heartbeat_s = 0;
+  const int fields =
+    sscanf(text, "%15[a-z]:%ld:%ld", mode, &error, &heartbeat_s);
+  if (fields < 2) {
+    return false;
+  }
+  if (strcmp(mode, "sdt") == 0) {
+    config->mode = RECORD_COMPRESSION_SWINGING_DOOR;
+  } else if (strcmp(mode, "deadband") == 0) {
+    config->mode = RECORD_COMPRESSION_DEADBAND;
+  } else {
+    return false;
+  }
+  config->error_milli_c = (int32_t)error;
+  if (fields == 3) {
+    config->heartbeat_ms = (uint32_t)heartbeat_s * 1000u;
+  }
+  return RecordCompressionConfigIsValid(config);
+}
+
+static bool
+ParseCalibration(const char* text, calibration_model_t* model)
+{
+  CalibrationModelInitIdentity(model);
+  model->mode = CAL_FIT_MODE_POLY;
+  char* cursor = (char*)text;
+  int count = 0;
+  while (count < CALIBRATION_MAX_POINTS) {
+    char* end = NULL;
+    model->coefficients[count] = strtod(cursor, &end);
+    if (end == cursor) {
+      return false;
+    }
+    count++;
+    if (*end != ',') {
+      break;
+    }
+    cursor = end + 1;
+  }
+  if (count < 2) {
+    return false;
+  }
+  model->degree = (uint8_t)(count - 1);
+  model->is_valid = true;
+  return true;
+}
+
+static bool
+ParseOptions(int argc, char** argv, bench_options_t* options)
+{
+  static const struct option kLongOptions[] = {
+    { "input", required_argument, NULL, 'i' },
+    { "output", required_argument, NULL, 'o' },
+    { "speed", required_argument, NULL, 's' },
+    { "period", required_argument, NULL, 'p' },
+    { "channel", required_argument, NULL, 'C' },
+    { "continuous", no_argument, NULL, 'c' },
+    { "samples", required_argument, NULL, 'n' },
+    { "median", required_argument, NULL, 'm' },
+    { "ema", required_argument, NULL, 'e' },
+    { "decimate", required_argument, NULL, 'd' },
+    { "compress", required_argument, NULL, 'z' },
+    { "cal", required_argument, NULL, 'k' },
+    { "fram", required_argument, NULL, 'f' },
+    { "batch", required_argument, NULL, 'b' },
+    { "watermark", required_argument, NULL, 'w' },
+    { "flush-ms", required_argument, NULL, 'F' },
+    { "verbose", no_argument, NULL, 'v' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 },
+  };
+
+  *options = (bench_options_t){
+    .speed = 0,
+    .period_ms = 1000,
+    .channel = -1,
+    .fram_bytes = 32768,
+    .batch_bytes = 8192,
+    .watermark_records = 1024,
+    .flush_period_ms = 3600000,
+  };
+  SampleFilterConfigInitDefault(&options->filter);
+  RecordCompressionConfigInitDefault(&options->compression);
+  CalibrationModelInitIdentity(&options->calibration);
+  options->calibration.is_valid = false;
+
+  int option = 0;
+  while ((option = getopt_long(argc,
+                               argv,
+                               "i:o:s:p:C:cn:m:e:d:z:k:f:b:w:F:vh",
+                               kLongOptions,
+                               NULL)) != -1) {
+    switch (option) {
+      case 'i':
+        options->input = optarg;
+        break;
+      case 'o':
+        options->output = optarg;
+        break;
+      case 's':
+        options->speed = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'p':
+        options->period_ms = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'C':
+        options->channel = (int)strtol(optarg, NULL, 0);
+        break;
+      case 'c':
+        options->continuous = true;
+        break;
+      case 'n':
+        options->max_samples = strtoull(optarg, NULL, 0);
+        break;
+      case 'm':
+        options->filter.median_n = (uint8_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'e':
+        options->filter.ema_alpha_q16 =
+          (uint32_t)lround(strtod(optarg, NULL) * SAMPLE_FILTER_EMA_ALPHA_ONE);
+        break;
+      case 'd': {
+        unsigned factor = 1;
+        unsigned order = 1;
+        if (sscanf(optarg, "%u:%u", &factor, &order) < 1) {
+          return false;
+        }
+        options->filter.decimation = (uint8_t)factor;
+        options->filter.cic_order = (uint8_t)order;
+        break;
+      }
+      case 'z':
+        if (!ParseCompression(optarg, &options->compression)) {
+          fprintf(stderr, "--compress expects sdt|deadband:ERR_MC[:HB_S]\n");
+          return false;
+        }
+        break;
+      case 'k':
+        if (!ParseCalibration(optarg, &options->calibration)) {
+          fprintf(stderr, "--cal expects C0,C1[,C2,C3]\n");
+          return false;
+        }
+        break;
+      case 'f':
+        options->fram_bytes = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'b':
+        options->batch_bytes = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'w':
+        options->watermark_records = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'F':
+        options->flush_period_ms = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'v':
+        g_sim_log_level = ESP_LOG_INFO;
+        break;
+      default:
+        return false;
+    }
+  }
+  if (options->input == NULL || options->channel > 15 ||
+      (options->speed > 0 && options->period_ms == 0) ||
+      options->batch_bytes < 256 || options->watermark_records == 0) {
+    return false;
+  }
+  if (!SampleFilterConfigIsValid(&options->filter)) {
+    fprintf(stderr, "invalid filter settings\n");
+    return false;
+  }
+  return true;
+}
+
+static void
+PrintError(const char* label, const error_stats_t* stats)
+{
+  if (stats->count == 0) {
+    printf("%-19s n/a\n", label);
+    return;
+  }
+  printf("%-19s rms=%.1f max=%" PRId64 " mC (n=%" PRIu64 ")\n",
+         label,
+         sqrt(stats->sum_sq / (double)stats->count),
+         stats->max_abs,
+         stats->count);
+}
+
+static void
+PrintCost(const char* label, const cost_stats_t* stats)
+{
+  printf("%-19s avg=%.2f max=%" PRId64 " us (n=%" PRIu64 ")\n",
+         label,
+         (stats->count > 0) ? (double)stats->total_us / stats->count : 0.0,
+         stats->max_us,
+         stats->count);
+}
+
+static void
+PrintReport(const bench_t* bench, double wall_s)
+{
+  const bench_options_t* options = &bench->options;
+  printf("\n== replay_bench: %s, %s, %s\n",
+         options->input,
+         (options->speed == 0) ? "one row per sample" : "timed",
+         Max31865ConversionName(bench->reader.conversion));
+  printf("replay:            rows=%" PRIu32 " conversions=%" PRIu32
+         " faulted_samples=%" PRIu64 "\n",
+         bench->replay.rows,
+         bench->replay.conversions,
+         bench->faulted);
+  printf("samples:           %" PRIu64 " in %.2f s wall (%.0f samples/s)\n",
+         bench->samples,
+         wall_s,
+         (wall_s > 0.0) ? bench->samples / wall_s : 0.0);
+  printf("records:           built=%" PRIu64 " stored=%" PRIu64
+         " (%.1f%% kept, %s)\n",
+         bench->records,
+         bench->stored,
+         (bench->records > 0) ? 100.0 * bench->stored / bench->records : 0.0,
+         RecordCompressionModeToString(options->compression.mode));
+  printf("fram:              capacity=%u high_water=%" PRIu32
+         " overruns=%" PRIu64 "\n",
+         (unsigned)FramLogGetCapacityRecords(&bench->fram_log),
+         bench->fram_high_water,
+         FramLogGetOverrunRecordsTotal(&bench->fram_log));
+  printf("csv:               rows=%" PRIu64 " bytes=%" PRIu64 "%s%s\n",
+         bench->csv_rows,
+         bench->csv_bytes,
+         (options->output != NULL) ? " -> " : "",
+         (options->output != NULL) ? options->output : "");
+  PrintError("conversion error:", &bench->sample_error);
+  PrintError("record error:", &bench->record_error);
+  PrintCost("read:", &bench->read_cost);
+  PrintCost("pipeline:", &bench->pipeline_cost);
+  PrintCost("flush pass:", &bench->batch_cost);
+}
+
+int
+main(int argc, char** argv)
+{
+  bench_t* bench = &g_bench;
+  if (!ParseOptions(argc, argv, &bench->options)) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+  const bench_options_t* options = &bench->options;
+
+  if (Max31865ReaderInit(&bench->reader, SPI2_HOST, 0) != ESP_OK ||
+      Max31865ReplayOpen(&bench->replay,
+                         options->input,
+                         (int8_t)options->channel,
+                         options->speed,
+                         false) != ESP_OK ||
+      Max31865ReaderAttachReplay(&bench->reader, &bench->replay) != ESP_OK) {
+    fprintf(stderr, "cannot replay %s\n", options->input);
+    return 1;
+  }
+  // The trace plays faster than the chip settles.
+  bench->reader.bias_settle_ms =
+    (options->speed == 0) ? 0 : bench->reader.bias_settle_ms / options->speed;
+  if (options->continuous &&
+      Max31865StartContinuous(&bench->reader) != ESP_OK) {
+    fprintf(stderr, "continuous mode failed\n");
+    return 1;
+  }
+  SampleFilterInit(&bench->filter, &options->filter);
+  CalibrationFixedSync(&bench->calibration, &options->calibration, NULL, 0);
+  RecordCompressorInit(&bench->compressor, &options->compression);
+
+  bench->fram = (uint8_t*)calloc(1, options->fram_bytes);
+  bench->batch = (uint8_t*)malloc(options->batch_bytes);
+  if (bench->fram == NULL || bench->batch == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  const fram_io_t io = {
+    .context = bench,
+    .read = &RamFramRead,
+    .write = &RamFramWrite,
+  };
+  if (FramLogInit(&bench->fram_log, io, options->fram_bytes) != ESP_OK) {
+    fprintf(stderr, "FRAM log init failed\n");
+    return 1;
+  }
+  if (options->output != NULL) {
+    bench->output = fopen(options->output, "wb");
+    char header[256];
+    size_t header_len = 0;
+    if (bench->output == NULL ||
+        !CsvFormatHeader(header, sizeof(header), &header_len) ||
+        fwrite(header, 1, header_len, bench->output) != header_len) {
+      fprintf(stderr, "cannot write %s\n", options->output);
+      return 1;
+    }
+  }
+
+  const int64_t start_us = esp_timer_get_time();
+  const int64_t tick_us =
+    (options->speed > 0)
+      ? (int64_t)options->period_ms * 1000 / (int64_t)options->speed
+      : 0;
+  bool first = true;
+  while (options->max_samples == 0 || bench->samples < options->max_samples) {
+    if (tick_us > 0) {
+      const int64_t wait_us =
+        start_us + (int64_t)bench->samples * tick_us - esp_timer_get_time();
+      if (wait_us > 0) {
+        vTaskDelay(pdMS_TO_TICKS((wait_us + 999) / 1000));
+      }
+    }
+    const int64_t read_start_us = esp_timer_get_time();
+    max31865_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+    const esp_err_t result = Max31865ReadOnce(&bench->reader, &sample);
+    const int64_t read_end_us = esp_timer_get_time();
+    if (bench->replay.finished) {
+      break;
+    }
+    CostAdd(&bench->read_cost, read_end_us - read_start_us);
+    if (first) {
+      bench->last_flush_trace_ms = bench->replay.trace_ms;
+      first = false;
+    }
+    SensorStep(bench, result, &sample);
+    CostAdd(&bench->pipeline_cost, esp_timer_get_time() - read_end_us);
+    StorageTick(bench, bench->replay.trace_ms);
+  }
+
+  log_record_t held;
+  if (RecordCompressorFlush(&bench->compressor, &held)) {
+    StoreRecord(bench, &held);
+  }
+  while (FlushPass(bench)) {
+  }
+  const double wall_s = (esp_timer_get_time() - start_us) / 1e6;
+  if (bench->output != NULL) {
+    fclose(bench->output);
+  }
+  (void)Max31865StopContinuous(&bench->reader);
+  Max31865ReplayClose(&bench->replay);
+
+  PrintReport(bench, wall_s);
+  return 0;
+}
@@ -0,0 +1,264 @@
+// Host check of the integer acquisition path: ADC code -> inverse table ->
+// CalibrationFixedEvaluate(), against the double path (Callendar-Van Dusen
+// solve -> CalibrationModelEvaluateWithPoints()). Checks the calibration
+// step alone over the whole sensor range, then the pipeline end to end for
+// every ADC code. Exits non-zero when an error exceeds its limit.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "calibration.h"
+#include "esp_log.h"
+#include "rtd_lut.h"
+
+esp_log_level_t g_sim_log_level = ESP_LOG_NONE;
+
+static const double kCvdA = 3.9083e-3;
+static const double kCvdB = -5.775e-7;
+static const double kCvdC = -4.183e-12;
+static const int32_t kMinMilliC = -200000;
+static const int32_t kMaxMilliC = 850000;
+// Calibration alone: the last-digit rounding of the two paths.
+static const int64_t kMaxCalErrorMilliC = 1;
+// End to end: the inverse table (under 2 milli-°C) plus the calibration.
+static const double kMaxPipelineErrorMilliC = 3.0;
+static const double kMaxResistanceErrorMilliOhm = 1.0;
+
+static double
+CvdRatio(double t)
+{
+  double ratio = 1.0 + kCvdA * t + kCvdB * t * t;
+  if (t < 0.0) {
+    ratio += kCvdC * (t - 100.0) * t * t * t;
+  }
+  return ratio;
+}
+
+static double
+CvdTemperature(double ratio)
+{
+  double low = -260.0;
+  double high = 900.0;
+  for (int i = 0; i < 100; ++i) {
+    const double mid = (low + high) / 2.0;
+    if (CvdRatio(mid) < ratio) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return (low + high) / 2.0;
+}
+
+static double
+NowSeconds(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+typedef struct
+{
+  const char* name;
+  calibration_model_t model;
+  calibration_point_t points[CALIBRATION_MAX_POINTS];
+  size_t points_count;
+} cal_case_t;
+
+static const cal_case_t kCalCases[] = {
+  { "identity", { CAL_FIT_MODE_LINEAR, 1, { 0.0, 1.0 }, false }, { { 0 } }, 0 },
+  { "offset", { CAL_FIT_MODE_LINEAR, 1, { 0.35, 1.0 }, true }, { { 0 } }, 0 },
+  { "linear",
+    { CAL_FIT_MODE_LINEAR, 1, { -0.412, 1.0021 }, true },
+    { { 0 } },
+    0 },
+  { "poly2",
+    { CAL_FIT_MODE_POLY, 2, { -0.2, 0.998, 3.1e-6 }, true },
+    { { 0 } },
+    0 },
+  { "poly3",
+    { CAL_FIT_MODE_POLY, 3, { 0.1, 1.001, -2.3e-6, 1.7e-9 }, true },
+    { { 0 } },
+    0 },
+  { "piecewise",
+    { CAL_FIT_MODE_PIECEWISE, 1, { 0.0, 1.0 }, true },
+    { { .raw_avg_mC = -38000, .actual_mC = -37650 },
+      { .raw_avg_mC = 100120, .actual_mC = 100000 },
+      { .raw_avg_mC = 231500, .actual_mC = 231770 } },
+    3 },
+};
+
+static int32_t
+DoubleCalMilliC(const cal_case_t* cal, double raw_c)
+{
+  return (int32_t)llround(CalibrationModelEvaluateWithPoints(
+                            &cal->model, raw_c, cal->points, cal->points_count) *
+                          1000.0);
+}
+
+static bool
+CheckCalibration(const cal_case_t* cal)
+{
+  calibration_fixed_t fixed = { 0 };
+  CalibrationFixedSync(&fixed, &cal->model, cal->points, cal->points_count);
+  int64_t max_error = 0;
+  int32_t worst_milli_c = 0;
+  for (int32_t raw = kMinMilliC; raw <= kMaxMilliC; raw += 7) {
+    const int64_t error =
+      llabs((int64_t)CalibrationFixedEvaluate(&fixed, raw) -
+            DoubleCalMilliC(cal, raw / 1000.0));
+    if (error > max_error) {
+      max_error = error;
+      worst_milli_c = raw;
+    }
+  }
+  const bool ok = max_error <= kMaxCalErrorMilliC;
+  printf("cal %-9s %-7s max_err=%lld m°C (at %.3f °C)  %s\n",
+         cal->name,
+         fixed.integer ? "integer" : "double",
+         (long long)max_error,
+         worst_milli_c / 1000.0,
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+
+static int32_t
+ClampMilliC(int32_t milli_c)
+{
+  return (milli_c < kMinMilliC)   ? kMinMilliC
+         : (milli_c > kMaxMilliC) ? kMaxMilliC
+                                  : milli_c;
+}
+
+// What the firmware does per sample with the inverse-table conversion.
+typedef struct
+{
+  uint64_t code_scale;
+  int64_t rref_milli_ohm;
+  calibration_fixed_t calibration;
+} fixed_pipeline_t;
+
+static void
+FixedPipelineRun(const fixed_pipeline_t* pipeline,
+                 uint16_t code,
+                 int32_t* resistance_milli_ohm_out,
+                 int32_t* temp_milli_c_out)
+{
+  *resistance_milli_ohm_out =
+    (int32_t)(((int64_t)code * pipeline->rref_milli_ohm + (1 << 14)) >> 15);
+  *temp_milli_c_out = CalibrationFixedEvaluate(
+    &pipeline->calibration,
+    ClampMilliC(RtdLutCodeToMilliC(code, pipeline->code_scale)));
+}
+
+static bool
+CheckPipeline(const cal_case_t* cal, double r0_ohm, double rref_ohm)
+{
+  fixed_pipeline_t pipeline = {
+    .code_scale = RtdLutCodeScale(rref_ohm, r0_ohm),
+    .rref_milli_ohm = llround(rref_ohm * 1000.0),
+  };
+  CalibrationFixedSync(
+    &pipeline.calibration, &cal->model, cal->points, cal->points_count);
+
+  double max_temp_error = 0.0;
+  double max_resistance_error = 0.0;
+  for (uint32_t code = 0; code < 32768u; ++code) {
+    const double resistance = (double)code * rref_ohm / 32768.0;
+    const double ratio = resistance / r0_ohm;
+    if (ratio < CvdRatio(kMinMilliC / 1000.0) ||
+        ratio > CvdRatio(kMaxMilliC / 1000.0)) {
+      continue;
+    }
+    int32_t resistance_milli_ohm = 0;
+    int32_t temp_milli_c = 0;
+    FixedPipelineRun(
+      &pipeline, (uint16_t)code, &resistance_milli_ohm, &temp_milli_c);
+    const double reference =
+      CalibrationModelEvaluateWithPoints(&cal->model,
+                                         CvdTemperature(ratio),
+                                         cal->points,
+                                         cal->points_count) *
+      1000.0;
+    const double temp_error = fabs(temp_milli_c - reference);
+    const double resistance_error =
+      fabs(resistance_milli_ohm - resistance * 1000.0);
+    if (temp_error > max_temp_error) {
+      max_temp_error = temp_error;
+    }
+    if (resistance_error > max_resistance_error) {
+      max_resistance_error = resistance_error;
+    }
+  }
+  const bool ok = max_temp_error <= kMaxPipelineErrorMilliC &&
+                  max_resistance_error <= kMaxResistanceErrorMilliOhm;
+  printf("pipeline %-9s R0=%6.1f Rref=%7.1f  max_err=%.3f m°C  "
+         "%.3f mΩ  %s\n",
+         cal->name,
+         r0_ohm,
+         rref_ohm,
+         max_temp_error,
+         max_resistance_error,
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// Rough cost per sample on this host, integer pipeline against double.
+static void
+ReportTiming(const cal_case_t* cal)
+{
+  fixed_pipeline_t pipeline = {
+    .code_scale = RtdLutCodeScale(430.0, 100.0),
+    .rref_milli_ohm = 430000,
+  };
+  CalibrationFixedSync(
+    &pipeline.calibration, &cal->model, cal->points, cal->points_count);
+  const int rounds = 200;
+  volatile int64_t sink = 0;
+
+  double start = NowSeconds();
+  for (int round = 0; round < rounds; ++round) {
+    for (uint32_t code = 1000; code < 31000u; ++code) {
+      int32_t resistance_milli_ohm = 0;
+      int32_t temp_milli_c = 0;
+      FixedPipelineRun(
+        &pipeline, (uint16_t)code, &resistance_milli_ohm, &temp_milli_c);
+      sink += resistance_milli_ohm + temp_milli_c;
+    }
+  }
+  const double fixed_ns = (NowSeconds() - start) * 1e9 / (rounds * 30000.0);
+
+  start = NowSeconds();
+  for (uint32_t code = 1000; code < 31000u; ++code) {
+    const double resistance = code * 430.0 / 32768.0;
+    sink += llround(resistance * 1000.0);
+    sink += DoubleCalMilliC(cal, CvdTemperature(resistance / 100.0));
+  }
+  const double double_ns = (NowSeconds() - start) * 1e9 / 30000.0;
+  (void)sink;
+  printf("host time per sample (%s): integer %.1f ns, double %.1f ns\n",
+         cal->name,
+         fixed_ns,
+         double_ns);
+}
+
+int
+main(void)
+{
+  const size_t num_cases = sizeof(kCalCases) / sizeof(kCalCases[0]);
+  bool ok = true;
+  for (size_t i = 0; i < num_cases; ++i) {
+    ok = CheckCalibration(&kCalCases[i]) && ok;
+  }
+  for (size_t i = 0; i < num_cases; ++i) {
+    ok = CheckPipeline(&kCalCases[i], 100.0, 430.0) && ok;
+  }
+  ok = CheckPipeline(&kCalCases[4], 1000.0, 4300.0) && ok;
+  ReportTiming(&kCalCases[4]);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
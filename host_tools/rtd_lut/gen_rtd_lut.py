@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Generate kRtdLutMilliC, the inverse RTD table behind the INVERSE_LUT
+conversion (main/rtd_lut.h).
+
+The grid comes from the RTD_LUT_* macros in main/rtd_lut.h: entry i is the
+temperature at R/R0 = (RTD_LUT_FIRST_STEP + i) / 2^RTD_LUT_STEP_SHIFT,
+solved from the IEC 60751 Callendar-Van Dusen equation. Working in R/R0
+keeps the table independent of the RTD (PT100/PT500/PT1000) and of Rref.
+
+Run by the firmware and host builds:
+  gen_rtd_lut.py --header main/rtd_lut.h --out <build>/rtd_lut_table.c
+"""
+
+from __future__ import annotations
+
+import argparse
+import re
+import sys
+from pathlib import Path
+from typing import Dict, List
+
+CVD_A = 3.9083e-3
+CVD_B = -5.775e-7
+CVD_C = -4.183e-12
+
+
+def cvd_ratio(t: float) -> float:
+    """R/R0 at t °C."""
+    ratio = 1.0 + CVD_A * t + CVD_B * t * t
+    if t < 0.0:
+        ratio += CVD_C * (t - 100.0) * t ** 3
+    return ratio
+
+
+def cvd_temperature(ratio: float) -> float:
+    """Inverse of cvd_ratio by bisection; R/R0 is monotonic over the range."""
+    low, high = -260.0, 900.0
+    for _ in range(100):
+        mid = (low + high) / 2.0
+        if cvd_ratio(mid) < ratio:
+            low = mid
+        else:
+            high = mid
+    return (low + high) / 2.0
+
+
+def read_grid(header: Path) -> Dict[str, int]:
+    text = header.read_text(encoding="utf-8")
+    grid = {
+        name: int(value)
+        for name, value in re.findall(r"#define RTD_LUT_(\w+) (\d+)", text)
+    }
+    for name in ("STEP_SHIFT", "FIRST_STEP", "LENGTH"):
+        if name not in grid:
+            raise ValueError(f"{header}: RTD_LUT_{name} not found")
+    return grid
+
+
+def build_table(grid: Dict[str, int]) -> List[int]:
+    scale = float(1 << grid["STEP_SHIFT"])
+    return [
+        round(cvd_temperature((grid["FIRST_STEP"] + i) / scale) * 1000.0)
+        for i in range(grid["LENGTH"])
+    ]
+
+
+def render(table: List[int], header: Path) -> str:
+    lines = [
+        "// Generated by host_tools/rtd_lut/gen_rtd_lut.py from "
+        f"{header.name}; do not edit.",
+        '#include "rtd_lut.h"',
+        "",
+        "const int32_t kRtdLutMilliC[RTD_LUT_LENGTH] = {",
+    ]
+    for start in range(0, len(table), 8):
+        row = ", ".join(f"{value:7d}" for value in table[start : start + 8])
+        lines.append(f"  {row},")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--header", type=Path, required=True, help="main/rtd_lut.h")
+    parser.add_argument("--out", type=Path, required=True, help="C file to write")
+    args = parser.parse_args()
+
+    try:
+        grid = read_grid(args.header)
+    except (OSError, ValueError) as exc:
+        print(exc, file=sys.stderr)
+        return 1
+    table = build_table(grid)
+    if any(b <= a for a, b in zip(table, table[1:])):
+        print("table is not strictly increasing", file=sys.stderr)
+        return 1
+    text = render(table, args.header)
+    # Leave an unchanged file alone so the build does not recompile it.
+    if not args.out.exists() or args.out.read_text(encoding="utf-8") != text:
+        args.out.parent.mkdir(parents=True, exist_ok=True)
+        args.out.write_text(text, encoding="utf-8")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,144 @@
+// Host check of the inverse RTD table: converts every 15-bit ADC code in
+// range with RtdLutCodeToMilliC() and compares it with a double-precision
+// Callendar-Van Dusen solve, for PT100/PT500/PT1000 and common Rref values.
+// Exits non-zero when the error exceeds the limit.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "rtd_lut.h"
+
+static const double kCvdA = 3.9083e-3;
+static const double kCvdB = -5.775e-7;
+static const double kCvdC = -4.183e-12;
+static const double kMinC = -200.0;
+static const double kMaxC = 850.0;
+// Far below one ADC code (about 33 milli-°C on a PT100 with 430 Ω Rref).
+static const double kMaxErrorMilliC = 2.0;
+
+static double
+CvdRatio(double t)
+{
+  double ratio = 1.0 + kCvdA * t + kCvdB * t * t;
+  if (t < 0.0) {
+    ratio += kCvdC * (t - 100.0) * t * t * t;
+  }
+  return ratio;
+}
+
+static double
+CvdTemperature(double ratio)
+{
+  double low = -260.0;
+  double high = 900.0;
+  for (int i = 0; i < 100; ++i) {
+    const double mid = (low + high) / 2.0;
+    if (CvdRatio(mid) < ratio) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return (low + high) / 2.0;
+}
+
+static double
+NowSeconds(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+typedef struct
+{
+  const char* name;
+  double r0_ohm;
+  double rref_ohm;
+} rtd_case_t;
+
+static bool
+CheckCase(const rtd_case_t* rtd)
+{
+  const uint64_t scale = RtdLutCodeScale(rtd->rref_ohm, rtd->r0_ohm);
+  double max_error = 0.0;
+  double sum_error = 0.0;
+  double worst_c = 0.0;
+  unsigned codes = 0;
+  for (uint32_t code = 0; code < 32768u; ++code) {
+    const double ratio = (double)code * rtd->rref_ohm / 32768.0 / rtd->r0_ohm;
+    if (ratio < CvdRatio(kMinC) || ratio > CvdRatio(kMaxC)) {
+      continue;
+    }
+    const double reference = CvdTemperature(ratio) * 1000.0;
+    const double error =
+      fabs((double)RtdLutCodeToMilliC((uint16_t)code, scale) - reference);
+    sum_error += error;
+    codes++;
+    if (error > max_error) {
+      max_error = error;
+      worst_c = reference / 1000.0;
+    }
+  }
+  const bool ok = codes > 0 && max_error <= kMaxErrorMilliC;
+  printf("%-7s Rref=%7.1f  codes=%5u  max_err=%.3f m°C (at %.1f °C)  "
+         "mean_err=%.3f m°C  %s\n",
+         rtd->name,
+         rtd->rref_ohm,
+         codes,
+         max_error,
+         worst_c,
+         codes > 0 ? sum_error / codes : 0.0,
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// Rough cost per conversion on this host, LUT against the CVD solve.
+static void
+ReportTiming(void)
+{
+  const uint64_t scale = RtdLutCodeScale(430.0, 100.0);
+  const int rounds = 200;
+  volatile int64_t sink = 0;
+
+  double start = NowSeconds();
+  for (int round = 0; round < rounds; ++round) {
+    for (uint32_t code = 1000; code < 31000u; ++code) {
+      sink += RtdLutCodeToMilliC((uint16_t)code, scale);
+    }
+  }
+  const double lut_ns = (NowSeconds() - start) * 1e9 / (rounds * 30000.0);
+
+  start = NowSeconds();
+  for (uint32_t code = 1000; code < 31000u; ++code) {
+    sink += (int64_t)CvdTemperature(code * 430.0 / 32768.0 / 100.0);
+  }
+  const double cvd_ns = (NowSeconds() - start) * 1e9 / 30000.0;
+  (void)sink;
+  printf("host time per conversion: lut %.1f ns, cvd bisection %.1f ns\n",
+         lut_ns,
+         cvd_ns);
+}
+
+int
+main(void)
+{
+  static const rtd_case_t kCases[] = {
+    { "PT100", 100.0, 430.0 },   { "PT100", 100.0, 400.0 },
+    { "PT500", 500.0, 2000.0 },  { "PT500", 500.0, 2150.0 },
+    { "PT1000", 1000.0, 4000.0 }, { "PT1000", 1000.0, 4300.0 },
+  };
+  printf("inverse table: %d entries, step R0/%d\n",
+         RTD_LUT_LENGTH,
+         1 << RTD_LUT_STEP_SHIFT);
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(kCases) / sizeof(kCases[0]); ++i) {
+    ok = CheckCase(&kCases[i]) && ok;
+  }
+  ReportTiming();
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+TCP collector for the root uplink (CONFIG_APP_UPLINK_ENABLE); stores records
+in the same SQLite table as mesh_ingest.py.
+
+Handshake (text lines):
+  root      -> collector: PT100-UPLINK <version> <root MAC> binary|csv
+  collector -> root:      RESUME <node MAC> <next record_id>   (per known node)
+  collector -> root:      READY
+after which the root streams export frames (see export_decoder.py) or CSV
+rows. The next record_id per node is the highest stored record_id + 1 and
+is updated in the same transaction as the samples, so a reconnecting root
+skips what is already stored and replays the rest of its window.
+"""
+
+from __future__ import annotations
+
+import argparse
+import socketserver
+import sqlite3
+import sys
+import threading
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+
+from export_decoder import ExportDecoder
+from mesh_ingest import init_db, insert_samples
+
+
+PROTOCOL_VERSION = 1
+
+RESUME_SQL = """
+CREATE TABLE IF NOT EXISTS uplink_resume (
+  node_id TEXT PRIMARY KEY,
+  next_record_id INTEGER NOT NULL
+);
+"""
+
+UPSERT_RESUME_SQL = (
+    "INSERT INTO uplink_resume(node_id, next_record_id) VALUES(?, ?) "
+    "ON CONFLICT(node_id) DO UPDATE SET "
+    "next_record_id = MAX(next_record_id, excluded.next_record_id)"
+)
+
+
+def open_db(db_path: Path) -> sqlite3.Connection:
+    connection = init_db(db_path)
+    connection.executescript(RESUME_SQL)
+    connection.commit()
+    return connection
+
+
+def parse_csv_row(line: str) -> Optional[Dict[str, Any]]:
+    # schema_ver,record_id,seq,epoch_utc,iso8601_local,raw_rtd_ohms,
+    # raw_temp_c,cal_temp_c,flags,node_id
+    fields = line.strip().split(",")
+    if len(fields) != 10 or not fields[0].isdigit():
+        return None  # header or damaged row
+    return {
+        "type": "temp",
+        "record_id": int(fields[1]),
+        "seq": int(fields[2]),
+        "ts": int(fields[3]),
+        "r_ohm": float(fields[5]),
+        "raw_c": float(fields[6]),
+        "temp_c": float(fields[7]),
+        "flags": int(fields[8], 16),
+        "node": fields[9],
+    }
+
+
+class UplinkHandler(socketserver.StreamRequestHandler):
+    def handle(self) -> None:
+        server: UplinkServer = self.server  # type: ignore[assignment]
+        peer = f"{self.client_address[0]}:{self.client_address[1]}"
+        hello = self.rfile.readline(128).decode("ascii", errors="replace").split()
+        if len(hello) != 4 or hello[0] != "PT100-UPLINK" or int(hello[1]) != PROTOCOL_VERSION:
+            print(f"{peer}: bad hello {hello}", file=sys.stderr)
+            return
+        root, stream_format = hello[2], hello[3]
+
+        connection = open_db(server.db_path)
+        resume = [] if server.no_resume else connection.execute(
+            "SELECT node_id, next_record_id FROM uplink_resume"
+        ).fetchall()
+        lines = [f"RESUME {node} {next_id}\n" for node, next_id in resume]
+        self.wfile.write(("".join(lines) + "READY\n").encode("ascii"))
+        self.wfile.flush()
+        print(f"{peer}: root {root} ({stream_format}), {len(resume)} RESUME entries")
+
+        stored = 0
+        decoder = ExportDecoder() if stream_format == "binary" else None
+        try:
+            while True:
+                if decoder is not None:
+                    data = self.request.recv(65536)
+                    if not data:
+                        break
+                    samples = decoder.feed(data)
+                else:
+                    line = self.rfile.readline()
+                    if not line:
+                        break
+                    sample = parse_csv_row(line.decode("utf-8", errors="replace"))
+                    samples = [sample] if sample is not None else []
+                stored += self.store(connection, samples)
+        except ConnectionError as exc:
+            print(f"{peer}: {exc}", file=sys.stderr)
+        finally:
+            connection.close()
+        stats = f" {decoder.stats}" if decoder is not None else ""
+        print(f"{peer}: closed, {stored} records stored{stats}")
+
+    def store(self, connection: sqlite3.Connection, samples: List[Dict[str, Any]]) -> int:
+        if not samples:
+            return 0
+        server: UplinkServer = self.server  # type: ignore[assignment]
+        next_ids: Dict[str, int] = {}
+        for sample in samples:
+            node = sample["node"]
+            next_ids[node] = max(next_ids.get(node, 0), sample["record_id"] + 1)
+        with server.db_lock:
+            insert_samples(connection, samples, commit=False)
+            connection.executemany(UPSERT_RESUME_SQL, next_ids.items())
+            connection.commit()
+        if server.echo:
+            for sample in samples:
+                print(sample)
+        return len(samples)
+
+
+class UplinkServer(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+    def __init__(self, address, db_path: Path, echo: bool, no_resume: bool) -> None:
+        super().__init__(address, UplinkHandler)
+        self.db_path = db_path
+        self.echo = echo
+        self.no_resume = no_resume
+        self.db_lock = threading.Lock()
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0", help="Listen address")
+    parser.add_argument("--port", type=int, default=5140)
+    parser.add_argument("--db", type=Path, default=Path("pt100_mesh.sqlite3"))
+    parser.add_argument("--echo", action="store_true", help="Print stored samples to stdout")
+    parser.add_argument(
+        "--no-resume", action="store_true", help="Send no RESUME lines (root replays its whole window)"
+    )
+    args = parser.parse_args()
+
+    open_db(args.db).close()
+    with UplinkServer((args.host, args.port), args.db, args.echo, args.no_resume) as server:
+        print(f"Listening on {args.host}:{args.port}. DB={args.db}")
+        try:
+            server.serve_forever()
+        except KeyboardInterrupt:
+            pass
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
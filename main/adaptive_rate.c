@@ -0,0 +1,164 @@
+#include "adaptive_rate.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+void
+AdaptiveRateConfigInitDefault(adaptive_rate_config_t* config)
+{
+  if (config == NULL) {
+    return;
+  }
+  memset(config, 0, sizeof(*config));
+  config->enabled = false;
+  config->fast_period_ms = 1000;
+  config->rise_milli_c_per_min = 500;
+  config->dwell_ms = 2u * 60u * 1000u;
+}
+
+bool
+AdaptiveRateConfigIsValid(const adaptive_rate_config_t* config)
+{
+  if (config == NULL) {
+    return false;
+  }
+  return !config->enabled ||
+         (config->fast_period_ms > 0 && config->rise_milli_c_per_min > 0);
+}
+
+void
+AdaptiveRateInit(adaptive_rate_t* rate)
+{
+  if (rate == NULL) {
+    return;
+  }
+  memset(rate, 0, sizeof(*rate));
+}
+
+static const adaptive_rate_point_t*
+Newest(const adaptive_rate_t* rate)
+{
+  const uint8_t index =
+    (uint8_t)((rate->history_next + ADAPTIVE_RATE_HISTORY - 1u) %
+              ADAPTIVE_RATE_HISTORY);
+  return &rate->history[index];
+}
+
+// Least-squares line through the history; times relative to the newest
+// point keep the sums small. Sets the slope and noise, and the standard
+// error of the slope in milli-°C per minute.
+static void
+Fit(adaptive_rate_t* rate, double* slope_error)
+{
+  *slope_error = 0.0;
+  const uint8_t count = rate->history_count;
+  if (count < 3) {
+    rate->slope_milli_c_per_min = 0;
+    rate->noise_milli_c = 0;
+    return;
+  }
+  const adaptive_rate_point_t* newest = Newest(rate);
+  double sum_t = 0.0;
+  double sum_v = 0.0;
+  for (uint8_t i = 0; i < count; ++i) {
+    sum_t += (double)(rate->history[i].mono_ms - newest->mono_ms);
+    sum_v += (double)(rate->history[i].milli_c - newest->milli_c);
+  }
+  const double mean_t = sum_t / count;
+  const double mean_v = sum_v / count;
+  double sxx = 0.0;
+  double sxy = 0.0;
+  for (uint8_t i = 0; i < count; ++i) {
+    const double t =
+      (double)(rate->history[i].mono_ms - newest->mono_ms) - mean_t;
+    const double v =
+      (double)(rate->history[i].milli_c - newest->milli_c) - mean_v;
+    sxx += t * t;
+    sxy += t * v;
+  }
+  if (sxx <= 0.0) {
+    rate->slope_milli_c_per_min = 0;
+    rate->noise_milli_c = 0;
+    return;
+  }
+  const double slope = sxy / sxx; // milli-°C per ms
+  double residual = 0.0;
+  for (uint8_t i = 0; i < count; ++i) {
+    const double t =
+      (double)(rate->history[i].mono_ms - newest->mono_ms) - mean_t;
+    const double v =
+      (double)(rate->history[i].milli_c - newest->milli_c) - mean_v;
+    const double r = v - slope * t;
+    residual += r * r;
+  }
+  const double noise = sqrt(residual / (count - 2));
+  const double per_min = slope * 60000.0;
+  rate->slope_milli_c_per_min =
+    (int32_t)((per_min > INT32_MAX)   ? INT32_MAX
+              : (per_min < -INT32_MAX) ? -INT32_MAX
+                                       : lround(per_min));
+  rate->noise_milli_c =
+    (int32_t)((noise > INT32_MAX) ? INT32_MAX : lround(noise));
+  *slope_error = noise / sqrt(sxx) * 60000.0;
+}
+
+bool
+AdaptiveRateUpdate(adaptive_rate_t* rate,
+                   const adaptive_rate_config_t* config,
+                   int32_t milli_c,
+                   bool valid,
+                   int64_t mono_ms,
+                   uint32_t slow_period_ms)
+{
+  if (rate == NULL || config == NULL || !config->enabled) {
+    return false;
+  }
+  if (!valid) {
+    rate->history_count = 0;
+    rate->history_next = 0;
+    rate->calm_since_ms = mono_ms;
+    return rate->fast;
+  }
+
+  // A jump against the noise of the records before it.
+  bool step = false;
+  if (rate->history_count > 0) {
+    const int64_t delta = (int64_t)milli_c - Newest(rate)->milli_c;
+    const int64_t magnitude = (delta < 0) ? -delta : delta;
+    const int64_t threshold =
+      (int64_t)config->rise_milli_c_per_min * slow_period_ms / 60000;
+    step = magnitude > threshold &&
+           magnitude > 4 * (int64_t)rate->noise_milli_c;
+  }
+
+  rate->history[rate->history_next].mono_ms = mono_ms;
+  rate->history[rate->history_next].milli_c = milli_c;
+  rate->history_next =
+    (uint8_t)((rate->history_next + 1u) % ADAPTIVE_RATE_HISTORY);
+  if (rate->history_count < ADAPTIVE_RATE_HISTORY) {
+    rate->history_count++;
+  }
+  double slope_error = 0.0;
+  Fit(rate, &slope_error);
+
+  const double slope = (rate->slope_milli_c_per_min < 0)
+                         ? -(double)rate->slope_milli_c_per_min
+                         : (double)rate->slope_milli_c_per_min;
+  if (!rate->fast) {
+    const bool ramp = rate->history_count >= 4 &&
+                      slope - 2.0 * slope_error >=
+                        (double)config->rise_milli_c_per_min;
+    if (ramp || step) {
+      rate->fast = true;
+      rate->calm_since_ms = mono_ms;
+      rate->to_fast++;
+    }
+  } else if (step || slope * 2.0 >= (double)config->rise_milli_c_per_min) {
+    rate->calm_since_ms = mono_ms;
+  } else if (mono_ms - rate->calm_since_ms >= (int64_t)config->dwell_ms) {
+    rate->fast = false;
+    rate->to_slow++;
+  }
+  return rate->fast;
+}
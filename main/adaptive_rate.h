@@ -0,0 +1,73 @@
+#ifndef PT100_LOGGER_ADAPTIVE_RATE_H_
+#define PT100_LOGGER_ADAPTIVE_RATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Picks the sampling period from how fast the temperature moves: the log
+// period while it is steady, fast_period_ms through ramps and steps. One
+// tracker per RTD channel, fed with each record's temperature; the sensor
+// task samples fast while any channel asks for it.
+//
+// The slope is a least-squares fit over the last ADAPTIVE_RATE_HISTORY
+// records and the noise is the RMS residual of that fit. It goes fast when
+// the slope exceeds rise_milli_c_per_min by more than twice its own
+// standard error, or when one record jumps by what that rate would cover
+// in a slow period (and by more than four times the noise). It goes back
+// to slow once the slope stays under half the rise rate for dwell_ms.
+
+#define ADAPTIVE_RATE_HISTORY 16
+
+  typedef struct
+  {
+    bool enabled;
+    uint32_t fast_period_ms;
+    int32_t rise_milli_c_per_min;
+    uint32_t dwell_ms;
+  } adaptive_rate_config_t;
+
+  typedef struct
+  {
+    int64_t mono_ms;
+    int32_t milli_c;
+  } adaptive_rate_point_t;
+
+  typedef struct
+  {
+    adaptive_rate_point_t history[ADAPTIVE_RATE_HISTORY];
+    uint8_t history_count;
+    uint8_t history_next;
+    bool fast;
+    int64_t calm_since_ms; // slope under the fall rate since (fast only)
+    int32_t slope_milli_c_per_min;
+    int32_t noise_milli_c;
+    uint32_t to_fast;
+    uint32_t to_slow;
+  } adaptive_rate_t;
+
+  void AdaptiveRateConfigInitDefault(adaptive_rate_config_t* config);
+
+  bool AdaptiveRateConfigIsValid(const adaptive_rate_config_t* config);
+
+  void AdaptiveRateInit(adaptive_rate_t* rate);
+
+  // Feeds one record. Invalid readings (faults) drop the history but keep
+  // the current rate. slow_period_ms is the log period. Returns whether the
+  // channel wants the fast period.
+  bool AdaptiveRateUpdate(adaptive_rate_t* rate,
+                          const adaptive_rate_config_t* config,
+                          int32_t milli_c,
+                          bool valid,
+                          int64_t mono_ms,
+                          uint32_t slow_period_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_ADAPTIVE_RATE_H_
@@ -0,0 +1,186 @@
+#include "alarm.h"
+
+#include <string.h>
+
+void
+AlarmStateInit(alarm_state_t* state, uint8_t channel)
+{
+  if (state != NULL) {
+    memset(state, 0, sizeof(*state));
+    state->channel = channel;
+  }
+}
+
+static bool
+IsActive(const alarm_state_t* state, uint8_t kind)
+{
+  return (state->active & (1u << kind)) != 0;
+}
+
+typedef struct
+{
+  alarm_event_t* events;
+  size_t max_events;
+  size_t count;
+  int64_t epoch_ms;
+} alarm_output_t;
+
+static void
+Emit(alarm_state_t* state,
+     alarm_output_t* out,
+     uint8_t kind,
+     bool active,
+     int32_t value,
+     int32_t limit)
+{
+  if (out->count >= out->max_events) {
+    return; // state stays as it was; the next sample retries
+  }
+  if (active) {
+    state->active |= (uint8_t)(1u << kind);
+  } else {
+    state->active &= (uint8_t)~(1u << kind);
+  }
+  alarm_event_t* event = &out->events[out->count++];
+  event->epoch_ms = out->epoch_ms;
+  event->value = value;
+  event->limit = limit;
+  event->sequence = state->sequence++;
+  event->kind = kind;
+  event->active = active ? 1u : 0u;
+  event->channel = state->channel;
+}
+
+// Keeps one point per window / ALARM_RATE_HISTORY so the history spans the
+// window whatever the sample period. Returns false until it covers half the
+// window.
+static bool
+RateSlope(alarm_state_t* state,
+          const alarm_rules_t* rules,
+          int32_t milli_c,
+          int64_t mono_ms,
+          int32_t* slope_out)
+{
+  const int64_t spacing_ms = rules->rate_window_ms / ALARM_RATE_HISTORY;
+  const uint8_t newest =
+    (uint8_t)((state->history_next + ALARM_RATE_HISTORY - 1u) %
+              ALARM_RATE_HISTORY);
+  if (state->history_count == 0 ||
+      mono_ms - state->history[newest].mono_ms >= spacing_ms) {
+    state->history[state->history_next] =
+      (alarm_rate_point_t){ .mono_ms = mono_ms, .milli_c = milli_c };
+    state->history_next =
+      (uint8_t)((state->history_next + 1u) % ALARM_RATE_HISTORY);
+    if (state->history_count < ALARM_RATE_HISTORY) {
+      state->history_count++;
+    }
+  }
+
+  // Oldest point still inside the window.
+  const uint8_t oldest_slot =
+    (uint8_t)((state->history_next + ALARM_RATE_HISTORY -
+               state->history_count) %
+              ALARM_RATE_HISTORY);
+  const alarm_rate_point_t* reference = NULL;
+  for (uint8_t i = 0; i < state->history_count; ++i) {
+    const alarm_rate_point_t* point =
+      &state->history[(oldest_slot + i) % ALARM_RATE_HISTORY];
+    if (mono_ms - point->mono_ms <= (int64_t)rules->rate_window_ms) {
+      reference = point;
+      break;
+    }
+  }
+  if (reference == NULL) {
+    return false;
+  }
+  const int64_t span_ms = mono_ms - reference->mono_ms;
+  if (span_ms <= 0 || span_ms * 2 < (int64_t)rules->rate_window_ms) {
+    return false;
+  }
+  *slope_out =
+    (int32_t)(((int64_t)milli_c - reference->milli_c) * 60000 / span_ms);
+  return true;
+}
+
+size_t
+AlarmEvaluate(alarm_state_t* state,
+              const alarm_rules_t* rules,
+              int32_t milli_c,
+              bool valid,
+              int64_t mono_ms,
+              int64_t epoch_ms,
+              alarm_event_t* events_out,
+              size_t max_events)
+{
+  if (state == NULL || rules == NULL || events_out == NULL) {
+    return 0;
+  }
+  alarm_output_t out = {
+    .events = events_out,
+    .max_events = max_events,
+    .count = 0,
+    .epoch_ms = epoch_ms,
+  };
+
+  if (rules->fault_enabled &&
+      IsActive(state, ALARM_KIND_SENSOR_FAULT) == valid) {
+    Emit(state, &out, ALARM_KIND_SENSOR_FAULT, !valid, state->last_milli_c, 0);
+  }
+  if (!valid) {
+    // Thresholds hold their state; the slope restarts after the fault.
+    state->history_count = 0;
+    return out.count;
+  }
+  state->last_milli_c = milli_c;
+
+  const int32_t hysteresis =
+    (rules->hysteresis_milli_c > 0) ? rules->hysteresis_milli_c : 0;
+  if (rules->high_enabled) {
+    const bool raised = IsActive(state, ALARM_KIND_HIGH);
+    if (!raised && milli_c >= rules->high_milli_c) {
+      Emit(state, &out, ALARM_KIND_HIGH, true, milli_c, rules->high_milli_c);
+    } else if (raised && milli_c < rules->high_milli_c - hysteresis) {
+      Emit(state, &out, ALARM_KIND_HIGH, false, milli_c, rules->high_milli_c);
+    }
+  }
+  if (rules->low_enabled) {
+    const bool raised = IsActive(state, ALARM_KIND_LOW);
+    if (!raised && milli_c <= rules->low_milli_c) {
+      Emit(state, &out, ALARM_KIND_LOW, true, milli_c, rules->low_milli_c);
+    } else if (raised && milli_c > rules->low_milli_c + hysteresis) {
+      Emit(state, &out, ALARM_KIND_LOW, false, milli_c, rules->low_milli_c);
+    }
+  }
+
+  int32_t slope = 0;
+  if (rules->rate_milli_c_per_min > 0 && rules->rate_window_ms > 0 &&
+      RateSlope(state, rules, milli_c, mono_ms, &slope)) {
+    const int32_t limit = rules->rate_milli_c_per_min;
+    const int32_t magnitude = (slope < 0) ? -slope : slope;
+    const bool raised = IsActive(state, ALARM_KIND_RATE);
+    // Clears at three quarters of the limit so a noisy slope does not chatter.
+    if (!raised && magnitude >= limit) {
+      Emit(state, &out, ALARM_KIND_RATE, true, slope, limit);
+    } else if (raised && magnitude < limit - limit / 4) {
+      Emit(state, &out, ALARM_KIND_RATE, false, slope, limit);
+    }
+  }
+  return out.count;
+}
+
+const char*
+AlarmKindToString(uint8_t kind)
+{
+  switch (kind) {
+    case ALARM_KIND_HIGH:
+      return "high";
+    case ALARM_KIND_LOW:
+      return "low";
+    case ALARM_KIND_RATE:
+      return "rate";
+    case ALARM_KIND_SENSOR_FAULT:
+      return "sensor_fault";
+    default:
+      return "unknown";
+  }
+}
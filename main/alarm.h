@@ -0,0 +1,93 @@
+#ifndef PT100_LOGGER_ALARM_H_
+#define PT100_LOGGER_ALARM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Alarm rules evaluated on every calibrated sample, ahead of any batching.
+// Only transitions (raise, clear) become events; they travel on their own
+// mesh message and export frame type instead of the record path.
+
+#define ALARM_RATE_HISTORY 16
+// Kinds a single sample can change at once (high/low, rate, fault).
+#define ALARM_MAX_EVENTS_PER_SAMPLE 4
+
+  typedef enum
+  {
+    ALARM_KIND_HIGH = 1,         // value = temperature, limit = high threshold
+    ALARM_KIND_LOW = 2,          // value = temperature, limit = low threshold
+    ALARM_KIND_RATE = 3,         // value = slope in milli-°C/min (signed)
+    ALARM_KIND_SENSOR_FAULT = 4, // value = last temperature, limit = 0
+  } alarm_kind_t;
+
+#pragma pack(push, 1)
+  typedef struct
+  {
+    int64_t epoch_ms;   // sample time (0 when the clock was not valid)
+    int32_t value;      // see alarm_kind_t
+    int32_t limit;
+    uint16_t sequence;  // per node and channel, +1 per event
+    uint8_t kind;       // alarm_kind_t
+    uint8_t active;     // 1 = raised, 0 = cleared
+    uint8_t channel;    // RTD channel (see rtd_channels.h)
+  } alarm_event_t;
+#pragma pack(pop)
+
+  typedef struct
+  {
+    bool high_enabled;
+    int32_t high_milli_c;
+    bool low_enabled;
+    int32_t low_milli_c;
+    int32_t rate_milli_c_per_min; // absolute slope; 0 = off
+    uint32_t rate_window_ms;      // slope is taken over about this long
+    int32_t hysteresis_milli_c;   // a threshold alarm clears this far inside
+    bool fault_enabled;
+  } alarm_rules_t;
+
+  typedef struct
+  {
+    int64_t mono_ms;
+    int32_t milli_c;
+  } alarm_rate_point_t;
+
+  typedef struct
+  {
+    uint8_t channel; // copied into every event
+    uint8_t active;  // bit (1 << kind) per raised alarm
+    uint16_t sequence;
+    int32_t last_milli_c;
+    // Decimated history for the slope: one point per window / history size.
+    alarm_rate_point_t history[ALARM_RATE_HISTORY];
+    uint8_t history_count;
+    uint8_t history_next;
+  } alarm_state_t;
+
+  void AlarmStateInit(alarm_state_t* state, uint8_t channel);
+
+  // Evaluates one sample. valid is false for sensor faults (the temperature
+  // is then ignored). mono_ms is a monotonic clock for the slope, epoch_ms
+  // the timestamp to put on events. Writes up to max_events transitions and
+  // returns how many.
+  size_t AlarmEvaluate(alarm_state_t* state,
+                       const alarm_rules_t* rules,
+                       int32_t milli_c,
+                       bool valid,
+                       int64_t mono_ms,
+                       int64_t epoch_ms,
+                       alarm_event_t* events_out,
+                       size_t max_events);
+
+  const char* AlarmKindToString(uint8_t kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_ALARM_H_
@@ -11,6 +11,7 @@
 #include "nvs.h"
 #include "nvs_flash.h"
 #include "pt100_table.h"
+#include "rtd_lut.h"
 
 static const char* kTag = "settings";
 
@@ -33,12 +34,19 @@ static const char* kKeyCalContextFilter = "cal_ctx_filter";
 static const char* kKeyCalContextRref = "cal_ctx_rref";
 static const char* kKeyCalContextR0 = "cal_ctx_r0";
 static const char* kKeyCalContextTableVer = "cal_ctx_table";
+static const char* kKeyCalChannels = "cal_channels";
+static const char* kKeySampleFilter = "sample_filter";
+static const char* kKeyRecordCompression = "rec_compress";
+static const char* kKeyAdaptiveRate = "adaptive_rate";
+static const char* kKeyBurstCapture = "burst";
 static const char* kKeyTzPosix = "tz_posix";
 static const char* kKeyDstEnabled = "dst_enabled";
 static const char* kKeyNodeRole = "node_role";
 static const char* kKeyAllowChildren = "allow_child";
 static const char* kKeyAllowChildrenSet = "allow_child_set";
 static const char* kKeyDisplayUnits = "disp_units";
+static const char* kKeyExportFormat = "export_fmt";
+static const char* kKeyDataBaudRate = "data_baud";
 static const uint8_t kCalibrationContextVersion = 1;
 
 static app_node_role_t
@@ -124,6 +132,88 @@ AppSettingsParseDisplayUnits(const char* value,
   return false;
 }
 
+const char*
+AppSettingsExportFormatToString(app_export_format_t format)
+{
+  switch (format) {
+    case APP_EXPORT_FORMAT_CSV:
+      return "csv";
+    case APP_EXPORT_FORMAT_BINARY:
+      return "binary";
+    default:
+      return "unknown";
+  }
+}
+
+bool
+AppSettingsParseExportFormat(const char* value,
+                             app_export_format_t* format_out)
+{
+  if (value == NULL || format_out == NULL) {
+    return false;
+  }
+  if (strcasecmp(value, "csv") == 0) {
+    *format_out = APP_EXPORT_FORMAT_CSV;
+    return true;
+  }
+  if (strcasecmp(value, "binary") == 0 || strcasecmp(value, "bin") == 0) {
+    *format_out = APP_EXPORT_FORMAT_BINARY;
+    return true;
+  }
+  return false;
+}
+
+static app_export_format_t
+DefaultExportFormat(void)
+{
+#ifdef CONFIG_APP_DATA_PORT_FORMAT_BINARY
+  return APP_EXPORT_FORMAT_BINARY;
+#else
+  return APP_EXPORT_FORMAT_CSV;
+#endif
+}
+
+static void
+DefaultRecordCompression(record_compression_config_t* config)
+{
+  RecordCompressionConfigInitDefault(config);
+#if defined(CONFIG_APP_RECORD_COMPRESSION_DEADBAND)
+  config->mode = RECORD_COMPRESSION_DEADBAND;
+#elif defined(CONFIG_APP_RECORD_COMPRESSION_SWINGING_DOOR)
+  config->mode = RECORD_COMPRESSION_SWINGING_DOOR;
+#endif
+#ifdef CONFIG_APP_RECORD_COMPRESSION_ERROR_MILLI_C
+  config->error_milli_c = CONFIG_APP_RECORD_COMPRESSION_ERROR_MILLI_C;
+  config->heartbeat_ms = (uint32_t)CONFIG_APP_RECORD_COMPRESSION_HEARTBEAT_S *
+                         1000u;
+#endif
+}
+
+static void
+DefaultAdaptiveRate(adaptive_rate_config_t* config)
+{
+  AdaptiveRateConfigInitDefault(config);
+#ifdef CONFIG_APP_ADAPTIVE_RATE
+  config->enabled = true;
+  config->fast_period_ms = (uint32_t)CONFIG_APP_ADAPTIVE_RATE_FAST_PERIOD_MS;
+  config->rise_milli_c_per_min = CONFIG_APP_ADAPTIVE_RATE_RISE_MILLI_C_PER_MIN;
+  config->dwell_ms = (uint32_t)CONFIG_APP_ADAPTIVE_RATE_DWELL_S * 1000u;
+#endif
+}
+
+static void
+DefaultBurstCapture(burst_capture_config_t* config)
+{
+  BurstCaptureConfigInitDefault(config);
+  config->period_ms = APP_SETTINGS_LOG_PERIOD_MIN_MS;
+#ifdef CONFIG_APP_BURST_CAPTURE
+  config->enabled = true;
+  config->period_ms = (uint32_t)CONFIG_APP_BURST_PERIOD_MS;
+  config->pre_ms = (uint32_t)CONFIG_APP_BURST_PRE_MS;
+  config->post_ms = (uint32_t)CONFIG_APP_BURST_POST_MS;
+#endif
+}
+
 static void
 ApplyDefaults(app_settings_t* settings)
 {
@@ -138,6 +228,14 @@ ApplyDefaults(app_settings_t* settings)
   settings->calibration_context_valid = false;
   settings->calibration_points_count = 0;
   memset(settings->calibration_points, 0, sizeof(settings->calibration_points));
+  for (size_t i = 0; i < RTD_CHANNELS_MAX; ++i) {
+    CalibrationModelInitIdentity(&settings->channel_calibration[i]);
+    settings->channel_calibration[i].is_valid = false;
+  }
+  SampleFilterConfigInitDefault(&settings->sample_filter);
+  DefaultRecordCompression(&settings->record_compression);
+  DefaultAdaptiveRate(&settings->adaptive_rate);
+  DefaultBurstCapture(&settings->burst_capture);
   snprintf(settings->tz_posix,
            sizeof(settings->tz_posix),
            "%s",
@@ -148,6 +246,8 @@ ApplyDefaults(app_settings_t* settings)
     AppSettingsRoleDefaultAllowsChildren(settings->node_role);
   settings->allow_children_set = false;
   settings->display_units = APP_DISPLAY_UNITS_F;
+  settings->export_format = DefaultExportFormat();
+  settings->data_baud_rate = (uint32_t)CONFIG_APP_DATA_PORT_BAUD_RATE;
 }
 
 static bool
@@ -203,6 +303,46 @@ LoadCalibrationContext(nvs_handle_t handle, calibration_context_t* context_out)
   return true;
 }
 
+static void
+LoadChannelCalibration(nvs_handle_t handle, calibration_model_t* models_out)
+{
+  calibration_model_t loaded[RTD_CHANNELS_MAX];
+  size_t size = sizeof(loaded);
+  if (nvs_get_blob(handle, kKeyCalChannels, loaded, &size) != ESP_OK ||
+      size != sizeof(loaded)) {
+    return;
+  }
+  for (size_t i = 1; i < RTD_CHANNELS_MAX; ++i) {
+    if (loaded[i].is_valid && loaded[i].degree <= CALIBRATION_MAX_DEGREE &&
+        loaded[i].mode != CAL_FIT_MODE_PIECEWISE) {
+      models_out[i] = loaded[i];
+    }
+  }
+}
+
+// Keeps the default when the stored chain is invalid or no longer divides
+// the log period.
+static void
+LoadSampleFilter(nvs_handle_t handle, app_settings_t* settings)
+{
+  sample_filter_config_t loaded;
+  size_t size = sizeof(loaded);
+  if (nvs_get_blob(handle, kKeySampleFilter, &loaded, &size) != ESP_OK ||
+      size != sizeof(loaded) || !SampleFilterConfigIsValid(&loaded)) {
+    return;
+  }
+  const uint32_t sample_period_ms =
+    SampleFilterSamplePeriodMs(&loaded, settings->log_period_ms);
+  if (sample_period_ms < APP_SETTINGS_LOG_PERIOD_MIN_MS) {
+    ESP_LOGW(kTag,
+             "filter decimation %u does not fit log period %u ms; ignored",
+             (unsigned)loaded.decimation,
+             (unsigned)settings->log_period_ms);
+    return;
+  }
+  settings->sample_filter = loaded;
+}
+
 static esp_err_t
 OpenNvs(nvs_handle_t* handle_out)
 {
@@ -226,7 +366,8 @@ AppSettingsLoad(app_settings_t* settings_out)
 
   uint32_t log_period_ms = 0;
   result = nvs_get_u32(handle, kKeyLogPeriodMs, &log_period_ms);
-  if (result == ESP_OK && log_period_ms >= 100 && log_period_ms <= 3600000) {
+  if (result == ESP_OK && log_period_ms >= APP_SETTINGS_LOG_PERIOD_MIN_MS &&
+      log_period_ms <= APP_SETTINGS_LOG_PERIOD_MAX_MS) {
     settings_out->log_period_ms = log_period_ms;
   }
 
@@ -297,6 +438,36 @@ AppSettingsLoad(app_settings_t* settings_out)
     settings_out->calibration_points_count = 0;
   }
 
+  LoadChannelCalibration(handle, settings_out->channel_calibration);
+  LoadSampleFilter(handle, settings_out);
+
+  record_compression_config_t compression;
+  size_t compression_size = sizeof(compression);
+  result = nvs_get_blob(
+    handle, kKeyRecordCompression, &compression, &compression_size);
+  if (result == ESP_OK && compression_size == sizeof(compression) &&
+      RecordCompressionConfigIsValid(&compression)) {
+    settings_out->record_compression = compression;
+  }
+
+  adaptive_rate_config_t adaptive;
+  size_t adaptive_size = sizeof(adaptive);
+  result = nvs_get_blob(handle, kKeyAdaptiveRate, &adaptive, &adaptive_size);
+  if (result == ESP_OK && adaptive_size == sizeof(adaptive) &&
+      AdaptiveRateConfigIsValid(&adaptive) &&
+      adaptive.fast_period_ms >= APP_SETTINGS_LOG_PERIOD_MIN_MS) {
+    settings_out->adaptive_rate = adaptive;
+  }
+
+  burst_capture_config_t burst;
+  size_t burst_size = sizeof(burst);
+  result = nvs_get_blob(handle, kKeyBurstCapture, &burst, &burst_size);
+  if (result == ESP_OK && burst_size == sizeof(burst) &&
+      BurstCaptureConfigIsValid(&burst) &&
+      burst.period_ms >= APP_SETTINGS_LOG_PERIOD_MIN_MS) {
+    settings_out->burst_capture = burst;
+  }
+
   calibration_context_t loaded_context;
   if (LoadCalibrationContext(handle, &loaded_context)) {
     settings_out->calibration_context = loaded_context;
@@ -368,6 +539,18 @@ AppSettingsLoad(app_settings_t* settings_out)
     settings_out->display_units = (app_display_units_t)display_units;
   }
 
+  uint8_t export_format = (uint8_t)settings_out->export_format;
+  result = nvs_get_u8(handle, kKeyExportFormat, &export_format);
+  if (result == ESP_OK && export_format <= (uint8_t)APP_EXPORT_FORMAT_BINARY) {
+    settings_out->export_format = (app_export_format_t)export_format;
+  }
+
+  uint32_t data_baud_rate = 0;
+  result = nvs_get_u32(handle, kKeyDataBaudRate, &data_baud_rate);
+  if (result == ESP_OK && data_baud_rate > 0) {
+    settings_out->data_baud_rate = data_baud_rate;
+  }
+
   nvs_close(handle);
   ESP_LOGI(
     kTag,
@@ -402,6 +585,82 @@ AppSettingsSaveLogPeriodMs(uint32_t log_period_ms)
   return result;
 }
 
+esp_err_t
+AppSettingsSaveSampleFilter(const sample_filter_config_t* config)
+{
+  if (!SampleFilterConfigIsValid(config)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  nvs_handle_t handle;
+  esp_err_t result = OpenNvs(&handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  result = nvs_set_blob(handle, kKeySampleFilter, config, sizeof(*config));
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
+
+esp_err_t
+AppSettingsSaveRecordCompression(const record_compression_config_t* config)
+{
+  if (!RecordCompressionConfigIsValid(config)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  nvs_handle_t handle;
+  esp_err_t result = OpenNvs(&handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  result = nvs_set_blob(handle, kKeyRecordCompression, config, sizeof(*config));
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
+
+esp_err_t
+AppSettingsSaveAdaptiveRate(const adaptive_rate_config_t* config)
+{
+  if (!AdaptiveRateConfigIsValid(config)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  nvs_handle_t handle;
+  esp_err_t result = OpenNvs(&handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  result = nvs_set_blob(handle, kKeyAdaptiveRate, config, sizeof(*config));
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
+
+esp_err_t
+AppSettingsSaveBurstCapture(const burst_capture_config_t* config)
+{
+  if (!BurstCaptureConfigIsValid(config)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  nvs_handle_t handle;
+  esp_err_t result = OpenNvs(&handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  result = nvs_set_blob(handle, kKeyBurstCapture, config, sizeof(*config));
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
+
 esp_err_t
 AppSettingsSaveFramFlushWatermarkRecords(uint32_t watermark_records)
 {
@@ -519,10 +778,17 @@ AppSettingsBuildCalibrationContextFromReader(calibration_context_t* context,
   context->filter_hz = reader->filter_hz;
   context->rref_ohm = reader->rref_ohm;
   context->r0_ohm = reader->rtd_nominal_ohm;
-  context->table_version =
-    (reader->conversion == kMax31865ConversionTablePt100)
-      ? (uint32_t)PT100_TABLE_LENGTH
-      : 0u;
+  switch (reader->conversion) {
+    case kMax31865ConversionTablePt100:
+      context->table_version = (uint32_t)PT100_TABLE_LENGTH;
+      break;
+    case kMax31865ConversionInverseLut:
+      context->table_version = (uint32_t)RTD_LUT_LENGTH;
+      break;
+    default:
+      context->table_version = 0u;
+      break;
+  }
 }
 
 esp_err_t
@@ -563,6 +829,28 @@ AppSettingsSaveCalibrationPoints(const calibration_point_t* points,
   return result;
 }
 
+esp_err_t
+AppSettingsSaveChannelCalibration(const calibration_model_t* models)
+{
+  if (models == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  nvs_handle_t handle;
+  esp_err_t result = OpenNvs(&handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  result = nvs_set_blob(handle,
+                        kKeyCalChannels,
+                        models,
+                        sizeof(calibration_model_t) * RTD_CHANNELS_MAX);
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
+
 esp_err_t
 AppSettingsSaveTimeZone(const char* tz_posix, bool dst_enabled)
 {
@@ -646,6 +934,46 @@ AppSettingsSaveDisplayUnits(app_display_units_t units)
   return result;
 }
 
+esp_err_t
+AppSettingsSaveExportFormat(app_export_format_t format)
+{
+  if (format != APP_EXPORT_FORMAT_CSV && format != APP_EXPORT_FORMAT_BINARY) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  nvs_handle_t handle;
+  esp_err_t result = OpenNvs(&handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+
+  result = nvs_set_u8(handle, kKeyExportFormat, (uint8_t)format);
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
+
+esp_err_t
+AppSettingsSaveDataBaudRate(uint32_t baud_rate)
+{
+  if (baud_rate == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  nvs_handle_t handle;
+  esp_err_t result = OpenNvs(&handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+
+  result = nvs_set_u32(handle, kKeyDataBaudRate, baud_rate);
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
+
 void
 AppSettingsApplyTimeZone(const app_settings_t* settings)
 {
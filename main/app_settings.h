@@ -5,14 +5,29 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "adaptive_rate.h"
+#include "burst_capture.h"
 #include "calibration.h"
 #include "esp_err.h"
 #include "max31865_reader.h"
+#include "record_compressor.h"
+#include "rtd_channels.h"
+#include "sample_filter.h"
+#include "sdkconfig.h"
 
 #define APP_SETTINGS_TZ_POSIX_MAX_LEN 64
 #define APP_SETTINGS_TZ_DEFAULT_POSIX "CST6CDT,M3.2.0/2,M11.1.0/2"
 #define APP_SETTINGS_TZ_DEFAULT_STD "CST6"
 
+// A one-shot MAX31865 read takes ~80 ms; continuous conversion delivers a
+// new reading every 20 ms.
+#ifdef CONFIG_APP_MAX31865_CONTINUOUS
+#define APP_SETTINGS_LOG_PERIOD_MIN_MS 20u
+#else
+#define APP_SETTINGS_LOG_PERIOD_MIN_MS 100u
+#endif
+#define APP_SETTINGS_LOG_PERIOD_MAX_MS 3600000u
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -31,6 +46,12 @@ extern "C"
     APP_DISPLAY_UNITS_F = 1,
   } app_display_units_t;
 
+  typedef enum
+  {
+    APP_EXPORT_FORMAT_CSV = 0,
+    APP_EXPORT_FORMAT_BINARY = 1,
+  } app_export_format_t;
+
   typedef struct
   {
     uint8_t conversion_mode;
@@ -58,12 +79,26 @@ extern "C"
     bool calibration_context_valid;
     calibration_point_t calibration_points[CALIBRATION_MAX_POINTS];
     uint8_t calibration_points_count;
+    // Extra RTD channels (CONFIG_APP_RTD_EXTRA_CS_GPIOS), indexed by
+    // channel; [0] is unused since channel 0 uses calibration above.
+    calibration_model_t channel_calibration[RTD_CHANNELS_MAX];
+    // Applied to every channel; with decimation the sensor samples at
+    // log_period_ms / decimation.
+    sample_filter_config_t sample_filter;
+    // Applied to every channel's records before storage.
+    record_compression_config_t record_compression;
+    // Fast period while the temperature moves; log_period_ms otherwise.
+    adaptive_rate_config_t adaptive_rate;
+    // High-rate capture around events, beside the normal log.
+    burst_capture_config_t burst_capture;
     char tz_posix[APP_SETTINGS_TZ_POSIX_MAX_LEN];
     bool dst_enabled;
     app_node_role_t node_role;
     bool allow_children;
     bool allow_children_set;
     app_display_units_t display_units;
+    app_export_format_t export_format;
+    uint32_t data_baud_rate;
   } app_settings_t;
 
   // Loads settings from NVS. If keys are missing or invalid, applies defaults.
@@ -72,6 +107,16 @@ extern "C"
   // Persists updated log interval to NVS.
   esp_err_t AppSettingsSaveLogPeriodMs(uint32_t log_period_ms);
 
+  // Persists the filter chain config.
+  esp_err_t AppSettingsSaveSampleFilter(const sample_filter_config_t* config);
+
+  esp_err_t AppSettingsSaveRecordCompression(
+    const record_compression_config_t* config);
+
+  esp_err_t AppSettingsSaveAdaptiveRate(const adaptive_rate_config_t* config);
+
+  esp_err_t AppSettingsSaveBurstCapture(const burst_capture_config_t* config);
+
   // Persists updated FRAM flush watermark to NVS.
   esp_err_t AppSettingsSaveFramFlushWatermarkRecords(
     uint32_t watermark_records);
@@ -84,6 +129,10 @@ extern "C"
     const calibration_model_t* model,
     const calibration_context_t* context);
 
+  // Persists the extra-channel models (all RTD_CHANNELS_MAX entries).
+  esp_err_t AppSettingsSaveChannelCalibration(
+    const calibration_model_t* models);
+
   void AppSettingsBuildCalibrationContextFromReader(
     calibration_context_t* context,
     const max31865_reader_t* reader);
@@ -116,6 +165,15 @@ extern "C"
   // Persists updated display units.
   esp_err_t AppSettingsSaveDisplayUnits(app_display_units_t units);
 
+  // Data port export helpers.
+  const char* AppSettingsExportFormatToString(app_export_format_t format);
+  bool AppSettingsParseExportFormat(const char* value,
+                                    app_export_format_t* format_out);
+
+  // Persists the data port format and baud rate.
+  esp_err_t AppSettingsSaveExportFormat(app_export_format_t format);
+  esp_err_t AppSettingsSaveDataBaudRate(uint32_t baud_rate);
+
   // Applies TZ to the runtime environment.
   void AppSettingsApplyTimeZone(const app_settings_t* settings);
 
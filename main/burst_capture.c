@@ -0,0 +1,305 @@
+#include "burst_capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+
+static const char* kFilePrefix = "burst_";
+static const char* kFileSuffix = ".csv";
+
+static uint32_t
+TicksFor(uint32_t ms, uint32_t period_ms)
+{
+  return (ms + period_ms - 1u) / period_ms;
+}
+
+void
+BurstCaptureConfigInitDefault(burst_capture_config_t* config)
+{
+  if (config == NULL) {
+    return;
+  }
+  memset(config, 0, sizeof(*config));
+  config->enabled = false;
+  config->period_ms = 100;
+  config->pre_ms = 5000;
+  config->post_ms = 5000;
+  config->level_enabled = false;
+  config->level_milli_c = 0;
+  config->slope_milli_c_per_s = 0;
+}
+
+bool
+BurstCaptureConfigIsValid(const burst_capture_config_t* config)
+{
+  if (config == NULL) {
+    return false;
+  }
+  if (!config->enabled) {
+    return true;
+  }
+  return config->period_ms > 0 && config->pre_ms <= 3600000u &&
+         config->post_ms <= 3600000u && config->slope_milli_c_per_s >= 0;
+}
+
+uint32_t
+BurstCaptureRingSamples(const burst_capture_config_t* config,
+                        uint8_t channels)
+{
+  if (config == NULL || config->period_ms == 0 || channels == 0) {
+    return 0;
+  }
+  const uint64_t ticks = (uint64_t)TicksFor(config->pre_ms, config->period_ms) +
+                         1u + TicksFor(config->post_ms, config->period_ms);
+  const uint64_t samples = ticks * channels;
+  return (samples > UINT32_MAX) ? UINT32_MAX : (uint32_t)samples;
+}
+
+const char*
+BurstTriggerSourceToString(uint8_t source)
+{
+  switch (source) {
+    case BURST_TRIGGER_LEVEL:
+      return "level";
+    case BURST_TRIGGER_SLOPE:
+      return "slope";
+    case BURST_TRIGGER_CONSOLE:
+      return "console";
+    case BURST_TRIGGER_MESH:
+      return "mesh";
+    default:
+      return "none";
+  }
+}
+
+esp_err_t
+BurstCaptureInit(burst_capture_t* capture,
+                 const burst_capture_config_t* config,
+                 uint8_t channels)
+{
+  if (capture == NULL || !BurstCaptureConfigIsValid(config) ||
+      channels == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const burst_capture_stats_t stats = capture->stats;
+  BurstCaptureDeinit(capture);
+  memset(capture, 0, sizeof(*capture));
+  capture->stats = stats;
+  capture->config = *config;
+  capture->channels = channels;
+  if (!config->enabled) {
+    return ESP_OK;
+  }
+
+  const uint32_t capacity = BurstCaptureRingSamples(config, channels);
+  if (capacity > BURST_CAPTURE_MAX_SAMPLES) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  capture->ring = (burst_sample_t*)heap_caps_calloc(
+    capacity, sizeof(burst_sample_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (capture->ring != NULL) {
+    capture->in_psram = true;
+  } else {
+    capture->ring = (burst_sample_t*)calloc(capacity, sizeof(burst_sample_t));
+  }
+  if (capture->ring == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  capture->capacity = capacity;
+  capture->state = BURST_CAPTURE_ARMED;
+  return ESP_OK;
+}
+
+void
+BurstCaptureDeinit(burst_capture_t* capture)
+{
+  if (capture == NULL) {
+    return;
+  }
+  free(capture->ring);
+  capture->ring = NULL;
+  capture->capacity = 0;
+  capture->head = 0;
+  capture->count = 0;
+  capture->state = BURST_CAPTURE_ARMED;
+}
+
+// Sample written back samples before the next slot (1 = newest).
+static const burst_sample_t*
+Back(const burst_capture_t* capture, uint32_t back)
+{
+  return &capture->ring[(capture->head + capture->capacity - back) %
+                        capture->capacity];
+}
+
+// Level crossing or slope on one channel of the newest tick.
+static uint8_t
+AutoTrigger(const burst_capture_t* capture, uint8_t channel)
+{
+  const burst_capture_config_t* config = &capture->config;
+  const uint32_t channels = capture->channels;
+  const burst_sample_t* now = Back(capture, channels - channel);
+  if (now->fault) {
+    return BURST_TRIGGER_NONE;
+  }
+  if (config->level_enabled && capture->count >= 2u * channels) {
+    const burst_sample_t* before = Back(capture, 2u * channels - channel);
+    if (!before->fault && (before->temp_milli_c < config->level_milli_c) !=
+                            (now->temp_milli_c < config->level_milli_c)) {
+      return BURST_TRIGGER_LEVEL;
+    }
+  }
+  if (config->slope_milli_c_per_s > 0) {
+    uint32_t ticks_back = 1000u / config->period_ms;
+    if (ticks_back == 0) {
+      ticks_back = 1;
+    }
+    const uint32_t back = (ticks_back + 1u) * channels - channel;
+    if (capture->count < (ticks_back + 1u) * channels) {
+      return BURST_TRIGGER_NONE;
+    }
+    const burst_sample_t* past = Back(capture, back);
+    const int64_t dt_ms = now->mono_ms - past->mono_ms;
+    if (past->fault || dt_ms <= 0) {
+      return BURST_TRIGGER_NONE;
+    }
+    int64_t dv = (int64_t)now->temp_milli_c - past->temp_milli_c;
+    if (dv < 0) {
+      dv = -dv;
+    }
+    if (dv * 1000 >= (int64_t)config->slope_milli_c_per_s * dt_ms) {
+      return BURST_TRIGGER_SLOPE;
+    }
+  }
+  return BURST_TRIGGER_NONE;
+}
+
+bool
+BurstCapturePush(burst_capture_t* capture,
+                 const burst_sample_t* samples,
+                 uint8_t manual_trigger)
+{
+  if (capture == NULL || samples == NULL || capture->ring == NULL) {
+    return false;
+  }
+  if (capture->state == BURST_CAPTURE_FROZEN) {
+    if (manual_trigger != BURST_TRIGGER_NONE) {
+      capture->stats.triggers_ignored++;
+    }
+    return false; // the frozen burst must not be overwritten
+  }
+
+  for (uint8_t ch = 0; ch < capture->channels; ++ch) {
+    capture->ring[capture->head] = samples[ch];
+    capture->head = (capture->head + 1u) % capture->capacity;
+  }
+  if (capture->count < capture->capacity) {
+    capture->count += capture->channels;
+  }
+
+  if (capture->state == BURST_CAPTURE_CAPTURING) {
+    if (manual_trigger != BURST_TRIGGER_NONE) {
+      capture->stats.triggers_ignored++;
+    }
+    if (capture->post_remaining > 0) {
+      capture->post_remaining--;
+    }
+  } else {
+    uint8_t source = manual_trigger;
+    uint8_t channel = 0;
+    const uint32_t pre_samples =
+      (TicksFor(capture->config.pre_ms, capture->config.period_ms) + 1u) *
+      capture->channels;
+    if (source == BURST_TRIGGER_NONE && capture->count >= pre_samples) {
+      for (; channel < capture->channels; ++channel) {
+        source = AutoTrigger(capture, channel);
+        if (source != BURST_TRIGGER_NONE) {
+          break;
+        }
+      }
+    }
+    if (source == BURST_TRIGGER_NONE) {
+      return false;
+    }
+    if (channel >= capture->channels) {
+      channel = 0;
+    }
+    capture->state = BURST_CAPTURE_CAPTURING;
+    capture->post_remaining =
+      TicksFor(capture->config.post_ms, capture->config.period_ms);
+    capture->trigger_source = source;
+    capture->trigger_channel = channel;
+    capture->trigger_epoch_ms = samples[channel].epoch_ms;
+    capture->trigger_mono_ms = samples[channel].mono_ms;
+    capture->stats.triggers++;
+  }
+
+  if (capture->post_remaining > 0) {
+    return false;
+  }
+  capture->state = BURST_CAPTURE_FROZEN;
+  capture->stats.frozen++;
+  return true;
+}
+
+uint32_t
+BurstCaptureFrozenCount(const burst_capture_t* capture)
+{
+  return (capture != NULL && capture->state == BURST_CAPTURE_FROZEN)
+           ? capture->count
+           : 0;
+}
+
+const burst_sample_t*
+BurstCaptureFrozenSample(const burst_capture_t* capture, uint32_t index)
+{
+  if (index >= BurstCaptureFrozenCount(capture)) {
+    return NULL;
+  }
+  return Back(capture, capture->count - index);
+}
+
+void
+BurstCaptureRearm(burst_capture_t* capture)
+{
+  if (capture == NULL) {
+    return;
+  }
+  capture->head = 0;
+  capture->count = 0;
+  capture->post_remaining = 0;
+  capture->trigger_source = BURST_TRIGGER_NONE;
+  capture->state = BURST_CAPTURE_ARMED;
+}
+
+void
+BurstCaptureFileName(uint32_t id, char* out, size_t out_size)
+{
+  if (out == NULL || out_size == 0) {
+    return;
+  }
+  snprintf(
+    out, out_size, "%s%05lu%s", kFilePrefix, (unsigned long)id, kFileSuffix);
+}
+
+bool
+BurstCaptureParseFileName(const char* name, uint32_t* id_out)
+{
+  if (name == NULL || id_out == NULL) {
+    return false;
+  }
+  const size_t prefix_len = strlen(kFilePrefix);
+  if (strncmp(name, kFilePrefix, prefix_len) != 0) {
+    return false;
+  }
+  char* end = NULL;
+  const unsigned long id = strtoul(name + prefix_len, &end, 10);
+  if (end == name + prefix_len || strcmp(end, kFileSuffix) != 0 ||
+      id > UINT32_MAX) {
+    return false;
+  }
+  *id_out = (uint32_t)id;
+  return true;
+}
@@ -0,0 +1,137 @@
+#ifndef PT100_LOGGER_BURST_CAPTURE_H_
+#define PT100_LOGGER_BURST_CAPTURE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Event-triggered capture at the full sensor rate, beside the normal log.
+// While enabled the sensor task samples every period_ms and pushes each
+// tick (one sample per RTD channel) into a pre-trigger ring in PSRAM. A
+// trigger (level crossing, slope, console or mesh) lets post_ms more run
+// in, then freezes the ring: pre_ms before the trigger, post_ms after. The
+// storage task writes the frozen burst to its own SD file and re-arms.
+//
+// Not thread-safe: the runtime serializes Push, Rearm and state reads.
+
+#define BURST_CAPTURE_MAX_SAMPLES 65536u // ring size, all channels
+#define BURST_CAPTURE_DIR "bursts"       // under the SD mount point
+
+  typedef enum
+  {
+    BURST_TRIGGER_NONE = 0,
+    BURST_TRIGGER_LEVEL = 1,
+    BURST_TRIGGER_SLOPE = 2,
+    BURST_TRIGGER_CONSOLE = 3,
+    BURST_TRIGGER_MESH = 4,
+  } burst_trigger_source_t;
+
+  typedef enum
+  {
+    BURST_CAPTURE_ARMED = 0,     // filling the pre-trigger ring
+    BURST_CAPTURE_CAPTURING = 1, // triggered, filling the post window
+    BURST_CAPTURE_FROZEN = 2,    // complete, waiting to be written
+  } burst_capture_state_t;
+
+  typedef struct
+  {
+    bool enabled;
+    uint32_t period_ms;
+    uint32_t pre_ms;
+    uint32_t post_ms;
+    bool level_enabled;
+    int32_t level_milli_c;       // trigger when a channel crosses it
+    int32_t slope_milli_c_per_s; // |dT/dt| over ~1 s; 0 = off
+  } burst_capture_config_t;
+
+  typedef struct
+  {
+    int64_t epoch_ms; // 0 while time is not valid
+    int64_t mono_ms;
+    int32_t raw_milli_c;
+    int32_t temp_milli_c; // calibrated
+    int32_t resistance_milli_ohm;
+    uint8_t channel;
+    bool fault;
+  } burst_sample_t;
+
+  typedef struct
+  {
+    uint32_t triggers;
+    uint32_t triggers_ignored; // manual triggers while capturing or frozen
+    uint32_t frozen;
+    uint32_t written;
+    uint32_t write_failures;
+  } burst_capture_stats_t;
+
+  typedef struct
+  {
+    burst_capture_config_t config;
+    uint8_t channels;
+    burst_sample_t* ring; // capacity samples, whole ticks
+    uint32_t capacity;
+    bool in_psram;
+    uint32_t head;  // next slot
+    uint32_t count; // valid samples, up to capacity
+    uint8_t state;  // burst_capture_state_t
+    uint32_t post_remaining; // ticks still to capture
+    // Trigger of the current burst.
+    uint8_t trigger_source;
+    uint8_t trigger_channel;
+    int64_t trigger_epoch_ms;
+    int64_t trigger_mono_ms;
+    burst_capture_stats_t stats;
+  } burst_capture_t;
+
+  void BurstCaptureConfigInitDefault(burst_capture_config_t* config);
+
+  bool BurstCaptureConfigIsValid(const burst_capture_config_t* config);
+
+  // Ring samples the config needs with channels per tick.
+  uint32_t BurstCaptureRingSamples(const burst_capture_config_t* config,
+                                   uint8_t channels);
+
+  const char* BurstTriggerSourceToString(uint8_t source);
+
+  // Allocates the ring (PSRAM when available) for an enabled config and
+  // arms. Keeps stats across re-inits.
+  esp_err_t BurstCaptureInit(burst_capture_t* capture,
+                             const burst_capture_config_t* config,
+                             uint8_t channels);
+
+  // Frees the ring; stats stay.
+  void BurstCaptureDeinit(burst_capture_t* capture);
+
+  // Feeds one tick: samples[0..channels-1]. manual_trigger is a
+  // console/mesh request (BURST_TRIGGER_NONE when there is none). Level
+  // and slope triggers only fire once the pre-trigger window is full.
+  // Returns true when this tick froze a burst.
+  bool BurstCapturePush(burst_capture_t* capture,
+                        const burst_sample_t* samples,
+                        uint8_t manual_trigger);
+
+  // Frozen burst, oldest first.
+  uint32_t BurstCaptureFrozenCount(const burst_capture_t* capture);
+  const burst_sample_t* BurstCaptureFrozenSample(
+    const burst_capture_t* capture,
+    uint32_t index);
+
+  // Drops the frozen burst and starts filling the ring again.
+  void BurstCaptureRearm(burst_capture_t* capture);
+
+  // "burst_00042.csv" <-> 42.
+  void BurstCaptureFileName(uint32_t id, char* out, size_t out_size);
+  bool BurstCaptureParseFileName(const char* name, uint32_t* id_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_BURST_CAPTURE_H_
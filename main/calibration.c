@@ -13,8 +13,6 @@ typedef struct
   size_t count;
   size_t index;
   int32_t last_raw_milli_c;
-  int32_t mean_raw_milli_c;
-  int32_t stddev_raw_milli_c;
 } cal_window_state_t;
 
 static cal_window_state_t g_cal_window;
@@ -419,7 +417,7 @@ CalibrationModelFitFromPointsWithOptions(
       return ESP_ERR_INVALID_ARG;
   }
 
-  if (degree + 1 > num_points) {
+  if ((size_t)degree + 1 > num_points) {
     ESP_LOGW(kTag,
              "not enough points for degree %u (need >=%u)",
              degree,
@@ -458,35 +456,159 @@ CalibrationModelFitFromPointsWithOptions(
   return ESP_OK;
 }
 
+// Integer calibration. |x| <= 2^20 milli-°C (1048 °C) and coefficients
+// below 2^39 keep every Horner product under 2^62.
+#define CAL_FIXED_X_SHIFT 20
+static const int64_t kCalFixedCoeffLimit = (int64_t)1 << 39;
+static const int32_t kCalFixedMaxAbsX = (int32_t)1 << CAL_FIXED_X_SHIFT;
+
+static bool
+FixedIsCurrent(const calibration_fixed_t* fixed,
+               const calibration_model_t* model,
+               const calibration_point_t* points,
+               size_t num_points)
+{
+  const calibration_model_t* source = &fixed->source;
+  if (!fixed->compiled || source->is_valid != model->is_valid ||
+      source->mode != model->mode || source->degree != model->degree ||
+      memcmp(source->coefficients,
+             model->coefficients,
+             sizeof(model->coefficients)) != 0) {
+    return false;
+  }
+  if (model->mode != CAL_FIT_MODE_PIECEWISE) {
+    return true; // points only matter to piecewise models
+  }
+  if (fixed->points_count != num_points) {
+    return false;
+  }
+  for (size_t i = 0; i < num_points; ++i) {
+    if (fixed->points[i].raw_avg_mC != points[i].raw_avg_mC ||
+        fixed->points[i].actual_mC != points[i].actual_mC) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void
-CalWindowPushRawSample(int32_t raw_milli_c)
+CalibrationFixedSync(calibration_fixed_t* fixed,
+                     const calibration_model_t* model,
+                     const calibration_point_t* points,
+                     size_t num_points)
 {
-  g_cal_window.samples_milli_c[g_cal_window.index] = raw_milli_c;
-  g_cal_window.index = (g_cal_window.index + 1) % CAL_WINDOW_SIZE;
-  if (g_cal_window.count < CAL_WINDOW_SIZE) {
-    g_cal_window.count++;
+  if (fixed == NULL || model == NULL) {
+    return;
+  }
+  if (points == NULL || num_points > CALIBRATION_MAX_POINTS) {
+    num_points = 0;
+  }
+  if (FixedIsCurrent(fixed, model, points, num_points)) {
+    return;
   }
 
-  g_cal_window.last_raw_milli_c = raw_milli_c;
+  memset(fixed, 0, sizeof(*fixed));
+  fixed->source = *model;
+  if (num_points > 0) {
+    memcpy(fixed->points, points, num_points * sizeof(points[0]));
+  }
+  fixed->points_count = (uint8_t)num_points;
+  fixed->compiled = true;
+  fixed->integer = true;
+  if (!model->is_valid || model->mode == CAL_FIT_MODE_PIECEWISE) {
+    return;
+  }
+  if (model->degree > CALIBRATION_MAX_DEGREE) {
+    fixed->integer = false;
+    return;
+  }
+  // y_mC = sum c[i] * 1000^(1-i) * x_mC^i, with x_mC = t * 2^20.
+  double scale = 1000.0;
+  for (uint8_t i = 0; i <= model->degree; ++i) {
+    const double value = ldexp(model->coefficients[i] * scale, 16);
+    if (!(fabs(value) < (double)kCalFixedCoeffLimit)) {
+      fixed->integer = false; // also catches NaN
+      return;
+    }
+    fixed->coeff_q16[i] = llround(value);
+    scale *= (double)(1 << CAL_FIXED_X_SHIFT) / 1000.0;
+  }
+}
 
-  double sum = 0.0;
-  for (size_t i = 0; i < g_cal_window.count; ++i) {
-    sum += g_cal_window.samples_milli_c[i];
+// InterpolateResidual() in milli-°C.
+static int32_t
+InterpolateResidualMilliC(const calibration_point_t* points,
+                          size_t num_points,
+                          int32_t raw_milli_c)
+{
+  int lower_index = -1;
+  int upper_index = -1;
+  for (size_t index = 0; index < num_points; ++index) {
+    const int32_t x_value = points[index].raw_avg_mC;
+    if (x_value <= raw_milli_c &&
+        (lower_index < 0 || x_value > points[lower_index].raw_avg_mC)) {
+      lower_index = (int)index;
+    }
+    if (x_value >= raw_milli_c &&
+        (upper_index < 0 || x_value < points[upper_index].raw_avg_mC)) {
+      upper_index = (int)index;
+    }
+  }
+  if (lower_index < 0 && upper_index < 0) {
+    return 0;
+  }
+  if (lower_index < 0) {
+    lower_index = upper_index;
+  } else if (upper_index < 0) {
+    upper_index = lower_index;
   }
-  const double mean = sum / (double)g_cal_window.count;
+  const calibration_point_t* lower = &points[lower_index];
+  const calibration_point_t* upper = &points[upper_index];
+  const int64_t lower_residual = (int64_t)lower->actual_mC - lower->raw_avg_mC;
+  if (upper->raw_avg_mC == lower->raw_avg_mC) {
+    return (int32_t)lower_residual;
+  }
+  const int64_t upper_residual = (int64_t)upper->actual_mC - upper->raw_avg_mC;
+  return (int32_t)(lower_residual +
+                   (upper_residual - lower_residual) *
+                     ((int64_t)raw_milli_c - lower->raw_avg_mC) /
+                     ((int64_t)upper->raw_avg_mC - lower->raw_avg_mC));
+}
 
-  double variance_sum = 0.0;
-  for (size_t i = 0; i < g_cal_window.count; ++i) {
-    const double delta =
-      (double)g_cal_window.samples_milli_c[i] - mean;
-    variance_sum += delta * delta;
+int32_t
+CalibrationFixedEvaluate(const calibration_fixed_t* fixed, int32_t raw_milli_c)
+{
+  if (fixed == NULL || !fixed->compiled || !fixed->source.is_valid) {
+    return raw_milli_c;
+  }
+  if (fixed->source.mode == CAL_FIT_MODE_PIECEWISE) {
+    return raw_milli_c + InterpolateResidualMilliC(
+                           fixed->points, fixed->points_count, raw_milli_c);
+  }
+  if (!fixed->integer || raw_milli_c > kCalFixedMaxAbsX ||
+      raw_milli_c < -kCalFixedMaxAbsX) {
+    return (int32_t)llround(
+      CalibrationModelEvaluate(&fixed->source, raw_milli_c / 1000.0) * 1000.0);
   }
-  const double variance =
-    (g_cal_window.count > 0) ? (variance_sum / g_cal_window.count) : 0.0;
-  const double stddev = sqrt(variance);
+  const int64_t x = raw_milli_c;
+  int64_t acc = fixed->coeff_q16[fixed->source.degree];
+  for (int i = (int)fixed->source.degree - 1; i >= 0; --i) {
+    acc = fixed->coeff_q16[i] + ((acc * x) >> CAL_FIXED_X_SHIFT);
+  }
+  return (int32_t)((acc + 0x8000) >> 16);
+}
 
-  g_cal_window.mean_raw_milli_c = (int32_t)llround(mean);
-  g_cal_window.stddev_raw_milli_c = (int32_t)llround(stddev);
+// Only stores the sample: the window statistics are computed when asked
+// for, off the sampling path.
+void
+CalWindowPushRawSample(int32_t raw_milli_c)
+{
+  g_cal_window.samples_milli_c[g_cal_window.index] = raw_milli_c;
+  g_cal_window.index = (g_cal_window.index + 1) % CAL_WINDOW_SIZE;
+  if (g_cal_window.count < CAL_WINDOW_SIZE) {
+    g_cal_window.count++;
+  }
+  g_cal_window.last_raw_milli_c = raw_milli_c;
 }
 
 bool
@@ -509,10 +631,22 @@ CalWindowGetStats(int32_t* out_last_raw_mC,
   if (out_last_raw_mC != NULL) {
     *out_last_raw_mC = g_cal_window.last_raw_milli_c;
   }
+  const size_t count = g_cal_window.count;
+  double sum = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    sum += g_cal_window.samples_milli_c[i];
+  }
+  const double mean = (count > 0) ? sum / (double)count : 0.0;
+  double variance_sum = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    const double delta = (double)g_cal_window.samples_milli_c[i] - mean;
+    variance_sum += delta * delta;
+  }
+  const double variance = (count > 0) ? (variance_sum / count) : 0.0;
   if (out_mean_raw_mC != NULL) {
-    *out_mean_raw_mC = g_cal_window.mean_raw_milli_c;
+    *out_mean_raw_mC = (int32_t)llround(mean);
   }
   if (out_stddev_mC != NULL) {
-    *out_stddev_mC = g_cal_window.stddev_raw_milli_c;
+    *out_stddev_mC = (int32_t)llround(sqrt(variance));
   }
 }
@@ -92,6 +92,34 @@ extern "C"
     calibration_model_t* model_out,
     calibration_fit_diagnostics_t* diagnostics_out);
 
+  // Integer form of a model (and its points, for piecewise) for the
+  // per-sample path: milli-°C in and out, no floating point. Polynomials
+  // run by Horner in x / 2^20 milli-°C with Q16 milli-°C coefficients;
+  // piecewise models interpolate the point residuals. Models whose
+  // coefficients would overflow keep using the double evaluation.
+  typedef struct
+  {
+    calibration_model_t source; // what the integer form was built from
+    calibration_point_t points[CALIBRATION_MAX_POINTS];
+    uint8_t points_count;
+    bool compiled;
+    bool integer; // false: double fallback
+    // Q16 of c[i] * 1000^(1-i) * 2^(20 i)
+    int64_t coeff_q16[CALIBRATION_MAX_POINTS];
+  } calibration_fixed_t;
+
+  // Rebuilds fixed when model or points differ from what it was built
+  // from; a few compares otherwise, so it can run every sample.
+  void CalibrationFixedSync(calibration_fixed_t* fixed,
+                            const calibration_model_t* model,
+                            const calibration_point_t* points,
+                            size_t num_points);
+
+  // Same result as CalibrationModelEvaluateWithPoints() to within 1 milli-°C
+  // (host_tools/rtd_lut checks it).
+  int32_t CalibrationFixedEvaluate(const calibration_fixed_t* fixed,
+                                   int32_t raw_milli_c);
+
   void CalWindowPushRawSample(int32_t raw_milli_c);
   bool CalWindowIsReady(void);
   size_t CalWindowGetSampleCount(void);
@@ -0,0 +1,176 @@
+#include "clock_sync.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Rate errors beyond this are measurement noise, not a crystal.
+static const double kMaxDriftPpm = 500.0;
+static const double kDriftSmoothing = 0.25;
+// Drift is only estimated over spans long enough to beat the jitter.
+static const int64_t kMinDriftSpanUs = 60LL * 1000 * 1000;
+
+static int64_t
+AbsI64(int64_t value)
+{
+  return (value < 0) ? -value : value;
+}
+
+static int64_t
+DriftOver(const clock_sync_t* sync, int64_t span_us)
+{
+  return (int64_t)(sync->drift_ppm * (double)span_us / 1e6);
+}
+
+static void
+ResetWindow(clock_sync_t* sync)
+{
+  sync->window_count = 0;
+  sync->window_next = 0;
+  sync->has_drift_ref = false;
+  sync->corrections_since_ref_us = 0;
+}
+
+// Every stored offset was measured before the correction; shift them so
+// the window keeps describing the clock as it is now.
+static void
+ApplyCorrectionToWindow(clock_sync_t* sync, int64_t correction_us)
+{
+  for (uint32_t index = 0; index < sync->window_count; ++index) {
+    sync->window[index].offset_us -= correction_us;
+  }
+  sync->corrections_since_ref_us += correction_us;
+}
+
+// NTP clock filter: the sample with the shortest round trip has the least
+// asymmetric queueing, so its offset is the most trustworthy.
+static const clock_sync_entry_t*
+BestEntry(const clock_sync_t* sync)
+{
+  const clock_sync_entry_t* best = NULL;
+  for (uint32_t index = 0; index < sync->window_count; ++index) {
+    const clock_sync_entry_t* entry = &sync->window[index];
+    if (best == NULL || entry->delay_us < best->delay_us) {
+      best = entry;
+    }
+  }
+  return best;
+}
+
+static void
+UpdateDrift(clock_sync_t* sync, int64_t raw_offset_us, int64_t t4_us)
+{
+  if (!sync->has_drift_ref) {
+    sync->has_drift_ref = true;
+    sync->ref_t4_us = t4_us;
+    sync->ref_raw_offset_us = raw_offset_us;
+    sync->corrections_since_ref_us = 0;
+    return;
+  }
+  const int64_t span_us = t4_us - sync->ref_t4_us;
+  if (span_us < kMinDriftSpanUs) {
+    return;
+  }
+  // Offset the leaf would have accumulated with no corrections at all.
+  const int64_t free_run_us =
+    raw_offset_us + sync->corrections_since_ref_us - sync->ref_raw_offset_us;
+  double ppm = ((double)free_run_us * 1e6) / (double)span_us;
+  if (ppm > kMaxDriftPpm) {
+    ppm = kMaxDriftPpm;
+  } else if (ppm < -kMaxDriftPpm) {
+    ppm = -kMaxDriftPpm;
+  }
+  sync->drift_ppm += kDriftSmoothing * (ppm - sync->drift_ppm);
+  sync->ref_t4_us = t4_us;
+  sync->ref_raw_offset_us = raw_offset_us;
+  sync->corrections_since_ref_us = 0;
+}
+
+void
+ClockSyncInit(clock_sync_t* sync, int64_t step_threshold_us)
+{
+  if (sync == NULL) {
+    return;
+  }
+  memset(sync, 0, sizeof(*sync));
+  sync->step_threshold_us = step_threshold_us;
+}
+
+clock_sync_action_t
+ClockSyncAddSample(clock_sync_t* sync,
+                   const clock_sync_sample_t* sample,
+                   int64_t poll_interval_us,
+                   int64_t* correction_us_out)
+{
+  if (correction_us_out != NULL) {
+    *correction_us_out = 0;
+  }
+  if (sync == NULL || sample == NULL) {
+    return CLOCK_SYNC_ACTION_NONE;
+  }
+  sync->samples_total++;
+
+  const int64_t delay_us =
+    (sample->t4_us - sample->t1_us) - (sample->t3_us - sample->t2_us);
+  if (delay_us < 0 || sample->t3_us < sample->t2_us) {
+    sync->samples_rejected++;
+    return CLOCK_SYNC_ACTION_NONE;
+  }
+  const int64_t offset_us =
+    ((sample->t2_us - sample->t1_us) + (sample->t3_us - sample->t4_us)) / 2;
+
+  // Far off (boot, or the root's clock jumped): step and start over.
+  if (AbsI64(offset_us) > sync->step_threshold_us) {
+    ResetWindow(sync);
+    sync->locked = true;
+    sync->steps++;
+    sync->offset_us = offset_us;
+    sync->delay_us = delay_us;
+    sync->error_us = delay_us / 2;
+    sync->last_sync_us = sample->t4_us + offset_us;
+    if (correction_us_out != NULL) {
+      *correction_us_out = offset_us;
+    }
+    return CLOCK_SYNC_ACTION_STEP;
+  }
+
+  clock_sync_entry_t* slot = &sync->window[sync->window_next];
+  slot->offset_us = offset_us;
+  slot->delay_us = delay_us;
+  slot->t4_us = sample->t4_us;
+  sync->window_next = (sync->window_next + 1u) % CLOCK_SYNC_WINDOW;
+  if (sync->window_count < CLOCK_SYNC_WINDOW) {
+    sync->window_count++;
+  }
+
+  UpdateDrift(sync, offset_us, sample->t4_us);
+  const clock_sync_entry_t* best = BestEntry(sync);
+
+  // The best sample may be a few polls old; age it by the estimated drift.
+  // Then feed-forward the drift expected before the next sample so the
+  // clock does not walk away between polls.
+  const int64_t best_offset_us =
+    best->offset_us + DriftOver(sync, sample->t4_us - best->t4_us);
+  const int64_t correction_us =
+    best_offset_us + DriftOver(sync, poll_interval_us);
+
+  sync->locked = true;
+  sync->offset_us = best_offset_us;
+  sync->delay_us = best->delay_us;
+  sync->error_us = best->delay_us / 2 + AbsI64(offset_us - best_offset_us);
+  sync->last_sync_us = sample->t4_us;
+
+  ApplyCorrectionToWindow(sync, correction_us);
+  if (correction_us_out != NULL) {
+    *correction_us_out = correction_us;
+  }
+  return CLOCK_SYNC_ACTION_SLEW;
+}
+
+void
+ClockSyncNoteUnapplied(clock_sync_t* sync, int64_t unapplied_us)
+{
+  if (sync == NULL || unapplied_us == 0) {
+    return;
+  }
+  ApplyCorrectionToWindow(sync, -unapplied_us);
+}
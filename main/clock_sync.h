@@ -0,0 +1,92 @@
+#ifndef PT100_LOGGER_CLOCK_SYNC_H_
+#define PT100_LOGGER_CLOCK_SYNC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Two-way (NTP-style) clock synchronization estimator for leaf nodes. Pure
+// arithmetic; the caller owns the transport and applies the corrections.
+//
+//   t1 leaf sends probe      (leaf clock)
+//   t2 root receives probe   (root clock)
+//   t3 root sends reply      (root clock)
+//   t4 leaf receives reply   (leaf clock)
+//
+//   offset = ((t2 - t1) + (t3 - t4)) / 2   root minus leaf
+//   delay  = (t4 - t1) - (t3 - t2)         round trip on the mesh
+#define CLOCK_SYNC_WINDOW 8
+
+  typedef struct
+  {
+    int64_t t1_us;
+    int64_t t2_us;
+    int64_t t3_us;
+    int64_t t4_us;
+  } clock_sync_sample_t;
+
+  typedef enum
+  {
+    CLOCK_SYNC_ACTION_NONE = 0,
+    CLOCK_SYNC_ACTION_SLEW, // adjtime() by correction_us
+    CLOCK_SYNC_ACTION_STEP, // settimeofday(now + correction_us)
+  } clock_sync_action_t;
+
+  typedef struct
+  {
+    int64_t offset_us; // measured, corrected for slews applied since
+    int64_t delay_us;
+    int64_t t4_us;
+  } clock_sync_entry_t;
+
+  typedef struct
+  {
+    int64_t step_threshold_us;
+    clock_sync_entry_t window[CLOCK_SYNC_WINDOW];
+    uint32_t window_count;
+    uint32_t window_next;
+
+    bool locked;           // at least one correction applied
+    int64_t offset_us;     // filtered offset of the latest update
+    int64_t delay_us;      // round trip of the sample used
+    int64_t error_us;      // bound: delay / 2 + residual offset
+    double drift_ppm;      // leaf clock rate error vs root (+ = leaf slow)
+    int64_t last_sync_us;  // leaf clock at the latest accepted sample
+
+    // Drift reference: raw (uncorrected) offset at ref_t4_us.
+    bool has_drift_ref;
+    int64_t ref_t4_us;
+    int64_t ref_raw_offset_us;
+    int64_t corrections_since_ref_us;
+
+    uint32_t samples_total;
+    uint32_t samples_rejected;
+    uint32_t steps;
+  } clock_sync_t;
+
+  void ClockSyncInit(clock_sync_t* sync, int64_t step_threshold_us);
+
+  // Feeds one completed exchange. Returns the action to apply and the
+  // correction (root minus leaf, in microseconds). poll_interval_us is the
+  // expected time until the next sample; the slew includes the drift
+  // predicted over that interval.
+  clock_sync_action_t ClockSyncAddSample(clock_sync_t* sync,
+                                         const clock_sync_sample_t* sample,
+                                         int64_t poll_interval_us,
+                                         int64_t* correction_us_out);
+
+  // The clock did not apply unapplied_us of the corrections returned so far
+  // (a slew cut short by the next one). Call before the next sample so the
+  // window and the drift estimate describe the clock as it is; a negative
+  // value books a correction applied outside ClockSyncAddSample().
+  void ClockSyncNoteUnapplied(clock_sync_t* sync, int64_t unapplied_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_CLOCK_SYNC_H_
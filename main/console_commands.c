@@ -3,6 +3,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include <dirent.h>
 #include <inttypes.h>
 #include <math.h>
 #include <stdio.h>
@@ -12,7 +13,9 @@
 
 #include "argtable3/argtable3.h"
 #include "boot_mode.h"
+#include "burst_capture.h"
 #include "calibration.h"
+#include "data_port.h"
 #include "diagnostics/diag_fram.h"
 #include "diagnostics/diag_mesh.h"
 #include "diagnostics/diag_rtc.h"
@@ -35,6 +38,7 @@
 #include "esp_log.h"
 #include "esp_system.h"
 #include "linenoise/linenoise.h"
+#include "mesh_rejoin.h"
 #include "runtime_manager.h"
 #include "time_sync.h"
 
@@ -115,6 +119,17 @@ CommandStatus(int argc, char** argv)
   printf("runtime_running: %s\n", RuntimeIsRunning() ? "yes" : "no");
   printf("time_valid: %s\n", TimeSyncIsSystemTimeValid() ? "yes" : "no");
   printf("log_period_ms: %u\n", (unsigned)settings->log_period_ms);
+  if (g_runtime->sensor != NULL) {
+    printf("sensor_conversion: %s drdy_gpio=%d (timeouts=%u)\n",
+           g_runtime->sensor->continuous ? "continuous" : "one-shot",
+           g_runtime->sensor->drdy_gpio,
+           (unsigned)g_runtime->sensor->drdy_timeouts);
+  }
+  if (g_runtime->rtd_channels != NULL) {
+    printf("rtd_channels: %u (last_cycle_us=%d)\n",
+           (unsigned)g_runtime->rtd_channels->count,
+           (int)g_runtime->rtd_channels->last_cycle_us);
+  }
   printf("sd_flush_period_ms: %u\n", (unsigned)settings->sd_flush_period_ms);
   printf("sd_batch_target_bytes: %u\n",
          (unsigned)settings->sd_batch_bytes_target);
@@ -178,14 +193,20 @@ CommandStatus(int argc, char** argv)
   printf("fram_count/seq: %u/%u\n",
          (unsigned)FramLogGetBufferedRecords(g_runtime->fram_log),
          (unsigned)FramLogNextSequence(g_runtime->fram_log));
-  const uint32_t export_dropped = (g_runtime->export_dropped_count != NULL)
-                                    ? *g_runtime->export_dropped_count
-                                    : 0u;
+  const record_ring_t* export_ring = g_runtime->export_ring;
+  const uint32_t export_dropped =
+    (export_ring != NULL) ? (uint32_t)export_ring->dropped : 0u;
   const uint32_t export_write_fail =
     (g_runtime->export_write_fail_count != NULL)
       ? *g_runtime->export_write_fail_count
       : 0u;
   printf("export_dropped_count: %u\n", (unsigned)export_dropped);
+  if (export_ring != NULL) {
+    printf("export_ring_capacity/high_water: %u/%u (%s)\n",
+           (unsigned)export_ring->capacity,
+           (unsigned)export_ring->high_water,
+           export_ring->in_psram ? "psram" : "internal");
+  }
   printf("export_write_fail_count: %u\n", (unsigned)export_write_fail);
 
   printf("calibration: mode=%s degree=%u coeffs=[%.9g, %.9g, %.9g, %.9g]\n",
@@ -214,6 +235,196 @@ CommandStatus(int argc, char** argv)
          SdLoggerLastRecordIdOnSd(g_runtime->sd_logger));
   printf("mesh_connected: %s\n",
          MeshTransportIsConnected(g_runtime->mesh) ? "yes" : "no");
+  const mesh_transport_stats_t* mesh_stats = &g_runtime->mesh->stats;
+  printf("mesh_tx_frames/records: %u/%u\n",
+         (unsigned)mesh_stats->frames_sent,
+         (unsigned)mesh_stats->records_sent);
+  printf("mesh_tx_fail/dropped: %u/%u\n",
+         (unsigned)mesh_stats->send_failures,
+         (unsigned)mesh_stats->records_dropped);
+  printf("mesh_rx_frames/records: %u/%u (decode_errors=%u)\n",
+         (unsigned)mesh_stats->frames_received,
+         (unsigned)mesh_stats->records_received,
+         (unsigned)mesh_stats->decode_errors);
+  if (g_runtime->mesh->is_root) {
+    mesh_reorder_stats_t reorder;
+    uint32_t node_count = 0;
+    uint32_t buffered = 0;
+    MeshTransportGetReorderStats(
+      g_runtime->mesh, &reorder, &node_count, &buffered);
+    printf("mesh_nodes/buffered: %u/%u (untracked=%u)\n",
+           (unsigned)node_count,
+           (unsigned)buffered,
+           (unsigned)mesh_stats->records_untracked);
+    printf("mesh_rx_lock_timeouts: %u\n",
+           (unsigned)mesh_stats->rx_lock_timeouts);
+    printf("mesh_rx_delivered: %" PRIu64 "\n", reorder.delivered);
+    printf("mesh_rx_dup/reordered/skipped/late: %u/%u/%u/%u\n",
+           (unsigned)reorder.duplicates,
+           (unsigned)reorder.reordered,
+           (unsigned)reorder.gaps_skipped,
+           (unsigned)reorder.late_recovered);
+    printf("mesh_rx_lost: %" PRIu64 "\n", reorder.lost);
+    printf("mesh_rx_refused: %u (export ring full, re-requested)\n",
+           (unsigned)reorder.refused);
+    printf("mesh_acks_sent: %u\n", (unsigned)mesh_stats->acks_sent);
+    if (g_runtime->mesh->credit_budget == MESH_TRANSPORT_CREDIT_UNLIMITED) {
+      printf("mesh_credit_budget: unlimited\n");
+    } else {
+      printf("mesh_credit_budget: %u records/min\n",
+             (unsigned)g_runtime->mesh->credit_budget);
+    }
+    uplink_stats_t uplink;
+    if (RuntimeGetUplinkStats(&uplink)) {
+      printf("uplink: %s connects=%u fails=%u drops=%u\n",
+             uplink.connected ? "connected" : "down",
+             (unsigned)uplink.connects,
+             (unsigned)uplink.connect_failures,
+             (unsigned)uplink.disconnects);
+      printf("uplink_sent/replayed/skipped/dropped: %u/%u/%u/%u\n",
+             (unsigned)uplink.records_sent,
+             (unsigned)uplink.records_replayed,
+             (unsigned)uplink.records_skipped,
+             (unsigned)uplink.records_dropped);
+      printf("uplink_pending: %u (frames=%u bytes=%" PRIu64 ")\n",
+             (unsigned)uplink.window_pending,
+             (unsigned)uplink.frames_sent,
+             uplink.bytes_sent);
+    }
+    const uint32_t interned_count = NodeTableCount(g_runtime->node_table);
+    if (g_runtime->node_table->records_refused > 0) {
+      printf("node_table_full_dropped: %u (nodes=%u)\n",
+             (unsigned)g_runtime->node_table->records_refused,
+             (unsigned)g_runtime->node_table->refused_count);
+    }
+    const int64_t now_us = esp_timer_get_time();
+    for (uint32_t index = 0; index < interned_count; ++index) {
+      const node_table_entry_t* node =
+        NodeTableGet(g_runtime->node_table, (uint8_t)index);
+      if (node == NULL) {
+        break;
+      }
+      printf("node[%u]: %s records=%u dropped=%u last_id=%" PRIu64
+             " age_s=%lld\n",
+             (unsigned)index,
+             node->id_string,
+             (unsigned)node->records,
+             (unsigned)node->records_dropped,
+             node->last_record_id,
+             (node->last_seen_us > 0)
+               ? (long long)((now_us - node->last_seen_us) / 1000000)
+               : -1LL);
+    }
+  } else {
+    runtime_mesh_forward_stats_t forward;
+    RuntimeGetMeshForwardStats(&forward);
+    printf("mesh_backlog_records: %" PRIu64 "\n", forward.backlog_records);
+    printf("mesh_backfill/rewinds/acks: %u/%u/%u\n",
+           (unsigned)forward.backfill_records_total,
+           (unsigned)forward.rewinds_total,
+           (unsigned)mesh_stats->acks_received);
+    if (forward.ram_backlog_dropped > 0) {
+      printf("mesh_ram_backlog_dropped: %u\n",
+             (unsigned)forward.ram_backlog_dropped);
+    }
+    const uint32_t credit_grant = MeshTransportCreditGrant(g_runtime->mesh);
+    if (credit_grant == MESH_TRANSPORT_CREDIT_UNLIMITED) {
+      printf("mesh_credit: unlimited (deferred=%u)\n",
+             (unsigned)mesh_stats->credit_deferred);
+    } else {
+      printf("mesh_credit: %u records/min (deferred=%u)\n",
+             (unsigned)credit_grant,
+             (unsigned)mesh_stats->credit_deferred);
+    }
+    printf("mesh_rejoin: count=%u last=%u ms max=%u ms\n",
+           (unsigned)mesh_stats->rejoins,
+           (unsigned)mesh_stats->rejoin_last_ms,
+           (unsigned)mesh_stats->rejoin_max_ms);
+    mesh_rejoin_status_t rejoin;
+    MeshRejoinGetStatus(&rejoin);
+    if (rejoin.enabled) {
+      if (rejoin.cache_valid) {
+        printf("mesh_parent_cache: %02x:%02x:%02x:%02x:%02x:%02x ch=%u%s\n",
+               rejoin.parent.bssid[0],
+               rejoin.parent.bssid[1],
+               rejoin.parent.bssid[2],
+               rejoin.parent.bssid[3],
+               rejoin.parent.bssid[4],
+               rejoin.parent.bssid[5],
+               (unsigned)rejoin.parent.channel,
+               rejoin.pinned ? " (pinned)" : "");
+      } else {
+        printf("mesh_parent_cache: empty\n");
+      }
+      printf("mesh_fast_rejoin windows/attempts/joins/fallbacks: "
+             "%u/%u/%u/%u\n",
+             (unsigned)rejoin.fast_windows,
+             (unsigned)rejoin.fast_attempts,
+             (unsigned)rejoin.fast_joins,
+             (unsigned)rejoin.fallbacks);
+    }
+    if (g_runtime->mesh->relay != NULL) {
+      printf("mesh_relay_in/out/sections/records: %u/%u/%u/%u "
+             "(passthrough=%u)\n",
+             (unsigned)mesh_stats->relay_frames_in,
+             (unsigned)mesh_stats->relay_frames_sent,
+             (unsigned)mesh_stats->relay_sections_sent,
+             (unsigned)mesh_stats->relay_records_sent,
+             (unsigned)mesh_stats->relay_passthrough);
+    }
+    clock_sync_t clock_sync;
+    if (RuntimeGetClockSync(&clock_sync)) {
+      const int64_t age_s =
+        (TimeSyncGetEpochUs() - clock_sync.last_sync_us) / 1000000;
+      printf("time_sync_offset/error/delay_us: %lld/%lld/%lld\n",
+             (long long)clock_sync.offset_us,
+             (long long)clock_sync.error_us,
+             (long long)clock_sync.delay_us);
+      printf("time_sync_drift_ppm: %.2f (age_s=%lld)\n",
+             clock_sync.drift_ppm,
+             (long long)age_s);
+    } else {
+      printf("time_sync: not locked\n");
+    }
+    printf("time_sync_probes/replies/rejected/steps: %u/%u/%u/%u\n",
+           (unsigned)mesh_stats->time_probes_sent,
+           (unsigned)mesh_stats->time_replies_received,
+           (unsigned)clock_sync.samples_rejected,
+           (unsigned)clock_sync.steps);
+  }
+  runtime_sample_rate_t sample_rate;
+  RuntimeGetSampleRate(&sample_rate);
+  printf("sample_rate: every %u ms (%s)\n",
+         (unsigned)sample_rate.period_ms,
+         !g_runtime->settings->adaptive_rate.enabled ? "fixed"
+         : sample_rate.fast                           ? "adaptive fast"
+                                                      : "adaptive slow");
+  sample_timing_stats_t sample_timing;
+  RuntimeGetSampleTimingStats(&sample_timing);
+  printf("sample_aligned/total/missed: %u/%u/%u\n",
+         (unsigned)sample_timing.aligned_samples,
+         (unsigned)sample_timing.samples,
+         (unsigned)sample_timing.missed_boundaries);
+  printf("sample_jitter_us last/mean/max: %ld/%ld/%ld (read_us=%ld)\n",
+         (long)sample_timing.last_jitter_us,
+         (long)sample_timing.mean_abs_jitter_us,
+         (long)sample_timing.max_abs_jitter_us,
+         (long)sample_timing.read_duration_us);
+  printf("sensor_stack_free: %u bytes\n",
+         (unsigned)RuntimeSensorStackFree());
+  runtime_alarm_stats_t alarms;
+  RuntimeGetAlarmStats(&alarms);
+  printf("alarms raised/cleared/sent/pending/dropped: %u/%u/%u/%u/%u\n",
+         (unsigned)alarms.raised,
+         (unsigned)alarms.cleared,
+         (unsigned)alarms.sent,
+         (unsigned)alarms.pending,
+         (unsigned)alarms.dropped);
+  printf("alarms_exported: %u (latency_ms last/max: %u/%u, mesh rx=%u)\n",
+         (unsigned)alarms.exported,
+         (unsigned)alarms.latency_last_ms,
+         (unsigned)alarms.latency_max_ms,
+         (unsigned)mesh_stats->alarms_received);
   printf("cal_points: %u\n",
          (unsigned)g_runtime->settings->calibration_points_count);
   return 0;
@@ -400,6 +611,7 @@ static struct
 static struct
 {
   struct arg_str* action;
+  struct arg_str* value;
   struct arg_end* end;
 } g_data_args;
 
@@ -445,6 +657,313 @@ static struct
   struct arg_end* end;
 } g_children_args;
 
+static struct
+{
+  struct arg_str* action;
+  struct arg_int* channel;
+  struct arg_dbl* coeffs;
+  struct arg_end* end;
+} g_rtd_args;
+
+static void
+PrintSampleFilter(const sample_filter_config_t* config)
+{
+  const uint32_t log_period_ms = g_runtime->settings->log_period_ms;
+  printf("filter: median=%u ema_alpha=%.4f decimate=%u cic_order=%u "
+         "(sample every %u ms)\n",
+         (unsigned)config->median_n,
+         config->ema_alpha_q16 / (double)SAMPLE_FILTER_EMA_ALPHA_ONE,
+         (unsigned)config->decimation,
+         (unsigned)config->cic_order,
+         (unsigned)SampleFilterSamplePeriodMs(config, log_period_ms));
+}
+
+static void
+PrintSampleFilterStage(const char* name,
+                       const sample_filter_stage_stats_t* stage)
+{
+  if (stage->in == 0) {
+    return;
+  }
+  printf("  %-9s in/out %u/%u  |delta| mean/max %ld/%ld mC\n",
+         name,
+         (unsigned)stage->in,
+         (unsigned)stage->out,
+         (long)stage->mean_abs_delta_milli_c,
+         (long)stage->max_abs_delta_milli_c);
+}
+
+// log filter [show] | off | median <n> | ema <alpha> |
+// decimate <factor> [cic_order]
+static int
+CommandLogFilter(int argc, char** argv)
+{
+  sample_filter_config_t config = g_runtime->settings->sample_filter;
+  const char* action = (argc >= 3) ? argv[2] : "show";
+  if (strcmp(action, "show") == 0) {
+    PrintSampleFilter(&config);
+    for (uint8_t ch = 0; ch < RTD_CHANNELS_MAX; ++ch) {
+      sample_filter_stats_t stats;
+      if (!RuntimeGetSampleFilterStats(ch, &stats)) {
+        break;
+      }
+      printf("ch%u: resets=%u discarded_blocks=%u\n",
+             (unsigned)ch,
+             (unsigned)stats.resets,
+             (unsigned)stats.discarded_blocks);
+      PrintSampleFilterStage("median", &stats.median);
+      PrintSampleFilterStage("ema", &stats.ema);
+      PrintSampleFilterStage("decimator", &stats.decimator);
+    }
+    return 0;
+  }
+
+  char* end = NULL;
+  if (strcmp(action, "off") == 0 && argc == 3) {
+    SampleFilterConfigInitDefault(&config);
+  } else if (strcmp(action, "median") == 0 && argc == 4) {
+    const long n = strtol(argv[3], &end, 10);
+    if (end == argv[3] || *end != '\0' || n < 1 ||
+        n > SAMPLE_FILTER_MEDIAN_MAX || (n % 2) == 0) {
+      printf("invalid median size (odd, 1..%d; 1 = off)\n",
+             SAMPLE_FILTER_MEDIAN_MAX);
+      return 1;
+    }
+    config.median_n = (uint8_t)n;
+  } else if (strcmp(action, "ema") == 0 && argc == 4) {
+    const double alpha = strtod(argv[3], &end);
+    if (end == argv[3] || *end != '\0' || !(alpha >= 0.0 && alpha <= 1.0)) {
+      printf("invalid alpha (0..1; 0 = off)\n");
+      return 1;
+    }
+    config.ema_alpha_q16 =
+      (uint32_t)lround(alpha * (double)SAMPLE_FILTER_EMA_ALPHA_ONE);
+    if (alpha > 0.0 && config.ema_alpha_q16 == 0) {
+      config.ema_alpha_q16 = 1;
+    }
+  } else if (strcmp(action, "decimate") == 0 && (argc == 4 || argc == 5)) {
+    const long factor = strtol(argv[3], &end, 10);
+    if (end == argv[3] || *end != '\0' || factor < 1 ||
+        factor > SAMPLE_FILTER_DECIMATION_MAX) {
+      printf("invalid factor (1..%d; 1 = off)\n",
+             SAMPLE_FILTER_DECIMATION_MAX);
+      return 1;
+    }
+    long order = config.cic_order;
+    if (argc == 5) {
+      order = strtol(argv[4], &end, 10);
+      if (end == argv[4] || *end != '\0' || order < 1 ||
+          order > SAMPLE_FILTER_CIC_ORDER_MAX) {
+        printf("invalid cic order (1..%d; 1 = boxcar)\n",
+               SAMPLE_FILTER_CIC_ORDER_MAX);
+        return 1;
+      }
+    }
+    config.decimation = (uint8_t)factor;
+    config.cic_order = (uint8_t)order;
+  } else {
+    printf("usage: log filter [show] | off | median <n> | ema <alpha> | "
+           "decimate <factor> [cic_order]\n");
+    return 1;
+  }
+
+  const uint32_t sample_period_ms =
+    SampleFilterSamplePeriodMs(&config, g_runtime->settings->log_period_ms);
+  if (sample_period_ms < APP_SETTINGS_LOG_PERIOD_MIN_MS) {
+    printf("decimation must divide log_period_ms (%u) into samples of at "
+           "least %u ms\n",
+           (unsigned)g_runtime->settings->log_period_ms,
+           (unsigned)APP_SETTINGS_LOG_PERIOD_MIN_MS);
+    return 1;
+  }
+  const adaptive_rate_config_t* adaptive = &g_runtime->settings->adaptive_rate;
+  if (adaptive->enabled &&
+      SampleFilterSamplePeriodMs(&config, adaptive->fast_period_ms) <
+        APP_SETTINGS_LOG_PERIOD_MIN_MS) {
+    printf("decimation must also divide the adaptive fast period (%u ms)\n",
+           (unsigned)adaptive->fast_period_ms);
+    return 1;
+  }
+  // The sensor task picks the change up at its next sample.
+  g_runtime->settings->sample_filter = config;
+  esp_err_t result = AppSettingsSaveSampleFilter(&config);
+  if (result != ESP_OK) {
+    printf("save failed: %s\n", esp_err_to_name(result));
+    return 1;
+  }
+  PrintSampleFilter(&config);
+  return 0;
+}
+
+static void
+PrintRecordCompression(const record_compression_config_t* config)
+{
+  if (config->mode == RECORD_COMPRESSION_OFF) {
+    printf("compress: off\n");
+    return;
+  }
+  printf("compress: %s error=%ld mC heartbeat=%u s\n",
+         RecordCompressionModeToString(config->mode),
+         (long)config->error_milli_c,
+         (unsigned)(config->heartbeat_ms / 1000u));
+}
+
+// log compress [show] | off | sdt|deadband <error_mC> [heartbeat_s]
+static int
+CommandLogCompress(int argc, char** argv)
+{
+  record_compression_config_t config = g_runtime->settings->record_compression;
+  const char* action = (argc >= 3) ? argv[2] : "show";
+  if (strcmp(action, "show") == 0) {
+    PrintRecordCompression(&config);
+    for (uint8_t ch = 0; ch < RTD_CHANNELS_MAX; ++ch) {
+      record_compression_stats_t stats;
+      if (!RuntimeGetRecordCompressionStats(ch, &stats)) {
+        break;
+      }
+      printf("ch%u: in=%u kept=%u heartbeats=%u (%.1fx)\n",
+             (unsigned)ch,
+             (unsigned)stats.in,
+             (unsigned)stats.out,
+             (unsigned)stats.heartbeats,
+             (stats.out > 0) ? (double)stats.in / stats.out : 0.0);
+    }
+    return 0;
+  }
+
+  if (strcmp(action, "off") == 0 && argc == 3) {
+    config.mode = RECORD_COMPRESSION_OFF;
+  } else if ((strcmp(action, "sdt") == 0 ||
+              strcmp(action, "deadband") == 0) &&
+             (argc == 4 || argc == 5)) {
+    char* end = NULL;
+    const long error_milli_c = strtol(argv[3], &end, 10);
+    if (end == argv[3] || *end != '\0' || error_milli_c < 1 ||
+        error_milli_c > 100000) {
+      printf("invalid error (1..100000 mC)\n");
+      return 1;
+    }
+    if (argc == 5) {
+      const long heartbeat_s = strtol(argv[4], &end, 10);
+      if (end == argv[4] || *end != '\0' || heartbeat_s < 1 ||
+          heartbeat_s > 86400) {
+        printf("invalid heartbeat (1..86400 s)\n");
+        return 1;
+      }
+      config.heartbeat_ms = (uint32_t)heartbeat_s * 1000u;
+    }
+    config.mode = (strcmp(action, "sdt") == 0)
+                    ? RECORD_COMPRESSION_SWINGING_DOOR
+                    : RECORD_COMPRESSION_DEADBAND;
+    config.error_milli_c = (int32_t)error_milli_c;
+  } else {
+    printf("usage: log compress [show] | off | sdt <error_mC> [heartbeat_s] "
+           "| deadband <error_mC> [heartbeat_s]\n");
+    return 1;
+  }
+
+  // The sensor task picks the change up at its next sample.
+  g_runtime->settings->record_compression = config;
+  esp_err_t result = AppSettingsSaveRecordCompression(&config);
+  if (result != ESP_OK) {
+    printf("save failed: %s\n", esp_err_to_name(result));
+    return 1;
+  }
+  PrintRecordCompression(&config);
+  return 0;
+}
+
+static void
+PrintAdaptiveRate(const adaptive_rate_config_t* config)
+{
+  if (!config->enabled) {
+    printf("adaptive: off\n");
+    return;
+  }
+  printf("adaptive: fast=%u ms above %ld mC/min, slow after %u s calm\n",
+         (unsigned)config->fast_period_ms,
+         (long)config->rise_milli_c_per_min,
+         (unsigned)(config->dwell_ms / 1000u));
+}
+
+// log adaptive [show] | off | <fast_ms> <rise_mC_per_min> [dwell_s]
+static int
+CommandLogAdaptive(int argc, char** argv)
+{
+  adaptive_rate_config_t config = g_runtime->settings->adaptive_rate;
+  const char* action = (argc >= 3) ? argv[2] : "show";
+  if (strcmp(action, "show") == 0) {
+    PrintAdaptiveRate(&config);
+    for (uint8_t ch = 0; ch < RTD_CHANNELS_MAX; ++ch) {
+      adaptive_rate_t rate;
+      if (!RuntimeGetAdaptiveRate(ch, &rate)) {
+        break;
+      }
+      printf("ch%u: %s slope=%ld mC/min noise=%ld mC to_fast/to_slow=%u/%u\n",
+             (unsigned)ch,
+             rate.fast ? "fast" : "slow",
+             (long)rate.slope_milli_c_per_min,
+             (long)rate.noise_milli_c,
+             (unsigned)rate.to_fast,
+             (unsigned)rate.to_slow);
+    }
+    return 0;
+  }
+
+  if (strcmp(action, "off") == 0 && argc == 3) {
+    config.enabled = false;
+  } else if (argc == 4 || argc == 5) {
+    char* end = NULL;
+    const long fast_ms = strtol(argv[2], &end, 10);
+    if (end == argv[2] || *end != '\0' ||
+        fast_ms < (long)APP_SETTINGS_LOG_PERIOD_MIN_MS ||
+        fast_ms >= (long)g_runtime->settings->log_period_ms) {
+      printf("invalid fast period (%u ms..log_period_ms)\n",
+             (unsigned)APP_SETTINGS_LOG_PERIOD_MIN_MS);
+      return 1;
+    }
+    const long rise = strtol(argv[3], &end, 10);
+    if (end == argv[3] || *end != '\0' || rise < 1 || rise > 10000000) {
+      printf("invalid rise rate (1..10000000 mC/min)\n");
+      return 1;
+    }
+    if (argc == 5) {
+      const long dwell_s = strtol(argv[4], &end, 10);
+      if (end == argv[4] || *end != '\0' || dwell_s < 1 || dwell_s > 86400) {
+        printf("invalid dwell (1..86400 s)\n");
+        return 1;
+      }
+      config.dwell_ms = (uint32_t)dwell_s * 1000u;
+    }
+    const sample_filter_config_t* filter = &g_runtime->settings->sample_filter;
+    if (SampleFilterSamplePeriodMs(filter, (uint32_t)fast_ms) <
+        APP_SETTINGS_LOG_PERIOD_MIN_MS) {
+      printf("fast period must split into %u samples of at least %u ms "
+             "(log filter decimate)\n",
+             (unsigned)filter->decimation,
+             (unsigned)APP_SETTINGS_LOG_PERIOD_MIN_MS);
+      return 1;
+    }
+    config.enabled = true;
+    config.fast_period_ms = (uint32_t)fast_ms;
+    config.rise_milli_c_per_min = (int32_t)rise;
+  } else {
+    printf("usage: log adaptive [show] | off | <fast_ms> <rise_mC_per_min> "
+           "[dwell_s]\n");
+    return 1;
+  }
+
+  // The sensor task picks the change up at its next sample.
+  g_runtime->settings->adaptive_rate = config;
+  esp_err_t result = AppSettingsSaveAdaptiveRate(&config);
+  if (result != ESP_OK) {
+    printf("save failed: %s\n", esp_err_to_name(result));
+    return 1;
+  }
+  PrintAdaptiveRate(&config);
+  return 0;
+}
+
 static int
 CommandLog(int argc, char** argv)
 {
@@ -454,7 +973,8 @@ CommandLog(int argc, char** argv)
 
   if (argc < 2) {
     printf("usage: log interval <ms> | log watermark <records> | log "
-           "flush_period <ms> | log batch <bytes> | log show\n");
+           "flush_period <ms> | log batch <bytes> | log filter ... | log "
+           "compress ... | log adaptive ... | log show\n");
     return 1;
   }
 
@@ -463,6 +983,15 @@ CommandLog(int argc, char** argv)
     // Backwards/typo-friendly alias.
     action = "flush_period";
   }
+  if (strcmp(action, "filter") == 0) {
+    return CommandLogFilter(argc, argv);
+  }
+  if (strcmp(action, "compress") == 0) {
+    return CommandLogCompress(argc, argv);
+  }
+  if (strcmp(action, "adaptive") == 0) {
+    return CommandLogAdaptive(argc, argv);
+  }
   if (strcmp(action, "interval") == 0) {
     if (argc != 3) {
       printf("usage: log interval <ms>\n");
@@ -475,8 +1004,28 @@ CommandLog(int argc, char** argv)
       return 1;
     }
     const int interval_ms = (int)interval_ms_long;
-    if (interval_ms < 100 || interval_ms > 3600000) {
-      printf("invalid interval\n");
+    if (interval_ms < (int)APP_SETTINGS_LOG_PERIOD_MIN_MS ||
+        interval_ms > (int)APP_SETTINGS_LOG_PERIOD_MAX_MS) {
+      printf("invalid interval (%u..%u ms)\n",
+             (unsigned)APP_SETTINGS_LOG_PERIOD_MIN_MS,
+             (unsigned)APP_SETTINGS_LOG_PERIOD_MAX_MS);
+      return 1;
+    }
+    const sample_filter_config_t* filter = &g_runtime->settings->sample_filter;
+    if (SampleFilterSamplePeriodMs(filter, (uint32_t)interval_ms) <
+        APP_SETTINGS_LOG_PERIOD_MIN_MS) {
+      printf("interval must split into %u samples of at least %u ms "
+             "(log filter decimate)\n",
+             (unsigned)filter->decimation,
+             (unsigned)APP_SETTINGS_LOG_PERIOD_MIN_MS);
+      return 1;
+    }
+    const adaptive_rate_config_t* adaptive =
+      &g_runtime->settings->adaptive_rate;
+    if (adaptive->enabled &&
+        (uint32_t)interval_ms <= adaptive->fast_period_ms) {
+      printf("interval must exceed the adaptive fast period (%u ms)\n",
+             (unsigned)adaptive->fast_period_ms);
       return 1;
     }
     g_runtime->settings->log_period_ms = (uint32_t)interval_ms;
@@ -576,6 +1125,9 @@ CommandLog(int argc, char** argv)
            (unsigned)g_runtime->settings->sd_flush_period_ms);
     printf("sd_batch_target_bytes: %u\n",
            (unsigned)g_runtime->settings->sd_batch_bytes_target);
+    PrintSampleFilter(&g_runtime->settings->sample_filter);
+    PrintRecordCompression(&g_runtime->settings->record_compression);
+    PrintAdaptiveRate(&g_runtime->settings->adaptive_rate);
     return 0;
   }
 
@@ -959,6 +1511,97 @@ CommandMode(int argc, char** argv)
   return 1;
 }
 
+static void
+PrintChannelModel(uint8_t channel, const calibration_model_t* model)
+{
+  if (!model->is_valid) {
+    printf("  ch%u: uncalibrated\n", (unsigned)channel);
+    return;
+  }
+  printf("  ch%u: degree=%u c0=%.6f c1=%.6f c2=%.9f c3=%.12f\n",
+         (unsigned)channel,
+         (unsigned)model->degree,
+         model->coefficients[0],
+         model->coefficients[1],
+         model->coefficients[2],
+         model->coefficients[3]);
+}
+
+// Extra RTD channels. Channel 0 is calibrated with 'cal'; the others take
+// polynomial coefficients fitted off-device.
+static int
+CommandRtd(int argc, char** argv)
+{
+  int errors = arg_parse(argc, argv, (void**)&g_rtd_args);
+  if (errors != 0) {
+    arg_print_errors(stderr, g_rtd_args.end, argv[0]);
+    return 1;
+  }
+  if (g_runtime == NULL || g_runtime->rtd_channels == NULL) {
+    return 1;
+  }
+  const rtd_channels_t* channels = g_runtime->rtd_channels;
+  app_settings_t* settings = g_runtime->settings;
+
+  const char* action = g_rtd_args.action->sval[0];
+  if (strcmp(action, "show") == 0) {
+    printf("rtd_channels: %u (cycles=%u last_cycle_us=%d)\n",
+           (unsigned)channels->count,
+           (unsigned)channels->cycles,
+           (int)channels->last_cycle_us);
+    for (uint8_t ch = 0; ch < channels->count; ++ch) {
+      const max31865_reader_t* reader = channels->readers[ch];
+      printf("  ch%u: cs_gpio=%d %s\n",
+             (unsigned)ch,
+             reader->cs_gpio,
+             reader->is_initialized ? "ok" : "not initialized");
+    }
+    printf("calibration (ch0: see 'cal show'):\n");
+    for (uint8_t ch = 1; ch < channels->count; ++ch) {
+      PrintChannelModel(ch, &settings->channel_calibration[ch]);
+    }
+    return 0;
+  }
+
+  const bool set = (strcmp(action, "set") == 0);
+  if (!set && strcmp(action, "clear") != 0) {
+    printf("unknown action. usage: rtd show | rtd set <channel> <c0> <c1> "
+           "[c2] [c3] | rtd clear <channel>\n");
+    return 1;
+  }
+  const int channel =
+    (g_rtd_args.channel->count > 0) ? g_rtd_args.channel->ival[0] : -1;
+  if (channel < 1 || channel >= (int)channels->count) {
+    printf("channel must be 1..%d\n", (int)channels->count - 1);
+    return 1;
+  }
+  if (set && g_rtd_args.coeffs->count < 2) {
+    printf("usage: rtd set <channel> <c0> <c1> [c2] [c3]\n");
+    return 1;
+  }
+
+  calibration_model_t* model = &settings->channel_calibration[channel];
+  CalibrationModelInitIdentity(model);
+  if (set) {
+    model->degree = (uint8_t)(g_rtd_args.coeffs->count - 1);
+    model->mode =
+      (model->degree > 1) ? CAL_FIT_MODE_POLY : CAL_FIT_MODE_LINEAR;
+    for (int i = 0; i < g_rtd_args.coeffs->count; ++i) {
+      model->coefficients[i] = g_rtd_args.coeffs->dval[i];
+    }
+  } else {
+    model->is_valid = false;
+  }
+  esp_err_t result =
+    AppSettingsSaveChannelCalibration(settings->channel_calibration);
+  if (result != ESP_OK) {
+    printf("save failed: %s\n", esp_err_to_name(result));
+    return 1;
+  }
+  PrintChannelModel((uint8_t)channel, model);
+  return 0;
+}
+
 static int
 CommandData(int argc, char** argv)
 {
@@ -972,6 +1615,53 @@ CommandData(int argc, char** argv)
   if (strcmp(action, "show") == 0) {
     printf("data_streaming: %s\n",
            RuntimeIsDataStreamingEnabled() ? "on" : "off");
+    printf("data_format: %s\n",
+           AppSettingsExportFormatToString(RuntimeGetExportFormat()));
+    printf("data_baud: %u\n", (unsigned)DataPortGetBaudRate());
+    return 0;
+  }
+
+  if (strcmp(action, "format") == 0) {
+    app_export_format_t format = APP_EXPORT_FORMAT_CSV;
+    if (g_data_args.value->count == 0 ||
+        !AppSettingsParseExportFormat(g_data_args.value->sval[0], &format)) {
+      printf("usage: data format csv|binary\n");
+      return 1;
+    }
+    RuntimeSetExportFormat(format);
+    esp_err_t result = AppSettingsSaveExportFormat(format);
+    if (result != ESP_OK) {
+      printf("save failed: %s\n", esp_err_to_name(result));
+      return 1;
+    }
+    printf("data_format set to %s\n", AppSettingsExportFormatToString(format));
+    return 0;
+  }
+
+  if (strcmp(action, "baud") == 0) {
+    char* end = NULL;
+    const unsigned long baud =
+      (g_data_args.value->count > 0)
+        ? strtoul(g_data_args.value->sval[0], &end, 10)
+        : 0;
+    if (end == NULL || *end != '\0' || baud > UINT32_MAX) {
+      printf("usage: data baud <rate>\n");
+      return 1;
+    }
+    esp_err_t result = DataPortSetBaudRate((uint32_t)baud);
+    if (result != ESP_OK) {
+      printf("set failed: %s\n", esp_err_to_name(result));
+      return 1;
+    }
+    if (g_runtime != NULL && g_runtime->settings != NULL) {
+      g_runtime->settings->data_baud_rate = (uint32_t)baud;
+    }
+    result = AppSettingsSaveDataBaudRate((uint32_t)baud);
+    if (result != ESP_OK) {
+      printf("save failed: %s\n", esp_err_to_name(result));
+      return 1;
+    }
+    printf("data_baud set to %u\n", (unsigned)baud);
     return 0;
   }
 
@@ -987,7 +1677,8 @@ CommandData(int argc, char** argv)
     return 0;
   }
 
-  printf("unknown action. usage: data show | data on | data off\n");
+  printf("unknown action. usage: data show | data on | data off | data format "
+         "csv|binary | data baud <rate>\n");
   return 1;
 }
 
@@ -1707,6 +2398,282 @@ CommandDiagnostics(int argc, char** argv)
   return 2;
 }
 
+static const char*
+BurstStateToString(uint8_t state)
+{
+  switch (state) {
+    case BURST_CAPTURE_ARMED:
+      return "armed";
+    case BURST_CAPTURE_CAPTURING:
+      return "capturing";
+    case BURST_CAPTURE_FROZEN:
+      return "frozen (writing)";
+    default:
+      return "unknown";
+  }
+}
+
+static void
+PrintBurstConfig(const burst_capture_config_t* config)
+{
+  if (!config->enabled) {
+    printf("burst: off\n");
+    return;
+  }
+  printf("burst: every %u ms, pre=%u ms post=%u ms\n",
+         (unsigned)config->period_ms,
+         (unsigned)config->pre_ms,
+         (unsigned)config->post_ms);
+  if (config->level_enabled) {
+    printf("burst trigger level: %ld mC\n", (long)config->level_milli_c);
+  }
+  if (config->slope_milli_c_per_s > 0) {
+    printf("burst trigger slope: %ld mC/s\n",
+           (long)config->slope_milli_c_per_s);
+  }
+}
+
+static int
+BurstList(void)
+{
+  char dir_path[48];
+  snprintf(dir_path,
+           sizeof(dir_path),
+           "%s/%s",
+           g_runtime->sd_logger->mount_point,
+           BURST_CAPTURE_DIR);
+  DIR* dir = opendir(dir_path);
+  if (dir == NULL) {
+    printf("no bursts\n");
+    return 0;
+  }
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    uint32_t id = 0;
+    if (!BurstCaptureParseFileName(entry->d_name, &id)) {
+      continue;
+    }
+    char path[96];
+    snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+    char header[160] = "";
+    long size = 0;
+    FILE* file = fopen(path, "rb");
+    if (file != NULL) {
+      if (fgets(header, sizeof(header), file) == NULL) {
+        header[0] = '\0';
+      }
+      fseek(file, 0, SEEK_END);
+      size = ftell(file);
+      fclose(file);
+    }
+    header[strcspn(header, "\r\n")] = '\0';
+    printf("%5lu %8ld B  %s\n",
+           (unsigned long)id,
+           size,
+           (header[0] == '#') ? header + 2 : header);
+  }
+  closedir(dir);
+  return 0;
+}
+
+static int
+BurstExport(const char* id_text)
+{
+  char* end = NULL;
+  const unsigned long id = strtoul(id_text, &end, 10);
+  if (end == id_text || *end != '\0') {
+    printf("invalid burst id\n");
+    return 1;
+  }
+  char name[32];
+  BurstCaptureFileName((uint32_t)id, name, sizeof(name));
+  char path[96];
+  snprintf(path,
+           sizeof(path),
+           "%s/%s/%s",
+           g_runtime->sd_logger->mount_point,
+           BURST_CAPTURE_DIR,
+           name);
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    printf("no burst %lu\n", id);
+    return 1;
+  }
+  char buffer[256];
+  size_t read_bytes;
+  while ((read_bytes = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    fwrite(buffer, 1, read_bytes, stdout);
+  }
+  fclose(file);
+  fflush(stdout);
+  return 0;
+}
+
+static int
+BurstTrigger(int argc, char** argv)
+{
+  if (argc == 2) {
+    if (!RuntimeRequestBurstTrigger(BURST_TRIGGER_CONSOLE)) {
+      printf("burst capture is not running\n");
+      return 1;
+    }
+    printf("burst triggered\n");
+    return 0;
+  }
+  if (argc != 3 || !g_runtime->mesh->is_root) {
+    printf("usage: burst trigger (this node) | burst trigger all|<mac> "
+           "(root)\n");
+    return 1;
+  }
+  uint8_t mac[6];
+  const bool all = strcmp(argv[2], "all") == 0;
+  if (!all && sscanf(argv[2],
+                     "%2hhx:%2hhx:%2hhx:%2hhx:%2hhx:%2hhx",
+                     &mac[0],
+                     &mac[1],
+                     &mac[2],
+                     &mac[3],
+                     &mac[4],
+                     &mac[5]) != 6) {
+    printf("invalid mac (aa:bb:cc:dd:ee:ff)\n");
+    return 1;
+  }
+  esp_err_t result =
+    MeshTransportSendBurstTrigger(g_runtime->mesh, all ? NULL : mac);
+  if (result != ESP_OK) {
+    printf("mesh trigger failed: %s\n", esp_err_to_name(result));
+    return 1;
+  }
+  if (all) {
+    (void)RuntimeRequestBurstTrigger(BURST_TRIGGER_CONSOLE);
+  }
+  printf("burst trigger sent\n");
+  return 0;
+}
+
+// burst [show] | off | on <period_ms> <pre_ms> <post_ms> |
+// level <mC>|off | slope <mC_per_s>|off | trigger [all|<mac>] | list |
+// export <id>
+static int
+CommandBurst(int argc, char** argv)
+{
+  if (g_runtime == NULL) {
+    return 1;
+  }
+  burst_capture_config_t config = g_runtime->settings->burst_capture;
+  const char* action = (argc >= 2) ? argv[1] : "show";
+  if (strcmp(action, "show") == 0) {
+    PrintBurstConfig(&config);
+    runtime_burst_status_t status;
+    RuntimeGetBurstStatus(&status);
+    if (status.paused) {
+      printf("paused: the period does not divide the sample period\n");
+    }
+    if (status.active) {
+      printf("ring: %u/%u samples in %s, %s\n",
+             (unsigned)status.ring_fill,
+             (unsigned)status.ring_samples,
+             status.in_psram ? "PSRAM" : "internal RAM",
+             BurstStateToString(status.state));
+    }
+    printf("triggers=%u ignored=%u frozen=%u written=%u write_failures=%u\n",
+           (unsigned)status.stats.triggers,
+           (unsigned)status.stats.triggers_ignored,
+           (unsigned)status.stats.frozen,
+           (unsigned)status.stats.written,
+           (unsigned)status.stats.write_failures);
+    return 0;
+  }
+  if (strcmp(action, "trigger") == 0) {
+    return BurstTrigger(argc, argv);
+  }
+  if (strcmp(action, "list") == 0 && argc == 2) {
+    return BurstList();
+  }
+  if (strcmp(action, "export") == 0 && argc == 3) {
+    return BurstExport(argv[2]);
+  }
+
+  char* end = NULL;
+  if (strcmp(action, "off") == 0 && argc == 2) {
+    config.enabled = false;
+  } else if (strcmp(action, "on") == 0 && argc == 5) {
+    long values[3];
+    for (int i = 0; i < 3; ++i) {
+      values[i] = strtol(argv[2 + i], &end, 10);
+      if (end == argv[2 + i] || *end != '\0' || values[i] < 0 ||
+          values[i] > 3600000) {
+        printf("invalid value: %s\n", argv[2 + i]);
+        return 1;
+      }
+    }
+    if (values[0] < (long)APP_SETTINGS_LOG_PERIOD_MIN_MS ||
+        values[0] > 60000) {
+      printf("invalid period (%u..60000 ms)\n",
+             (unsigned)APP_SETTINGS_LOG_PERIOD_MIN_MS);
+      return 1;
+    }
+    config.enabled = true;
+    config.period_ms = (uint32_t)values[0];
+    config.pre_ms = (uint32_t)values[1];
+    config.post_ms = (uint32_t)values[2];
+    const uint32_t ring_samples =
+      BurstCaptureRingSamples(&config, g_runtime->rtd_channels->count);
+    if (ring_samples > BURST_CAPTURE_MAX_SAMPLES) {
+      printf("window too long: %u samples (max %u)\n",
+             (unsigned)ring_samples,
+             (unsigned)BURST_CAPTURE_MAX_SAMPLES);
+      return 1;
+    }
+    const uint32_t sample_period_ms = SampleFilterSamplePeriodMs(
+      &g_runtime->settings->sample_filter, g_runtime->settings->log_period_ms);
+    if (sample_period_ms == 0 || sample_period_ms % config.period_ms != 0) {
+      printf("the period must divide the sample period (%u ms)\n",
+             (unsigned)sample_period_ms);
+      return 1;
+    }
+  } else if (strcmp(action, "level") == 0 && argc == 3) {
+    if (strcmp(argv[2], "off") == 0) {
+      config.level_enabled = false;
+    } else {
+      const long level = strtol(argv[2], &end, 10);
+      if (end == argv[2] || *end != '\0' || level < -250000 ||
+          level > 1000000) {
+        printf("invalid level (mC)\n");
+        return 1;
+      }
+      config.level_enabled = true;
+      config.level_milli_c = (int32_t)level;
+    }
+  } else if (strcmp(action, "slope") == 0 && argc == 3) {
+    if (strcmp(argv[2], "off") == 0) {
+      config.slope_milli_c_per_s = 0;
+    } else {
+      const long slope = strtol(argv[2], &end, 10);
+      if (end == argv[2] || *end != '\0' || slope < 1 || slope > 10000000) {
+        printf("invalid slope (1..10000000 mC/s)\n");
+        return 1;
+      }
+      config.slope_milli_c_per_s = (int32_t)slope;
+    }
+  } else {
+    printf("usage: burst [show] | off | on <period_ms> <pre_ms> <post_ms> | "
+           "level <mC>|off | slope <mC_per_s>|off | trigger [all|<mac>] | "
+           "list | export <id>\n");
+    return 1;
+  }
+
+  // The sensor task picks the change up at its next tick.
+  g_runtime->settings->burst_capture = config;
+  esp_err_t result = AppSettingsSaveBurstCapture(&config);
+  if (result != ESP_OK) {
+    printf("save failed: %s\n", esp_err_to_name(result));
+    return 1;
+  }
+  PrintBurstConfig(&config);
+  return 0;
+}
+
 static int
 CommandReboot(int argc, char** argv)
 {
@@ -1763,7 +2730,11 @@ RegisterCommands(void)
   const esp_console_cmd_t log_cmd = {
     .command = "log",
     .help = "Logging config: log interval <ms> | log watermark <records> | log "
-            "flush_period <ms> | log batch <bytes> | log show",
+            "flush_period <ms> | log batch <bytes> | log filter [show] | log "
+            "filter off|median <n>|ema <alpha>|decimate <factor> [cic_order] "
+            "| log compress [show] | log compress off|sdt|deadband "
+            "<error_mC> [heartbeat_s] | log adaptive [show] | log adaptive "
+            "off|<fast_ms> <rise_mC_per_min> [dwell_s] | log show",
     .hint = NULL,
     .func = &CommandLog,
   };
@@ -1832,11 +2803,15 @@ RegisterCommands(void)
   };
   ESP_ERROR_CHECK(esp_console_cmd_register(&mode_cmd));
 
-  g_data_args.action = arg_str1(NULL, NULL, "<action>", "show|on|off");
-  g_data_args.end = arg_end(1);
+  g_data_args.action =
+    arg_str1(NULL, NULL, "<action>", "show|on|off|format|baud");
+  g_data_args.value =
+    arg_str0(NULL, NULL, "<value>", "csv|binary (format) or rate (baud)");
+  g_data_args.end = arg_end(2);
   const esp_console_cmd_t data_cmd = {
     .command = "data",
-    .help = "data show | data on | data off",
+    .help = "data show | data on | data off | data format csv|binary | "
+            "data baud <rate>",
     .hint = NULL,
     .func = &CommandData,
     .argtable = &g_data_args,
@@ -1928,6 +2903,23 @@ RegisterCommands(void)
   };
   ESP_ERROR_CHECK(esp_console_cmd_register(&children_cmd));
 
+  g_rtd_args.action = arg_str1(NULL, NULL, "<action>", "show|set|clear");
+  g_rtd_args.channel = arg_int0(NULL, NULL, "<channel>", "RTD channel (1..)");
+  g_rtd_args.coeffs =
+    arg_dbln(NULL, NULL, "<c>", 0, CALIBRATION_MAX_POINTS, "c0 c1 [c2] [c3]");
+  g_rtd_args.end = arg_end(6);
+  const esp_console_cmd_t rtd_cmd = {
+    .command = "rtd",
+    .help = "RTD channels: rtd show | rtd set <channel> <c0> <c1> [c2] [c3] | "
+            "rtd clear <channel>\n"
+            "Channels 1.. (APP_RTD_EXTRA_CS_GPIOS) use y = c0 + c1*x + ...; "
+            "channel 0 uses 'cal'.",
+    .hint = NULL,
+    .func = &CommandRtd,
+    .argtable = &g_rtd_args,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&rtd_cmd));
+
   const esp_console_cmd_t diag_cmd = {
     .command = "diag",
     .help = "Diagnostics entry point",
@@ -1937,6 +2929,17 @@ RegisterCommands(void)
   };
   ESP_ERROR_CHECK(esp_console_cmd_register(&diag_cmd));
 
+  const esp_console_cmd_t burst_cmd = {
+    .command = "burst",
+    .help = "Burst capture: burst [show] | burst off | burst on <period_ms> "
+            "<pre_ms> <post_ms> | burst level <mC>|off | burst slope "
+            "<mC_per_s>|off | burst trigger [all|<mac>] | burst list | "
+            "burst export <id>",
+    .hint = NULL,
+    .func = &CommandBurst,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&burst_cmd));
+
   const esp_console_cmd_t reboot_cmd = {
     .command = "reboot",
     .help = "Soft reboot the device",
@@ -133,6 +133,36 @@ CsvFormatRow(const log_record_t* record,
   return true;
 }
 
+bool
+CsvFormatAlarm(const alarm_event_t* event,
+               const char* node_id,
+               char* out,
+               size_t out_size,
+               size_t* written_out)
+{
+  if (event == NULL || out == NULL || out_size == 0) {
+    return false;
+  }
+  const int length = snprintf(out,
+                              out_size,
+                              "#alarm,%" PRId64 ",%s,%u,%s,%s,%.3f,%.3f,%u\n",
+                              event->epoch_ms,
+                              (node_id != NULL) ? node_id : "",
+                              (unsigned)event->channel,
+                              AlarmKindToString(event->kind),
+                              event->active ? "raise" : "clear",
+                              event->value / 1000.0,
+                              event->limit / 1000.0,
+                              (unsigned)event->sequence);
+  if (length < 0 || (size_t)length >= out_size) {
+    return false;
+  }
+  if (written_out != NULL) {
+    *written_out = (size_t)length;
+  }
+  return true;
+}
+
 bool
 CsvWriteHeader(csv_write_fn_t writer, void* context)
 {
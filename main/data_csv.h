@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "alarm.h"
 #include "log_record.h"
 
 #ifdef __cplusplus
@@ -22,6 +23,17 @@ bool CsvFormatRow(const log_record_t* record,
                   size_t out_size,
                   size_t* written_out);
 
+// Alarm events share the CSV stream as comment lines, so readers that skip
+// '#' lines see only records:
+//   #alarm,<epoch_ms>,<node_id>,<channel>,<kind>,raise|clear,<value>,<limit>,
+//     <sequence>
+// value and limit in °C (°C/min for rate alarms).
+bool CsvFormatAlarm(const alarm_event_t* event,
+                    const char* node_id,
+                    char* out,
+                    size_t out_size,
+                    size_t* written_out);
+
 bool CsvWriteHeader(csv_write_fn_t writer, void* context);
 bool CsvWriteRow(csv_write_fn_t writer,
                  void* context,
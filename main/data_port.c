@@ -2,11 +2,15 @@
 
 #include "driver/uart.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 
 static const char* kTag = "data_port";
 static bool g_initialized = false;
+static uint32_t g_baud_rate = CONFIG_APP_DATA_PORT_BAUD_RATE;
 static const int kRxBufferLen = 256;
-static const int kTxBufferLen = 2048;
+static const int kTxBufferLen = CONFIG_APP_DATA_PORT_TX_BUFFER_BYTES;
+static const uint32_t kMinBaudRate = 9600;
+static const uint32_t kMaxBaudRate = 3000000;
 
 esp_err_t
 DataPortInit(void)
@@ -16,7 +20,7 @@ DataPortInit(void)
   }
 
   const uart_config_t config = {
-    .baud_rate = 115200,
+    .baud_rate = (int)g_baud_rate,
     .data_bits = UART_DATA_8_BITS,
     .parity = UART_PARITY_DISABLE,
     .stop_bits = UART_STOP_BITS_1,
@@ -82,3 +86,28 @@ DataPortWrite(const char* bytes, size_t len, size_t* bytes_written)
   }
   return ESP_OK;
 }
+
+esp_err_t
+DataPortSetBaudRate(uint32_t baud_rate)
+{
+  if (baud_rate < kMinBaudRate || baud_rate > kMaxBaudRate) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (g_initialized) {
+    // Let queued bytes leave at the old rate so the host sees a clean cut.
+    (void)uart_wait_tx_done(UART_NUM_0, pdMS_TO_TICKS(500));
+    esp_err_t result = uart_set_baudrate(UART_NUM_0, baud_rate);
+    if (result != ESP_OK) {
+      ESP_LOGE(kTag, "uart_set_baudrate failed: %s", esp_err_to_name(result));
+      return result;
+    }
+  }
+  g_baud_rate = baud_rate;
+  return ESP_OK;
+}
+
+uint32_t
+DataPortGetBaudRate(void)
+{
+  return g_baud_rate;
+}
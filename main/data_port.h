@@ -2,10 +2,16 @@
 #define PT100_LOGGER_DATA_PORT_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "esp_err.h"
 
 esp_err_t DataPortInit(void);
 esp_err_t DataPortWrite(const char* bytes, size_t len, size_t* bytes_written);
 
+// Changes the UART0 baud rate; applied at the next DataPortInit() if the
+// driver is not installed yet.
+esp_err_t DataPortSetBaudRate(uint32_t baud_rate);
+uint32_t DataPortGetBaudRate(void);
+
 #endif // PT100_LOGGER_DATA_PORT_H_
@@ -60,9 +60,7 @@ RunDiagRtd(const app_runtime_t* runtime,
              sizeof(warning),
              "NOTE: 3-wire assumes matched lead resistance");
   }
-  const char* conversion =
-    (reader->conversion == kMax31865ConversionCvdIterative) ? "CVD_ITERATIVE"
-                                                            : "TABLE_PT100";
+  const char* conversion = Max31865ConversionName(reader->conversion);
 
   uint8_t config_reg = 0;
   esp_err_t reg_result = Max31865ReadReg(runtime->sensor, kRegConfig, &config_reg);
@@ -0,0 +1,179 @@
+#include "export_frame.h"
+
+#include <string.h>
+
+#include "esp_rom_crc.h"
+
+static size_t
+EntrySize(uint8_t type)
+{
+  switch (type) {
+    case EXPORT_FRAME_TYPE_NODES:
+      return sizeof(export_frame_node_t);
+    case EXPORT_FRAME_TYPE_ALARMS:
+      return sizeof(export_frame_alarm_t);
+    default:
+      return sizeof(export_frame_record_t);
+  }
+}
+
+static bool
+HasRoom(const export_frame_writer_t* writer, size_t entry_size)
+{
+  return writer->count < UINT16_MAX &&
+         writer->used + entry_size + EXPORT_FRAME_CRC_LEN <= writer->capacity;
+}
+
+esp_err_t
+ExportFrameWriterInit(export_frame_writer_t* writer,
+                      uint8_t* buffer,
+                      size_t capacity,
+                      uint8_t type,
+                      uint32_t sequence)
+{
+  if (writer == NULL || buffer == NULL ||
+      capacity < sizeof(export_frame_header_t) + EXPORT_FRAME_CRC_LEN) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (type != EXPORT_FRAME_TYPE_RECORDS && type != EXPORT_FRAME_TYPE_NODES &&
+      type != EXPORT_FRAME_TYPE_ALARMS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  writer->buffer = buffer;
+  writer->capacity = capacity;
+  writer->used = sizeof(export_frame_header_t);
+  writer->count = 0;
+  writer->type = type;
+
+  export_frame_header_t header = {
+    .version = EXPORT_FRAME_VERSION,
+    .type = type,
+    .count = 0,
+    .sequence = sequence,
+  };
+  memcpy(buffer, &header, sizeof(header));
+  return ESP_OK;
+}
+
+esp_err_t
+ExportFrameWriterAddRecord(export_frame_writer_t* writer,
+                           uint8_t node_index,
+                           const log_record_t* record)
+{
+  if (writer == NULL || record == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (writer->type != EXPORT_FRAME_TYPE_RECORDS) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!HasRoom(writer, sizeof(export_frame_record_t))) {
+    return ESP_ERR_NO_MEM;
+  }
+  uint8_t* out = writer->buffer + writer->used;
+  out[0] = node_index;
+  memcpy(out + 1, record, sizeof(*record));
+  writer->used += sizeof(export_frame_record_t);
+  writer->count++;
+  return ESP_OK;
+}
+
+esp_err_t
+ExportFrameWriterAddNode(export_frame_writer_t* writer,
+                         uint8_t node_index,
+                         const pt100_mesh_addr_t* addr)
+{
+  if (writer == NULL || addr == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (writer->type != EXPORT_FRAME_TYPE_NODES) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!HasRoom(writer, sizeof(export_frame_node_t))) {
+    return ESP_ERR_NO_MEM;
+  }
+  uint8_t* out = writer->buffer + writer->used;
+  out[0] = node_index;
+  memcpy(out + 1, addr->addr, sizeof(addr->addr));
+  writer->used += sizeof(export_frame_node_t);
+  writer->count++;
+  return ESP_OK;
+}
+
+esp_err_t
+ExportFrameWriterAddAlarm(export_frame_writer_t* writer,
+                          uint8_t node_index,
+                          const alarm_event_t* event)
+{
+  if (writer == NULL || event == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (writer->type != EXPORT_FRAME_TYPE_ALARMS) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!HasRoom(writer, sizeof(export_frame_alarm_t))) {
+    return ESP_ERR_NO_MEM;
+  }
+  uint8_t* out = writer->buffer + writer->used;
+  out[0] = node_index;
+  memcpy(out + 1, event, sizeof(*event));
+  writer->used += sizeof(export_frame_alarm_t);
+  writer->count++;
+  return ESP_OK;
+}
+
+bool
+ExportFrameWriterIsFull(const export_frame_writer_t* writer)
+{
+  return writer == NULL || !HasRoom(writer, EntrySize(writer->type));
+}
+
+size_t
+ExportFrameWriterFinish(export_frame_writer_t* writer,
+                        uint8_t* out,
+                        size_t out_size)
+{
+  if (writer == NULL || out == NULL) {
+    return 0;
+  }
+  export_frame_header_t* header = (export_frame_header_t*)writer->buffer;
+  header->count = writer->count;
+
+  const uint32_t crc = esp_rom_crc32_le(0, writer->buffer, writer->used);
+  uint8_t* trailer = writer->buffer + writer->used;
+  trailer[0] = (uint8_t)(crc & 0xFFu);
+  trailer[1] = (uint8_t)((crc >> 8) & 0xFFu);
+  trailer[2] = (uint8_t)((crc >> 16) & 0xFFu);
+  trailer[3] = (uint8_t)((crc >> 24) & 0xFFu);
+
+  return CobsEncode(
+    writer->buffer, writer->used + EXPORT_FRAME_CRC_LEN, out, out_size);
+}
+
+size_t
+CobsEncode(const uint8_t* in, size_t len, uint8_t* out, size_t out_size)
+{
+  if (in == NULL || out == NULL || out_size < EXPORT_FRAME_COBS_MAX(len)) {
+    return 0;
+  }
+  size_t code_pos = 0;
+  size_t out_pos = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < len; ++i) {
+    if (in[i] == 0) {
+      out[code_pos] = code;
+      code_pos = out_pos++;
+      code = 1;
+      continue;
+    }
+    out[out_pos++] = in[i];
+    code++;
+    if (code == 0xFF) {
+      out[code_pos] = code;
+      code_pos = out_pos++;
+      code = 1;
+    }
+  }
+  out[code_pos] = code;
+  out[out_pos++] = 0;
+  return out_pos;
+}
@@ -0,0 +1,114 @@
+#ifndef PT100_LOGGER_EXPORT_FRAME_H_
+#define PT100_LOGGER_EXPORT_FRAME_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alarm.h"
+#include "esp_err.h"
+#include "log_record.h"
+#include "mesh_addr.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Binary data-port stream: every frame is export_frame_header_t, count
+// entries, then a CRC-32 (zlib/IEEE, little endian) over header + entries.
+// The frame is COBS-encoded and terminated by a single 0x00, so a host can
+// resynchronise on any zero byte and drop frames whose CRC fails.
+#define EXPORT_FRAME_VERSION 1u
+
+#define EXPORT_FRAME_TYPE_RECORDS 1u // export_frame_record_t entries
+#define EXPORT_FRAME_TYPE_NODES 2u   // export_frame_node_t entries
+#define EXPORT_FRAME_TYPE_ALARMS 3u  // export_frame_alarm_t entries
+
+#define EXPORT_FRAME_CRC_LEN 4u
+
+// Worst-case COBS output for n input bytes, including the 0x00 delimiter.
+#define EXPORT_FRAME_COBS_MAX(n) ((n) + ((n) / 254u) + 2u)
+
+// Unencoded size of a records frame holding n entries.
+#define EXPORT_FRAME_RECORDS_LEN(n)                                            \
+  (sizeof(export_frame_header_t) + (n) * sizeof(export_frame_record_t) +       \
+   EXPORT_FRAME_CRC_LEN)
+
+#pragma pack(push, 1)
+  typedef struct
+  {
+    uint8_t version;   // EXPORT_FRAME_VERSION
+    uint8_t type;      // EXPORT_FRAME_TYPE_*
+    uint16_t count;    // entries that follow
+    uint32_t sequence; // per-frame, +1 each frame; gaps mean lost frames
+  } export_frame_header_t;
+
+  typedef struct
+  {
+    uint8_t node_index; // index announced by a NODES frame
+    log_record_t record;
+  } export_frame_record_t;
+
+  typedef struct
+  {
+    uint8_t node_index;
+    uint8_t mac[6];
+  } export_frame_node_t;
+
+  typedef struct
+  {
+    uint8_t node_index;
+    alarm_event_t event;
+  } export_frame_alarm_t;
+#pragma pack(pop)
+
+  // Frame builder over a caller-owned buffer (no allocation).
+  typedef struct
+  {
+    uint8_t* buffer;
+    size_t capacity;
+    size_t used;
+    uint16_t count;
+    uint8_t type;
+  } export_frame_writer_t;
+
+  esp_err_t ExportFrameWriterInit(export_frame_writer_t* writer,
+                                  uint8_t* buffer,
+                                  size_t capacity,
+                                  uint8_t type,
+                                  uint32_t sequence);
+
+  // Append one entry; ESP_ERR_NO_MEM (writer unchanged) when it would not
+  // fit together with the CRC, ESP_ERR_INVALID_STATE on a type mismatch.
+  esp_err_t ExportFrameWriterAddRecord(export_frame_writer_t* writer,
+                                       uint8_t node_index,
+                                       const log_record_t* record);
+  esp_err_t ExportFrameWriterAddNode(export_frame_writer_t* writer,
+                                     uint8_t node_index,
+                                     const pt100_mesh_addr_t* addr);
+  esp_err_t ExportFrameWriterAddAlarm(export_frame_writer_t* writer,
+                                      uint8_t node_index,
+                                      const alarm_event_t* event);
+
+  // True when another entry of the writer's type would not fit.
+  bool ExportFrameWriterIsFull(const export_frame_writer_t* writer);
+
+  // Appends the CRC and COBS-encodes the frame plus delimiter into out.
+  // Returns the encoded length, or 0 if out is too small.
+  size_t ExportFrameWriterFinish(export_frame_writer_t* writer,
+                                 uint8_t* out,
+                                 size_t out_size);
+
+  // COBS-encodes len bytes and appends the 0x00 delimiter. Returns the
+  // encoded length, or 0 if out is too small.
+  size_t CobsEncode(const uint8_t* in,
+                    size_t len,
+                    uint8_t* out,
+                    size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_EXPORT_FRAME_H_
@@ -130,11 +130,7 @@ RecordAddressForIndex(const fram_log_t* log, uint32_t record_index)
 static esp_err_t
 WriteRecord(const fram_log_t* log, uint32_t record_index, log_record_t record)
 {
-  record.magic = LOG_RECORD_MAGIC;
-  record.schema_version = LOG_RECORD_SCHEMA_VER;
-  record.crc16_ccitt = 0;
-  record.crc16_ccitt =
-    Crc16CcittFalse(&record, sizeof(record) - sizeof(record.crc16_ccitt));
+  LogRecordSeal(&record);
 
   const uint32_t address = RecordAddressForIndex(log, record_index);
   return IoWrite(log, address, &record, sizeof(record));
@@ -305,6 +301,13 @@ FramLogInit(fram_log_t* log, fram_io_t io, uint32_t fram_size_bytes)
   log->next_sequence = max_sequence;
   log->next_record_id = max_record_id;
 
+  if (log->write_index > 0) {
+    log_record_t newest;
+    if (ReadRecord(log, log->write_index - 1u, &newest) == ESP_OK) {
+      log->last_appended_record_id = newest.record_id;
+    }
+  }
+
   ESP_LOGI(kTag,
            "FRAM log: cap=%u rec write=%u read=%u count=%u seq=%u id=%" PRIu64,
            (unsigned)log->capacity_records,
@@ -466,6 +469,7 @@ FramLogAppend(fram_log_t* log, const log_record_t* record)
   }
 
   log->write_index++;
+  log->last_appended_record_id = record->record_id;
   if (log->record_count < log->capacity_records) {
     log->record_count++;
   } else {
@@ -544,6 +548,76 @@ FramLogPeekOffset(const fram_log_t* log,
   return ESP_OK;
 }
 
+static uint32_t
+RetainedRecordCount(const fram_log_t* log)
+{
+  if (log->last_appended_record_id == 0) {
+    return 0;
+  }
+  uint32_t retained = (log->write_index < log->capacity_records)
+                        ? log->write_index
+                        : log->capacity_records;
+  // Record ids start at 1; never claim more slots than ids handed out.
+  if ((uint64_t)retained > log->last_appended_record_id) {
+    retained = (uint32_t)log->last_appended_record_id;
+  }
+  return retained;
+}
+
+uint64_t
+FramLogOldestRetainedRecordId(const fram_log_t* log)
+{
+  if (log == NULL) {
+    return 0;
+  }
+  const uint32_t retained = RetainedRecordCount(log);
+  if (retained == 0) {
+    return 0;
+  }
+  return log->last_appended_record_id - (retained - 1u);
+}
+
+esp_err_t
+FramLogPeekRetainedRecordId(const fram_log_t* log,
+                            uint64_t record_id,
+                            log_record_t* record_out)
+{
+  if (log == NULL || record_out == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint32_t retained = RetainedRecordCount(log);
+  if (retained == 0 || record_id > log->last_appended_record_id) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  const uint64_t back = log->last_appended_record_id - record_id;
+  if (back >= retained) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  uint32_t record_index = log->write_index - 1u - (uint32_t)back;
+  esp_err_t result = ReadRecord(log, record_index, record_out);
+  if (result != ESP_OK) {
+    return result;
+  }
+  // Ids and slots only stay in lockstep while every assigned id was
+  // appended. After a failed append the slot holds an older id; re-anchor
+  // once on what we found instead of trusting the mapping.
+  if (record_out->record_id < record_id) {
+    const uint64_t shift = record_id - record_out->record_id;
+    if (shift > (uint64_t)(log->write_index - 1u - record_index)) {
+      return ESP_ERR_INVALID_RESPONSE;
+    }
+    record_index += (uint32_t)shift;
+    result = ReadRecord(log, record_index, record_out);
+    if (result != ESP_OK) {
+      return result;
+    }
+  }
+  if (record_out->record_id != record_id) {
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+  return ESP_OK;
+}
+
 esp_err_t
 FramLogDiscardOldest(fram_log_t* log)
 {
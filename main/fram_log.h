@@ -30,6 +30,7 @@ extern "C"
     uint64_t next_record_id;
     uint64_t overrun_records_total;
     uint32_t overrun_events_total;
+    uint64_t last_appended_record_id; // 0 if unknown (no retained records)
 
     uint32_t records_since_header_persist;
     bool saw_corruption;
@@ -83,6 +84,19 @@ extern "C"
                               uint32_t offset,
                               log_record_t* record_out);
 
+  // Read a record that is still physically present in the ring by record_id.
+  // Unlike PeekOffset this also reaches records already consumed by the SD
+  // flush, as long as they have not been overwritten. Returns
+  // ESP_ERR_NOT_FOUND if the record is outside the retained window and
+  // ESP_ERR_INVALID_RESPONSE if the slot fails validation or holds a
+  // different record_id.
+  esp_err_t FramLogPeekRetainedRecordId(const fram_log_t* log,
+                                        uint64_t record_id,
+                                        log_record_t* record_out);
+
+  // Oldest record_id in the retained window, or 0 if nothing is retained.
+  uint64_t FramLogOldestRetainedRecordId(const fram_log_t* log);
+
   // Discard the oldest record without reading it.
   // Returns ESP_ERR_NOT_FOUND if empty.
   esp_err_t FramLogDiscardOldest(fram_log_t* log);
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "crc16.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -22,8 +24,21 @@ extern "C"
     LOG_RECORD_FLAG_MESH_CONNECTED = 1u << 3,
     LOG_RECORD_FLAG_SENSOR_FAULT = 1u << 4,
     LOG_RECORD_FLAG_FRAM_FULL = 1u << 5,
+    // Part of a compressed series (record_compressor.h): the records left
+    // out are interpolated from the kept ones, within the set error.
+    LOG_RECORD_FLAG_COMPRESSED = 1u << 6,
+    // Sampled at the adaptive fast period (adaptive_rate.h) rather than the
+    // log period.
+    LOG_RECORD_FLAG_FAST_RATE = 1u << 7,
   } log_record_flags_t;
 
+// RTD channel that produced the record (flags bits 12..15). Channel 0, the
+// only one on single-sensor nodes, leaves the bits clear.
+#define LOG_RECORD_CHANNEL_SHIFT 12u
+#define LOG_RECORD_CHANNEL_MASK 0xF000u
+#define LOG_RECORD_CHANNEL(flags)                                              \
+  ((uint8_t)(((flags) & LOG_RECORD_CHANNEL_MASK) >> LOG_RECORD_CHANNEL_SHIFT))
+
 #pragma pack(push, 1)
   typedef struct
   {
@@ -41,6 +56,18 @@ extern "C"
   } log_record_t;
 #pragma pack(pop)
 
+  // Sets magic and schema and computes crc16_ccitt over the record as it is.
+  // Done once, where the record is produced; receivers check against it.
+  static inline void
+  LogRecordSeal(log_record_t* record)
+  {
+    record->magic = LOG_RECORD_MAGIC;
+    record->schema_version = LOG_RECORD_SCHEMA_VER;
+    record->crc16_ccitt = 0;
+    record->crc16_ccitt =
+      Crc16CcittFalse(record, sizeof(*record) - sizeof(record->crc16_ccitt));
+  }
+
 #ifdef __cplusplus
 }
 #endif
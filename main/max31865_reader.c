@@ -4,11 +4,13 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "pt100_table.h"
+#include "rtd_lut.h"
 #include "sdkconfig.h"
 
 static const char* kTag = "max31865";
@@ -22,9 +24,12 @@ static const uint8_t kRegHighFaultLsb = 0x04;
 static const uint8_t kRegLowFaultMsb = 0x05;
 static const uint8_t kRegLowFaultLsb = 0x06;
 static const uint8_t kRegFaultStatus = 0x07;
+// RTD MSB through fault status (0x01..0x07) in one transaction.
+#define MAX31865_BURST_LEN 7u
 
 // Config bits.
 static const uint8_t kCfgVbias = 0x80;
+static const uint8_t kCfgAutoConvert = 0x40;
 static const uint8_t kCfgOneShot = 0x20;
 static const uint8_t kCfg3Wire = 0x10;
 static const uint8_t kCfgFaultStatusClear = 0x02;
@@ -39,6 +44,9 @@ static const uint8_t kFaultRtdInLow = 0x08;
 static const uint8_t kFaultOverUnder = 0x04;
 static const uint8_t kFaultRtdFlag = 0x01; // Derived from RTD LSB fault bit.
 
+static const int32_t kLutMinMilliC = (int32_t)(PT100_TABLE_MIN_C * 1000);
+static const int32_t kLutMaxMilliC = (int32_t)(PT100_TABLE_MAX_C * 1000);
+
 static const double kCvdA = 3.9083e-3;
 static const double kCvdB = -5.775e-7;
 static const double kCvdC = -4.183e-12;
@@ -66,6 +74,9 @@ SpiTransfer(spi_device_handle_t device,
 esp_err_t
 Max31865WriteReg(max31865_reader_t* reader, uint8_t reg, uint8_t value)
 {
+  if (reader != NULL && reader->replay != NULL) {
+    return Max31865ReplayWriteReg(reader->replay, reg, value);
+  }
   if (reader == NULL || reader->spi_device == NULL) {
     return ESP_ERR_INVALID_STATE;
   }
@@ -79,6 +90,9 @@ Max31865ReadRegs(max31865_reader_t* reader,
                  uint8_t* data_out,
                  size_t len)
 {
+  if (reader != NULL && reader->replay != NULL) {
+    return Max31865ReplayReadRegs(reader->replay, reg, data_out, len);
+  }
   if (reader == NULL || reader->spi_device == NULL || data_out == NULL ||
       len == 0) {
     return ESP_ERR_INVALID_ARG;
@@ -129,6 +143,12 @@ ConversionDelayMs(const max31865_reader_t* reader)
   return (reader->filter_hz <= 50) ? 65 : 55;
 }
 
+uint32_t
+Max31865ConversionPeriodUs(const max31865_reader_t* reader)
+{
+  return (reader->filter_hz <= 50) ? 20000u : 16667u;
+}
+
 double
 Max31865AdcCodeToResistance(uint16_t adc_code, double rref_ohm)
 {
@@ -142,9 +162,93 @@ ClearFaults(max31865_reader_t* reader, uint8_t base_config)
     reader, kRegConfig, (uint8_t)(base_config | kCfgFaultStatusClear));
 }
 
+// Reads the RTD registers and the fault status in one SPI transaction.
+static esp_err_t
+ReadBurst(max31865_reader_t* reader, uint8_t rtd_raw[2], uint8_t* fault_out)
+{
+  uint8_t regs[MAX31865_BURST_LEN] = { 0 };
+  esp_err_t result = Max31865ReadRegs(reader, kRegRtdMsb, regs, sizeof(regs));
+  if (result != ESP_OK) {
+    return result;
+  }
+  rtd_raw[0] = regs[0];
+  rtd_raw[1] = regs[1];
+  *fault_out = regs[kRegFaultStatus - kRegRtdMsb];
+  return ESP_OK;
+}
+
+static void IRAM_ATTR
+DrdyIsr(void* arg)
+{
+  max31865_reader_t* reader = (max31865_reader_t*)arg;
+  reader->drdy_edge_us = esp_timer_get_time();
+  BaseType_t woken = pdFALSE;
+  (void)xSemaphoreGiveFromISR(reader->drdy_ready, &woken);
+  if (woken == pdTRUE) {
+    portYIELD_FROM_ISR(woken);
+  }
+}
+
+esp_err_t
+Max31865ReaderAttachDrdy(max31865_reader_t* reader, int gpio)
+{
+  if (reader == NULL || gpio < 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (reader->drdy_ready != NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  reader->drdy_ready = xSemaphoreCreateBinary();
+  if (reader->drdy_ready == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  const gpio_config_t config = {
+    .pin_bit_mask = 1ULL << gpio,
+    .mode = GPIO_MODE_INPUT,
+    .pull_up_en = GPIO_PULLUP_ENABLE,
+    .pull_down_en = GPIO_PULLDOWN_DISABLE,
+    .intr_type = GPIO_INTR_NEGEDGE,
+  };
+  esp_err_t result = gpio_config(&config);
+  if (result == ESP_OK) {
+    result = gpio_install_isr_service(0);
+    if (result == ESP_ERR_INVALID_STATE) {
+      result = ESP_OK; // already installed by another driver
+    }
+  }
+  if (result == ESP_OK) {
+    result = gpio_isr_handler_add((gpio_num_t)gpio, &DrdyIsr, reader);
+  }
+  if (result != ESP_OK) {
+    vSemaphoreDelete(reader->drdy_ready);
+    reader->drdy_ready = NULL;
+    return result;
+  }
+  reader->drdy_gpio = gpio;
+  return ESP_OK;
+}
+
+// Waits for DRDY; false on timeout (or without DRDY).
+static bool
+WaitForDrdy(max31865_reader_t* reader, int timeout_ms)
+{
+  if (reader->drdy_ready == NULL) {
+    return false;
+  }
+  if (xSemaphoreTake(reader->drdy_ready, pdMS_TO_TICKS(timeout_ms) + 1) ==
+      pdTRUE) {
+    return true;
+  }
+  reader->drdy_timeouts++;
+  return false;
+}
+
 static esp_err_t
 WaitForConversionComplete(max31865_reader_t* reader, int timeout_ms)
 {
+  if (WaitForDrdy(reader, timeout_ms)) {
+    return ESP_OK;
+  }
   const int64_t start_us = esp_timer_get_time();
   const int64_t timeout_us = (int64_t)timeout_ms * 1000;
   while ((esp_timer_get_time() - start_us) < timeout_us) {
@@ -247,6 +351,21 @@ ResistanceToTemperature(const max31865_reader_t* reader, double resistance_ohm)
            : ConvertTablePt100(resistance_ohm, reader->rtd_nominal_ohm);
 }
 
+const char*
+Max31865ConversionName(max31865_conversion_t conversion)
+{
+  switch (conversion) {
+    case kMax31865ConversionTablePt100:
+      return "TABLE";
+    case kMax31865ConversionCvdIterative:
+      return "CVD";
+    case kMax31865ConversionInverseLut:
+      return "LUT";
+    default:
+      return "UNKNOWN";
+  }
+}
+
 void
 Max31865FormatFault(uint8_t fault_status, char* out, size_t out_len)
 {
@@ -322,6 +441,7 @@ Max31865ReaderInit(max31865_reader_t* reader,
     ESP_LOGE(kTag, "spi_bus_add_device failed: %s", esp_err_to_name(result));
     return result;
   }
+  reader->cs_gpio = cs_gpio;
 
   reader->rtd_nominal_ohm = (double)CONFIG_APP_RTD_R0_OHMS;
   reader->rref_ohm = (double)CONFIG_APP_MAX31865_RREF_OHMS;
@@ -343,13 +463,19 @@ Max31865ReaderInit(max31865_reader_t* reader,
 
 #if CONFIG_APP_MAX31865_CONVERSION_CVD_ITERATIVE
   reader->conversion = kMax31865ConversionCvdIterative;
+#elif CONFIG_APP_MAX31865_CONVERSION_INVERSE_LUT
+  reader->conversion = kMax31865ConversionInverseLut;
 #else
   reader->conversion = kMax31865ConversionTablePt100;
 #endif
+  reader->lut_code_scale =
+    RtdLutCodeScale(reader->rref_ohm, reader->rtd_nominal_ohm);
+  reader->rref_milli_ohm = llround(reader->rref_ohm * 1000.0);
 
   reader->ema_valid = false;
   reader->ema_temp_c = 0.0;
   reader->ema_resistance_ohm = 0.0;
+  reader->drdy_gpio = -1;
 
   const uint8_t base_config = BuildBaseConfig(reader);
   InitializeFaultThresholds(reader);
@@ -365,12 +491,35 @@ Max31865ReaderInit(max31865_reader_t* reader,
   reader->is_initialized = true;
   ESP_LOGI(
     kTag,
-    "Initialized MAX31865 (Rref=%.2fΩ R0=%.2fΩ wires=%u filter=%uHz mode=%s)",
+    "Initialized MAX31865 (Rref=%.2fΩ R0=%.2fΩ wires=%u filter=%uHz mode=%s "
+    "cs=%d)",
     reader->rref_ohm,
     reader->rtd_nominal_ohm,
     (unsigned)reader->wires,
     (unsigned)reader->filter_hz,
-    (reader->conversion == kMax31865ConversionCvdIterative) ? "CVD" : "TABLE");
+    Max31865ConversionName(reader->conversion),
+    cs_gpio);
+  return ESP_OK;
+}
+
+esp_err_t
+Max31865ReaderAttachReplay(max31865_reader_t* reader,
+                           max31865_replay_t* replay)
+{
+  if (reader == NULL || replay == NULL || replay->file == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (reader->drdy_ready != NULL || reader->continuous) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  replay->rref_ohm = reader->rref_ohm;
+  replay->r0_ohm = reader->rtd_nominal_ohm;
+  replay->conversion_us = (uint32_t)ConversionDelayMs(reader) * 1000u;
+  reader->replay = replay;
+  ESP_LOGW(kTag,
+           "cs=%d replays a recorded trace (%s)",
+           reader->cs_gpio,
+           (replay->speed == 0) ? "one row per conversion" : "timed");
   return ESP_OK;
 }
 
@@ -387,20 +536,66 @@ FillSample(max31865_sample_t* sample,
   sample->adc_code = adc_code;
   sample->resistance_ohm = resistance;
   sample->temperature_c = temp_c;
+  sample->resistance_milli_ohm = (int32_t)llround(resistance * 1000.0);
+  sample->temp_milli_c = (int32_t)llround(temp_c * 1000.0);
   sample->fault_status = fault_status;
   sample->fault_present = (fault_status != 0);
 }
 
+// Decodes the RTD registers (code << 1 | fault bit) into sample_out and
+// returns the combined fault status.
+static uint8_t
+FillSampleFromRtd(const max31865_reader_t* reader,
+                  const uint8_t rtd_raw[2],
+                  uint8_t fault_reg,
+                  int64_t conversion_us,
+                  max31865_sample_t* sample_out)
+{
+  uint16_t rtd_code = ((uint16_t)rtd_raw[0] << 8) | rtd_raw[1];
+  const bool rtd_fault_bit = (rtd_code & 0x01u) != 0;
+  rtd_code >>= 1;
+
+  uint8_t combined_faults = fault_reg;
+  if (rtd_fault_bit) {
+    combined_faults |= kFaultRtdFlag;
+  }
+
+  if (reader->conversion == kMax31865ConversionInverseLut) {
+    // Integer only; the double fields are derived for display.
+    int32_t temp_milli_c =
+      RtdLutCodeToMilliC(rtd_code, reader->lut_code_scale);
+    if (temp_milli_c < kLutMinMilliC) {
+      temp_milli_c = kLutMinMilliC;
+    } else if (temp_milli_c > kLutMaxMilliC) {
+      temp_milli_c = kLutMaxMilliC;
+    }
+    sample_out->adc_code = rtd_code;
+    sample_out->resistance_milli_ohm =
+      (int32_t)(((int64_t)rtd_code * reader->rref_milli_ohm + (1 << 14)) >> 15);
+    sample_out->temp_milli_c = temp_milli_c;
+    sample_out->resistance_ohm = sample_out->resistance_milli_ohm * 1e-3;
+    sample_out->temperature_c = temp_milli_c * 1e-3;
+    sample_out->fault_status = combined_faults;
+    sample_out->fault_present = (combined_faults != 0);
+  } else {
+    const double resistance =
+      Max31865AdcCodeToResistance(rtd_code, reader->rref_ohm);
+    const double temp_c = ResistanceToTemperature(reader, resistance);
+    FillSample(sample_out, rtd_code, resistance, temp_c, combined_faults);
+  }
+  sample_out->conversion_us = conversion_us;
+  return combined_faults;
+}
+
 esp_err_t
-Max31865ReadOnce(max31865_reader_t* reader, max31865_sample_t* sample_out)
+Max31865OneShotBegin(max31865_reader_t* reader)
 {
-  if (reader == NULL || sample_out == NULL) {
+  if (reader == NULL) {
     return ESP_ERR_INVALID_ARG;
   }
-  if (!reader->is_initialized) {
+  if (!reader->is_initialized || reader->continuous) {
     return ESP_ERR_INVALID_STATE;
   }
-
   const uint8_t base_config = BuildBaseConfig(reader);
   (void)ClearFaults(reader, base_config);
 
@@ -409,33 +604,53 @@ Max31865ReadOnce(max31865_reader_t* reader, max31865_sample_t* sample_out)
   if (result != ESP_OK) {
     return result;
   }
-
-  if (reader->bias_settle_ms > 0) {
-    vTaskDelay(pdMS_TO_TICKS(reader->bias_settle_ms));
+  if (reader->drdy_ready != NULL) {
+    (void)xSemaphoreTake(reader->drdy_ready, 0); // drop a stale edge
   }
+  return ESP_OK;
+}
 
-  result = Max31865WriteReg(
+esp_err_t
+Max31865OneShotTrigger(max31865_reader_t* reader)
+{
+  if (reader == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint8_t base_config = BuildBaseConfig(reader);
+  esp_err_t result = Max31865WriteReg(
     reader, kRegConfig, (uint8_t)(base_config | kCfgVbias | kCfgOneShot));
   if (result != ESP_OK) {
     (void)Max31865WriteReg(reader, kRegConfig, base_config);
     return result;
   }
+  reader->oneshot_trigger_us = esp_timer_get_time();
+  return ESP_OK;
+}
 
+esp_err_t
+Max31865OneShotFinish(max31865_reader_t* reader, max31865_sample_t* sample_out)
+{
+  if (reader == NULL || sample_out == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint8_t base_config = BuildBaseConfig(reader);
   const int wait_ms = ConversionDelayMs(reader) + reader->bias_settle_ms;
-  result = WaitForConversionComplete(reader, wait_ms + 10);
-  if (result == ESP_ERR_TIMEOUT) {
-    vTaskDelay(pdMS_TO_TICKS(wait_ms));
-    result = ESP_OK;
+  const int64_t elapsed_us = esp_timer_get_time() - reader->oneshot_trigger_us;
+  esp_err_t result = ESP_OK;
+  // Chips finished later in a pipelined cycle are already done.
+  if (elapsed_us < (int64_t)ConversionDelayMs(reader) * 1000) {
+    result = WaitForConversionComplete(reader, wait_ms + 10);
+    if (result == ESP_ERR_TIMEOUT) {
+      vTaskDelay(pdMS_TO_TICKS(wait_ms));
+      result = ESP_OK;
+    }
   }
+  const int64_t conversion_us = esp_timer_get_time();
 
   uint8_t rtd_raw[2] = { 0 };
-  if (result == ESP_OK) {
-    result = Max31865ReadRegs(reader, kRegRtdMsb, rtd_raw, sizeof(rtd_raw));
-  }
-
   uint8_t fault_reg = 0;
   if (result == ESP_OK) {
-    result = Max31865ReadReg(reader, kRegFaultStatus, &fault_reg);
+    result = ReadBurst(reader, rtd_raw, &fault_reg);
   }
 
   (void)Max31865WriteReg(reader, kRegConfig, base_config);
@@ -444,23 +659,133 @@ Max31865ReadOnce(max31865_reader_t* reader, max31865_sample_t* sample_out)
     return result;
   }
 
-  uint16_t rtd_code = ((uint16_t)rtd_raw[0] << 8) | rtd_raw[1];
-  const bool rtd_fault_bit = (rtd_code & 0x01u) != 0;
-  rtd_code >>= 1;
+  const uint8_t combined_faults = FillSampleFromRtd(
+    reader, rtd_raw, fault_reg, conversion_us, sample_out);
+  if (combined_faults != 0) {
+    (void)ClearFaults(reader, base_config);
+  }
+  return ESP_OK;
+}
 
-  uint8_t combined_faults = fault_reg;
-  if (rtd_fault_bit) {
-    combined_faults |= kFaultRtdFlag;
+esp_err_t
+Max31865ReadOnce(max31865_reader_t* reader, max31865_sample_t* sample_out)
+{
+  if (reader == NULL || sample_out == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!reader->is_initialized) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (reader->continuous) {
+    return Max31865ReadContinuous(reader, sample_out);
   }
 
-  const double resistance =
-    Max31865AdcCodeToResistance(rtd_code, reader->rref_ohm);
-  const double temp_c = ResistanceToTemperature(reader, resistance);
+  esp_err_t result = Max31865OneShotBegin(reader);
+  if (result != ESP_OK) {
+    return result;
+  }
+  if (reader->bias_settle_ms > 0) {
+    vTaskDelay(pdMS_TO_TICKS(reader->bias_settle_ms));
+  }
+  result = Max31865OneShotTrigger(reader);
+  if (result != ESP_OK) {
+    return result;
+  }
+  return Max31865OneShotFinish(reader, sample_out);
+}
+
+esp_err_t
+Max31865StartContinuous(max31865_reader_t* reader)
+{
+  if (reader == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!reader->is_initialized) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (reader->continuous) {
+    return ESP_OK;
+  }
+  const uint8_t run_config =
+    (uint8_t)(BuildBaseConfig(reader) | kCfgVbias | kCfgAutoConvert);
+  (void)ClearFaults(reader, (uint8_t)(run_config & ~kCfgAutoConvert));
+  esp_err_t result = Max31865WriteReg(reader, kRegConfig, run_config);
+  if (result != ESP_OK) {
+    return result;
+  }
+  // The first conversion after enabling bias takes a one-shot's time.
+  reader->continuous_ready_us =
+    esp_timer_get_time() +
+    ((int64_t)ConversionDelayMs(reader) + reader->bias_settle_ms) * 1000;
+  if (reader->drdy_ready != NULL) {
+    (void)xSemaphoreTake(reader->drdy_ready, 0);
+  }
+  reader->continuous = true;
+  ESP_LOGI(kTag,
+           "Continuous conversion every %u us",
+           (unsigned)Max31865ConversionPeriodUs(reader));
+  return ESP_OK;
+}
+
+esp_err_t
+Max31865StopContinuous(max31865_reader_t* reader)
+{
+  if (reader == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!reader->continuous) {
+    return ESP_OK;
+  }
+  reader->continuous = false;
+  return Max31865WriteReg(reader, kRegConfig, BuildBaseConfig(reader));
+}
 
-  FillSample(sample_out, rtd_code, resistance, temp_c, combined_faults);
+esp_err_t
+Max31865ReadContinuous(max31865_reader_t* reader,
+                       max31865_sample_t* sample_out)
+{
+  if (reader == NULL || sample_out == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!reader->is_initialized || !reader->continuous) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const int64_t period_us = Max31865ConversionPeriodUs(reader);
+  int64_t wait_us = reader->continuous_ready_us - esp_timer_get_time();
+  int64_t conversion_us = 0;
+  if (reader->drdy_ready != NULL) {
+    // DRDY stays low until the RTD registers are read, so a pending edge
+    // means an unread conversion; otherwise wait for the next one.
+    const int64_t timeout_us = ((wait_us > 0) ? wait_us : 0) + 2 * period_us;
+    if (WaitForDrdy(reader, (int)(timeout_us / 1000))) {
+      conversion_us = reader->drdy_edge_us;
+    }
+  } else if (wait_us > 0) {
+    vTaskDelay(pdMS_TO_TICKS((wait_us + 999) / 1000) + 1);
+  }
+  const int64_t now_us = esp_timer_get_time();
+  if (conversion_us == 0 || now_us - conversion_us > period_us) {
+    // Unknown within one period: newer conversions replaced the data
+    // without a new edge, or there is no DRDY.
+    conversion_us = now_us;
+  }
+
+  uint8_t rtd_raw[2] = { 0 };
+  uint8_t fault_reg = 0;
+  esp_err_t result = ReadBurst(reader, rtd_raw, &fault_reg);
+  if (result != ESP_OK) {
+    return result;
+  }
 
+  const uint8_t combined_faults = FillSampleFromRtd(
+    reader, rtd_raw, fault_reg, conversion_us, sample_out);
   if (combined_faults != 0) {
-    (void)ClearFaults(reader, base_config);
+    // Clear without leaving auto-convert; bias stays on.
+    (void)Max31865WriteReg(
+      reader,
+      kRegConfig,
+      (uint8_t)(BuildBaseConfig(reader) | kCfgVbias | kCfgAutoConvert |
+                kCfgFaultStatusClear));
   }
   return ESP_OK;
 }
@@ -532,8 +857,11 @@ Max31865ReadAveraged(max31865_reader_t* reader,
   averaged_out->adc_code = (uint16_t)llround(mean_code);
   averaged_out->resistance_ohm = mean_res;
   averaged_out->temperature_c = mean_temp;
+  averaged_out->resistance_milli_ohm = (int32_t)llround(mean_res * 1000.0);
+  averaged_out->temp_milli_c = (int32_t)llround(mean_temp * 1000.0);
   averaged_out->fault_status = 0;
   averaged_out->fault_present = false;
+  averaged_out->conversion_us = 0; // several conversions
 
   stats.stddev_temp_c = sqrt(
     (stats.valid_samples > 1) ? (m2 / (double)(stats.valid_samples - 1)) : 0.0);
@@ -587,6 +915,7 @@ Max31865ReadEmaUpdate(max31865_reader_t* reader,
              sample.resistance_ohm,
              sample.temperature_c,
              sample.fault_status);
+  sample_out->conversion_us = sample.conversion_us;
 
   if (ema_temp_out != NULL) {
     *ema_temp_out = reader->ema_temp_c;
@@ -7,6 +7,9 @@
 
 #include "driver/spi_master.h"
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "max31865_replay.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -17,6 +20,7 @@ extern "C"
   {
     kMax31865ConversionTablePt100 = 0,
     kMax31865ConversionCvdIterative = 1,
+    kMax31865ConversionInverseLut = 2,
   } max31865_conversion_t;
 
   typedef struct
@@ -24,8 +28,13 @@ extern "C"
     uint16_t adc_code;
     double resistance_ohm;
     double temperature_c;
+    // The same readings in integer units. With the inverse-table conversion
+    // these are computed first, without floating point.
+    int32_t resistance_milli_ohm;
+    int32_t temp_milli_c;
     uint8_t fault_status;
     bool fault_present;
+    int64_t conversion_us; // esp_timer time the conversion completed
   } max31865_sample_t;
 
   typedef struct
@@ -43,17 +52,34 @@ extern "C"
   typedef struct
   {
     spi_device_handle_t spi_device;
+    int cs_gpio;
     double rtd_nominal_ohm; // e.g. 100.0 for PT100
     double rref_ohm;        // e.g. 430.0 on common breakout boards
     uint8_t wires;          // 2, 3, or 4
     uint8_t filter_hz;      // 50 or 60
     uint32_t bias_settle_ms;
     max31865_conversion_t conversion;
+    uint64_t lut_code_scale; // RtdLutCodeScale() for the inverse table
+    int64_t rref_milli_ohm;
     bool pulsed_bias;
     bool is_initialized;
     double ema_temp_c;
     double ema_resistance_ohm;
     bool ema_valid;
+    int64_t oneshot_trigger_us; // esp_timer time of the last one-shot start
+    // Continuous (auto-convert) mode: bias stays on and the chip converts
+    // every 20 ms (50 Hz filter) or 16.7 ms (60 Hz).
+    bool continuous;
+    int64_t continuous_ready_us; // first conversion complete (esp_timer)
+    // DRDY (Max31865ReaderAttachDrdy): the falling edge gives
+    // drdy_ready from the ISR. NULL when the config register is polled.
+    SemaphoreHandle_t drdy_ready;
+    int drdy_gpio;
+    volatile int64_t drdy_edge_us;
+    uint32_t drdy_timeouts; // waits that fell back to polling or a stale read
+    // Register access goes to a recorded trace instead of SPI when set
+    // (Max31865ReaderAttachReplay).
+    max31865_replay_t* replay;
   } max31865_reader_t;
 
   // Initialize MAX31865 on an already-initialized SPI bus.
@@ -61,6 +87,16 @@ extern "C"
                                spi_host_device_t host,
                                int cs_gpio);
 
+  // Waits on the chip's DRDY output (falling-edge interrupt on gpio)
+  // instead of polling the config register.
+  esp_err_t Max31865ReaderAttachDrdy(max31865_reader_t* reader, int gpio);
+
+  // Replaces the chip with a trace player (max31865_replay.h) for every
+  // register access from here on. Takes the reader's Rref, R0 and
+  // conversion time. Not with DRDY, which the trace cannot drive.
+  esp_err_t Max31865ReaderAttachReplay(max31865_reader_t* reader,
+                                       max31865_replay_t* replay);
+
   // Register helpers.
   esp_err_t Max31865ReadReg(max31865_reader_t* reader,
                             uint8_t reg,
@@ -73,10 +109,36 @@ extern "C"
                              uint8_t reg,
                              uint8_t value);
 
-  // Read one conversion using pulsed bias + one-shot mode.
+  // Read one conversion using pulsed bias + one-shot mode. In continuous
+  // mode this is Max31865ReadContinuous().
   esp_err_t Max31865ReadOnce(max31865_reader_t* reader,
                              max31865_sample_t* sample_out);
 
+  // One-shot read in three steps so several chips can convert at once:
+  // Begin (bias on) on all, wait the bias settle time once, Trigger on all,
+  // then Finish each (waits for its conversion, reads it, bias off).
+  // Max31865ReadOnce() is the single-chip sequence.
+  esp_err_t Max31865OneShotBegin(max31865_reader_t* reader);
+  esp_err_t Max31865OneShotTrigger(max31865_reader_t* reader);
+  esp_err_t Max31865OneShotFinish(max31865_reader_t* reader,
+                                  max31865_sample_t* sample_out);
+
+  // Switches to auto-convert with bias left on. Reads then cost one SPI
+  // transaction instead of a ~80 ms one-shot cycle.
+  esp_err_t Max31865StartContinuous(max31865_reader_t* reader);
+
+  // Back to one-shot mode with bias off.
+  esp_err_t Max31865StopContinuous(max31865_reader_t* reader);
+
+  // Returns the next unread conversion. With DRDY it waits for one; without
+  // it only the first conversion is waited for, and reading faster than the
+  // conversion period returns the same conversion again.
+  esp_err_t Max31865ReadContinuous(max31865_reader_t* reader,
+                                   max31865_sample_t* sample_out);
+
+  // Time between conversions in continuous mode.
+  uint32_t Max31865ConversionPeriodUs(const max31865_reader_t* reader);
+
   // Read multiple samples and report the mean (faulted samples are skipped).
   // stats_out is optional; if provided stddev_temp_c will be populated for the
   // non-faulted samples.
@@ -98,6 +160,8 @@ extern "C"
                                float* resistance_ohm);
 
   // Helpers for diagnostics.
+  const char* Max31865ConversionName(max31865_conversion_t conversion);
+
   void Max31865FormatFault(uint8_t fault_status, char* out, size_t out_len);
   double Max31865AdcCodeToResistance(uint16_t adc_code, double rref_ohm);
 
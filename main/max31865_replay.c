@@ -0,0 +1,380 @@
+#include "max31865_replay.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "log_record.h"
+
+static const char* kTag = "max31865_replay";
+
+// The register bits the reader uses.
+static const uint8_t kRegConfig = 0x00;
+static const uint8_t kRegRtdMsb = 0x01;
+static const uint8_t kRegRtdLsb = 0x02;
+static const uint8_t kRegFaultStatus = 0x07;
+static const uint8_t kCfgVbias = 0x80;
+static const uint8_t kCfgAutoConvert = 0x40;
+static const uint8_t kCfgOneShot = 0x20;
+static const uint8_t kCfgFaultStatusClear = 0x02;
+// An open RTD: full-scale code, RTD fault bit and over/under-voltage.
+static const uint16_t kOpenCode = 0x7FFF;
+static const uint8_t kOpenFaultStatus = 0x04;
+
+// Spacing of rows without a time, and how long the last row lasts.
+static const int64_t kDefaultRowPeriodMs = 1000;
+static const int64_t kMaxInterpolateMs = 60000;
+#define REPLAY_LINE_MAX 256
+#define REPLAY_COLUMNS_MAX 16
+
+static const double kCvdA = 3.9083e-3;
+static const double kCvdB = -5.775e-7;
+static const double kCvdC = -4.183e-12;
+
+// Splits line at commas in place; returns the column count.
+static int
+SplitColumns(char* line, char* columns[REPLAY_COLUMNS_MAX])
+{
+  line[strcspn(line, "\r\n")] = '\0';
+  int count = 0;
+  char* cursor = line;
+  while (count < REPLAY_COLUMNS_MAX) {
+    columns[count++] = cursor;
+    char* comma = strchr(cursor, ',');
+    if (comma == NULL) {
+      break;
+    }
+    *comma = '\0';
+    cursor = comma + 1;
+  }
+  return count;
+}
+
+static const char*
+Column(char* columns[REPLAY_COLUMNS_MAX], int count, int8_t index)
+{
+  return (index >= 0 && index < count) ? columns[index] : NULL;
+}
+
+static bool
+ParseDouble(const char* text, double* out)
+{
+  if (text == NULL || *text == '\0') {
+    return false;
+  }
+  char* end = NULL;
+  const double value = strtod(text, &end);
+  if (end == text || !isfinite(value)) {
+    return false;
+  }
+  *out = value;
+  return true;
+}
+
+// Callendar-Van Dusen: resistance at temp_c.
+static double
+CvdResistance(double temp_c, double r0_ohm)
+{
+  double ratio = 1.0 + kCvdA * temp_c + kCvdB * temp_c * temp_c;
+  if (temp_c < 0.0) {
+    ratio += kCvdC * (temp_c - 100.0) * temp_c * temp_c * temp_c;
+  }
+  return r0_ohm * ratio;
+}
+
+// Milliseconds of "2025-12-26T10:42:24.412-06:00"; 0 without them.
+static int64_t
+IsoMillis(const char* iso)
+{
+  const char* dot = (iso != NULL) ? strchr(iso, '.') : NULL;
+  if (dot == NULL) {
+    return 0;
+  }
+  int64_t millis = 0;
+  int digits = 0;
+  for (const char* c = dot + 1; digits < 3 && *c >= '0' && *c <= '9'; ++c) {
+    millis = millis * 10 + (*c - '0');
+    digits++;
+  }
+  for (; digits < 3; ++digits) {
+    millis *= 10;
+  }
+  return millis;
+}
+
+// Next row of the selected channel; false at the end of the file.
+static bool
+ReadRow(max31865_replay_t* replay, max31865_replay_row_t* row_out)
+{
+  char line[REPLAY_LINE_MAX];
+  while (fgets(line, sizeof(line), replay->file) != NULL) {
+    if (line[0] == '#' || line[0] == '\r' || line[0] == '\n') {
+      continue; // alarm comment lines and blank lines
+    }
+    char* columns[REPLAY_COLUMNS_MAX];
+    const int count = SplitColumns(line, columns);
+
+    uint16_t flags = 0;
+    const char* flags_text = Column(columns, count, replay->column_flags);
+    if (flags_text != NULL) {
+      flags = (uint16_t)strtoul(flags_text, NULL, 0);
+    }
+    if (replay->channel >= 0 &&
+        LOG_RECORD_CHANNEL(flags) != (uint8_t)replay->channel) {
+      continue;
+    }
+
+    max31865_replay_row_t row;
+    memset(&row, 0, sizeof(row));
+    const int64_t last_ms = replay->rows > 0 ? replay->next.time_ms : 0;
+    double epoch_sec = 0.0;
+    if (ParseDouble(Column(columns, count, replay->column_epoch),
+                    &epoch_sec) &&
+        epoch_sec > 0.0) {
+      row.time_ms = (int64_t)epoch_sec * 1000 +
+                    IsoMillis(Column(columns, count, replay->column_iso));
+    } else {
+      row.time_ms = last_ms + kDefaultRowPeriodMs;
+    }
+    if (replay->rows > 0 && row.time_ms <= last_ms) {
+      row.time_ms = last_ms + 1; // clock stepped back while logging
+    }
+
+    double temp_c = 0.0;
+    const bool have_temp =
+      ParseDouble(Column(columns, count, replay->column_temp), &temp_c);
+    row.temp_milli_c = have_temp ? (int32_t)lround(temp_c * 1000.0)
+                                 : INT32_MIN;
+    bool have_ohms = ParseDouble(Column(columns, count, replay->column_ohms),
+                                 &row.resistance_ohm) &&
+                     row.resistance_ohm > 0.0;
+    if (!have_ohms && have_temp) {
+      row.resistance_ohm = CvdResistance(temp_c, replay->r0_ohm);
+      have_ohms = true;
+    }
+    row.fault = !have_ohms || (flags & LOG_RECORD_FLAG_SENSOR_FAULT) != 0;
+    replay->rows++;
+    *row_out = row;
+    return true;
+  }
+  return false;
+}
+
+// Back to the first row; false when the file has none.
+static bool
+Restart(max31865_replay_t* replay, int64_t now_us)
+{
+  if (fseek(replay->file, replay->data_offset, SEEK_SET) != 0) {
+    return false;
+  }
+  replay->rows = 0;
+  if (!ReadRow(replay, &replay->prev)) {
+    return false;
+  }
+  replay->next = replay->prev; // ReadRow spaces rows from next
+  replay->has_next = ReadRow(replay, &replay->next);
+  replay->origin_us = now_us;
+  replay->origin_trace_ms = replay->prev.time_ms;
+  return true;
+}
+
+// Moves prev to next; loops or finishes at the end of the trace.
+static void
+StepRow(max31865_replay_t* replay, int64_t now_us)
+{
+  if (replay->has_next) {
+    replay->prev = replay->next;
+    replay->has_next = ReadRow(replay, &replay->next);
+    return;
+  }
+  if (replay->loop && Restart(replay, now_us)) {
+    replay->loops++;
+    return;
+  }
+  replay->finished = true;
+}
+
+// Latches the trace at now_us into the RTD and fault registers.
+static void
+Convert(max31865_replay_t* replay, int64_t now_us)
+{
+  if (!replay->started) {
+    replay->started = true;
+    if (!Restart(replay, now_us)) {
+      replay->finished = true;
+    }
+  } else if (replay->speed == 0) {
+    StepRow(replay, now_us);
+  }
+
+  double ohms = replay->prev.resistance_ohm;
+  bool fault = replay->prev.fault || replay->rows == 0;
+  int32_t trace_temp = replay->prev.temp_milli_c;
+  replay->trace_ms = replay->prev.time_ms;
+  if (replay->speed > 0 && !replay->finished) {
+    int64_t trace_ms = replay->origin_trace_ms +
+                       (now_us - replay->origin_us) / 1000 *
+                         (int64_t)replay->speed;
+    while (!replay->finished && replay->has_next &&
+           replay->next.time_ms <= trace_ms) {
+      StepRow(replay, now_us);
+    }
+    if (!replay->has_next && !replay->finished &&
+        trace_ms >= replay->prev.time_ms + kDefaultRowPeriodMs) {
+      StepRow(replay, now_us); // past the last row: loop or finish
+      trace_ms = replay->origin_trace_ms;
+    }
+    ohms = replay->prev.resistance_ohm;
+    fault = replay->prev.fault;
+    trace_temp = replay->prev.temp_milli_c;
+    replay->trace_ms = replay->prev.time_ms;
+    const int64_t span_ms = replay->next.time_ms - replay->prev.time_ms;
+    if (replay->has_next && !fault && !replay->next.fault && span_ms > 0 &&
+        span_ms <= kMaxInterpolateMs && trace_ms > replay->prev.time_ms) {
+      const double weight =
+        (double)(trace_ms - replay->prev.time_ms) / (double)span_ms;
+      ohms += (replay->next.resistance_ohm - ohms) * weight;
+      if (trace_temp != INT32_MIN && replay->next.temp_milli_c != INT32_MIN) {
+        trace_temp += (int32_t)lround(
+          (double)(replay->next.temp_milli_c - trace_temp) * weight);
+      }
+      replay->trace_ms = trace_ms;
+    }
+  }
+  replay->trace_temp_milli_c = fault ? INT32_MIN : trace_temp;
+
+  uint16_t code = kOpenCode;
+  if (!fault) {
+    const long scaled = lround(ohms / replay->rref_ohm * 32768.0);
+    code = (uint16_t)((scaled < 0) ? 0 : (scaled > 0x7FFF) ? 0x7FFF : scaled);
+  }
+  const uint16_t rtd_raw = (uint16_t)((code << 1) | (fault ? 1u : 0u));
+  replay->regs[kRegRtdMsb] = (uint8_t)(rtd_raw >> 8);
+  replay->regs[kRegRtdLsb] = (uint8_t)(rtd_raw & 0xFFu);
+  replay->regs[kRegFaultStatus] = fault ? kOpenFaultStatus : 0;
+  replay->conversions++;
+}
+
+esp_err_t
+Max31865ReplayOpen(max31865_replay_t* replay,
+                   const char* path,
+                   int8_t channel,
+                   uint32_t speed,
+                   bool loop)
+{
+  if (replay == NULL || path == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(replay, 0, sizeof(*replay));
+  replay->file = fopen(path, "rb");
+  if (replay->file == NULL) {
+    ESP_LOGE(kTag, "Cannot open %s", path);
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  char header[REPLAY_LINE_MAX];
+  if (fgets(header, sizeof(header), replay->file) == NULL) {
+    Max31865ReplayClose(replay);
+    return ESP_ERR_INVALID_SIZE;
+  }
+  replay->column_ohms = -1;
+  replay->column_temp = -1;
+  replay->column_epoch = -1;
+  replay->column_iso = -1;
+  replay->column_flags = -1;
+  char* columns[REPLAY_COLUMNS_MAX];
+  const int count = SplitColumns(header, columns);
+  for (int i = 0; i < count; ++i) {
+    if (strcmp(columns[i], "raw_rtd_ohms") == 0) {
+      replay->column_ohms = (int8_t)i;
+    } else if (strcmp(columns[i], "raw_temp_c") == 0) {
+      replay->column_temp = (int8_t)i;
+    } else if (strcmp(columns[i], "epoch_utc") == 0) {
+      replay->column_epoch = (int8_t)i;
+    } else if (strcmp(columns[i], "iso8601_local") == 0) {
+      replay->column_iso = (int8_t)i;
+    } else if (strcmp(columns[i], "flags") == 0) {
+      replay->column_flags = (int8_t)i;
+    }
+  }
+  if (replay->column_ohms < 0 && replay->column_temp < 0) {
+    ESP_LOGE(kTag, "%s has neither raw_rtd_ohms nor raw_temp_c", path);
+    Max31865ReplayClose(replay);
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+
+  replay->data_offset = ftell(replay->file);
+  replay->channel = channel;
+  replay->speed = speed;
+  replay->loop = loop;
+  replay->rref_ohm = 430.0;
+  replay->r0_ohm = 100.0;
+  replay->trace_temp_milli_c = INT32_MIN;
+  return ESP_OK;
+}
+
+void
+Max31865ReplayClose(max31865_replay_t* replay)
+{
+  if (replay == NULL) {
+    return;
+  }
+  if (replay->file != NULL) {
+    fclose(replay->file);
+    replay->file = NULL;
+  }
+}
+
+esp_err_t
+Max31865ReplayWriteReg(max31865_replay_t* replay, uint8_t reg, uint8_t value)
+{
+  if (replay == NULL || replay->file == NULL ||
+      reg >= sizeof(replay->regs)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (reg != kRegConfig) {
+    replay->regs[reg] = value;
+    return ESP_OK;
+  }
+  if ((value & kCfgFaultStatusClear) != 0) {
+    replay->regs[kRegFaultStatus] = 0;
+    replay->regs[kRegRtdLsb] &= (uint8_t)~1u;
+  }
+  replay->regs[kRegConfig] = (uint8_t)(value & ~kCfgFaultStatusClear);
+  if ((value & kCfgOneShot) != 0 && (value & kCfgAutoConvert) == 0) {
+    const int64_t now_us = esp_timer_get_time();
+    Convert(replay, now_us);
+    replay->oneshot_done_us =
+      now_us + ((replay->speed > 0)
+                  ? (int64_t)(replay->conversion_us / replay->speed)
+                  : 0);
+  }
+  return ESP_OK;
+}
+
+esp_err_t
+Max31865ReplayReadRegs(max31865_replay_t* replay,
+                       uint8_t reg,
+                       uint8_t* data_out,
+                       size_t len)
+{
+  if (replay == NULL || replay->file == NULL || data_out == NULL ||
+      reg + len > sizeof(replay->regs)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint8_t config = replay->regs[kRegConfig];
+  const int64_t now_us = esp_timer_get_time();
+  if ((config & kCfgOneShot) != 0 && now_us >= replay->oneshot_done_us) {
+    replay->regs[kRegConfig] &= (uint8_t)~kCfgOneShot; // conversion done
+  }
+  // In auto-convert every read of the RTD registers sees a new conversion.
+  if ((config & (kCfgVbias | kCfgAutoConvert)) ==
+        (kCfgVbias | kCfgAutoConvert) &&
+      reg <= kRegRtdMsb && reg + len > kRegRtdMsb) {
+    Convert(replay, now_us);
+  }
+  memcpy(data_out, &replay->regs[reg], len);
+  return ESP_OK;
+}
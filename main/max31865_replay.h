@@ -0,0 +1,97 @@
+#ifndef PT100_LOGGER_MAX31865_REPLAY_H_
+#define PT100_LOGGER_MAX31865_REPLAY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Stand-in for a MAX31865 that replays a recorded trace: a CSV as the
+// logger writes it (host_tools/*.csv), resistance from raw_rtd_ohms or,
+// when that is empty, from raw_temp_c. Attached to a reader with
+// Max31865ReaderAttachReplay(), it answers the reader's register reads and
+// writes in place of the SPI bus, so one-shot and continuous reads, the
+// conversion methods, fault handling and everything after the reader run
+// unchanged.
+//
+// With speed > 0 the trace plays against esp_timer at speed times real
+// time, the resistance is interpolated between rows (held across gaps over
+// a minute) and a one-shot conversion takes 1/speed of the chip's time.
+// With speed 0 every conversion takes the next row at once. Rows
+// flagged LOG_RECORD_FLAG_SENSOR_FAULT, or without a reading, convert as
+// an open RTD.
+
+  typedef struct
+  {
+    int64_t time_ms; // epoch_utc plus the milliseconds of iso8601_local
+    double resistance_ohm;
+    int32_t temp_milli_c; // raw_temp_c as logged; INT32_MIN if missing
+    bool fault;
+  } max31865_replay_row_t;
+
+  typedef struct max31865_replay
+  {
+    FILE* file;
+    long data_offset; // first row, for looping
+    int8_t column_ohms;
+    int8_t column_temp;
+    int8_t column_epoch;
+    int8_t column_iso;
+    int8_t column_flags;
+    int8_t channel; // rows of this channel only (flags bits 12..15); -1 all
+    uint32_t speed;
+    bool loop;
+    // From the reader (Max31865ReaderAttachReplay).
+    double rref_ohm;
+    double r0_ohm;
+    uint32_t conversion_us;
+    // Playback.
+    bool started;
+    bool has_next;
+    max31865_replay_row_t prev;
+    max31865_replay_row_t next;
+    int64_t origin_us;       // clock time that maps to origin_trace_ms
+    int64_t origin_trace_ms; // first row of the current pass
+    int64_t trace_ms;        // trace time of the latest conversion
+    int32_t trace_temp_milli_c; // raw_temp_c at trace_ms (interpolated)
+    // Register file (0x00..0x07).
+    uint8_t regs[8];
+    int64_t oneshot_done_us;
+    uint32_t rows;
+    uint32_t conversions;
+    uint32_t loops;
+    bool finished; // past the last row without loop; the last row holds
+  } max31865_replay_t;
+
+  // Opens path and reads its header. channel selects one RTD channel's
+  // rows (-1 for every row); speed 0 steps one row per conversion; loop
+  // restarts at the first row after the last.
+  esp_err_t Max31865ReplayOpen(max31865_replay_t* replay,
+                               const char* path,
+                               int8_t channel,
+                               uint32_t speed,
+                               bool loop);
+
+  void Max31865ReplayClose(max31865_replay_t* replay);
+
+  // Register access as seen on SPI (reg without the write bit).
+  esp_err_t Max31865ReplayWriteReg(max31865_replay_t* replay,
+                                   uint8_t reg,
+                                   uint8_t value);
+  esp_err_t Max31865ReplayReadRegs(max31865_replay_t* replay,
+                                   uint8_t reg,
+                                   uint8_t* data_out,
+                                   size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_MAX31865_REPLAY_H_
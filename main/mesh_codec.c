@@ -0,0 +1,368 @@
+#include "mesh_codec.h"
+
+#include <string.h>
+
+#include "crc16.h"
+
+// Compact codec (MESH_CODEC_COMPACT) payload:
+//   mesh_batch_header_t
+//   varint schema_version                (once per frame)
+//   record_count x {
+//     varint   record_id delta           (vs previous record, first vs 0)
+//     varint   sequence delta            (mod 2^32, so wrap is fine)
+//     zz-varint epoch seconds delta
+//     zz-varint millis delta
+//     zz-varint raw_temp_milli_c delta
+//     zz-varint temp_milli_c delta
+//     zz-varint resistance_milli_ohm delta
+//     varint   flags                     (absolute)
+//     uint16   record CRC as sealed by the sender (little endian)
+//   }
+//   uint16 CRC16-CCITT-FALSE over everything before it (little endian)
+//
+// The decoder restores magic and schema_version and keeps the sender's
+// record CRC; a record that does not rebuild to it is not delivered.
+#define COMPACT_CRC_BYTES 2u
+// Worst case per record: 10 (u64) + 5 (u32) + 10 (i64) + 4 x 5 (i32) + 3 (u16)
+// + 2 (CRC).
+#define COMPACT_MAX_RECORD_BYTES 50u
+#define COMPACT_MAX_SCHEMA_BYTES 5u
+
+static size_t
+PutVarint(uint8_t* out, uint64_t value)
+{
+  size_t length = 0;
+  while (value >= 0x80u) {
+    out[length++] = (uint8_t)(value | 0x80u);
+    value >>= 7;
+  }
+  out[length++] = (uint8_t)value;
+  return length;
+}
+
+static uint64_t
+ZigZagEncode(int64_t value)
+{
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t
+ZigZagDecode(uint64_t value)
+{
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1u);
+}
+
+static bool
+GetVarint(const uint8_t* data, size_t len, size_t* offset, uint64_t* value_out)
+{
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (*offset >= len) {
+      return false;
+    }
+    const uint8_t byte = data[(*offset)++];
+    value |= (uint64_t)(byte & 0x7Fu) << shift;
+    if ((byte & 0x80u) == 0) {
+      *value_out = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+static size_t
+EncodeCompactRecord(uint8_t* out,
+                    const log_record_t* previous,
+                    const log_record_t* record)
+{
+  size_t length = 0;
+  length += PutVarint(out + length, record->record_id - previous->record_id);
+  length += PutVarint(out + length,
+                      (uint32_t)(record->sequence - previous->sequence));
+  length += PutVarint(out + length,
+                      ZigZagEncode(record->timestamp_epoch_sec -
+                                   previous->timestamp_epoch_sec));
+  length += PutVarint(out + length,
+                      ZigZagEncode((int64_t)record->timestamp_millis -
+                                   previous->timestamp_millis));
+  length += PutVarint(out + length,
+                      ZigZagEncode((int64_t)record->raw_temp_milli_c -
+                                   previous->raw_temp_milli_c));
+  length += PutVarint(
+    out + length,
+    ZigZagEncode((int64_t)record->temp_milli_c - previous->temp_milli_c));
+  length += PutVarint(out + length,
+                      ZigZagEncode((int64_t)record->resistance_milli_ohm -
+                                   previous->resistance_milli_ohm));
+  length += PutVarint(out + length, record->flags);
+  out[length++] = (uint8_t)(record->crc16_ccitt & 0xFFu);
+  out[length++] = (uint8_t)(record->crc16_ccitt >> 8);
+  return length;
+}
+
+static bool
+DecodeCompactRecord(const uint8_t* data,
+                    size_t len,
+                    size_t* offset,
+                    const log_record_t* previous,
+                    log_record_t* record_out)
+{
+  uint64_t fields[8];
+  for (size_t index = 0; index < 8; ++index) {
+    if (!GetVarint(data, len, offset, &fields[index])) {
+      return false;
+    }
+  }
+  *record_out = *previous;
+  record_out->record_id = previous->record_id + fields[0];
+  record_out->sequence = previous->sequence + (uint32_t)fields[1];
+  record_out->timestamp_epoch_sec =
+    previous->timestamp_epoch_sec + ZigZagDecode(fields[2]);
+  record_out->timestamp_millis =
+    (int32_t)(previous->timestamp_millis + ZigZagDecode(fields[3]));
+  record_out->raw_temp_milli_c =
+    (int32_t)(previous->raw_temp_milli_c + ZigZagDecode(fields[4]));
+  record_out->temp_milli_c =
+    (int32_t)(previous->temp_milli_c + ZigZagDecode(fields[5]));
+  record_out->resistance_milli_ohm =
+    (int32_t)(previous->resistance_milli_ohm + ZigZagDecode(fields[6]));
+  record_out->flags = (uint16_t)fields[7];
+  if (*offset + 2u > len) {
+    return false;
+  }
+  record_out->crc16_ccitt =
+    (uint16_t)data[*offset] | (uint16_t)((uint16_t)data[*offset + 1] << 8);
+  *offset += 2u;
+  return true;
+}
+
+// Restores the fields the codec leaves out and checks the result against the
+// CRC the sender sealed the record with.
+static bool
+FinalizeDecodedRecord(log_record_t* record, uint32_t schema_version)
+{
+  record->magic = LOG_RECORD_MAGIC;
+  record->schema_version = schema_version;
+  const uint16_t sender_crc = record->crc16_ccitt;
+  record->crc16_ccitt = 0;
+  const uint16_t actual_crc =
+    Crc16CcittFalse(record, sizeof(*record) - sizeof(record->crc16_ccitt));
+  record->crc16_ccitt = sender_crc;
+  return actual_crc == sender_crc;
+}
+
+esp_err_t
+MeshBatchWriterInit(mesh_batch_writer_t* writer,
+                    uint8_t* buffer,
+                    size_t capacity,
+                    uint8_t codec)
+{
+  if (writer == NULL || buffer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (codec != MESH_CODEC_RAW && codec != MESH_CODEC_COMPACT) {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  if (capacity < sizeof(mesh_batch_header_t) + sizeof(log_record_t)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memset(writer, 0, sizeof(*writer));
+  writer->buffer = buffer;
+  writer->capacity = capacity;
+  writer->codec = codec;
+  writer->used = sizeof(mesh_batch_header_t);
+  return ESP_OK;
+}
+
+static esp_err_t
+AppendCompact(mesh_batch_writer_t* writer, const log_record_t* record)
+{
+  uint8_t scratch[COMPACT_MAX_SCHEMA_BYTES + COMPACT_MAX_RECORD_BYTES];
+  size_t length = 0;
+  log_record_t zero_record;
+  const log_record_t* previous = &writer->previous;
+
+  if (writer->record_count == 0) {
+    length += PutVarint(scratch, record->schema_version);
+    memset(&zero_record, 0, sizeof(zero_record));
+    previous = &zero_record;
+  } else if (record->schema_version != writer->schema_version) {
+    // One schema per frame; force the caller to start a new frame.
+    return ESP_ERR_NO_MEM;
+  }
+  length += EncodeCompactRecord(scratch + length, previous, record);
+
+  if (writer->used + length + COMPACT_CRC_BYTES > writer->capacity) {
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(writer->buffer + writer->used, scratch, length);
+  writer->used += length;
+  writer->previous = *record;
+  writer->schema_version = record->schema_version;
+  writer->record_count++;
+  return ESP_OK;
+}
+
+esp_err_t
+MeshBatchWriterAppend(mesh_batch_writer_t* writer, const log_record_t* record)
+{
+  if (writer == NULL || writer->buffer == NULL || record == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (writer->record_count >= MESH_BATCH_MAX_RECORDS) {
+    return ESP_ERR_NO_MEM;
+  }
+  if (writer->codec == MESH_CODEC_COMPACT) {
+    return AppendCompact(writer, record);
+  }
+  if (writer->used + sizeof(log_record_t) > writer->capacity) {
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(writer->buffer + writer->used, record, sizeof(log_record_t));
+  writer->used += sizeof(log_record_t);
+  writer->record_count++;
+  return ESP_OK;
+}
+
+bool
+MeshBatchWriterIsFull(const mesh_batch_writer_t* writer)
+{
+  if (writer == NULL || writer->buffer == NULL) {
+    return true;
+  }
+  if (writer->record_count >= MESH_BATCH_MAX_RECORDS) {
+    return true;
+  }
+  if (writer->codec == MESH_CODEC_COMPACT) {
+    return writer->used + COMPACT_MAX_SCHEMA_BYTES + COMPACT_MAX_RECORD_BYTES +
+             COMPACT_CRC_BYTES >
+           writer->capacity;
+  }
+  return writer->used + sizeof(log_record_t) > writer->capacity;
+}
+
+size_t
+MeshBatchWriterFinish(mesh_batch_writer_t* writer)
+{
+  if (writer == NULL || writer->buffer == NULL) {
+    return 0;
+  }
+  const mesh_batch_header_t header = {
+    .codec = writer->codec,
+    .record_count = writer->record_count,
+  };
+  memcpy(writer->buffer, &header, sizeof(header));
+  if (writer->codec != MESH_CODEC_COMPACT) {
+    return writer->used;
+  }
+  const uint16_t crc = Crc16CcittFalse(writer->buffer, writer->used);
+  writer->buffer[writer->used] = (uint8_t)(crc & 0xFFu);
+  writer->buffer[writer->used + 1] = (uint8_t)(crc >> 8);
+  return writer->used + COMPACT_CRC_BYTES;
+}
+
+static esp_err_t
+DecodeRaw(const uint8_t* data,
+          size_t len,
+          const mesh_batch_header_t* header,
+          mesh_batch_record_cb_t record_cb,
+          void* context,
+          uint32_t* records_out)
+{
+  size_t offset = sizeof(*header);
+  for (uint32_t index = 0; index < header->record_count; ++index) {
+    if (offset + sizeof(log_record_t) > len) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+    log_record_t record;
+    memcpy(&record, data + offset, sizeof(record));
+    offset += sizeof(record);
+    if (record_cb != NULL) {
+      record_cb(&record, context);
+    }
+    if (records_out != NULL) {
+      (*records_out)++;
+    }
+  }
+  return ESP_OK;
+}
+
+static esp_err_t
+DecodeCompact(const uint8_t* data,
+              size_t len,
+              const mesh_batch_header_t* header,
+              mesh_batch_record_cb_t record_cb,
+              void* context,
+              uint32_t* records_out)
+{
+  if (len < sizeof(*header) + COMPACT_CRC_BYTES) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  const size_t body_len = len - COMPACT_CRC_BYTES;
+  const uint16_t expected_crc =
+    (uint16_t)data[body_len] | (uint16_t)((uint16_t)data[body_len + 1] << 8);
+  if (Crc16CcittFalse(data, body_len) != expected_crc) {
+    return ESP_ERR_INVALID_CRC;
+  }
+  if (header->record_count == 0) {
+    return ESP_OK;
+  }
+
+  size_t offset = sizeof(*header);
+  uint64_t schema_version = 0;
+  if (!GetVarint(data, body_len, &offset, &schema_version)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  esp_err_t result = ESP_OK;
+  log_record_t previous;
+  memset(&previous, 0, sizeof(previous));
+  for (uint32_t index = 0; index < header->record_count; ++index) {
+    log_record_t record;
+    if (!DecodeCompactRecord(data, body_len, &offset, &previous, &record)) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+    previous = record;
+    if (!FinalizeDecodedRecord(&record, (uint32_t)schema_version)) {
+      // Deltas still hold, so the records after it decode fine.
+      result = ESP_ERR_INVALID_CRC;
+      continue;
+    }
+    if (record_cb != NULL) {
+      record_cb(&record, context);
+    }
+    if (records_out != NULL) {
+      (*records_out)++;
+    }
+  }
+  return result;
+}
+
+esp_err_t
+MeshBatchDecode(const uint8_t* data,
+                size_t len,
+                mesh_batch_record_cb_t record_cb,
+                void* context,
+                uint32_t* records_out)
+{
+  if (records_out != NULL) {
+    *records_out = 0;
+  }
+  if (data == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (len < sizeof(mesh_batch_header_t)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  mesh_batch_header_t header;
+  memcpy(&header, data, sizeof(header));
+  switch (header.codec) {
+    case MESH_CODEC_RAW:
+      return DecodeRaw(data, len, &header, record_cb, context, records_out);
+    case MESH_CODEC_COMPACT:
+      return DecodeCompact(data, len, &header, record_cb, context, records_out);
+    default:
+      return ESP_ERR_NOT_SUPPORTED;
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef PT100_LOGGER_MESH_CODEC_H_
+#define PT100_LOGGER_MESH_CODEC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "log_record.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Batch payload carried after the mesh message header (type + src_mac).
+// Layout: mesh_batch_header_t followed by record_count encoded records.
+// The codec byte doubles as the wire version: receivers decode every codec
+// they know, so fleets with mixed firmware keep working.
+#define MESH_CODEC_RAW 1u     // records copied verbatim (48 bytes each)
+#define MESH_CODEC_COMPACT 2u // delta varints, record and frame CRC16s
+
+#define MESH_BATCH_MAX_RECORDS 255u
+
+#pragma pack(push, 1)
+  typedef struct
+  {
+    uint8_t codec;        // MESH_CODEC_*
+    uint8_t record_count; // number of records that follow
+  } mesh_batch_header_t;
+#pragma pack(pop)
+
+  // Incremental batch encoder over a caller-owned buffer. The buffer must
+  // outlive the writer; no allocation happens here.
+  typedef struct
+  {
+    uint8_t* buffer;
+    size_t capacity;
+    size_t used;
+    uint8_t codec;
+    uint8_t record_count;
+    log_record_t previous;   // delta base (MESH_CODEC_COMPACT)
+    uint32_t schema_version; // per-frame field (MESH_CODEC_COMPACT)
+  } mesh_batch_writer_t;
+
+  typedef void (*mesh_batch_record_cb_t)(const log_record_t* record,
+                                         void* context);
+
+  esp_err_t MeshBatchWriterInit(mesh_batch_writer_t* writer,
+                                uint8_t* buffer,
+                                size_t capacity,
+                                uint8_t codec);
+
+  // Appends one record. Returns ESP_ERR_NO_MEM when the record does not fit;
+  // the writer is left unchanged so the caller can finish and start over.
+  esp_err_t MeshBatchWriterAppend(mesh_batch_writer_t* writer,
+                                  const log_record_t* record);
+
+  // Finalizes the batch header and returns the encoded size in bytes.
+  size_t MeshBatchWriterFinish(mesh_batch_writer_t* writer);
+
+  static inline bool
+  MeshBatchWriterIsEmpty(const mesh_batch_writer_t* writer)
+  {
+    return writer == NULL || writer->record_count == 0;
+  }
+
+  // True when no further record is guaranteed to fit; callers flush early
+  // instead of waiting for the latency deadline.
+  bool MeshBatchWriterIsFull(const mesh_batch_writer_t* writer);
+
+  // Decodes a batch payload, invoking record_cb once per record in order.
+  // Compact records are rebuilt into full log_record_t values (magic and
+  // schema restored) and must match the record CRC the sender carried; one
+  // that does not is skipped and the call returns ESP_ERR_INVALID_CRC once
+  // the rest are delivered. Also ESP_ERR_INVALID_CRC on a frame CRC mismatch
+  // (nothing delivered), ESP_ERR_INVALID_SIZE on truncation and
+  // ESP_ERR_NOT_SUPPORTED on an unknown codec. Records decoded before a
+  // truncation error are still delivered.
+  esp_err_t MeshBatchDecode(const uint8_t* data,
+                            size_t len,
+                            mesh_batch_record_cb_t record_cb,
+                            void* context,
+                            uint32_t* records_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_MESH_CODEC_H_
@@ -0,0 +1,62 @@
+#include "mesh_credit.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "mesh_transport.h"
+
+// Time over which a node's sends can reach the root together: one
+// aggregation window (plus a relay window) and the credit it saved up.
+static const uint32_t kBurstWindowMs =
+  MESH_TRANSPORT_AGG_MAX_LATENCY_MS + MESH_TRANSPORT_CREDIT_BURST_MS +
+  (MESH_TRANSPORT_RELAY_AGGREGATION ? MESH_TRANSPORT_RELAY_WINDOW_MS : 0);
+
+void
+MeshCreditInit(mesh_credit_t* credit, const record_ring_t* ring)
+{
+  if (credit == NULL) {
+    return;
+  }
+  memset(credit, 0, sizeof(*credit));
+  RecordRingOccupancy(ring, NULL, &credit->last_tail);
+}
+
+uint32_t
+MeshCreditUpdate(mesh_credit_t* credit,
+                 const record_ring_t* ring,
+                 uint32_t period_ms)
+{
+  if (credit == NULL || ring == NULL || ring->slots == NULL || period_ms == 0) {
+    return 0;
+  }
+  uint32_t used = 0;
+  uint32_t tail = 0;
+  RecordRingOccupancy(ring, &used, &tail);
+  const uint32_t drained = tail - credit->last_tail;
+  credit->last_tail = tail;
+
+  const uint32_t capacity = ring->capacity;
+  const uint32_t high_mark = capacity - capacity / 4u;
+  // Records granted last time may still sit in aggregators: a burst window
+  // at the old rate. They will need room the ring does not show yet, less
+  // what the consumers free over the same window.
+  uint64_t in_flight = (uint64_t)credit->budget * kBurstWindowMs / 60000u;
+  const uint64_t drained_in_window =
+    (uint64_t)drained * kBurstWindowMs / period_ms;
+  in_flight = (in_flight > drained_in_window) ? in_flight - drained_in_window
+                                              : 0;
+  uint64_t room = (used < high_mark) ? high_mark - used : 0;
+  room = (room > in_flight) ? room - in_flight : 0;
+  // What lands together must fit even when a window is longer than a period.
+  if (kBurstWindowMs > period_ms) {
+    room = room * period_ms / kBurstWindowMs;
+  }
+  const uint64_t per_period = (uint64_t)drained + room;
+  uint64_t per_min = per_period * 60000u / period_ms;
+  if (per_min > UINT32_MAX - 1u) {
+    per_min = UINT32_MAX - 1u; // UINT32_MAX means unlimited to the transport
+  }
+  credit->drained = drained;
+  credit->budget = (uint32_t)per_min;
+  return credit->budget;
+}
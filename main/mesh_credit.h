@@ -0,0 +1,44 @@
+#ifndef PT100_LOGGER_MESH_CREDIT_H_
+#define PT100_LOGGER_MESH_CREDIT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "record_ring.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Root-side flow control: turns export ring occupancy into the rate the
+// whole mesh may send at (records per minute, MeshTransportSetCreditBudget).
+// Leaves keep what they may not send in FRAM, so a slow export path defers
+// records instead of the ring dropping them.
+//
+// Per ACK period the mesh may send what the slowest ring consumer freed over
+// the last one plus the room left below three quarters full; a stalled
+// export path settles at zero, a busy one at its own rate. Leaves spend the
+// grant as a rate, not in one lump per ACK; when an aggregation window (plus
+// saved-up credit) is longer than the ACK period, the room is scaled down so
+// nodes sampling on the same clock and flushing together still fit.
+
+  typedef struct
+  {
+    uint32_t last_tail; // slowest consumer position at the last update
+    uint32_t drained;   // slots freed over the last period
+    uint32_t budget;    // last result, records per minute
+  } mesh_credit_t;
+
+  void MeshCreditInit(mesh_credit_t* credit, const record_ring_t* ring);
+
+  // Call once per ACK period, right before MeshTransportBroadcastAcks().
+  uint32_t MeshCreditUpdate(mesh_credit_t* credit,
+                            const record_ring_t* ring,
+                            uint32_t period_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_MESH_CREDIT_H_
@@ -0,0 +1,355 @@
+#include "mesh_rejoin.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_mesh_lite_core.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "nvs.h"
+
+static const char* kTag = "mesh_rejoin";
+static const char* kNvsNamespace = "pt100_logger";
+static const char* kKeyMeshParent = "mesh_parent";
+
+#ifdef CONFIG_APP_MESH_FAST_REJOIN
+static const bool kFastRejoin = true;
+#else
+static const bool kFastRejoin = false;
+#endif
+#ifdef CONFIG_APP_MESH_FAST_REJOIN_WINDOW_MS
+static const int64_t kFastRejoinWindowUs =
+  (int64_t)CONFIG_APP_MESH_FAST_REJOIN_WINDOW_MS * 1000;
+#else
+static const int64_t kFastRejoinWindowUs = 8000 * 1000;
+#endif
+
+typedef enum
+{
+  kRejoinIdle = 0, // associated
+  kRejoinFast,     // pinned to the cached parent until the window ends
+  kRejoinScan,     // left to the Mesh-Lite scan
+} rejoin_phase_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static mesh_transport_t* s_mesh = NULL;
+static esp_event_handler_instance_t s_wifi_handler = NULL;
+static bool s_started = false;
+static rejoin_phase_t s_phase = kRejoinScan;
+static int64_t s_window_end_us = 0;
+static bool s_pinned = false;
+static wifi_config_t s_saved_sta; // Mesh-Lite's STA config before the pin
+static mesh_parent_cache_t s_cache;
+static bool s_cache_valid = false;
+static mesh_parent_cache_t s_current; // parent of the live association
+static bool s_current_valid = false;
+static mesh_rejoin_status_t s_stats;
+
+static esp_err_t
+LoadCache(mesh_parent_cache_t* cache_out)
+{
+  nvs_handle_t handle;
+  esp_err_t result = nvs_open(kNvsNamespace, NVS_READONLY, &handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  size_t size = sizeof(*cache_out);
+  result = nvs_get_blob(handle, kKeyMeshParent, cache_out, &size);
+  nvs_close(handle);
+  if (result == ESP_OK &&
+      (size != sizeof(*cache_out) || cache_out->channel == 0 ||
+       cache_out->ssid_len == 0 || cache_out->ssid_len > 32)) {
+    result = ESP_ERR_INVALID_SIZE;
+  }
+  return result;
+}
+
+static esp_err_t
+StoreCache(const mesh_parent_cache_t* cache)
+{
+  nvs_handle_t handle;
+  esp_err_t result = nvs_open(kNvsNamespace, NVS_READWRITE, &handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  result = nvs_set_blob(handle, kKeyMeshParent, cache, sizeof(*cache));
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
+
+// Points the STA at the cached parent only: its BSSID, and a scan of its
+// channel alone. Keeps the password Mesh-Lite configured. The config to
+// restore is read afresh whenever no pin is in place, so it follows any
+// change Mesh-Lite made since the last window.
+static esp_err_t
+PinToCachedParent(const mesh_parent_cache_t* parent)
+{
+  wifi_config_t config = { 0 };
+  esp_err_t result = esp_wifi_get_config(WIFI_IF_STA, &config);
+  if (result != ESP_OK) {
+    return result;
+  }
+  if (!s_pinned) {
+    s_saved_sta = config;
+  }
+  memset(config.sta.ssid, 0, sizeof(config.sta.ssid));
+  memcpy(config.sta.ssid, parent->ssid, parent->ssid_len);
+  memcpy(config.sta.bssid, parent->bssid, sizeof(config.sta.bssid));
+  config.sta.bssid_set = true;
+  config.sta.channel = parent->channel;
+  config.sta.scan_method = WIFI_FAST_SCAN;
+  result = esp_wifi_set_config(WIFI_IF_STA, &config);
+  if (result == ESP_OK) {
+    s_pinned = true;
+  }
+  return result;
+}
+
+static void
+Unpin(void)
+{
+  if (!s_pinned) {
+    return;
+  }
+  s_pinned = false;
+  esp_err_t result = esp_wifi_set_config(WIFI_IF_STA, &s_saved_sta);
+  if (result != ESP_OK) {
+    ESP_LOGW(kTag, "restoring STA config failed: %s", esp_err_to_name(result));
+  }
+}
+
+static void
+TryCachedParent(const mesh_parent_cache_t* parent)
+{
+  esp_err_t result = PinToCachedParent(parent);
+  if (result == ESP_OK) {
+    result = esp_wifi_connect();
+  }
+  portENTER_CRITICAL(&s_lock);
+  s_stats.fast_attempts++;
+  portEXIT_CRITICAL(&s_lock);
+  if (result != ESP_OK) {
+    // Mesh-Lite may be mid-scan; the next disconnect tries again.
+    ESP_LOGD(kTag, "pinned connect: %s", esp_err_to_name(result));
+  }
+}
+
+static void
+OnConnected(const wifi_event_sta_connected_t* info)
+{
+  if (info == NULL) {
+    return;
+  }
+  mesh_parent_cache_t current = { 0 };
+  memcpy(current.bssid, info->bssid, sizeof(current.bssid));
+  current.channel = info->channel;
+  current.ssid_len =
+    (info->ssid_len > sizeof(current.ssid)) ? sizeof(current.ssid) : info->ssid_len;
+  memcpy(current.ssid, info->ssid, current.ssid_len);
+
+  portENTER_CRITICAL(&s_lock);
+  if (s_phase == kRejoinFast && s_cache_valid &&
+      memcmp(current.bssid, s_cache.bssid, sizeof(current.bssid)) == 0) {
+    s_stats.fast_joins++;
+  }
+  s_phase = kRejoinIdle;
+  s_current = current;
+  s_current_valid = true;
+  portEXIT_CRITICAL(&s_lock);
+
+  // Associated: hand the STA config back to Mesh-Lite without the BSSID and
+  // channel pin, which would otherwise block roaming and parent changes.
+  // The live association is not affected.
+  Unpin();
+}
+
+static void
+OnDisconnected(void)
+{
+  MeshTransportNoteLinkDown(s_mesh);
+
+  const int64_t now_us = esp_timer_get_time();
+  bool try_cache = false;
+  bool give_up = false;
+  mesh_parent_cache_t parent;
+  portENTER_CRITICAL(&s_lock);
+  s_current_valid = false;
+  if (s_phase == kRejoinIdle && s_cache_valid) {
+    s_phase = kRejoinFast;
+    s_window_end_us = now_us + kFastRejoinWindowUs;
+    s_stats.fast_windows++;
+  }
+  if (s_phase == kRejoinFast) {
+    if (now_us < s_window_end_us) {
+      try_cache = true;
+    } else {
+      s_phase = kRejoinScan;
+      s_stats.fallbacks++;
+      give_up = true;
+    }
+  }
+  parent = s_cache;
+  portEXIT_CRITICAL(&s_lock);
+
+  if (try_cache) {
+    TryCachedParent(&parent);
+  } else if (give_up) {
+    ESP_LOGI(kTag, "cached parent not reachable; falling back to a full scan");
+    Unpin();
+  }
+}
+
+static void
+WifiEventHandler(void* arg,
+                 esp_event_base_t event_base,
+                 int32_t event_id,
+                 void* event_data)
+{
+  (void)arg;
+  (void)event_base;
+
+  switch (event_id) {
+    case WIFI_EVENT_STA_CONNECTED:
+      OnConnected((const wifi_event_sta_connected_t*)event_data);
+      break;
+
+    case WIFI_EVENT_STA_DISCONNECTED:
+      OnDisconnected();
+      break;
+
+    default:
+      break;
+  }
+}
+
+esp_err_t
+MeshRejoinStart(mesh_transport_t* mesh)
+{
+  if (mesh == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!kFastRejoin || mesh->is_root) {
+    return ESP_OK;
+  }
+  if (s_started) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  mesh_parent_cache_t cache = { 0 };
+  const bool cache_valid = (LoadCache(&cache) == ESP_OK);
+
+  portENTER_CRITICAL(&s_lock);
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_mesh = mesh;
+  s_cache = cache;
+  s_cache_valid = cache_valid;
+  s_current_valid = false;
+  s_pinned = false;
+  s_phase = cache_valid ? kRejoinFast : kRejoinScan;
+  s_window_end_us = esp_timer_get_time() + kFastRejoinWindowUs;
+  if (cache_valid) {
+    s_stats.fast_windows++;
+  }
+  portEXIT_CRITICAL(&s_lock);
+
+  esp_err_t result = esp_event_handler_instance_register(
+    WIFI_EVENT, ESP_EVENT_ANY_ID, &WifiEventHandler, NULL, &s_wifi_handler);
+  if (result != ESP_OK) {
+    ESP_LOGE(kTag, "wifi handler register failed: %s", esp_err_to_name(result));
+    return result;
+  }
+  s_started = true;
+
+  if (cache_valid) {
+    ESP_LOGI(kTag,
+             "trying cached parent %02x:%02x:%02x:%02x:%02x:%02x ch %u",
+             cache.bssid[0],
+             cache.bssid[1],
+             cache.bssid[2],
+             cache.bssid[3],
+             cache.bssid[4],
+             cache.bssid[5],
+             (unsigned)cache.channel);
+    TryCachedParent(&cache);
+  }
+  return ESP_OK;
+}
+
+void
+MeshRejoinStop(void)
+{
+  if (!s_started) {
+    return;
+  }
+  esp_err_t result = esp_event_handler_instance_unregister(
+    WIFI_EVENT, ESP_EVENT_ANY_ID, s_wifi_handler);
+  if (result != ESP_OK) {
+    ESP_LOGW(kTag, "wifi handler unregister failed: %s", esp_err_to_name(result));
+  }
+  s_wifi_handler = NULL;
+  Unpin();
+  portENTER_CRITICAL(&s_lock);
+  s_started = false;
+  s_mesh = NULL;
+  s_phase = kRejoinScan;
+  s_current_valid = false;
+  portEXIT_CRITICAL(&s_lock);
+}
+
+void
+MeshRejoinSaveParent(void)
+{
+  if (!s_started) {
+    return;
+  }
+  const int level = esp_mesh_lite_get_level();
+  if (level <= 1) {
+    return; // not joined, or root
+  }
+  mesh_parent_cache_t current;
+  bool unchanged = false;
+  portENTER_CRITICAL(&s_lock);
+  if (!s_current_valid) {
+    portEXIT_CRITICAL(&s_lock);
+    return;
+  }
+  current = s_current;
+  unchanged =
+    s_cache_valid && memcmp(&current, &s_cache, sizeof(current)) == 0;
+  portEXIT_CRITICAL(&s_lock);
+  if (unchanged) {
+    return;
+  }
+
+  esp_err_t result = StoreCache(&current);
+  if (result != ESP_OK) {
+    ESP_LOGW(kTag, "storing parent failed: %s", esp_err_to_name(result));
+    return;
+  }
+  portENTER_CRITICAL(&s_lock);
+  s_cache = current;
+  s_cache_valid = true;
+  s_stats.cache_writes++;
+  portEXIT_CRITICAL(&s_lock);
+}
+
+void
+MeshRejoinGetStatus(mesh_rejoin_status_t* status_out)
+{
+  if (status_out == NULL) {
+    return;
+  }
+  portENTER_CRITICAL(&s_lock);
+  *status_out = s_stats;
+  status_out->enabled = s_started;
+  status_out->cache_valid = s_cache_valid;
+  status_out->pinned = s_pinned;
+  status_out->parent = s_cache;
+  portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,61 @@
+#ifndef PT100_LOGGER_MESH_REJOIN_H_
+#define PT100_LOGGER_MESH_REJOIN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "mesh_transport.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Leaf fast rejoin. The last parent (BSSID, channel and SSID) is kept in
+// NVS. At boot and after a disconnect the STA is first pinned to that
+// parent's BSSID and channel, so reassociation skips the full Mesh-Lite
+// scan. The pin is dropped as soon as the STA associates, so Mesh-Lite can
+// still roam or change parent later, or once the cached parent has not
+// answered for CONFIG_APP_MESH_FAST_REJOIN_WINDOW_MS, after which Mesh-Lite
+// scans as usual. Link losses are reported to the transport, which times
+// them until the next record goes upstream.
+
+  typedef struct
+  {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+  } mesh_parent_cache_t;
+
+  typedef struct
+  {
+    bool enabled;
+    bool cache_valid;
+    bool pinned; // STA currently pinned to the cached parent
+    mesh_parent_cache_t parent;
+    uint32_t fast_windows;  // link losses (and boots) that tried the cache
+    uint32_t fast_attempts; // pinned association attempts
+    uint32_t fast_joins;    // associations to the cached parent while pinned
+    uint32_t fallbacks;     // windows that ended in a full scan
+    uint32_t cache_writes;
+  } mesh_rejoin_status_t;
+
+  // Leaf nodes only; call after MeshTransportStart(). Loads the cache,
+  // registers the Wi-Fi event handler and tries the cached parent right away.
+  esp_err_t MeshRejoinStart(mesh_transport_t* mesh);
+
+  void MeshRejoinStop(void);
+
+  // Stores the current parent when it differs from the cached one. Call
+  // periodically from a task; NVS writes stay out of the event handler.
+  void MeshRejoinSaveParent(void);
+
+  void MeshRejoinGetStatus(mesh_rejoin_status_t* status_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_MESH_REJOIN_H_
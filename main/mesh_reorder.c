@@ -0,0 +1,292 @@
+#include "mesh_reorder.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// A record this far behind the window means the sender's id space restarted
+// (e.g. FRAM replaced). Re-base instead of treating it as a duplicate forever.
+static const uint64_t kResyncRecords = 100000u;
+// Steps taken one at a time before a far jump is collapsed into bulk counts.
+static const uint64_t kMaxSteppedAdvance = MESH_REORDER_SLOTS + 64u;
+
+static uint32_t
+PopCount64(uint64_t value)
+{
+  return (uint32_t)__builtin_popcountll(value);
+}
+
+// Moves next_record_id forward by one, emitting the head slot if buffered.
+// When the head id is absent it is remembered as missing (recoverable) or
+// counted as lost.
+static void
+AdvanceOne(mesh_reorder_window_t* window,
+           bool mark_missing,
+           mesh_reorder_emit_cb_t emit_cb,
+           void* context)
+{
+  const bool have = (window->ahead_bitmap & 1u) != 0;
+  if ((window->missing_bitmap >> 63) != 0) {
+    window->stats.lost++; // fell out of the history unrecovered
+  }
+  window->missing_bitmap <<= 1;
+  if (have) {
+    const log_record_t* record =
+      &window->slots[window->next_record_id % MESH_REORDER_SLOTS];
+    window->stats.delivered++;
+    window->stats.reordered++;
+    if (emit_cb != NULL) {
+      emit_cb(record, context);
+    }
+  } else if (mark_missing) {
+    window->missing_bitmap |= 1u;
+    window->stats.gaps_skipped++;
+  } else {
+    window->stats.lost++;
+  }
+  window->ahead_bitmap >>= 1;
+  window->next_record_id++;
+}
+
+static void
+DrainContiguous(mesh_reorder_window_t* window,
+                mesh_reorder_emit_cb_t emit_cb,
+                void* context)
+{
+  while ((window->ahead_bitmap & 1u) != 0) {
+    AdvanceOne(window, true, emit_cb, context);
+  }
+}
+
+// Advances next_record_id to target (> next_record_id).
+static void
+AdvanceTo(mesh_reorder_window_t* window,
+          uint64_t target,
+          bool mark_missing,
+          mesh_reorder_emit_cb_t emit_cb,
+          void* context)
+{
+  uint64_t steps = 0;
+  while (window->next_record_id < target &&
+         (window->ahead_bitmap != 0 || steps < kMaxSteppedAdvance)) {
+    AdvanceOne(window, mark_missing, emit_cb, context);
+    steps++;
+  }
+  if (window->next_record_id >= target) {
+    return;
+  }
+
+  // Nothing buffered and still far away: account in bulk.
+  const uint64_t remaining = target - window->next_record_id;
+  window->stats.lost += PopCount64(window->missing_bitmap);
+  if (mark_missing) {
+    window->stats.gaps_skipped += (uint32_t)remaining;
+    window->stats.lost += remaining - 64u;
+    window->missing_bitmap = ~(uint64_t)0;
+  } else {
+    window->stats.lost += remaining;
+    window->missing_bitmap = 0;
+  }
+  window->next_record_id = target;
+}
+
+static void
+UpdateWaitTimer(mesh_reorder_window_t* window, int64_t now_us)
+{
+  window->wait_started_us = (window->ahead_bitmap != 0) ? now_us : 0;
+}
+
+void
+MeshReorderInit(mesh_reorder_window_t* window)
+{
+  if (window != NULL) {
+    memset(window, 0, sizeof(*window));
+  }
+}
+
+void
+MeshReorderPush(mesh_reorder_window_t* window,
+                const log_record_t* record,
+                int64_t now_us,
+                mesh_reorder_emit_cb_t emit_cb,
+                void* context)
+{
+  if (window == NULL || record == NULL) {
+    return;
+  }
+  const uint64_t record_id = record->record_id;
+
+  if (!window->initialized) {
+    window->initialized = true;
+    window->next_record_id = record_id;
+  } else if (record_id + kResyncRecords < window->next_record_id) {
+    AdvanceTo(window,
+              window->next_record_id + MESH_REORDER_SLOTS,
+              false,
+              emit_cb,
+              context);
+    window->next_record_id = record_id;
+    window->ahead_bitmap = 0;
+    window->missing_bitmap = 0;
+  }
+
+  if (record_id < window->next_record_id) {
+    const uint64_t back = window->next_record_id - 1u - record_id;
+    if (back < 64u && ((window->missing_bitmap >> back) & 1u) != 0) {
+      window->missing_bitmap &= ~((uint64_t)1u << back);
+      window->stats.late_recovered++;
+      window->stats.delivered++;
+      if (emit_cb != NULL) {
+        emit_cb(record, context);
+      }
+      return;
+    }
+    window->stats.duplicates++;
+    return;
+  }
+
+  uint64_t offset = record_id - window->next_record_id;
+  if (offset >= MESH_REORDER_SLOTS) {
+    // Window overflow: give up on the oldest holes to make room.
+    AdvanceTo(window,
+              record_id - (MESH_REORDER_SLOTS - 1u),
+              true,
+              emit_cb,
+              context);
+    offset = record_id - window->next_record_id;
+  }
+
+  if (((window->ahead_bitmap >> offset) & 1u) != 0) {
+    window->stats.duplicates++;
+    return;
+  }
+
+  if (offset == 0) {
+    window->stats.delivered++;
+    if (emit_cb != NULL) {
+      emit_cb(record, context);
+    }
+    if ((window->missing_bitmap >> 63) != 0) {
+      window->stats.lost++;
+    }
+    window->missing_bitmap <<= 1;
+    window->ahead_bitmap >>= 1;
+    window->next_record_id++;
+    DrainContiguous(window, emit_cb, context);
+    UpdateWaitTimer(window, now_us);
+    return;
+  }
+
+  window->slots[record_id % MESH_REORDER_SLOTS] = *record;
+  const bool was_waiting = (window->ahead_bitmap != 0);
+  window->ahead_bitmap |= (uint64_t)1u << offset;
+  if (!was_waiting) {
+    window->wait_started_us = now_us;
+  }
+}
+
+void
+MeshReorderTick(mesh_reorder_window_t* window,
+                int64_t now_us,
+                int64_t max_delay_us,
+                mesh_reorder_emit_cb_t emit_cb,
+                void* context)
+{
+  if (window == NULL || !window->initialized || window->ahead_bitmap == 0) {
+    return;
+  }
+  if (now_us - window->wait_started_us < max_delay_us) {
+    return;
+  }
+  while ((window->ahead_bitmap & 1u) == 0) {
+    AdvanceOne(window, true, emit_cb, context);
+  }
+  DrainContiguous(window, emit_cb, context);
+  UpdateWaitTimer(window, now_us);
+}
+
+void
+MeshReorderSkipTo(mesh_reorder_window_t* window,
+                  uint64_t first_available,
+                  mesh_reorder_emit_cb_t emit_cb,
+                  void* context)
+{
+  if (window == NULL || first_available == 0) {
+    return;
+  }
+  if (!window->initialized) {
+    window->initialized = true;
+    window->next_record_id = first_available;
+    return;
+  }
+
+  if (first_available >= window->next_record_id) {
+    // Every remembered hole is below first_available: give them up.
+    window->stats.lost += PopCount64(window->missing_bitmap);
+    window->missing_bitmap = 0;
+    if (first_available > window->next_record_id) {
+      AdvanceTo(window, first_available, false, emit_cb, context);
+    }
+    DrainContiguous(window, emit_cb, context);
+    return;
+  }
+
+  // History bit i covers id next - 1 - i; ids below first_available are
+  // those with i >= next - first_available.
+  const uint64_t keep_bits = window->next_record_id - first_available;
+  if (keep_bits < 64u) {
+    const uint64_t keep_mask = ((uint64_t)1u << keep_bits) - 1u;
+    window->stats.lost += PopCount64(window->missing_bitmap & ~keep_mask);
+    window->missing_bitmap &= keep_mask;
+  }
+}
+
+void
+MeshReorderRefuse(mesh_reorder_window_t* window, uint64_t record_id)
+{
+  if (window == NULL || !window->initialized ||
+      record_id >= window->next_record_id) {
+    return;
+  }
+  window->stats.delivered--;
+  window->stats.refused++;
+  const uint64_t back = window->next_record_id - 1u - record_id;
+  if (back == 0) {
+    // Buffered records keep their slots; one that would fall off the end
+    // of the buffer is dropped and comes back with the replay.
+    window->next_record_id--;
+    window->missing_bitmap >>= 1;
+    window->ahead_bitmap <<= 1;
+#if MESH_REORDER_SLOTS < 64
+    window->ahead_bitmap &= ((uint64_t)1u << MESH_REORDER_SLOTS) - 1u;
+#endif
+    if (window->ahead_bitmap == 0) {
+      window->wait_started_us = 0;
+    }
+  } else if (back < 64u) {
+    window->missing_bitmap |= (uint64_t)1u << back;
+  } else {
+    window->stats.lost++;
+  }
+}
+
+uint64_t
+MeshReorderAckRecordId(const mesh_reorder_window_t* window)
+{
+  if (window == NULL || !window->initialized ||
+      window->next_record_id == 0) {
+    return 0;
+  }
+  if (window->missing_bitmap == 0) {
+    return window->next_record_id - 1u;
+  }
+  const uint32_t oldest_bit = 63u - (uint32_t)__builtin_clzll(
+                                      window->missing_bitmap);
+  const uint64_t oldest_missing = window->next_record_id - 1u - oldest_bit;
+  return oldest_missing - 1u;
+}
+
+uint32_t
+MeshReorderBufferedCount(const mesh_reorder_window_t* window)
+{
+  return (window == NULL) ? 0 : PopCount64(window->ahead_bitmap);
+}
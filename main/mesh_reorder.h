@@ -0,0 +1,99 @@
+#ifndef PT100_LOGGER_MESH_REORDER_H_
+#define PT100_LOGGER_MESH_REORDER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "log_record.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Per-node reorder/dedup window keyed by record_id. Records are emitted in
+// record_id order; a record that arrives ahead of a hole waits in a small
+// reorder buffer until the hole fills or MeshReorderTick() gives up on it.
+// Skipped ids stay in a 64-entry history so a late arrival is still
+// delivered once (out of order) instead of being mistaken for a duplicate.
+#ifdef CONFIG_APP_MESH_REORDER_SLOTS
+#define MESH_REORDER_SLOTS CONFIG_APP_MESH_REORDER_SLOTS
+#else
+#define MESH_REORDER_SLOTS 16
+#endif
+
+#if MESH_REORDER_SLOTS < 1 || MESH_REORDER_SLOTS > 64
+#error "MESH_REORDER_SLOTS must be in 1..64 (bitmap width)"
+#endif
+
+  typedef struct
+  {
+    uint64_t delivered;
+    uint32_t duplicates;
+    uint32_t reordered;      // delivered after waiting in the buffer
+    uint32_t gaps_skipped;   // ids passed over by timeout/window overflow
+    uint32_t late_recovered; // skipped ids that arrived afterwards
+    uint64_t lost;           // skipped and never recovered / reported lost
+    uint32_t refused;        // emitted, refused by the consumer, re-requested
+  } mesh_reorder_stats_t;
+
+  typedef struct
+  {
+    bool initialized;
+    uint64_t next_record_id; // lowest id not yet emitted or skipped
+    uint64_t ahead_bitmap;   // bit i: next_record_id + i is buffered
+    uint64_t missing_bitmap; // bit i: next_record_id - 1 - i was skipped
+    int64_t wait_started_us; // head-of-line wait start, 0 when idle
+    log_record_t slots[MESH_REORDER_SLOTS];
+    mesh_reorder_stats_t stats;
+  } mesh_reorder_window_t;
+
+  typedef void (*mesh_reorder_emit_cb_t)(const log_record_t* record,
+                                         void* context);
+
+  void MeshReorderInit(mesh_reorder_window_t* window);
+
+  // Accepts one received record. Emits zero or more records (in order) via
+  // emit_cb. O(1) amortized; a push far beyond the window advances it in at
+  // most MESH_REORDER_SLOTS + 64 steps before jumping.
+  void MeshReorderPush(mesh_reorder_window_t* window,
+                       const log_record_t* record,
+                       int64_t now_us,
+                       mesh_reorder_emit_cb_t emit_cb,
+                       void* context);
+
+  // Skips the head-of-line hole once it has blocked buffered records for
+  // max_delay_us, emitting what becomes contiguous.
+  void MeshReorderTick(mesh_reorder_window_t* window,
+                       int64_t now_us,
+                       int64_t max_delay_us,
+                       mesh_reorder_emit_cb_t emit_cb,
+                       void* context);
+
+  // The sender reports ids below first_available can never be resent.
+  void MeshReorderSkipTo(mesh_reorder_window_t* window,
+                         uint64_t first_available,
+                         mesh_reorder_emit_cb_t emit_cb,
+                         void* context);
+
+  // The consumer could not take an emitted record: it counts as not
+  // delivered and holds the ACK back so the sender replays it. Call for each
+  // refused record, latest first. The newest emitted one steps the window
+  // back; an older one goes back into the skipped history (lost once that
+  // has moved 64 ids past it).
+  void MeshReorderRefuse(mesh_reorder_window_t* window, uint64_t record_id);
+
+  // Highest record_id such that every id at or below it has been delivered
+  // or given up on by the sender. Skipped-but-recoverable ids hold it back
+  // so the sender replays them. 0 before the first record.
+  uint64_t MeshReorderAckRecordId(const mesh_reorder_window_t* window);
+
+  // Number of records currently held in the reorder buffer.
+  uint32_t MeshReorderBufferedCount(const mesh_reorder_window_t* window);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_MESH_REORDER_H_
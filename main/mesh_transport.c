@@ -1,23 +1,33 @@
 #include "mesh_transport.h"
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_mesh_lite.h"
 #include "esp_mesh_lite_core.h"
 #include "esp_mesh_lite_port.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "wifi_service.h"
 
 static const char* kTag = "mesh";
 static const char* kMeshSoftApSsid = "PT100_MESH";
 
-static mesh_transport_t* g_mesh = NULL;
+// The host simulator (host_tools/mesh_sim) runs one transport per thread in
+// a single process and defines this as _Thread_local.
+#ifndef MESH_TRANSPORT_INSTANCE_STORAGE
+#define MESH_TRANSPORT_INSTANCE_STORAGE
+#endif
+
+static MESH_TRANSPORT_INSTANCE_STORAGE mesh_transport_t* g_mesh = NULL;
 
 #ifndef ESP_MESH_LITE_RAW_MSG_ACTION_END
 #define ESP_MESH_LITE_RAW_MSG_ACTION_END { 0, 0, NULL }
@@ -28,9 +38,37 @@ typedef enum
   MESH_MESSAGE_RECORD = 1,
   MESH_MESSAGE_TIME_REQUEST = 2,
   MESH_MESSAGE_TIME_SYNC = 3,
+  // Several records packed into one frame (see mesh_codec.h). Shares the
+  // record raw message id so OnRawRecord handles both layouts.
+  MESH_MESSAGE_RECORD_BATCH = 4,
+  // Leaf -> root: records below the given id cannot be replayed.
+  MESH_MESSAGE_RECORD_GAP = 5,
+  // Root -> leaves: highest contiguous record_id held per node.
+  MESH_MESSAGE_ACK = 6,
+  // Two-way time sync: leaf probe (t1) and root reply (t1, t2, t3).
+  MESH_MESSAGE_TIME_PROBE = 7,
+  MESH_MESSAGE_TIME_REPLY = 8,
+  // Relay -> parent: batches of several nodes, see mesh_relay_section_t.
+  MESH_MESSAGE_RELAY_BATCH = 9,
+  // Leaf -> root: one alarm_event_t, sent on its own raw message id.
+  MESH_MESSAGE_ALARM = 10,
+  // Root -> leaves: start a burst capture; payload is the target MAC, all
+  // zeros for every node.
+  MESH_MESSAGE_BURST_TRIGGER = 11,
 } mesh_message_type_t;
 
 #pragma pack(push, 1)
+// MESH_MESSAGE_TIME_REPLY payload: int64_t t3_us, uint8_t entry count, then
+// entries. Probes that arrive close together share one broadcast (there is
+// no root -> node unicast) and one t3; leaves pick their entry by MAC and
+// echoed t1. Holding a probe only grows t3 - t2, which the leaf subtracts.
+typedef struct
+{
+  uint8_t mac[6];
+  int64_t t1_us;
+  int64_t t2_us;
+} mesh_time_reply_entry_t;
+
 typedef struct
 {
   uint8_t type;
@@ -39,16 +77,61 @@ typedef struct
   {
     log_record_t record;
     int64_t epoch_seconds;
+    uint64_t first_available_record_id;
+    int64_t probe_t1_us;
+    alarm_event_t alarm;
+    uint8_t target_mac[6];
   } payload;
 } mesh_message_t;
+
+// MESH_MESSAGE_RELAY_BATCH payload: uint8_t section count, then per section
+// this header and length bytes of batch payload (mesh_codec.h) exactly as
+// the origin node encoded it. Relays copy sections, they never re-encode.
+typedef struct
+{
+  uint8_t mac[6]; // origin node
+  uint16_t length;
+} mesh_relay_section_t;
+
+// MESH_MESSAGE_ACK payload: uint8_t entry count followed by entries, then
+// one uint16_t credit grant (records per minute, kAckCreditUnlimited for no
+// limit) per entry in the same order. Leaves that predate credits stop
+// reading after the entries.
+typedef struct
+{
+  uint8_t mac[6];
+  uint64_t record_id;
+} mesh_ack_wire_entry_t;
 #pragma pack(pop)
 
 static const uint32_t kRawMsgIdRecord = 0x00000001u;
 static const uint32_t kRawMsgIdTimeRequest = 0x00000002u;
 static const uint32_t kRawMsgIdTimeSync = 0x00000003u;
+static const uint32_t kRawMsgIdAck = 0x00000004u;
+static const uint32_t kRawMsgIdTimeProbe = 0x00000005u;
+static const uint32_t kRawMsgIdTimeReply = 0x00000006u;
+static const uint32_t kRawMsgIdAlarm = 0x00000007u;
+static const uint32_t kRawMsgIdBurstTrigger = 0x00000008u;
+
+// Leaves ignore TIME_SYNC broadcasts that agree with their clock this well.
+static const int64_t kTimeSyncCoarseStepS = 2;
+
+// A relay frame with less room than this left is sent right away; no
+// useful section fits any more.
+static const size_t kRelayFullMarginBytes = 64u;
+
+static const uint16_t kAckCreditUnlimited = 0xFFFFu;
+static const int64_t kCreditBurstUs =
+  (int64_t)MESH_TRANSPORT_CREDIT_BURST_MS * 1000;
 
 static const uint32_t kRawMsgMaxRetry = 3u;
 static const uint16_t kRawMsgRetryIntervalMs = 300u;
+// Alarms retry sooner and longer: same worst case, faster typical recovery.
+static const uint32_t kAlarmMaxRetry = 9u;
+static const uint16_t kAlarmRetryIntervalMs = 100u;
+// Root RX: longest wait for the reorder windows before a record is delivered
+// untracked (or a gap notice dropped; the window times the gap out instead).
+static const uint32_t kRxLockTimeoutMs = 100u;
 
 static size_t
 MeshMessageHeaderSize(void)
@@ -73,17 +156,20 @@ PopulateMeshMessageSrc(mesh_message_t* msg)
 }
 
 static esp_err_t
-SendRawMessage(uint32_t msg_id,
-               const uint8_t* data,
-               size_t size,
-               esp_err_t (*raw_resend)(const uint8_t* data, size_t size))
+SendRawMessageWithRetry(uint32_t msg_id,
+                        const uint8_t* data,
+                        size_t size,
+                        esp_err_t (*raw_resend)(const uint8_t* data,
+                                                size_t size),
+                        uint32_t max_retry,
+                        uint16_t retry_interval_ms)
 {
   esp_mesh_lite_msg_config_t config = {
     .raw_msg = {
       .msg_id = msg_id,
       .expect_resp_msg_id = 0,
-      .max_retry = kRawMsgMaxRetry,
-      .retry_interval = kRawMsgRetryIntervalMs,
+      .max_retry = max_retry,
+      .retry_interval = retry_interval_ms,
       .data = data,
       .size = size,
       .raw_resend = raw_resend,
@@ -93,6 +179,54 @@ SendRawMessage(uint32_t msg_id,
   return esp_mesh_lite_send_msg(ESP_MESH_LITE_RAW_MSG, &config);
 }
 
+static esp_err_t
+SendRawMessage(uint32_t msg_id,
+               const uint8_t* data,
+               size_t size,
+               esp_err_t (*raw_resend)(const uint8_t* data, size_t size))
+{
+  return SendRawMessageWithRetry(
+    msg_id, data, size, raw_resend, kRawMsgMaxRetry, kRawMsgRetryIntervalMs);
+}
+
+// A record frame made it out: closes a pending link loss measurement.
+static void
+NoteUpstreamSent(mesh_transport_t* mesh)
+{
+  portENTER_CRITICAL(&mesh->ack_lock);
+  const int64_t down_us = mesh->link_down_us;
+  mesh->link_down_us = 0;
+  portEXIT_CRITICAL(&mesh->ack_lock);
+  if (down_us == 0) {
+    return;
+  }
+  const int64_t elapsed_ms = (esp_timer_get_time() - down_us) / 1000;
+  const uint32_t ms =
+    (elapsed_ms > (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed_ms;
+  mesh->stats.rejoins++;
+  mesh->stats.rejoin_last_ms = ms;
+  if (ms > mesh->stats.rejoin_max_ms) {
+    mesh->stats.rejoin_max_ms = ms;
+  }
+  ESP_LOGI(kTag,
+           "upstream restored: first record %u ms after link loss",
+           (unsigned)ms);
+}
+
+// Record batches go to the parent when relays aggregate, so every relay on
+// the path sees (and re-packs) them; otherwise straight to the root.
+static esp_err_t
+SendRecordFrame(const uint8_t* data, size_t size)
+{
+#if MESH_TRANSPORT_RELAY_AGGREGATION
+  return SendRawMessage(
+    kRawMsgIdRecord, data, size, esp_mesh_lite_send_raw_msg_to_parent);
+#else
+  return SendRawMessage(
+    kRawMsgIdRecord, data, size, esp_mesh_lite_send_raw_msg_to_root);
+#endif
+}
+
 static void
 ResetRawMessageOutput(uint8_t** out_data, uint32_t* out_len)
 {
@@ -104,6 +238,380 @@ ResetRawMessageOutput(uint8_t** out_data, uint32_t* out_len)
   }
 }
 
+// Caller holds mesh->node_lock. NULL when the node is not tracked.
+static mesh_node_state_t*
+FindNode(mesh_transport_t* mesh, const pt100_mesh_addr_t* node)
+{
+  for (uint32_t index = 0; index < mesh->node_count; ++index) {
+    if (memcmp(&mesh->nodes[index].node, node, sizeof(*node)) == 0) {
+      return &mesh->nodes[index];
+    }
+  }
+  return NULL;
+}
+
+// Caller holds mesh->node_lock. Returns NULL when the table is full.
+static mesh_node_state_t*
+FindOrAddNode(mesh_transport_t* mesh, const pt100_mesh_addr_t* node)
+{
+  mesh_node_state_t* found = FindNode(mesh, node);
+  if (found != NULL) {
+    return found;
+  }
+  if (mesh->node_count >= MESH_TRANSPORT_MAX_NODES) {
+    return NULL;
+  }
+  mesh_node_state_t* entry = &mesh->nodes[mesh->node_count++];
+  entry->node = *node;
+  MeshReorderInit(&entry->window);
+  return entry;
+}
+
+// Reorder callback: copies each released record into the mesh_emit_batch_t
+// passed as context, for delivery once node_lock is dropped.
+static void
+CollectOrderedRecord(const log_record_t* record, void* context)
+{
+  mesh_emit_batch_t* batch = (mesh_emit_batch_t*)context;
+  if (batch->count < MESH_EMIT_BATCH_RECORDS) {
+    batch->records[batch->count++] = *record;
+  }
+}
+
+// false when the consumer refused the record.
+static bool
+DeliverRecord(mesh_transport_t* mesh,
+              const pt100_mesh_addr_t* from,
+              const log_record_t* record)
+{
+  if (mesh->record_rx_callback == NULL) {
+    return true;
+  }
+  return mesh->record_rx_callback(from, record, mesh->record_rx_context);
+}
+
+// Takes emit_lock, then node_lock, and empties the emit batch. emit_lock
+// keeps records from two windows' releases in order; node_lock is held only
+// while the windows are touched. false when either is busy past timeout.
+static bool
+LockWindows(mesh_transport_t* mesh, TickType_t timeout)
+{
+  if (xSemaphoreTake(mesh->emit_lock, timeout) != pdTRUE) {
+    return false;
+  }
+  if (xSemaphoreTake(mesh->node_lock, timeout) != pdTRUE) {
+    xSemaphoreGive(mesh->emit_lock);
+    return false;
+  }
+  mesh->emit_batch->count = 0;
+  return true;
+}
+
+// Drops node_lock, then hands the collected records to record_rx_callback
+// and drops emit_lock. from must not point into the node table. Once the
+// consumer refuses a record, it and the rest of the batch go back to the
+// node's window, so the ACK stops short of them and the node replays them.
+static void
+UnlockWindowsAndDeliver(mesh_transport_t* mesh, const pt100_mesh_addr_t* from)
+{
+  xSemaphoreGive(mesh->node_lock);
+  const mesh_emit_batch_t* batch = mesh->emit_batch;
+  uint32_t delivered = 0;
+  while (delivered < batch->count &&
+         DeliverRecord(mesh, from, &batch->records[delivered])) {
+    delivered++;
+  }
+  if (delivered < batch->count) {
+    xSemaphoreTake(mesh->node_lock, portMAX_DELAY);
+    mesh_node_state_t* entry = FindNode(mesh, from);
+    for (uint32_t index = batch->count; entry != NULL && index > delivered;
+         --index) {
+      const log_record_t* refused = &batch->records[index - 1u];
+      MeshReorderRefuse(&entry->window, refused->record_id);
+    }
+    xSemaphoreGive(mesh->node_lock);
+    mesh->stats.records_refused += batch->count - delivered;
+  }
+  xSemaphoreGive(mesh->emit_lock);
+}
+
+static void
+OnBatchRecordDecoded(const log_record_t* record, void* context)
+{
+  const pt100_mesh_addr_t* from = (const pt100_mesh_addr_t*)context;
+  if (g_mesh == NULL) {
+    return;
+  }
+  if (g_mesh->nodes == NULL || g_mesh->node_lock == NULL) {
+    DeliverRecord(g_mesh, from, record);
+    return;
+  }
+
+  if (!LockWindows(g_mesh, pdMS_TO_TICKS(kRxLockTimeoutMs))) {
+    // Don't stall the RX path: deliver untracked rather than wait.
+    g_mesh->stats.rx_lock_timeouts++;
+    g_mesh->stats.records_untracked++;
+    DeliverRecord(g_mesh, from, record);
+    return;
+  }
+  mesh_node_state_t* entry = FindOrAddNode(g_mesh, from);
+  if (entry != NULL) {
+    MeshReorderPush(&entry->window,
+                    record,
+                    esp_timer_get_time(),
+                    CollectOrderedRecord,
+                    g_mesh->emit_batch);
+  } else {
+    // Table full: deliver untracked rather than lose data.
+    g_mesh->stats.records_untracked++;
+    CollectOrderedRecord(record, g_mesh->emit_batch);
+  }
+  UnlockWindowsAndDeliver(g_mesh, from);
+}
+
+static esp_err_t
+HandleRecordGap(const pt100_mesh_addr_t* from, uint64_t first_available)
+{
+  if (first_available == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (g_mesh->nodes == NULL || g_mesh->node_lock == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!LockWindows(g_mesh, pdMS_TO_TICKS(kRxLockTimeoutMs))) {
+    g_mesh->stats.rx_lock_timeouts++;
+    return ESP_ERR_TIMEOUT;
+  }
+  mesh_node_state_t* entry = FindOrAddNode(g_mesh, from);
+  if (entry != NULL) {
+    MeshReorderSkipTo(&entry->window,
+                      first_available,
+                      CollectOrderedRecord,
+                      g_mesh->emit_batch);
+  }
+  UnlockWindowsAndDeliver(g_mesh, from);
+  return ESP_OK;
+}
+
+// Walks the sections of a MESH_MESSAGE_RELAY_BATCH payload. *offset starts
+// at 1 (after the count byte). ESP_ERR_INVALID_SIZE on truncation.
+static esp_err_t
+NextRelaySection(const uint8_t* payload,
+                 size_t len,
+                 size_t* offset,
+                 mesh_relay_section_t* section_out,
+                 const uint8_t** section_payload_out)
+{
+  if (len < *offset || len - *offset < sizeof(*section_out)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memcpy(section_out, payload + *offset, sizeof(*section_out));
+  *offset += sizeof(*section_out);
+  if (len - *offset < section_out->length) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  *section_payload_out = payload + *offset;
+  *offset += section_out->length;
+  return ESP_OK;
+}
+
+// Root: every section goes through its origin node's reorder window, as if
+// that node had sent it directly. A bad section does not stop the others.
+static esp_err_t
+DecodeRelayBatch(const uint8_t* payload, size_t len, uint32_t* decoded_out)
+{
+  *decoded_out = 0;
+  if (len < 1u) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  esp_err_t result = ESP_OK;
+  size_t offset = 1u;
+  for (uint8_t index = 0; index < payload[0]; ++index) {
+    mesh_relay_section_t section;
+    const uint8_t* section_payload = NULL;
+    esp_err_t next_result =
+      NextRelaySection(payload, len, &offset, &section, &section_payload);
+    if (next_result != ESP_OK) {
+      return next_result;
+    }
+    const pt100_mesh_addr_t from = Pt100MeshAddrFromMac(section.mac);
+    uint32_t decoded = 0;
+    esp_err_t decode_result = MeshBatchDecode(section_payload,
+                                              section.length,
+                                              OnBatchRecordDecoded,
+                                              (void*)&from,
+                                              &decoded);
+    *decoded_out += decoded;
+    if (decode_result != ESP_OK && result == ESP_OK) {
+      result = decode_result;
+    }
+  }
+  return result;
+}
+
+// Caller holds relay_lock.
+static void
+RelayReset(mesh_relay_t* relay)
+{
+  relay->used = MeshMessageHeaderSize() + 1u;
+  relay->section_count = 0;
+  relay->record_count = 0;
+}
+
+// Caller holds relay_lock.
+static esp_err_t
+RelaySendLocked(mesh_transport_t* mesh)
+{
+  mesh_relay_t* relay = mesh->relay;
+  if (relay->section_count == 0) {
+    return ESP_OK;
+  }
+  esp_err_t result = ESP_ERR_INVALID_STATE;
+  if (mesh->mesh_lite_started && mesh->is_connected) {
+    mesh_message_t header = {
+      .type = MESH_MESSAGE_RELAY_BATCH,
+    };
+    result = PopulateMeshMessageSrc(&header);
+    if (result == ESP_OK) {
+      const size_t header_size = MeshMessageHeaderSize();
+      memcpy(relay->frame, &header, header_size);
+      relay->frame[header_size] = relay->section_count;
+      result = SendRecordFrame(relay->frame, relay->used);
+    }
+  }
+  if (result == ESP_OK) {
+    NoteUpstreamSent(mesh);
+    mesh->stats.relay_frames_sent++;
+    mesh->stats.relay_sections_sent += relay->section_count;
+    mesh->stats.relay_records_sent += relay->record_count;
+  } else {
+    mesh->stats.send_failures++;
+    mesh->stats.records_dropped += relay->record_count;
+  }
+  RelayReset(relay);
+  return result;
+}
+
+// Caller holds relay_lock. Adds one node's batch payload as a section,
+// sending the pending frame first when it would not fit. Returns
+// ESP_ERR_INVALID_SIZE for a batch that cannot fit even an empty frame.
+static esp_err_t
+RelayAppendLocked(mesh_transport_t* mesh,
+                  const uint8_t mac[6],
+                  const uint8_t* payload,
+                  size_t length)
+{
+  mesh_relay_t* relay = mesh->relay;
+  const size_t needed = sizeof(mesh_relay_section_t) + length;
+  const size_t empty_room =
+    sizeof(relay->frame) - MeshMessageHeaderSize() - 1u;
+  if (length < sizeof(mesh_batch_header_t) || needed > empty_room) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  if (needed > sizeof(relay->frame) - relay->used ||
+      relay->section_count == UINT8_MAX) {
+    (void)RelaySendLocked(mesh);
+  }
+  if (relay->section_count == 0) {
+    relay->opened_us = esp_timer_get_time();
+  }
+
+  mesh_relay_section_t section;
+  memcpy(section.mac, mac, sizeof(section.mac));
+  section.length = (uint16_t)length;
+  memcpy(relay->frame + relay->used, &section, sizeof(section));
+  memcpy(relay->frame + relay->used + sizeof(section), payload, length);
+  relay->used += needed;
+  relay->section_count++;
+  mesh_batch_header_t batch;
+  memcpy(&batch, payload, sizeof(batch));
+  relay->record_count += batch.record_count;
+
+  if (sizeof(relay->frame) - relay->used < kRelayFullMarginBytes) {
+    (void)RelaySendLocked(mesh);
+  }
+  return ESP_OK;
+}
+
+// Caller holds relay_lock. Queues a whole MESH_MESSAGE_RECORD_BATCH message
+// (own or a child's). A batch too large to re-pack is sent on unchanged,
+// after the pending relay frame so each node's records stay in order.
+static esp_err_t
+RelayQueueBatchLocked(mesh_transport_t* mesh,
+                      const uint8_t* message,
+                      size_t len)
+{
+  const size_t header_size = MeshMessageHeaderSize();
+  if (len < header_size + sizeof(mesh_batch_header_t)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  const uint8_t* mac = message + offsetof(mesh_message_t, src_mac);
+  esp_err_t result =
+    RelayAppendLocked(mesh, mac, message + header_size, len - header_size);
+  if (result != ESP_ERR_INVALID_SIZE) {
+    return result;
+  }
+  (void)RelaySendLocked(mesh);
+  mesh->stats.relay_passthrough++;
+  return SendRecordFrame(message, len);
+}
+
+// Relay: terminate a child's RECORD_BATCH or RELAY_BATCH frame. Sections of
+// a sub-relay are copied one by one, so the root sees a flat list.
+static esp_err_t
+RelayChildFrame(mesh_transport_t* mesh, const uint8_t* data, uint32_t len)
+{
+  const size_t header_size = MeshMessageHeaderSize();
+  esp_err_t result = ESP_OK;
+  xSemaphoreTake(mesh->relay_lock, portMAX_DELAY);
+  mesh->stats.relay_frames_in++;
+  if (data[0] == MESH_MESSAGE_RECORD_BATCH) {
+    result = RelayQueueBatchLocked(mesh, data, len);
+  } else if (len > header_size) {
+    const uint8_t* payload = data + header_size;
+    const size_t payload_len = len - header_size;
+    size_t offset = 1u;
+    for (uint8_t index = 0; index < payload[0] && result == ESP_OK; ++index) {
+      mesh_relay_section_t section;
+      const uint8_t* section_payload = NULL;
+      result = NextRelaySection(
+        payload, payload_len, &offset, &section, &section_payload);
+      if (result == ESP_OK) {
+        result = RelayAppendLocked(
+          mesh, section.mac, section_payload, section.length);
+      }
+    }
+  } else {
+    result = ESP_ERR_INVALID_SIZE;
+  }
+  xSemaphoreGive(mesh->relay_lock);
+  if (result == ESP_ERR_INVALID_SIZE) {
+    mesh->stats.decode_errors++;
+  } else if (result != ESP_OK) {
+    mesh->stats.send_failures++;
+  }
+  return result;
+}
+
+// Sends a RECORD_GAP frame (own or a child's) on toward the root behind the
+// records this node still holds for the relay frame, so the gap arrives
+// after them.
+static esp_err_t
+RelayForwardGap(mesh_transport_t* mesh, const uint8_t* data, uint32_t len)
+{
+  if (mesh->relay == NULL) {
+    return SendRecordFrame(data, len);
+  }
+  xSemaphoreTake(mesh->relay_lock, portMAX_DELAY);
+  (void)RelaySendLocked(mesh);
+  esp_err_t result = SendRecordFrame(data, len);
+  xSemaphoreGive(mesh->relay_lock);
+  if (result != ESP_OK) {
+    mesh->stats.send_failures++;
+  }
+  return result;
+}
+
 static esp_err_t
 OnRawRecord(uint8_t* data,
             uint32_t len,
@@ -119,23 +627,80 @@ OnRawRecord(uint8_t* data,
   }
 
   const size_t header_size = MeshMessageHeaderSize();
-  if (len < header_size + sizeof(log_record_t)) {
+  if (len < header_size) {
     return ESP_ERR_INVALID_SIZE;
   }
 
   mesh_message_t msg;
   memset(&msg, 0, sizeof(msg));
   memcpy(&msg, data, header_size);
-  memcpy(&msg.payload.record, data + header_size, sizeof(log_record_t));
+  const pt100_mesh_addr_t from = Pt100MeshAddrFromMac(msg.src_mac);
+
+  if (g_mesh->relay != NULL && (msg.type == MESH_MESSAGE_RECORD_BATCH ||
+                                msg.type == MESH_MESSAGE_RELAY_BATCH)) {
+    return RelayChildFrame(g_mesh, data, len);
+  }
+
+  if (msg.type == MESH_MESSAGE_RELAY_BATCH) {
+    uint32_t decoded = 0;
+    esp_err_t decode_result =
+      DecodeRelayBatch(data + header_size, len - header_size, &decoded);
+    g_mesh->stats.frames_received++;
+    g_mesh->stats.records_received += decoded;
+    if (decode_result != ESP_OK) {
+      g_mesh->stats.decode_errors++;
+      ESP_LOGW(kTag,
+               "relay batch decode failed after %u records: %s",
+               (unsigned)decoded,
+               esp_err_to_name(decode_result));
+    }
+    return decode_result;
+  }
+
+  if (msg.type == MESH_MESSAGE_RECORD_BATCH) {
+    uint32_t decoded = 0;
+    esp_err_t decode_result = MeshBatchDecode(data + header_size,
+                                              len - header_size,
+                                              OnBatchRecordDecoded,
+                                              (void*)&from,
+                                              &decoded);
+    g_mesh->stats.frames_received++;
+    g_mesh->stats.records_received += decoded;
+    if (decode_result != ESP_OK) {
+      g_mesh->stats.decode_errors++;
+      ESP_LOGW(kTag,
+               "batch decode failed after %u records: %s",
+               (unsigned)decoded,
+               esp_err_to_name(decode_result));
+    }
+    return decode_result;
+  }
+
+  if (msg.type == MESH_MESSAGE_RECORD_GAP) {
+    if (len < header_size + sizeof(msg.payload.first_available_record_id)) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+    if (!g_mesh->is_root) {
+      return RelayForwardGap(g_mesh, data, len);
+    }
+    memcpy(&msg.payload.first_available_record_id,
+           data + header_size,
+           sizeof(msg.payload.first_available_record_id));
+    return HandleRecordGap(&from, msg.payload.first_available_record_id);
+  }
+
   if (msg.type != MESH_MESSAGE_RECORD) {
     return ESP_ERR_INVALID_RESPONSE;
   }
-
-  if (g_mesh->record_rx_callback != NULL) {
-    pt100_mesh_addr_t from = Pt100MeshAddrFromMac(msg.src_mac);
-    g_mesh->record_rx_callback(
-      &from, &msg.payload.record, g_mesh->record_rx_context);
+  if (len < header_size + sizeof(log_record_t)) {
+    return ESP_ERR_INVALID_SIZE;
   }
+  memcpy(&msg.payload.record, data + header_size, sizeof(log_record_t));
+
+  g_mesh->stats.frames_received++;
+  g_mesh->stats.records_received++;
+  // One record per frame (older leaves): same reorder window and ACK.
+  OnBatchRecordDecoded(&msg.payload.record, (void*)&from);
   return ESP_OK;
 }
 
@@ -165,20 +730,18 @@ OnRawTimeRequest(uint8_t* data,
     return ESP_ERR_INVALID_RESPONSE;
   }
 
-  if (g_mesh->is_root && TimeSyncIsSystemTimeValid()) {
-    const int64_t now_seconds = (int64_t)time(NULL);
-    mesh_message_t response = {
-      .type = MESH_MESSAGE_TIME_SYNC,
-      .payload.epoch_seconds = now_seconds,
-    };
-    if (PopulateMeshMessageSrc(&response) == ESP_OK) {
-      const size_t response_size =
-        MeshMessageHeaderSize() + sizeof(response.payload.epoch_seconds);
-      (void)SendRawMessage(kRawMsgIdTimeSync,
-                           (const uint8_t*)&response,
-                           response_size,
-                           esp_mesh_lite_send_broadcast_raw_msg_to_child);
+  // Answered by one coalesced broadcast from the root's time service (see
+  // MeshTransportTakeTimeRequests) instead of one broadcast per request.
+  if (g_mesh->is_root) {
+    portENTER_CRITICAL(&g_mesh->ack_lock);
+    if (!g_mesh->time_request_pending) {
+      g_mesh->time_request_pending = true;
+      g_mesh->time_request_first_us = esp_timer_get_time();
+    } else {
+      g_mesh->stats.time_requests_coalesced++;
     }
+    g_mesh->stats.time_requests_received++;
+    portEXIT_CRITICAL(&g_mesh->ack_lock);
   }
 
   return ESP_OK;
@@ -213,56 +776,320 @@ OnRawTimeSync(uint8_t* data,
     return ESP_ERR_INVALID_RESPONSE;
   }
 
+  // Whole-second broadcasts only bootstrap the clock. Once it is valid and
+  // close, two-way sync owns it and a step here would undo the slewing.
   if (!g_mesh->is_root && g_mesh->time_sync != NULL) {
-    (void)TimeSyncSetSystemEpoch(
-      msg.payload.epoch_seconds, true, g_mesh->time_sync);
+    const int64_t skew_s = msg.payload.epoch_seconds - (int64_t)time(NULL);
+    if (!TimeSyncIsSystemTimeValid() || skew_s > kTimeSyncCoarseStepS ||
+        skew_s < -kTimeSyncCoarseStepS) {
+      (void)TimeSyncSetSystemEpoch(
+        msg.payload.epoch_seconds, true, g_mesh->time_sync);
+    }
   }
 
   return ESP_OK;
 }
 
-static const esp_mesh_lite_raw_msg_action_t kMeshRawActions[] = {
-  { kRawMsgIdRecord, 0, OnRawRecord },
-  { kRawMsgIdTimeRequest, 0, OnRawTimeRequest },
-  { kRawMsgIdTimeSync, 0, OnRawTimeSync },
-  ESP_MESH_LITE_RAW_MSG_ACTION_END,
-};
-
-esp_err_t __attribute__((weak))
-esp_mesh_lite_stop(void)
+static esp_err_t
+OnRawAck(uint8_t* data,
+         uint32_t len,
+         uint8_t** out_data,
+         uint32_t* out_len,
+         uint32_t seq)
 {
-  return ESP_ERR_NOT_SUPPORTED;
-}
+  (void)seq;
+  ResetRawMessageOutput(out_data, out_len);
 
-esp_err_t __attribute__((weak))
-esp_mesh_lite_deinit(void)
-{
-  return ESP_ERR_NOT_SUPPORTED;
-}
+  if (g_mesh == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
 
-// Mesh-Lite component currently does not publish a public "stop" API surface
-// for all internal background work (reconnect scans, resend timers, etc.), but
-// the prebuilt library exports private helpers that are used by examples.
-//
-// We provide weak fallbacks so the app still builds if the symbol set changes.
-void __attribute__((weak))
-esp_mesh_lite_comm_stop_reconnect(void)
-{
-}
+  const size_t header_size = MeshMessageHeaderSize();
+  if (len < header_size + 1u) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  if (data[0] != MESH_MESSAGE_ACK) {
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+  if (g_mesh->is_root) {
+    return ESP_OK;
+  }
 
-void __attribute__((weak))
-esp_mesh_lite_stop_resend_raw_msg(void)
-{
-}
+  const uint8_t entry_count = data[header_size];
+  const size_t entries_size = entry_count * sizeof(mesh_ack_wire_entry_t);
+  if (len < header_size + 1u + entries_size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  const bool has_credits =
+    len >= header_size + 1u + entries_size + entry_count * sizeof(uint16_t);
 
-void __attribute__((weak))
-esp_mesh_lite_stop_resend_json_msg(void)
-{
-}
+  uint8_t local_mac[6] = { 0 };
+  if (esp_wifi_get_mac(WIFI_IF_STA, local_mac) != ESP_OK) {
+    return ESP_ERR_INVALID_STATE;
+  }
 
-void __attribute__((weak))
-esp_mesh_lite_clear_scan_status(void)
-{
+  const uint8_t* cursor = data + header_size + 1u;
+  for (uint8_t index = 0; index < entry_count; ++index) {
+    mesh_ack_wire_entry_t entry;
+    memcpy(&entry, cursor, sizeof(entry));
+    cursor += sizeof(entry);
+    if (memcmp(entry.mac, local_mac, sizeof(local_mac)) != 0) {
+      continue;
+    }
+    uint32_t grant = MESH_TRANSPORT_CREDIT_UNLIMITED;
+    if (has_credits) {
+      uint16_t wire_credit = 0;
+      memcpy(&wire_credit,
+             data + header_size + 1u + entries_size + index * sizeof(uint16_t),
+             sizeof(wire_credit));
+      if (wire_credit != kAckCreditUnlimited) {
+        grant = wire_credit;
+      }
+    }
+    portENTER_CRITICAL(&g_mesh->ack_lock);
+    g_mesh->acked_record_id = entry.record_id;
+    g_mesh->ack_pending = true;
+    if (g_mesh->credit_grant == MESH_TRANSPORT_CREDIT_UNLIMITED) {
+      g_mesh->credit_tokens_milli = 0; // refilled from now on
+      g_mesh->credit_refill_us = esp_timer_get_time();
+    }
+    g_mesh->credit_grant = grant;
+    portEXIT_CRITICAL(&g_mesh->ack_lock);
+    g_mesh->stats.acks_received++;
+    break;
+  }
+  return ESP_OK;
+}
+
+// Root: stamp t2 on entry and queue the probe; MeshTransportFlushTimeReplies
+// answers all queued probes in one frame stamped with t3 just before send.
+static esp_err_t
+OnRawTimeProbe(uint8_t* data,
+               uint32_t len,
+               uint8_t** out_data,
+               uint32_t* out_len,
+               uint32_t seq)
+{
+  const int64_t t2_us = TimeSyncGetEpochUs();
+  (void)seq;
+  ResetRawMessageOutput(out_data, out_len);
+
+  if (g_mesh == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const size_t header_size = MeshMessageHeaderSize();
+  if (len < header_size + sizeof(int64_t)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  mesh_message_t msg;
+  memset(&msg, 0, sizeof(msg));
+  memcpy(&msg, data, header_size + sizeof(msg.payload.probe_t1_us));
+  if (msg.type != MESH_MESSAGE_TIME_PROBE) {
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+  if (!g_mesh->is_root || !TimeSyncIsSystemTimeValid()) {
+    return ESP_OK;
+  }
+
+  const pt100_mesh_addr_t from = Pt100MeshAddrFromMac(msg.src_mac);
+  portENTER_CRITICAL(&g_mesh->ack_lock);
+  uint32_t slot = 0;
+  while (slot < g_mesh->time_reply_count &&
+         memcmp(&g_mesh->time_replies[slot].node, &from, sizeof(from)) != 0) {
+    slot++;
+  }
+  if (slot < MESH_TRANSPORT_MAX_NODES) {
+    // A repeated probe from the same leaf supersedes its older one.
+    g_mesh->time_replies[slot].node = from;
+    g_mesh->time_replies[slot].t1_us = msg.payload.probe_t1_us;
+    g_mesh->time_replies[slot].t2_us = t2_us;
+    if (slot == g_mesh->time_reply_count) {
+      g_mesh->time_reply_count++;
+    }
+  }
+  portEXIT_CRITICAL(&g_mesh->ack_lock);
+  return ESP_OK;
+}
+
+// Leaf: complete the exchange with t4 and hand the sample to the owner of
+// the clock estimator via the mailbox.
+static esp_err_t
+OnRawTimeReply(uint8_t* data,
+               uint32_t len,
+               uint8_t** out_data,
+               uint32_t* out_len,
+               uint32_t seq)
+{
+  const int64_t t4_us = TimeSyncGetEpochUs();
+  (void)seq;
+  ResetRawMessageOutput(out_data, out_len);
+
+  if (g_mesh == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const size_t header_size = MeshMessageHeaderSize();
+  const size_t prefix_size = header_size + sizeof(int64_t) + 1u;
+  if (len < prefix_size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  if (data[0] != MESH_MESSAGE_TIME_REPLY) {
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+  if (g_mesh->is_root) {
+    return ESP_OK;
+  }
+  int64_t t3_us = 0;
+  memcpy(&t3_us, data + header_size, sizeof(t3_us));
+  const uint8_t entry_count = data[header_size + sizeof(int64_t)];
+  if (len < prefix_size + entry_count * sizeof(mesh_time_reply_entry_t)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  uint8_t local_mac[6] = { 0 };
+  if (esp_wifi_get_mac(WIFI_IF_STA, local_mac) != ESP_OK) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const uint8_t* cursor = data + prefix_size;
+  for (uint8_t index = 0; index < entry_count; ++index) {
+    mesh_time_reply_entry_t entry;
+    memcpy(&entry, cursor, sizeof(entry));
+    cursor += sizeof(entry);
+    if (memcmp(entry.mac, local_mac, sizeof(local_mac)) != 0) {
+      continue;
+    }
+    portENTER_CRITICAL(&g_mesh->ack_lock);
+    if (g_mesh->time_probe_t1_us != 0 &&
+        entry.t1_us == g_mesh->time_probe_t1_us) {
+      g_mesh->time_sample.t1_us = entry.t1_us;
+      g_mesh->time_sample.t2_us = entry.t2_us;
+      g_mesh->time_sample.t3_us = t3_us;
+      g_mesh->time_sample.t4_us = t4_us;
+      g_mesh->time_sample_pending = true;
+      g_mesh->time_probe_t1_us = 0;
+    }
+    portEXIT_CRITICAL(&g_mesh->ack_lock);
+    break;
+  }
+  return ESP_OK;
+}
+
+static esp_err_t
+OnRawAlarm(uint8_t* data,
+           uint32_t len,
+           uint8_t** out_data,
+           uint32_t* out_len,
+           uint32_t seq)
+{
+  (void)seq;
+  ResetRawMessageOutput(out_data, out_len);
+
+  if (g_mesh == NULL || !g_mesh->is_root) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const size_t header_size = MeshMessageHeaderSize();
+  if (len < header_size + sizeof(alarm_event_t)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  mesh_message_t msg;
+  memset(&msg, 0, sizeof(msg));
+  memcpy(&msg, data, header_size + sizeof(alarm_event_t));
+  if (msg.type != MESH_MESSAGE_ALARM) {
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+  const pt100_mesh_addr_t from = Pt100MeshAddrFromMac(msg.src_mac);
+  g_mesh->stats.alarms_received++;
+  if (g_mesh->alarm_rx_callback != NULL) {
+    g_mesh->alarm_rx_callback(
+      &from, &msg.payload.alarm, g_mesh->alarm_rx_context);
+  }
+  return ESP_OK;
+}
+
+static esp_err_t
+OnRawBurstTrigger(uint8_t* data,
+                  uint32_t len,
+                  uint8_t** out_data,
+                  uint32_t* out_len,
+                  uint32_t seq)
+{
+  (void)seq;
+  ResetRawMessageOutput(out_data, out_len);
+
+  if (g_mesh == NULL || g_mesh->is_root) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const size_t header_size = MeshMessageHeaderSize();
+  mesh_message_t msg;
+  if (len < header_size + sizeof(msg.payload.target_mac)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memset(&msg, 0, sizeof(msg));
+  memcpy(&msg, data, header_size + sizeof(msg.payload.target_mac));
+  if (msg.type != MESH_MESSAGE_BURST_TRIGGER) {
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+  static const uint8_t kEveryNode[6] = { 0 };
+  if (memcmp(msg.payload.target_mac, kEveryNode, sizeof(kEveryNode)) != 0) {
+    uint8_t local_mac[6] = { 0 };
+    if (esp_wifi_get_mac(WIFI_IF_STA, local_mac) != ESP_OK ||
+        memcmp(msg.payload.target_mac, local_mac, sizeof(local_mac)) != 0) {
+      return ESP_OK;
+    }
+  }
+  g_mesh->stats.burst_triggers_received++;
+  if (g_mesh->burst_trigger_callback != NULL) {
+    g_mesh->burst_trigger_callback(g_mesh->burst_trigger_context);
+  }
+  return ESP_OK;
+}
+
+static const esp_mesh_lite_raw_msg_action_t kMeshRawActions[] = {
+  { kRawMsgIdRecord, 0, OnRawRecord },
+  { kRawMsgIdTimeRequest, 0, OnRawTimeRequest },
+  { kRawMsgIdTimeSync, 0, OnRawTimeSync },
+  { kRawMsgIdAck, 0, OnRawAck },
+  { kRawMsgIdTimeProbe, 0, OnRawTimeProbe },
+  { kRawMsgIdTimeReply, 0, OnRawTimeReply },
+  { kRawMsgIdAlarm, 0, OnRawAlarm },
+  { kRawMsgIdBurstTrigger, 0, OnRawBurstTrigger },
+  ESP_MESH_LITE_RAW_MSG_ACTION_END,
+};
+
+esp_err_t __attribute__((weak))
+esp_mesh_lite_stop(void)
+{
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t __attribute__((weak))
+esp_mesh_lite_deinit(void)
+{
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+// Mesh-Lite component currently does not publish a public "stop" API surface
+// for all internal background work (reconnect scans, resend timers, etc.), but
+// the prebuilt library exports private helpers that are used by examples.
+//
+// We provide weak fallbacks so the app still builds if the symbol set changes.
+void __attribute__((weak))
+esp_mesh_lite_comm_stop_reconnect(void)
+{
+}
+
+void __attribute__((weak))
+esp_mesh_lite_stop_resend_raw_msg(void)
+{
+}
+
+void __attribute__((weak))
+esp_mesh_lite_stop_resend_json_msg(void)
+{
+}
+
+void __attribute__((weak))
+esp_mesh_lite_clear_scan_status(void)
+{
 }
 
 void __attribute__((weak))
@@ -370,14 +1197,33 @@ StopMeshLiteBackgroundWorkBestEffort(void)
   (void)esp_wifi_scan_stop();
 }
 
+void
+MeshTransportNoteLinkDown(mesh_transport_t* mesh)
+{
+  if (mesh == NULL || mesh->is_root) {
+    return;
+  }
+  portENTER_CRITICAL(&mesh->ack_lock);
+  if (mesh->link_down_us == 0) {
+    mesh->link_down_us = esp_timer_get_time();
+  }
+  // The grant was sized for the old link: wait for the next ACK's.
+  mesh->credit_grant = MESH_TRANSPORT_CREDIT_INITIAL;
+  portEXIT_CRITICAL(&mesh->ack_lock);
+}
+
 static void
 CacheMeshLevel(mesh_transport_t* mesh)
 {
   if (mesh == NULL) {
     return;
   }
+  const bool was_connected = mesh->is_connected;
   mesh->last_level = esp_mesh_lite_get_level();
   mesh->is_connected = (mesh->last_level > 0);
+  if (was_connected && !mesh->is_connected) {
+    MeshTransportNoteLinkDown(mesh);
+  }
 }
 
 bool
@@ -392,6 +1238,73 @@ MeshTransportMeshLiteIsActive(void)
   return g_mesh != NULL && g_mesh->mesh_lite_started;
 }
 
+static void
+FreeNodeTable(mesh_transport_t* mesh)
+{
+  if (mesh->node_lock != NULL) {
+    vSemaphoreDelete(mesh->node_lock);
+    mesh->node_lock = NULL;
+  }
+  if (mesh->emit_lock != NULL) {
+    vSemaphoreDelete(mesh->emit_lock);
+    mesh->emit_lock = NULL;
+  }
+  free(mesh->emit_batch);
+  mesh->emit_batch = NULL;
+  free(mesh->nodes);
+  mesh->nodes = NULL;
+  mesh->node_count = 0;
+}
+
+static void
+FreeRelay(mesh_transport_t* mesh)
+{
+  if (mesh->relay_lock != NULL) {
+    vSemaphoreDelete(mesh->relay_lock);
+    mesh->relay_lock = NULL;
+  }
+  free(mesh->relay);
+  mesh->relay = NULL;
+}
+
+static esp_err_t
+AllocateRelay(mesh_transport_t* mesh)
+{
+  mesh->relay = (mesh_relay_t*)calloc(1, sizeof(mesh_relay_t));
+  mesh->relay_lock = xSemaphoreCreateMutex();
+  if (mesh->relay == NULL || mesh->relay_lock == NULL) {
+    FreeRelay(mesh);
+    return ESP_ERR_NO_MEM;
+  }
+  RelayReset(mesh->relay);
+  return ESP_OK;
+}
+
+// Root only: one reorder window per leaf. Prefers PSRAM when present since
+// the table is large (MESH_TRANSPORT_MAX_NODES x mesh_node_state_t) and only
+// touched at mesh packet rate.
+static esp_err_t
+AllocateNodeTable(mesh_transport_t* mesh)
+{
+  mesh->nodes = (mesh_node_state_t*)heap_caps_calloc(
+    MESH_TRANSPORT_MAX_NODES,
+    sizeof(mesh_node_state_t),
+    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (mesh->nodes == NULL) {
+    mesh->nodes = (mesh_node_state_t*)calloc(MESH_TRANSPORT_MAX_NODES,
+                                             sizeof(mesh_node_state_t));
+  }
+  mesh->emit_batch = (mesh_emit_batch_t*)malloc(sizeof(mesh_emit_batch_t));
+  mesh->node_lock = xSemaphoreCreateMutex();
+  mesh->emit_lock = xSemaphoreCreateMutex();
+  if (mesh->nodes == NULL || mesh->emit_batch == NULL ||
+      mesh->node_lock == NULL || mesh->emit_lock == NULL) {
+    FreeNodeTable(mesh);
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
 esp_err_t
 MeshTransportStart(mesh_transport_t* mesh,
                    bool is_root,
@@ -406,7 +1319,24 @@ MeshTransportStart(mesh_transport_t* mesh,
     return ESP_ERR_INVALID_ARG;
   }
   memset(mesh, 0, sizeof(*mesh));
+  mesh->ack_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  mesh->credit_grant = MESH_TRANSPORT_CREDIT_INITIAL;
+  mesh->credit_budget = MESH_TRANSPORT_CREDIT_UNLIMITED;
+  // The first join counts as a link loss, so cached-parent and scanned joins
+  // can be compared from boot.
+  mesh->link_down_us = is_root ? 0 : esp_timer_get_time();
   mesh->is_root = is_root;
+  if (is_root) {
+    esp_err_t nodes_result = AllocateNodeTable(mesh);
+    if (nodes_result != ESP_OK) {
+      return nodes_result;
+    }
+  } else if (MESH_TRANSPORT_RELAY_AGGREGATION && allow_children) {
+    esp_err_t relay_result = AllocateRelay(mesh);
+    if (relay_result != ESP_OK) {
+      return relay_result;
+    }
+  }
   mesh->record_rx_callback = record_rx_callback;
   mesh->record_rx_context = record_rx_context;
   mesh->time_sync = time_sync;
@@ -416,6 +1346,8 @@ MeshTransportStart(mesh_transport_t* mesh,
   esp_err_t svc_result = WifiServiceAcquire(WIFI_SERVICE_MODE_MESH);
   if (svc_result != ESP_OK) {
     g_mesh = NULL;
+    FreeNodeTable(mesh);
+    FreeRelay(mesh);
     return svc_result;
   }
 
@@ -533,6 +1465,47 @@ MeshTransportGetRootAddress(const mesh_transport_t* mesh,
   return ESP_OK;
 }
 
+// Spends one credit from a token bucket filled at the granted rate and
+// holding MESH_TRANSPORT_CREDIT_BURST_MS of it (at least one record), so a
+// node sends its grant spread out rather than in one burst after each ACK.
+// False (and counted) when empty.
+static bool
+CreditTake(mesh_transport_t* mesh)
+{
+  bool granted = true;
+  portENTER_CRITICAL(&mesh->ack_lock);
+  const uint32_t grant = mesh->credit_grant;
+  if (grant != MESH_TRANSPORT_CREDIT_UNLIMITED) {
+    const int64_t now_us = esp_timer_get_time();
+    int64_t elapsed_us = now_us - mesh->credit_refill_us;
+    if (elapsed_us > kCreditBurstUs) {
+      elapsed_us = kCreditBurstUs;
+    }
+    // grant/min in milli-records per microsecond: grant / 60000.
+    const uint64_t capacity_milli =
+      ((uint64_t)grant * kCreditBurstUs / 60000u > 1000u)
+        ? (uint64_t)grant * kCreditBurstUs / 60000u
+        : 1000u;
+    uint64_t tokens = mesh->credit_tokens_milli +
+                      (uint64_t)grant * (uint64_t)elapsed_us / 60000u;
+    if (tokens > capacity_milli) {
+      tokens = capacity_milli;
+    }
+    mesh->credit_refill_us = now_us;
+    if (tokens >= 1000u) {
+      tokens -= 1000u;
+    } else {
+      granted = false;
+    }
+    mesh->credit_tokens_milli = (uint32_t)tokens;
+  }
+  portEXIT_CRITICAL(&mesh->ack_lock);
+  if (!granted) {
+    mesh->stats.credit_deferred++;
+  }
+  return granted;
+}
+
 esp_err_t
 MeshTransportSendRecord(const mesh_transport_t* mesh,
                         const log_record_t* record)
@@ -543,6 +1516,9 @@ MeshTransportSendRecord(const mesh_transport_t* mesh,
   if (!mesh->mesh_lite_started || !mesh->is_connected) {
     return ESP_ERR_INVALID_STATE;
   }
+  if (!CreditTake((mesh_transport_t*)mesh)) {
+    return ESP_ERR_NOT_ALLOWED;
+  }
   mesh_message_t msg = {
     .type = MESH_MESSAGE_RECORD,
     .payload.record = *record,
@@ -552,10 +1528,684 @@ MeshTransportSendRecord(const mesh_transport_t* mesh,
     return mac_result;
   }
   const size_t msg_size = MeshMessageHeaderSize() + sizeof(log_record_t);
-  return SendRawMessage(kRawMsgIdRecord,
+  esp_err_t result = SendRawMessage(kRawMsgIdRecord,
+                                    (const uint8_t*)&msg,
+                                    msg_size,
+                                    esp_mesh_lite_send_raw_msg_to_root);
+  if (result == ESP_OK) {
+    NoteUpstreamSent((mesh_transport_t*)mesh);
+  }
+  return result;
+}
+
+static esp_err_t
+AggregatorOpen(mesh_transport_t* mesh)
+{
+  mesh_aggregator_t* aggregator = &mesh->aggregator;
+  const size_t header_size = MeshMessageHeaderSize();
+  esp_err_t init_result =
+    MeshBatchWriterInit(&aggregator->writer,
+                        aggregator->frame + header_size,
+                        sizeof(aggregator->frame) - header_size,
+                        MESH_TRANSPORT_WIRE_CODEC);
+  if (init_result != ESP_OK) {
+    return init_result;
+  }
+  aggregator->is_open = true;
+  aggregator->opened_us = esp_timer_get_time();
+  return ESP_OK;
+}
+
+static void
+AggregatorDiscard(mesh_transport_t* mesh)
+{
+  mesh_aggregator_t* aggregator = &mesh->aggregator;
+  if (aggregator->is_open) {
+    mesh->stats.records_dropped += aggregator->writer.record_count;
+  }
+  aggregator->is_open = false;
+}
+
+static esp_err_t
+AggregatorFlush(mesh_transport_t* mesh)
+{
+  mesh_aggregator_t* aggregator = &mesh->aggregator;
+  if (!aggregator->is_open || MeshBatchWriterIsEmpty(&aggregator->writer)) {
+    aggregator->is_open = false;
+    return ESP_OK;
+  }
+  if (!mesh->mesh_lite_started || !mesh->is_connected) {
+    AggregatorDiscard(mesh);
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  mesh_message_t header = {
+    .type = MESH_MESSAGE_RECORD_BATCH,
+  };
+  esp_err_t mac_result = PopulateMeshMessageSrc(&header);
+  if (mac_result != ESP_OK) {
+    AggregatorDiscard(mesh);
+    return mac_result;
+  }
+  const size_t header_size = MeshMessageHeaderSize();
+  memcpy(aggregator->frame, &header, header_size);
+
+  const uint32_t record_count = aggregator->writer.record_count;
+  const size_t payload_size = MeshBatchWriterFinish(&aggregator->writer);
+  aggregator->is_open = false;
+  if (mesh->relay != NULL) {
+    // Own records ride in the relay frame along with the children's.
+    xSemaphoreTake(mesh->relay_lock, portMAX_DELAY);
+    esp_err_t relay_result = RelayQueueBatchLocked(
+      mesh, aggregator->frame, header_size + payload_size);
+    xSemaphoreGive(mesh->relay_lock);
+    if (relay_result == ESP_OK) {
+      mesh->stats.records_sent += record_count;
+      return ESP_OK;
+    }
+    mesh->stats.send_failures++;
+    mesh->stats.records_dropped += record_count;
+    return relay_result;
+  }
+  esp_err_t send_result =
+    SendRecordFrame(aggregator->frame, header_size + payload_size);
+  if (send_result != ESP_OK) {
+    mesh->stats.send_failures++;
+    mesh->stats.records_dropped += record_count;
+    return send_result;
+  }
+  NoteUpstreamSent(mesh);
+  mesh->stats.frames_sent++;
+  mesh->stats.records_sent += record_count;
+  return ESP_OK;
+}
+
+static uint32_t
+RelayMsUntilDue(mesh_transport_t* mesh)
+{
+  if (mesh->relay == NULL) {
+    return UINT32_MAX;
+  }
+  uint32_t due_ms = UINT32_MAX;
+  xSemaphoreTake(mesh->relay_lock, portMAX_DELAY);
+  if (mesh->relay->section_count > 0) {
+    const int64_t elapsed_ms =
+      (esp_timer_get_time() - mesh->relay->opened_us) / 1000;
+    due_ms = (elapsed_ms >= MESH_TRANSPORT_RELAY_WINDOW_MS)
+               ? 0u
+               : (uint32_t)(MESH_TRANSPORT_RELAY_WINDOW_MS - elapsed_ms);
+  }
+  xSemaphoreGive(mesh->relay_lock);
+  return due_ms;
+}
+
+static esp_err_t
+RelayFlush(mesh_transport_t* mesh)
+{
+  if (mesh->relay == NULL) {
+    return ESP_OK;
+  }
+  xSemaphoreTake(mesh->relay_lock, portMAX_DELAY);
+  esp_err_t result = RelaySendLocked(mesh);
+  xSemaphoreGive(mesh->relay_lock);
+  return result;
+}
+
+esp_err_t
+MeshTransportFlushRecords(mesh_transport_t* mesh)
+{
+  if (mesh == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  esp_err_t result = AggregatorFlush(mesh);
+  esp_err_t relay_result = RelayFlush(mesh);
+  return (result != ESP_OK) ? result : relay_result;
+}
+
+esp_err_t
+MeshTransportQueueRecord(mesh_transport_t* mesh, const log_record_t* record)
+{
+  if (mesh == NULL || record == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!mesh->mesh_lite_started || !mesh->is_connected) {
+    AggregatorDiscard(mesh);
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!CreditTake(mesh)) {
+    return ESP_ERR_NOT_ALLOWED;
+  }
+
+  mesh_aggregator_t* aggregator = &mesh->aggregator;
+  if (!aggregator->is_open) {
+    esp_err_t open_result = AggregatorOpen(mesh);
+    if (open_result != ESP_OK) {
+      return open_result;
+    }
+  }
+
+  esp_err_t append_result =
+    MeshBatchWriterAppend(&aggregator->writer, record);
+  if (append_result == ESP_ERR_NO_MEM) {
+    // Frame is full: ship it and start a new one with this record.
+    (void)AggregatorFlush(mesh);
+    esp_err_t open_result = AggregatorOpen(mesh);
+    if (open_result != ESP_OK) {
+      return open_result;
+    }
+    append_result = MeshBatchWriterAppend(&aggregator->writer, record);
+  }
+  if (append_result != ESP_OK) {
+    return append_result;
+  }
+
+  if (MeshBatchWriterIsFull(&aggregator->writer)) {
+    return AggregatorFlush(mesh);
+  }
+  return ESP_OK;
+}
+
+static uint32_t
+AggregatorMsUntilDue(const mesh_transport_t* mesh)
+{
+  if (!mesh->aggregator.is_open) {
+    return UINT32_MAX;
+  }
+  const int64_t elapsed_ms =
+    (esp_timer_get_time() - mesh->aggregator.opened_us) / 1000;
+  if (elapsed_ms >= MESH_TRANSPORT_AGG_MAX_LATENCY_MS) {
+    return 0;
+  }
+  return (uint32_t)(MESH_TRANSPORT_AGG_MAX_LATENCY_MS - elapsed_ms);
+}
+
+uint32_t
+MeshTransportMsUntilFlushDue(const mesh_transport_t* mesh)
+{
+  if (mesh == NULL) {
+    return UINT32_MAX;
+  }
+  const uint32_t aggregator_ms = AggregatorMsUntilDue(mesh);
+  const uint32_t relay_ms = RelayMsUntilDue((mesh_transport_t*)mesh);
+  return (relay_ms < aggregator_ms) ? relay_ms : aggregator_ms;
+}
+
+esp_err_t
+MeshTransportFlushIfDue(mesh_transport_t* mesh)
+{
+  if (mesh == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  esp_err_t result = ESP_OK;
+  if (AggregatorMsUntilDue(mesh) == 0) {
+    result = AggregatorFlush(mesh);
+  }
+  if (RelayMsUntilDue(mesh) == 0) {
+    esp_err_t relay_result = RelayFlush(mesh);
+    if (result == ESP_OK) {
+      result = relay_result;
+    }
+  }
+  return result;
+}
+
+// The gap takes the record path (aggregator, then this node's relay frame,
+// then SendRecordFrame) so it cannot overtake records still held on the
+// way; a root that saw it first would skip past them and drop them as late.
+esp_err_t
+MeshTransportSendGap(mesh_transport_t* mesh,
+                     uint64_t first_available_record_id)
+{
+  if (mesh == NULL || mesh->is_root) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!mesh->mesh_lite_started || !mesh->is_connected) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  esp_err_t flush_result = AggregatorFlush(mesh);
+  if (flush_result != ESP_OK) {
+    return flush_result;
+  }
+  mesh_message_t msg = {
+    .type = MESH_MESSAGE_RECORD_GAP,
+    .payload.first_available_record_id = first_available_record_id,
+  };
+  esp_err_t mac_result = PopulateMeshMessageSrc(&msg);
+  if (mac_result != ESP_OK) {
+    return mac_result;
+  }
+  const size_t msg_size =
+    MeshMessageHeaderSize() + sizeof(msg.payload.first_available_record_id);
+  esp_err_t result =
+    RelayForwardGap(mesh, (const uint8_t*)&msg, (uint32_t)msg_size);
+  if (result == ESP_OK) {
+    mesh->stats.gap_notices_sent++;
+  }
+  return result;
+}
+
+esp_err_t
+MeshTransportSendAlarm(mesh_transport_t* mesh, const alarm_event_t* event)
+{
+  if (mesh == NULL || event == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (mesh->is_root || !mesh->mesh_lite_started || !mesh->is_connected) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  mesh_message_t msg = {
+    .type = MESH_MESSAGE_ALARM,
+    .payload.alarm = *event,
+  };
+  esp_err_t mac_result = PopulateMeshMessageSrc(&msg);
+  if (mac_result != ESP_OK) {
+    return mac_result;
+  }
+  // To the root even when relays aggregate: nothing on the path holds it.
+  esp_err_t result =
+    SendRawMessageWithRetry(kRawMsgIdAlarm,
+                            (const uint8_t*)&msg,
+                            MeshMessageHeaderSize() + sizeof(alarm_event_t),
+                            esp_mesh_lite_send_raw_msg_to_root,
+                            kAlarmMaxRetry,
+                            kAlarmRetryIntervalMs);
+  if (result == ESP_OK) {
+    mesh->stats.alarms_sent++;
+  }
+  return result;
+}
+
+void
+MeshTransportSetAlarmCallback(mesh_transport_t* mesh,
+                              mesh_alarm_rx_callback_t callback,
+                              void* context)
+{
+  if (mesh == NULL) {
+    return;
+  }
+  mesh->alarm_rx_context = context;
+  mesh->alarm_rx_callback = callback;
+}
+
+esp_err_t
+MeshTransportSendBurstTrigger(mesh_transport_t* mesh,
+                              const uint8_t* target_mac)
+{
+  if (mesh == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!mesh->is_root || !mesh->mesh_lite_started || !mesh->is_connected) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  mesh_message_t msg = {
+    .type = MESH_MESSAGE_BURST_TRIGGER,
+  };
+  if (target_mac != NULL) {
+    memcpy(msg.payload.target_mac, target_mac, sizeof(msg.payload.target_mac));
+  }
+  esp_err_t mac_result = PopulateMeshMessageSrc(&msg);
+  if (mac_result != ESP_OK) {
+    return mac_result;
+  }
+  return SendRawMessage(kRawMsgIdBurstTrigger,
                         (const uint8_t*)&msg,
-                        msg_size,
-                        esp_mesh_lite_send_raw_msg_to_root);
+                        MeshMessageHeaderSize() +
+                          sizeof(msg.payload.target_mac),
+                        esp_mesh_lite_send_broadcast_raw_msg_to_child);
+}
+
+void
+MeshTransportSetBurstTriggerCallback(mesh_transport_t* mesh,
+                                     mesh_burst_trigger_callback_t callback,
+                                     void* context)
+{
+  if (mesh == NULL) {
+    return;
+  }
+  mesh->burst_trigger_context = context;
+  mesh->burst_trigger_callback = callback;
+}
+
+bool
+MeshTransportTakeAck(mesh_transport_t* mesh, uint64_t* acked_out)
+{
+  if (mesh == NULL || acked_out == NULL) {
+    return false;
+  }
+  bool pending = false;
+  portENTER_CRITICAL(&mesh->ack_lock);
+  if (mesh->ack_pending) {
+    *acked_out = mesh->acked_record_id;
+    mesh->ack_pending = false;
+    pending = true;
+  }
+  portEXIT_CRITICAL(&mesh->ack_lock);
+  return pending;
+}
+
+esp_err_t
+MeshTransportBroadcastAcks(mesh_transport_t* mesh)
+{
+  if (mesh == NULL || !mesh->is_root) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!mesh->mesh_lite_started || !mesh->is_connected) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  uint8_t frame[MESH_TRANSPORT_FRAME_MAX_BYTES];
+  mesh_message_t header = {
+    .type = MESH_MESSAGE_ACK,
+  };
+  esp_err_t mac_result = PopulateMeshMessageSrc(&header);
+  if (mac_result != ESP_OK) {
+    return mac_result;
+  }
+  const size_t header_size = MeshMessageHeaderSize();
+  memcpy(frame, &header, header_size);
+
+  size_t per_frame = (sizeof(frame) - header_size - 1u) /
+                     (sizeof(mesh_ack_wire_entry_t) + sizeof(uint16_t));
+  if (per_frame > UINT8_MAX) {
+    per_frame = UINT8_MAX;
+  }
+
+  if (mesh->nodes == NULL || mesh->node_lock == NULL) {
+    return ESP_OK;
+  }
+
+  // Even split of the budget; the remainder goes to a window of nodes that
+  // moves on every broadcast so no node is always short.
+  const uint32_t budget = mesh->credit_budget;
+  xSemaphoreTake(mesh->node_lock, portMAX_DELAY);
+  const uint32_t split_count = mesh->node_count;
+  xSemaphoreGive(mesh->node_lock);
+  const uint32_t share = (split_count > 0) ? budget / split_count : 0;
+  const uint32_t remainder = (split_count > 0) ? budget % split_count : 0;
+  const uint32_t rotor = mesh->credit_rotor;
+  if (split_count > 0) {
+    mesh->credit_rotor = (rotor + remainder) % split_count;
+  }
+
+  esp_err_t result = ESP_OK;
+  uint32_t next_entry = 0;
+  bool more = true;
+  while (more) {
+    uint8_t count = 0;
+    uint16_t credits[UINT8_MAX];
+    uint8_t* cursor = frame + header_size + 1u;
+    xSemaphoreTake(mesh->node_lock, portMAX_DELAY);
+    while (next_entry < mesh->node_count && count < per_frame) {
+      const uint32_t index = next_entry++;
+      const mesh_node_state_t* entry = &mesh->nodes[index];
+      mesh_ack_wire_entry_t wire;
+      memcpy(wire.mac, entry->node.addr, sizeof(wire.mac));
+      wire.record_id = MeshReorderAckRecordId(&entry->window);
+      memcpy(cursor, &wire, sizeof(wire));
+      cursor += sizeof(wire);
+
+      uint32_t grant = share;
+      if (index < split_count &&
+          (index + split_count - rotor) % split_count < remainder) {
+        grant++;
+      }
+      if (budget == MESH_TRANSPORT_CREDIT_UNLIMITED ||
+          grant >= kAckCreditUnlimited) {
+        grant = kAckCreditUnlimited;
+      }
+      credits[count++] = (uint16_t)grant;
+    }
+    more = next_entry < mesh->node_count;
+    xSemaphoreGive(mesh->node_lock);
+
+    if (count == 0) {
+      break;
+    }
+    frame[header_size] = count;
+    memcpy(cursor, credits, count * sizeof(uint16_t));
+    cursor += count * sizeof(uint16_t);
+    esp_err_t send_result =
+      SendRawMessage(kRawMsgIdAck,
+                     frame,
+                     (size_t)(cursor - frame),
+                     esp_mesh_lite_send_broadcast_raw_msg_to_child);
+    if (send_result == ESP_OK) {
+      mesh->stats.acks_sent++;
+    } else if (result == ESP_OK) {
+      result = send_result;
+    }
+  }
+  return result;
+}
+
+void
+MeshTransportSetCreditBudget(mesh_transport_t* mesh, uint32_t records_per_min)
+{
+  if (mesh == NULL) {
+    return;
+  }
+  mesh->credit_budget = records_per_min;
+}
+
+uint32_t
+MeshTransportCreditGrant(const mesh_transport_t* mesh)
+{
+  if (mesh == NULL) {
+    return MESH_TRANSPORT_CREDIT_UNLIMITED;
+  }
+  return mesh->credit_grant;
+}
+
+void
+MeshTransportReorderTick(mesh_transport_t* mesh)
+{
+  if (mesh == NULL || mesh->nodes == NULL || mesh->node_lock == NULL) {
+    return;
+  }
+  const int64_t now_us = esp_timer_get_time();
+  const int64_t max_delay_us =
+    (int64_t)MESH_TRANSPORT_REORDER_MAX_DELAY_MS * 1000;
+  // One node per lock hold, so the batch holds at most one window's release
+  // and the RX path waits for one delivery at most.
+  for (uint32_t index = 0;; ++index) {
+    (void)LockWindows(mesh, portMAX_DELAY);
+    if (index >= mesh->node_count) {
+      xSemaphoreGive(mesh->node_lock);
+      xSemaphoreGive(mesh->emit_lock);
+      break;
+    }
+    mesh_node_state_t* entry = &mesh->nodes[index];
+    const pt100_mesh_addr_t from = entry->node;
+    MeshReorderTick(&entry->window,
+                    now_us,
+                    max_delay_us,
+                    CollectOrderedRecord,
+                    mesh->emit_batch);
+    UnlockWindowsAndDeliver(mesh, &from);
+  }
+}
+
+void
+MeshTransportGetReorderStats(mesh_transport_t* mesh,
+                             mesh_reorder_stats_t* total_out,
+                             uint32_t* node_count_out,
+                             uint32_t* buffered_out)
+{
+  mesh_reorder_stats_t total;
+  memset(&total, 0, sizeof(total));
+  uint32_t node_count = 0;
+  uint32_t buffered = 0;
+  if (mesh != NULL && mesh->nodes != NULL && mesh->node_lock != NULL) {
+    xSemaphoreTake(mesh->node_lock, portMAX_DELAY);
+    node_count = mesh->node_count;
+    for (uint32_t index = 0; index < node_count; ++index) {
+      const mesh_reorder_window_t* window = &mesh->nodes[index].window;
+      total.delivered += window->stats.delivered;
+      total.duplicates += window->stats.duplicates;
+      total.reordered += window->stats.reordered;
+      total.gaps_skipped += window->stats.gaps_skipped;
+      total.late_recovered += window->stats.late_recovered;
+      total.lost += window->stats.lost;
+      total.refused += window->stats.refused;
+      buffered += MeshReorderBufferedCount(window);
+    }
+    xSemaphoreGive(mesh->node_lock);
+  }
+  if (total_out != NULL) {
+    *total_out = total;
+  }
+  if (node_count_out != NULL) {
+    *node_count_out = node_count;
+  }
+  if (buffered_out != NULL) {
+    *buffered_out = buffered;
+  }
+}
+
+esp_err_t
+MeshTransportSendTimeProbe(mesh_transport_t* mesh)
+{
+  if (mesh == NULL || mesh->is_root) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!mesh->mesh_lite_started || !mesh->is_connected) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  mesh_message_t msg = {
+    .type = MESH_MESSAGE_TIME_PROBE,
+  };
+  esp_err_t mac_result = PopulateMeshMessageSrc(&msg);
+  if (mac_result != ESP_OK) {
+    return mac_result;
+  }
+  msg.payload.probe_t1_us = TimeSyncGetEpochUs();
+  portENTER_CRITICAL(&mesh->ack_lock);
+  mesh->time_probe_t1_us = msg.payload.probe_t1_us;
+  mesh->time_sample_pending = false;
+  portEXIT_CRITICAL(&mesh->ack_lock);
+
+  esp_err_t result = SendRawMessageWithRetry(
+    kRawMsgIdTimeProbe,
+    (const uint8_t*)&msg,
+    MeshMessageHeaderSize() + sizeof(msg.payload.probe_t1_us),
+    esp_mesh_lite_send_raw_msg_to_root,
+    0,
+    kRawMsgRetryIntervalMs);
+  if (result == ESP_OK) {
+    mesh->stats.time_probes_sent++;
+  }
+  return result;
+}
+
+bool
+MeshTransportTakeTimeSample(mesh_transport_t* mesh,
+                            clock_sync_sample_t* sample_out)
+{
+  if (mesh == NULL || sample_out == NULL) {
+    return false;
+  }
+  bool pending = false;
+  portENTER_CRITICAL(&mesh->ack_lock);
+  if (mesh->time_sample_pending) {
+    *sample_out = mesh->time_sample;
+    mesh->time_sample_pending = false;
+    pending = true;
+  }
+  portEXIT_CRITICAL(&mesh->ack_lock);
+  if (pending) {
+    mesh->stats.time_replies_received++;
+  }
+  return pending;
+}
+
+esp_err_t
+MeshTransportFlushTimeReplies(mesh_transport_t* mesh)
+{
+  if (mesh == NULL || !mesh->is_root) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  uint8_t frame[MESH_TRANSPORT_FRAME_MAX_BYTES];
+  mesh_message_t header = {
+    .type = MESH_MESSAGE_TIME_REPLY,
+  };
+  esp_err_t mac_result = PopulateMeshMessageSrc(&header);
+  if (mac_result != ESP_OK) {
+    return mac_result;
+  }
+  const size_t header_size = MeshMessageHeaderSize();
+  const size_t prefix_size = header_size + sizeof(int64_t) + 1u;
+  memcpy(frame, &header, header_size);
+  size_t per_frame =
+    (sizeof(frame) - prefix_size) / sizeof(mesh_time_reply_entry_t);
+  if (per_frame > UINT8_MAX) {
+    per_frame = UINT8_MAX;
+  }
+
+  esp_err_t result = ESP_OK;
+  bool more = true;
+  while (more) {
+    uint8_t count = 0;
+    uint8_t* cursor = frame + prefix_size;
+    portENTER_CRITICAL(&mesh->ack_lock);
+    while (count < per_frame && count < mesh->time_reply_count) {
+      const mesh_time_probe_pending_t* pending = &mesh->time_replies[count];
+      mesh_time_reply_entry_t entry;
+      memcpy(entry.mac, pending->node.addr, sizeof(entry.mac));
+      entry.t1_us = pending->t1_us;
+      entry.t2_us = pending->t2_us;
+      memcpy(cursor, &entry, sizeof(entry));
+      cursor += sizeof(entry);
+      count++;
+    }
+    // Drop what was taken; the remainder moves to the front.
+    const uint32_t remaining = mesh->time_reply_count - count;
+    memmove(&mesh->time_replies[0],
+            &mesh->time_replies[count],
+            remaining * sizeof(mesh->time_replies[0]));
+    mesh->time_reply_count = remaining;
+    more = remaining > 0;
+    portEXIT_CRITICAL(&mesh->ack_lock);
+
+    if (count == 0) {
+      break;
+    }
+    frame[header_size + sizeof(int64_t)] = count;
+    const int64_t t3_us = TimeSyncGetEpochUs();
+    memcpy(frame + header_size, &t3_us, sizeof(t3_us));
+    // No retries: a resent reply would carry a stale t3.
+    esp_err_t send_result =
+      SendRawMessageWithRetry(kRawMsgIdTimeReply,
+                              frame,
+                              (size_t)(cursor - frame),
+                              esp_mesh_lite_send_broadcast_raw_msg_to_child,
+                              0,
+                              kRawMsgRetryIntervalMs);
+    if (send_result == ESP_OK) {
+      mesh->stats.time_reply_frames_sent++;
+    } else if (result == ESP_OK) {
+      result = send_result;
+    }
+  }
+  return result;
+}
+
+bool
+MeshTransportTakeTimeRequests(mesh_transport_t* mesh, int64_t window_us)
+{
+  if (mesh == NULL || !mesh->is_root) {
+    return false;
+  }
+  bool due = false;
+  const int64_t now_us = esp_timer_get_time();
+  portENTER_CRITICAL(&mesh->ack_lock);
+  if (mesh->time_request_pending &&
+      now_us - mesh->time_request_first_us >= window_us) {
+    mesh->time_request_pending = false;
+    due = true;
+  }
+  portEXIT_CRITICAL(&mesh->ack_lock);
+  return due;
 }
 
 esp_err_t
@@ -616,6 +2266,8 @@ MeshTransportStop(mesh_transport_t* mesh)
   mesh->is_connected = false;
   if (!mesh->mesh_lite_started) {
     g_mesh = NULL;
+    FreeNodeTable(mesh);
+    FreeRelay(mesh);
     return ESP_OK;
   }
 
@@ -645,6 +2297,8 @@ MeshTransportStop(mesh_transport_t* mesh)
   mesh->is_started = false;
   mesh->last_level = -1;
   g_mesh = NULL;
+  FreeNodeTable(mesh);
+  FreeRelay(mesh);
 
   if (WifiServiceActiveMode() == WIFI_SERVICE_MODE_MESH) {
     esp_err_t svc_result = WifiServiceRelease();
@@ -5,19 +5,182 @@
 #include <stdint.h>
 
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "alarm.h"
 #include "log_record.h"
 #include "mesh_addr.h"
+#include "clock_sync.h"
+#include "freertos/semphr.h"
+#include "mesh_codec.h"
+#include "mesh_reorder.h"
+#include "sdkconfig.h"
 #include "time_sync.h"
 
+#ifdef CONFIG_APP_MESH_FRAME_MAX_BYTES
+#define MESH_TRANSPORT_FRAME_MAX_BYTES CONFIG_APP_MESH_FRAME_MAX_BYTES
+#else
+#define MESH_TRANSPORT_FRAME_MAX_BYTES 1024
+#endif
+
+#ifdef CONFIG_APP_MESH_MAX_NODES
+#define MESH_TRANSPORT_MAX_NODES CONFIG_APP_MESH_MAX_NODES
+#else
+#define MESH_TRANSPORT_MAX_NODES 32
+#endif
+
+#ifdef CONFIG_APP_MESH_WIRE_CODEC_RAW
+#define MESH_TRANSPORT_WIRE_CODEC MESH_CODEC_RAW
+#else
+#define MESH_TRANSPORT_WIRE_CODEC MESH_CODEC_COMPACT
+#endif
+
+#ifdef CONFIG_APP_MESH_AGG_MAX_LATENCY_MS
+#define MESH_TRANSPORT_AGG_MAX_LATENCY_MS CONFIG_APP_MESH_AGG_MAX_LATENCY_MS
+#else
+#define MESH_TRANSPORT_AGG_MAX_LATENCY_MS 2000
+#endif
+
+#ifdef CONFIG_APP_MESH_REORDER_MAX_DELAY_MS
+#define MESH_TRANSPORT_REORDER_MAX_DELAY_MS CONFIG_APP_MESH_REORDER_MAX_DELAY_MS
+#else
+#define MESH_TRANSPORT_REORDER_MAX_DELAY_MS 3000
+#endif
+
+// Relay aggregation: record frames go to the parent instead of straight to
+// the root, and every node that accepts children re-packs what it receives
+// (plus its own batches) into one frame per window. Mesh-wide: a relay
+// built without it does not forward child frames sent this way.
+#ifdef CONFIG_APP_MESH_RELAY_AGGREGATION
+#define MESH_TRANSPORT_RELAY_AGGREGATION 1
+#else
+#define MESH_TRANSPORT_RELAY_AGGREGATION 0
+#endif
+
+#ifdef CONFIG_APP_MESH_RELAY_WINDOW_MS
+#define MESH_TRANSPORT_RELAY_WINDOW_MS CONFIG_APP_MESH_RELAY_WINDOW_MS
+#else
+#define MESH_TRANSPORT_RELAY_WINDOW_MS 500
+#endif
+
+// Credit grant (records per minute) meaning "no limit": the default before
+// a node's first ACK, and what roots without a flow-control budget send.
+#define MESH_TRANSPORT_CREDIT_UNLIMITED UINT32_MAX
+// Credit a node may save up, as time at its granted rate.
+#define MESH_TRANSPORT_CREDIT_BURST_MS 1000
+// Grant a leaf holds to until an ACK sizes its share, at boot and after a
+// link loss, so nodes that join together do not flood the root's ring.
+#ifdef CONFIG_APP_MESH_CREDIT_INITIAL_PER_MIN
+#define MESH_TRANSPORT_CREDIT_INITIAL CONFIG_APP_MESH_CREDIT_INITIAL_PER_MIN
+#else
+#define MESH_TRANSPORT_CREDIT_INITIAL 60
+#endif
+// Records one reorder window operation can release: a push releases up to
+// MESH_REORDER_SLOTS buffered records plus the pushed one.
+#define MESH_EMIT_BATCH_RECORDS (MESH_REORDER_SLOTS + 1u)
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-  typedef void (*mesh_record_rx_callback_t)(const pt100_mesh_addr_t* from,
+  // Root: called for every record, in order per node. false when the record
+  // could not be taken (export ring full); the ACK then stops short of it
+  // and the node sends it again.
+  typedef bool (*mesh_record_rx_callback_t)(const pt100_mesh_addr_t* from,
                                             const log_record_t* record,
                                             void* context);
 
+  // Root: called from the Mesh-Lite RX context for every alarm event.
+  typedef void (*mesh_alarm_rx_callback_t)(const pt100_mesh_addr_t* from,
+                                           const alarm_event_t* event,
+                                           void* context);
+
+  // Leaf: called from the Mesh-Lite RX context when the root asks this node
+  // for a burst capture.
+  typedef void (*mesh_burst_trigger_callback_t)(void* context);
+
+  typedef struct
+  {
+    uint32_t frames_sent;
+    uint32_t records_sent;
+    uint32_t send_failures;
+    uint32_t records_dropped; // queued but discarded (send failed/offline)
+    uint32_t frames_received;
+    uint32_t records_received;
+    uint32_t decode_errors;
+    uint32_t records_untracked; // root: node table full, delivered as-is
+    uint32_t rx_lock_timeouts;  // root: windows busy past the RX timeout
+    uint32_t records_refused;   // root: refused by the consumer, re-requested
+    uint32_t acks_sent;
+    uint32_t acks_received;
+    uint32_t gap_notices_sent;
+    uint32_t time_probes_sent;
+    uint32_t time_replies_received;
+    uint32_t time_reply_frames_sent;  // root
+    uint32_t time_requests_received;  // root, legacy TIME_REQUEST
+    uint32_t time_requests_coalesced; // root, answered by a shared broadcast
+    uint32_t relay_frames_in;     // child frames re-packed by this relay
+    uint32_t relay_frames_sent;   // relay frames sent to the parent
+    uint32_t relay_sections_sent; // per-node batches carried by them
+    uint32_t relay_records_sent;  // child and own records carried by them
+    uint32_t relay_passthrough;   // batches too large to re-pack, sent as-is
+    uint32_t credit_deferred;     // leaf: sends refused for lack of credit
+    uint32_t alarms_sent;             // leaf
+    uint32_t alarms_received;         // root
+    uint32_t burst_triggers_received; // leaf
+    uint32_t rejoins;        // leaf: link losses (and the first join) ended
+    uint32_t rejoin_last_ms; // link loss to first record sent upstream
+    uint32_t rejoin_max_ms;
+  } mesh_transport_stats_t;
+
+  // Root-side delivery state for one leaf. Records from aggregated frames
+  // pass through the node's reorder window (dedup + in-order emission); the
+  // ACK sent back is MeshReorderAckRecordId() of that window.
+  typedef struct
+  {
+    pt100_mesh_addr_t node;
+    mesh_reorder_window_t window;
+  } mesh_node_state_t;
+
+  // Root: records released by one window operation, delivered once
+  // node_lock is dropped.
+  typedef struct
+  {
+    log_record_t records[MESH_EMIT_BATCH_RECORDS];
+    uint32_t count;
+  } mesh_emit_batch_t;
+
+  // Root: a probe waiting for the next coalesced TIME_REPLY frame.
+  typedef struct
+  {
+    pt100_mesh_addr_t node;
+    int64_t t1_us;
+    int64_t t2_us;
+  } mesh_time_probe_pending_t;
+
+  // Leaf-side record aggregator. Owned by the single task that queues records
+  // (StorageTask); not safe to use concurrently from several tasks.
+  typedef struct
+  {
+    uint8_t frame[MESH_TRANSPORT_FRAME_MAX_BYTES];
+    mesh_batch_writer_t writer;
+    bool is_open;
+    int64_t opened_us; // esp_timer time of the first queued record
+  } mesh_aggregator_t;
+
+  // Relay-side frame: per-node batch payloads from children and from this
+  // node, sent to the parent when full or MESH_TRANSPORT_RELAY_WINDOW_MS
+  // after the first one. Filled from the Mesh-Lite RX context and the task
+  // owning the aggregator, so guarded by mesh_transport_t.relay_lock.
+  typedef struct
+  {
+    uint8_t frame[MESH_TRANSPORT_FRAME_MAX_BYTES];
+    size_t used; // message header + section count + sections
+    uint8_t section_count;
+    uint32_t record_count;
+    int64_t opened_us;
+  } mesh_relay_t;
+
   typedef struct
   {
     // NOTE: These flags are read/written from multiple tasks (event handler,
@@ -30,7 +193,51 @@ extern "C"
     pt100_mesh_addr_t root_address;
     mesh_record_rx_callback_t record_rx_callback;
     void* record_rx_context;
+    mesh_alarm_rx_callback_t alarm_rx_callback;
+    void* alarm_rx_context;
+    mesh_burst_trigger_callback_t burst_trigger_callback;
+    void* burst_trigger_context;
     const time_sync_t* time_sync; // used for RTC updates on time sync messages
+    mesh_aggregator_t aggregator;
+    mesh_transport_stats_t stats;
+
+    // Relay aggregation (non-root nodes that accept children), allocated in
+    // MeshTransportStart; NULL elsewhere.
+    SemaphoreHandle_t relay_lock;
+    mesh_relay_t* relay;
+
+    // Root: per-node windows, allocated in MeshTransportStart. node_lock
+    // guards the windows only; records they release are copied to
+    // emit_batch and handed to record_rx_callback after it is dropped, with
+    // emit_lock held so they stay in order. Neither the Mesh-Lite RX context
+    // nor the ACK broadcaster waits on a slow callback under node_lock.
+    SemaphoreHandle_t node_lock;
+    SemaphoreHandle_t emit_lock;
+    mesh_node_state_t* nodes; // MESH_TRANSPORT_MAX_NODES entries
+    uint32_t node_count;
+    mesh_emit_batch_t* emit_batch;
+
+    // Leaf: ACK and time-sample mailboxes; root: pending time probes and
+    // requests. All written from the Mesh-Lite RX context.
+    portMUX_TYPE ack_lock;
+    bool ack_pending;
+    uint64_t acked_record_id;
+    uint32_t credit_grant;        // records per minute, from the latest ACK
+    uint32_t credit_tokens_milli; // token bucket filled at credit_grant
+    int64_t credit_refill_us;
+    int64_t link_down_us; // leaf: link lost and no record sent since, else 0
+    int64_t time_probe_t1_us; // outstanding probe, 0 when none
+    bool time_sample_pending;
+    clock_sync_sample_t time_sample;
+    mesh_time_probe_pending_t time_replies[MESH_TRANSPORT_MAX_NODES];
+    uint32_t time_reply_count;
+    bool time_request_pending;
+    int64_t time_request_first_us;
+
+    // Root: records per minute the mesh may send, split over tracked nodes
+    // in each ACK broadcast.
+    uint32_t credit_budget;
+    uint32_t credit_rotor; // which nodes get the remainder of the split
   } mesh_transport_t;
 
   bool MeshTransportIsStarted(const mesh_transport_t* mesh);
@@ -57,6 +264,111 @@ extern "C"
   esp_err_t MeshTransportSendRecord(const mesh_transport_t* mesh,
                                     const log_record_t* record);
 
+  // Leaf nodes: send an alarm event straight to the root in its own message.
+  // Skips the aggregator, relay re-packing and send credits, so it goes out
+  // ahead of any queued record traffic.
+  esp_err_t MeshTransportSendAlarm(mesh_transport_t* mesh,
+                                   const alarm_event_t* event);
+
+  // Root nodes: where received alarm events go. Set after
+  // MeshTransportStart().
+  void MeshTransportSetAlarmCallback(mesh_transport_t* mesh,
+                                     mesh_alarm_rx_callback_t callback,
+                                     void* context);
+
+  // Root nodes: broadcast a burst trigger to one node (target_mac) or, with
+  // NULL, to every node.
+  esp_err_t MeshTransportSendBurstTrigger(mesh_transport_t* mesh,
+                                          const uint8_t* target_mac);
+
+  // Leaf nodes: where burst triggers from the root go.
+  void MeshTransportSetBurstTriggerCallback(
+    mesh_transport_t* mesh,
+    mesh_burst_trigger_callback_t callback,
+    void* context);
+
+  // Leaf nodes: queue a record into the current aggregated frame. The frame is
+  // sent when the next record would exceed MESH_TRANSPORT_FRAME_MAX_BYTES or
+  // when MeshTransportFlushIfDue() sees the latency deadline pass.
+  //
+  // Both send paths spend one credit per record and return
+  // ESP_ERR_NOT_ALLOWED while the node is ahead of the rate the root
+  // granted; the caller keeps the record (FRAM) and retries later.
+  esp_err_t MeshTransportQueueRecord(mesh_transport_t* mesh,
+                                     const log_record_t* record);
+
+  // Sends the pending aggregated frame (if any) immediately, and on relays
+  // the pending relay frame.
+  esp_err_t MeshTransportFlushRecords(mesh_transport_t* mesh);
+
+  // Sends the pending frame if its oldest record has waited at least
+  // MESH_TRANSPORT_AGG_MAX_LATENCY_MS, and a relay frame once its window has
+  // passed. Cheap to call on every loop iteration.
+  esp_err_t MeshTransportFlushIfDue(mesh_transport_t* mesh);
+
+  // Milliseconds until the pending frame (or relay frame) is due, or
+  // UINT32_MAX when there is nothing pending. Used to bound queue waits in the owning task.
+  uint32_t MeshTransportMsUntilFlushDue(const mesh_transport_t* mesh);
+
+  // Leaf nodes: tell the root that records below first_available_record_id
+  // can no longer be replayed (overwritten or unreadable in FRAM), so it can
+  // advance past the gap. Flushes the aggregator first and follows the
+  // record path, so the notice never overtakes records sent before it.
+  esp_err_t MeshTransportSendGap(mesh_transport_t* mesh,
+                                 uint64_t first_available_record_id);
+
+  // Leaf nodes: fetch the latest ACK from the root for this node. Returns true
+  // once per received ACK with the highest contiguous record_id the root holds.
+  bool MeshTransportTakeAck(mesh_transport_t* mesh, uint64_t* acked_out);
+
+  // Root nodes: broadcast the highest contiguous record_id held per node,
+  // together with each node's credit grant for the next ACK period.
+  esp_err_t MeshTransportBroadcastAcks(mesh_transport_t* mesh);
+
+  // Root nodes: records per minute the whole mesh may send (see
+  // mesh_credit.h), split evenly over tracked nodes by the next
+  // MeshTransportBroadcastAcks(). Defaults to MESH_TRANSPORT_CREDIT_UNLIMITED.
+  void MeshTransportSetCreditBudget(mesh_transport_t* mesh,
+                                    uint32_t records_per_min);
+
+  // Leaf nodes: the rate granted by the latest ACK in records per minute,
+  // MESH_TRANSPORT_CREDIT_INITIAL until the root sends one.
+  uint32_t MeshTransportCreditGrant(const mesh_transport_t* mesh);
+
+  // Leaf nodes: mark the upstream link as lost (e.g. from a Wi-Fi
+  // disconnect event). The time until the next record frame goes out is
+  // kept in rejoin_last_ms / rejoin_max_ms. Losses seen through the mesh
+  // level are marked automatically, and so is MeshTransportStart().
+  void MeshTransportNoteLinkDown(mesh_transport_t* mesh);
+
+  // Root nodes: release records held behind a hole for longer than
+  // MESH_TRANSPORT_REORDER_MAX_DELAY_MS. Call periodically (a few Hz).
+  void MeshTransportReorderTick(mesh_transport_t* mesh);
+
+  // Root nodes: reorder statistics summed over all tracked nodes, plus the
+  // number of nodes and records currently buffered.
+  void MeshTransportGetReorderStats(mesh_transport_t* mesh,
+                                    mesh_reorder_stats_t* total_out,
+                                    uint32_t* node_count_out,
+                                    uint32_t* buffered_out);
+
+  // Leaf nodes: start a two-way time exchange with the root. The completed
+  // sample shows up in MeshTransportTakeTimeSample(); an unanswered probe is
+  // simply superseded by the next one.
+  esp_err_t MeshTransportSendTimeProbe(mesh_transport_t* mesh);
+
+  bool MeshTransportTakeTimeSample(mesh_transport_t* mesh,
+                                   clock_sync_sample_t* sample_out);
+
+  // Root nodes: answer every probe received since the last call with one
+  // TIME_REPLY broadcast (chunked when needed). Call every ~100 ms.
+  esp_err_t MeshTransportFlushTimeReplies(mesh_transport_t* mesh);
+
+  // Root nodes: true once when legacy TIME_REQUESTs are pending and the
+  // first of them is at least window_us old; the caller then sends one
+  // MeshTransportBroadcastTime() for all of them.
+  bool MeshTransportTakeTimeRequests(mesh_transport_t* mesh, int64_t window_us);
+
   // Root nodes: broadcast time to all known nodes.
   esp_err_t MeshTransportBroadcastTime(const mesh_transport_t* mesh,
                                        int64_t epoch_seconds);
@@ -0,0 +1,151 @@
+#include "node_table.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void
+NodeTableInit(node_table_t* table)
+{
+  if (table == NULL) {
+    return;
+  }
+  memset(table->entries, 0, sizeof(table->entries));
+  table->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  table->intern_failures = 0;
+  table->records_refused = 0;
+  table->refused_count = 0;
+  atomic_store_explicit(&table->count, 0u, memory_order_release);
+}
+
+// Index of addr among entries [start, count), or count when absent.
+static uint32_t
+FindEntry(const node_table_t* table,
+          const pt100_mesh_addr_t* addr,
+          uint32_t start,
+          uint32_t count)
+{
+  for (uint32_t index = start; index < count; ++index) {
+    if (memcmp(&table->entries[index].addr, addr, sizeof(*addr)) == 0) {
+      return index;
+    }
+  }
+  return count;
+}
+
+esp_err_t
+NodeTableIntern(node_table_t* table,
+                const pt100_mesh_addr_t* addr,
+                uint8_t* index_out)
+{
+  if (table == NULL || addr == NULL || index_out == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint32_t seen =
+    atomic_load_explicit(&table->count, memory_order_acquire);
+  const uint32_t found = FindEntry(table, addr, 0, seen);
+  if (found < seen) {
+    *index_out = (uint8_t)found;
+    return ESP_OK;
+  }
+
+  // Formatted before the lock, which masks interrupts.
+  char id_string[NODE_TABLE_ID_STRING_LEN];
+  snprintf(id_string,
+           sizeof(id_string),
+           "%02X:%02X:%02X:%02X:%02X:%02X",
+           addr->addr[0],
+           addr->addr[1],
+           addr->addr[2],
+           addr->addr[3],
+           addr->addr[4],
+           addr->addr[5]);
+
+  esp_err_t result = ESP_OK;
+  portENTER_CRITICAL(&table->lock);
+  // Another context may have added addr since the lock-free look.
+  const uint32_t count =
+    atomic_load_explicit(&table->count, memory_order_relaxed);
+  const uint32_t index = FindEntry(table, addr, seen, count);
+  if (index == count) {
+    if (count >= NODE_TABLE_MAX_NODES) {
+      table->intern_failures++;
+      result = ESP_ERR_NO_MEM;
+    } else {
+      node_table_entry_t* entry = &table->entries[count];
+      memset(entry, 0, sizeof(*entry));
+      entry->addr = *addr;
+      memcpy(entry->id_string, id_string, sizeof(entry->id_string));
+      // Publish only after the entry is complete.
+      atomic_store_explicit(&table->count, count + 1u, memory_order_release);
+    }
+  }
+  portEXIT_CRITICAL(&table->lock);
+  if (result == ESP_OK) {
+    *index_out = (uint8_t)index;
+  }
+  return result;
+}
+
+bool
+NodeTableNoteRefused(node_table_t* table, const pt100_mesh_addr_t* addr)
+{
+  if (table == NULL || addr == NULL) {
+    return false;
+  }
+  bool first = true;
+  portENTER_CRITICAL(&table->lock);
+  table->records_refused++;
+  for (uint32_t index = 0; index < table->refused_count; ++index) {
+    if (memcmp(&table->refused[index], addr, sizeof(*addr)) == 0) {
+      first = false;
+      break;
+    }
+  }
+  if (first && table->refused_count >= NODE_TABLE_MAX_REFUSED) {
+    first = false;
+  }
+  if (first) {
+    table->refused[table->refused_count++] = *addr;
+  }
+  portEXIT_CRITICAL(&table->lock);
+  return first;
+}
+
+uint32_t
+NodeTableCount(const node_table_t* table)
+{
+  if (table == NULL) {
+    return 0;
+  }
+  return atomic_load_explicit(&((node_table_t*)table)->count,
+                              memory_order_acquire);
+}
+
+const node_table_entry_t*
+NodeTableGet(const node_table_t* table, uint8_t index)
+{
+  if (index >= NodeTableCount(table)) {
+    return NULL;
+  }
+  return &table->entries[index];
+}
+
+void
+NodeTableNoteRecord(node_table_t* table,
+                    uint8_t index,
+                    const log_record_t* record,
+                    bool dropped,
+                    int64_t now_us)
+{
+  if (record == NULL || index >= NodeTableCount(table)) {
+    return;
+  }
+  node_table_entry_t* entry = &table->entries[index];
+  if (dropped) {
+    entry->records_dropped++;
+  } else {
+    entry->records++;
+  }
+  entry->last_record_id = record->record_id;
+  entry->last_seen_us = now_us;
+}
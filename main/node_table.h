@@ -0,0 +1,85 @@
+#ifndef PT100_LOGGER_NODE_TABLE_H_
+#define PT100_LOGGER_NODE_TABLE_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "log_record.h"
+#include "mesh_addr.h"
+#include "mesh_transport.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Local node plus every leaf the root can track.
+#define NODE_TABLE_MAX_NODES (MESH_TRANSPORT_MAX_NODES + 1)
+#define NODE_TABLE_ID_STRING_LEN 18 // "AA:BB:CC:DD:EE:FF" + NUL
+// Senders refused for a full table that are remembered, so each is logged
+// once.
+#define NODE_TABLE_MAX_REFUSED 16
+
+  // Interned node: MAC -> small index, so per-record paths carry one byte
+  // instead of a formatted node id.
+  typedef struct
+  {
+    pt100_mesh_addr_t addr;
+    char id_string[NODE_TABLE_ID_STRING_LEN];
+    uint32_t records; // records handed to the export ring
+    uint32_t records_dropped;
+    uint64_t last_record_id;
+    int64_t last_seen_us; // esp_timer time of the latest record
+  } node_table_entry_t;
+
+  // Append-only. Senders are interned from several contexts (the mesh RX
+  // callbacks and the root's reorder tick), so appends and the refused list
+  // are serialized by lock. Readers only look at entries below the
+  // published count, so lookups never lock.
+  typedef struct
+  {
+    node_table_entry_t entries[NODE_TABLE_MAX_NODES];
+    atomic_uint count;
+    portMUX_TYPE lock;
+    uint32_t intern_failures;
+    // Records dropped because their sender did not fit, and the first
+    // NODE_TABLE_MAX_REFUSED such senders. Written under lock.
+    uint32_t records_refused;
+    pt100_mesh_addr_t refused[NODE_TABLE_MAX_REFUSED];
+    uint32_t refused_count;
+  } node_table_t;
+
+  void NodeTableInit(node_table_t* table);
+
+  // Returns the index for addr, adding it when unknown. ESP_ERR_NO_MEM when
+  // the table is full.
+  esp_err_t NodeTableIntern(node_table_t* table,
+                            const pt100_mesh_addr_t* addr,
+                            uint8_t* index_out);
+
+  // Counts a record dropped because NodeTableIntern() refused addr. true the
+  // first time addr is refused (for up to NODE_TABLE_MAX_REFUSED senders),
+  // so the caller logs each node once.
+  bool NodeTableNoteRefused(node_table_t* table, const pt100_mesh_addr_t* addr);
+
+  uint32_t NodeTableCount(const node_table_t* table);
+
+  // NULL when index is not (yet) published.
+  const node_table_entry_t* NodeTableGet(const node_table_t* table,
+                                         uint8_t index);
+
+  // Per-node counters; called by the producer that owns the index.
+  void NodeTableNoteRecord(node_table_t* table,
+                           uint8_t index,
+                           const log_record_t* record,
+                           bool dropped,
+                           int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_NODE_TABLE_H_
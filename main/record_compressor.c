@@ -0,0 +1,208 @@
+#include "record_compressor.h"
+
+#include <string.h>
+
+// A change in any of these always starts a new segment.
+static const uint16_t kStateFlags = LOG_RECORD_FLAG_TIME_VALID |
+                                    LOG_RECORD_FLAG_CAL_VALID |
+                                    LOG_RECORD_FLAG_SENSOR_FAULT;
+
+void
+RecordCompressionConfigInitDefault(record_compression_config_t* config)
+{
+  if (config == NULL) {
+    return;
+  }
+  memset(config, 0, sizeof(*config));
+  config->mode = RECORD_COMPRESSION_OFF;
+  config->error_milli_c = 20;
+  config->heartbeat_ms = 15u * 60u * 1000u;
+}
+
+bool
+RecordCompressionConfigIsValid(const record_compression_config_t* config)
+{
+  if (config == NULL || config->mode > RECORD_COMPRESSION_SWINGING_DOOR) {
+    return false;
+  }
+  return config->mode == RECORD_COMPRESSION_OFF ||
+         (config->error_milli_c > 0 && config->heartbeat_ms >= 1000u);
+}
+
+const char*
+RecordCompressionModeToString(uint8_t mode)
+{
+  switch (mode) {
+    case RECORD_COMPRESSION_OFF:
+      return "off";
+    case RECORD_COMPRESSION_DEADBAND:
+      return "deadband";
+    case RECORD_COMPRESSION_SWINGING_DOOR:
+      return "sdt";
+    default:
+      return "unknown";
+  }
+}
+
+void
+RecordCompressorInit(record_compressor_t* compressor,
+                     const record_compression_config_t* config)
+{
+  if (compressor == NULL) {
+    return;
+  }
+  memset(compressor, 0, sizeof(*compressor));
+  if (RecordCompressionConfigIsValid(config)) {
+    compressor->config = *config;
+  } else {
+    RecordCompressionConfigInitDefault(&compressor->config);
+  }
+}
+
+static void
+Keep(record_compressor_t* compressor,
+     const log_record_t* record,
+     int64_t mono_ms,
+     log_record_t* out,
+     size_t* count)
+{
+  out[*count] = *record;
+  out[*count].flags |= LOG_RECORD_FLAG_COMPRESSED;
+  (*count)++;
+  compressor->archive = *record;
+  compressor->archive_ms = mono_ms;
+  compressor->have_archive = true;
+  compressor->stats.out++;
+}
+
+// a / b > c / d for b, d > 0.
+static bool
+SlopeGreater(int64_t a, int64_t b, int64_t c, int64_t d)
+{
+  return a * d > c * b;
+}
+
+// Lines from the last kept record that pass within half the error of every
+// record since. The half leaves room for the kept end record itself being
+// off the best line by up to that much, so interpolating between kept
+// records stays within the full error. The first record sets both slopes.
+static void
+OpenDoor(record_compressor_t* compressor,
+         const log_record_t* record,
+         int64_t mono_ms)
+{
+  const int64_t dt = (mono_ms > compressor->archive_ms)
+                       ? mono_ms - compressor->archive_ms
+                       : 1;
+  const int64_t dv =
+    (int64_t)record->temp_milli_c - compressor->archive.temp_milli_c;
+  const int64_t half_error = compressor->config.error_milli_c / 2;
+  compressor->upper_num = dv - half_error;
+  compressor->upper_den = dt;
+  compressor->lower_num = dv + half_error;
+  compressor->lower_den = dt;
+}
+
+// Narrows the door with one more record; false once no line fits every
+// record since the last kept one.
+static bool
+NarrowDoor(record_compressor_t* compressor,
+           const log_record_t* record,
+           int64_t mono_ms)
+{
+  const int64_t dt = (mono_ms > compressor->archive_ms)
+                       ? mono_ms - compressor->archive_ms
+                       : 1;
+  const int64_t dv =
+    (int64_t)record->temp_milli_c - compressor->archive.temp_milli_c;
+  const int64_t half_error = compressor->config.error_milli_c / 2;
+  const int64_t upper = dv - half_error;
+  const int64_t lower = dv + half_error;
+  if (SlopeGreater(upper, dt, compressor->upper_num, compressor->upper_den)) {
+    compressor->upper_num = upper;
+    compressor->upper_den = dt;
+  }
+  if (SlopeGreater(compressor->lower_num, compressor->lower_den, lower, dt)) {
+    compressor->lower_num = lower;
+    compressor->lower_den = dt;
+  }
+  return !SlopeGreater(compressor->upper_num,
+                       compressor->upper_den,
+                       compressor->lower_num,
+                       compressor->lower_den);
+}
+
+size_t
+RecordCompressorPush(record_compressor_t* compressor,
+                     const log_record_t* record,
+                     int64_t mono_ms,
+                     log_record_t out[RECORD_COMPRESSION_MAX_OUT])
+{
+  if (compressor == NULL || record == NULL || out == NULL) {
+    return 0;
+  }
+  compressor->stats.in++;
+  size_t count = 0;
+  if (compressor->config.mode == RECORD_COMPRESSION_OFF) {
+    out[count++] = *record;
+    compressor->stats.out++;
+    return count;
+  }
+
+  const bool state_changed =
+    !compressor->have_archive ||
+    ((record->flags ^ compressor->archive.flags) & kStateFlags) != 0 ||
+    (record->flags & LOG_RECORD_FLAG_SENSOR_FAULT) != 0;
+  if (state_changed) {
+    if (compressor->have_held) {
+      Keep(compressor, &compressor->held, compressor->held_ms, out, &count);
+      compressor->have_held = false;
+    }
+    Keep(compressor, record, mono_ms, out, &count);
+    return count;
+  }
+
+  if (compressor->config.mode == RECORD_COMPRESSION_SWINGING_DOOR) {
+    if (!compressor->have_held) {
+      OpenDoor(compressor, record, mono_ms);
+    } else if (!NarrowDoor(compressor, record, mono_ms)) {
+      Keep(compressor, &compressor->held, compressor->held_ms, out, &count);
+      OpenDoor(compressor, record, mono_ms);
+    }
+  } else {
+    const int64_t dv =
+      (int64_t)record->temp_milli_c - compressor->archive.temp_milli_c;
+    if (dv > compressor->config.error_milli_c ||
+        -dv > compressor->config.error_milli_c) {
+      if (compressor->have_held) {
+        Keep(compressor, &compressor->held, compressor->held_ms, out, &count);
+      }
+      Keep(compressor, record, mono_ms, out, &count);
+      compressor->have_held = false;
+      return count;
+    }
+  }
+  compressor->held = *record;
+  compressor->held_ms = mono_ms;
+  compressor->have_held = true;
+
+  if (mono_ms - compressor->archive_ms >=
+      (int64_t)compressor->config.heartbeat_ms) {
+    Keep(compressor, record, mono_ms, out, &count);
+    compressor->have_held = false;
+    compressor->stats.heartbeats++;
+  }
+  return count;
+}
+
+bool
+RecordCompressorFlush(record_compressor_t* compressor, log_record_t* out)
+{
+  if (compressor == NULL || out == NULL || !compressor->have_held) {
+    return false;
+  }
+  size_t count = 0;
+  Keep(compressor, &compressor->held, compressor->held_ms, out, &count);
+  compressor->have_held = false;
+  return true;
+}
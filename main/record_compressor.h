@@ -0,0 +1,100 @@
+#ifndef PT100_LOGGER_RECORD_COMPRESSOR_H_
+#define PT100_LOGGER_RECORD_COMPRESSOR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log_record.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Drops records that a straight line between their neighbours reproduces,
+// one compressor per RTD channel, between the sensor task and storage.
+// Records it lets through carry LOG_RECORD_FLAG_COMPRESSED so host tools
+// interpolate between them instead of treating the gap as missing data.
+//
+// - Swinging door: drops records while a line from the last kept record
+//   still fits all of them; linear interpolation between the kept records
+//   reproduces every dropped one within error_milli_c.
+// - Deadband: keeps a record once it moves more than error_milli_c from
+//   the last kept one, plus the record before it so the step is not
+//   smeared across the gap. Holding the last kept value reproduces the
+//   dropped ones within error_milli_c.
+//
+// Either way a record is kept at least every heartbeat_ms, and every
+// record whose fault, calibration or time-valid flag differs from the last
+// kept one is kept.
+
+#define RECORD_COMPRESSION_MAX_OUT 2 // records one push can release
+
+  typedef enum
+  {
+    RECORD_COMPRESSION_OFF = 0,
+    RECORD_COMPRESSION_DEADBAND = 1,
+    RECORD_COMPRESSION_SWINGING_DOOR = 2,
+  } record_compression_mode_t;
+
+  typedef struct
+  {
+    uint8_t mode; // record_compression_mode_t
+    int32_t error_milli_c;
+    uint32_t heartbeat_ms;
+  } record_compression_config_t;
+
+  typedef struct
+  {
+    uint32_t in;
+    uint32_t out;
+    uint32_t heartbeats; // kept only because heartbeat_ms elapsed
+  } record_compression_stats_t;
+
+  typedef struct
+  {
+    record_compression_config_t config;
+    bool have_archive; // last kept record
+    log_record_t archive;
+    int64_t archive_ms;
+    bool have_held; // newest record, not kept (yet)
+    log_record_t held;
+    int64_t held_ms;
+    // Swinging door: steepest lower and flattest upper slope so far, in
+    // milli-°C per ms as num / den with den > 0.
+    int64_t lower_num;
+    int64_t lower_den;
+    int64_t upper_num;
+    int64_t upper_den;
+    record_compression_stats_t stats;
+  } record_compressor_t;
+
+  void RecordCompressionConfigInitDefault(record_compression_config_t* config);
+
+  bool RecordCompressionConfigIsValid(
+    const record_compression_config_t* config);
+
+  const char* RecordCompressionModeToString(uint8_t mode);
+
+  // Clears state and stats; an invalid config turns compression off.
+  void RecordCompressorInit(record_compressor_t* compressor,
+                            const record_compression_config_t* config);
+
+  // Feeds the channel's next record; mono_ms is a monotonic clock. Writes
+  // the records to store now (oldest first) and returns how many.
+  size_t RecordCompressorPush(record_compressor_t* compressor,
+                              const log_record_t* record,
+                              int64_t mono_ms,
+                              log_record_t out[RECORD_COMPRESSION_MAX_OUT]);
+
+  // Releases the record still held back (e.g. when logging stops). Returns
+  // false when there is none.
+  bool RecordCompressorFlush(record_compressor_t* compressor,
+                             log_record_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_RECORD_COMPRESSOR_H_
@@ -0,0 +1,228 @@
+#include "record_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+
+static const uint32_t kMinCapacity = 64;
+
+static uint32_t
+RoundDownPowerOfTwo(uint32_t value)
+{
+  uint32_t result = 1;
+  while (result <= value / 2u) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// Oldest position still needed by an attached consumer; head when none.
+static uint32_t
+OldestTail(const record_ring_t* ring, uint32_t head)
+{
+  uint32_t oldest_distance = 0;
+  for (uint32_t index = 0; index < RECORD_RING_MAX_CONSUMERS; ++index) {
+    if (!atomic_load_explicit(
+          (atomic_bool*)&ring->consumer_active[index], memory_order_acquire)) {
+      continue;
+    }
+    const uint32_t tail = atomic_load_explicit(
+      (atomic_uint*)&ring->consumer_tail[index], memory_order_acquire);
+    const uint32_t distance = head - tail;
+    if (distance > oldest_distance) {
+      oldest_distance = distance;
+    }
+  }
+  return head - oldest_distance;
+}
+
+esp_err_t
+RecordRingInit(record_ring_t* ring, uint32_t requested_capacity)
+{
+  if (ring == NULL || requested_capacity < kMinCapacity) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(ring, 0, sizeof(*ring));
+
+  uint32_t capacity = RoundDownPowerOfTwo(requested_capacity);
+  while (capacity >= kMinCapacity) {
+    ring->slots = (record_ring_slot_t*)heap_caps_calloc(
+      capacity, sizeof(record_ring_slot_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ring->slots != NULL) {
+      ring->in_psram = true;
+      break;
+    }
+    ring->slots =
+      (record_ring_slot_t*)calloc(capacity, sizeof(record_ring_slot_t));
+    if (ring->slots != NULL) {
+      break;
+    }
+    capacity /= 2u;
+  }
+  if (ring->slots == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  ring->capacity = capacity;
+  // Position 0 must not look published in a zeroed slot, so start at 1.
+  atomic_store_explicit(&ring->reserve_head, 1u, memory_order_release);
+  return ESP_OK;
+}
+
+void
+RecordRingDeinit(record_ring_t* ring)
+{
+  if (ring == NULL) {
+    return;
+  }
+  free(ring->slots);
+  memset(ring, 0, sizeof(*ring));
+}
+
+esp_err_t
+RecordRingAttachConsumer(record_ring_t* ring, uint32_t* id_out)
+{
+  if (ring == NULL || ring->slots == NULL || id_out == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  for (uint32_t index = 0; index < RECORD_RING_MAX_CONSUMERS; ++index) {
+    bool expected = false;
+    // Claim the id before it becomes visible to producers.
+    if (atomic_load_explicit(&ring->consumer_active[index],
+                             memory_order_acquire)) {
+      continue;
+    }
+    atomic_store_explicit(
+      &ring->consumer_tail[index],
+      atomic_load_explicit(&ring->reserve_head, memory_order_acquire),
+      memory_order_release);
+    if (atomic_compare_exchange_strong(
+          &ring->consumer_active[index], &expected, true)) {
+      *id_out = index;
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NO_MEM;
+}
+
+void
+RecordRingDetachConsumer(record_ring_t* ring, uint32_t consumer_id)
+{
+  if (ring == NULL || consumer_id >= RECORD_RING_MAX_CONSUMERS) {
+    return;
+  }
+  atomic_store_explicit(
+    &ring->consumer_active[consumer_id], false, memory_order_release);
+}
+
+esp_err_t
+RecordRingPush(record_ring_t* ring,
+               uint8_t node_index,
+               const log_record_t* record)
+{
+  if (ring == NULL || ring->slots == NULL || record == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  uint32_t head =
+    atomic_load_explicit(&ring->reserve_head, memory_order_relaxed);
+  uint32_t used = 0;
+  do {
+    used = head - OldestTail(ring, head);
+    if (used >= ring->capacity) {
+      atomic_fetch_add_explicit(&ring->dropped, 1u, memory_order_relaxed);
+      return ESP_ERR_NO_MEM;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(&ring->reserve_head,
+                                                  &head,
+                                                  head + 1u,
+                                                  memory_order_acq_rel,
+                                                  memory_order_relaxed));
+
+  record_ring_slot_t* slot = &ring->slots[head & (ring->capacity - 1u)];
+  slot->item.record = *record;
+  slot->item.node_index = node_index;
+  atomic_store_explicit(&slot->published, head + 1u, memory_order_release);
+
+  uint32_t high_water =
+    atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+  while (used + 1u > high_water &&
+         !atomic_compare_exchange_weak_explicit(&ring->high_water,
+                                                &high_water,
+                                                used + 1u,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+  }
+  return ESP_OK;
+}
+
+bool
+RecordRingPop(record_ring_t* ring,
+              uint32_t consumer_id,
+              record_ring_item_t* item_out)
+{
+  if (ring == NULL || ring->slots == NULL || item_out == NULL ||
+      consumer_id >= RECORD_RING_MAX_CONSUMERS) {
+    return false;
+  }
+  const uint32_t tail = atomic_load_explicit(&ring->consumer_tail[consumer_id],
+                                             memory_order_relaxed);
+  const record_ring_slot_t* slot = &ring->slots[tail & (ring->capacity - 1u)];
+  if (atomic_load_explicit((atomic_uint*)&slot->published,
+                           memory_order_acquire) != tail + 1u) {
+    return false;
+  }
+  *item_out = slot->item;
+  atomic_store_explicit(
+    &ring->consumer_tail[consumer_id], tail + 1u, memory_order_release);
+  return true;
+}
+
+uint32_t
+RecordRingPending(const record_ring_t* ring, uint32_t consumer_id)
+{
+  if (ring == NULL || ring->slots == NULL ||
+      consumer_id >= RECORD_RING_MAX_CONSUMERS) {
+    return 0;
+  }
+  const uint32_t head = atomic_load_explicit(
+    (atomic_uint*)&ring->reserve_head, memory_order_acquire);
+  const uint32_t tail = atomic_load_explicit(
+    (atomic_uint*)&ring->consumer_tail[consumer_id], memory_order_acquire);
+  return head - tail;
+}
+
+void
+RecordRingOccupancy(const record_ring_t* ring,
+                    uint32_t* used_out,
+                    uint32_t* oldest_tail_out)
+{
+  uint32_t used = 0;
+  uint32_t tail = 0;
+  if (ring != NULL && ring->slots != NULL) {
+    const uint32_t head = atomic_load_explicit(
+      (atomic_uint*)&ring->reserve_head, memory_order_acquire);
+    tail = OldestTail(ring, head);
+    used = head - tail;
+  }
+  if (used_out != NULL) {
+    *used_out = used;
+  }
+  if (oldest_tail_out != NULL) {
+    *oldest_tail_out = tail;
+  }
+}
+
+void
+RecordRingReset(record_ring_t* ring)
+{
+  if (ring == NULL || ring->slots == NULL) {
+    return;
+  }
+  const uint32_t head =
+    atomic_load_explicit(&ring->reserve_head, memory_order_acquire);
+  for (uint32_t index = 0; index < RECORD_RING_MAX_CONSUMERS; ++index) {
+    atomic_store_explicit(
+      &ring->consumer_tail[index], head, memory_order_release);
+  }
+}
@@ -0,0 +1,92 @@
+#ifndef PT100_LOGGER_RECORD_RING_H_
+#define PT100_LOGGER_RECORD_RING_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "log_record.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define RECORD_RING_MAX_CONSUMERS 4
+
+  typedef struct
+  {
+    log_record_t record;
+    uint8_t node_index; // node_table_t index of the originating node
+  } record_ring_item_t;
+
+  typedef struct
+  {
+    atomic_uint published; // ring position + 1 once item is written
+    record_ring_item_t item;
+  } record_ring_slot_t;
+
+  // Bounded multi-producer ring with independent consumer cursors (fan-out):
+  // every attached consumer sees every record, and a slot is reused only
+  // after all attached consumers moved past it.
+  //
+  // Producers reserve a position with a CAS on reserve_head, fill the slot,
+  // then publish it; no locks and no FreeRTOS calls, so pushing is safe from
+  // the Mesh-Lite RX context. The slot array may live in PSRAM (it only sees
+  // plain loads/stores); the CAS target stays in this struct, which callers
+  // keep in internal RAM.
+  typedef struct
+  {
+    record_ring_slot_t* slots;
+    uint32_t capacity; // power of two
+    atomic_uint reserve_head;
+    atomic_uint consumer_tail[RECORD_RING_MAX_CONSUMERS];
+    atomic_bool consumer_active[RECORD_RING_MAX_CONSUMERS];
+    atomic_uint dropped;
+    atomic_uint high_water;
+    bool in_psram;
+  } record_ring_t;
+
+  // Allocates at most requested_capacity slots (rounded down to a power of
+  // two), preferring PSRAM and shrinking when memory is short.
+  esp_err_t RecordRingInit(record_ring_t* ring, uint32_t requested_capacity);
+
+  void RecordRingDeinit(record_ring_t* ring);
+
+  // Attaches a consumer starting at the current head.
+  esp_err_t RecordRingAttachConsumer(record_ring_t* ring, uint32_t* id_out);
+
+  void RecordRingDetachConsumer(record_ring_t* ring, uint32_t consumer_id);
+
+  // Returns ESP_ERR_NO_MEM (and counts a drop) when the slowest consumer is a
+  // full ring behind.
+  esp_err_t RecordRingPush(record_ring_t* ring,
+                           uint8_t node_index,
+                           const log_record_t* record);
+
+  // Copies the consumer's next item out and advances its cursor. False when
+  // nothing is published yet. Each consumer id must have a single reader.
+  bool RecordRingPop(record_ring_t* ring,
+                     uint32_t consumer_id,
+                     record_ring_item_t* item_out);
+
+  // Items reserved but not yet consumed by consumer_id.
+  uint32_t RecordRingPending(const record_ring_t* ring, uint32_t consumer_id);
+
+  // Slots held for the slowest attached consumer (what makes pushes fail),
+  // and that consumer's absolute position; the difference between two
+  // positions is the number of slots freed in between.
+  void RecordRingOccupancy(const record_ring_t* ring,
+                           uint32_t* used_out,
+                           uint32_t* oldest_tail_out);
+
+  // Moves every attached consumer to the head. Only call while producers are
+  // quiescent (runtime stopped).
+  void RecordRingReset(record_ring_t* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_RECORD_RING_H_
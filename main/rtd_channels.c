@@ -0,0 +1,156 @@
+#include "rtd_channels.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char* kTag = "rtd_channels";
+
+static void
+AddExtraChannel(rtd_channels_t* channels,
+                spi_host_device_t host,
+                int cs_gpio)
+{
+  if (channels->count >= RTD_CHANNELS_MAX) {
+    ESP_LOGW(kTag,
+             "CS GPIO %d ignored: at most %d channels",
+             cs_gpio,
+             RTD_CHANNELS_MAX);
+    return;
+  }
+  for (uint8_t i = 0; i < channels->count; ++i) {
+    if (channels->readers[i]->cs_gpio == cs_gpio) {
+      ESP_LOGW(kTag, "CS GPIO %d listed twice; ignored", cs_gpio);
+      return;
+    }
+  }
+  max31865_reader_t* reader = &channels->extra[channels->count - 1u];
+  esp_err_t result = Max31865ReaderInit(reader, host, cs_gpio);
+  if (result != ESP_OK) {
+    ESP_LOGW(kTag,
+             "channel %u (CS GPIO %d) init failed: %s",
+             (unsigned)channels->count,
+             cs_gpio,
+             esp_err_to_name(result));
+    return;
+  }
+  channels->readers[channels->count] = reader;
+  channels->count++;
+}
+
+esp_err_t
+RtdChannelsInit(rtd_channels_t* channels,
+                max31865_reader_t* primary,
+                spi_host_device_t host,
+                const char* extra_cs_list)
+{
+  if (channels == NULL || primary == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(channels, 0, sizeof(*channels));
+  channels->readers[0] = primary;
+  channels->count = 1;
+
+  const char* cursor = (extra_cs_list != NULL) ? extra_cs_list : "";
+  while (*cursor != '\0') {
+    char* end = NULL;
+    const long gpio = strtol(cursor, &end, 10);
+    if (end == cursor) {
+      ESP_LOGW(kTag, "bad CS GPIO list near \"%s\"", cursor);
+      break;
+    }
+    if (gpio >= 0) {
+      AddExtraChannel(channels, host, (int)gpio);
+    }
+    cursor = end;
+    while (*cursor == ',' || *cursor == ' ') {
+      cursor++;
+    }
+  }
+  if (channels->count > 1) {
+    ESP_LOGI(kTag, "%u RTD channels", (unsigned)channels->count);
+  }
+  return ESP_OK;
+}
+
+esp_err_t
+RtdChannelsStartContinuous(rtd_channels_t* channels)
+{
+  if (channels == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  esp_err_t first_error = ESP_OK;
+  for (uint8_t i = 0; i < channels->count; ++i) {
+    esp_err_t result = Max31865StartContinuous(channels->readers[i]);
+    if (result != ESP_OK && first_error == ESP_OK) {
+      first_error = result;
+    }
+  }
+  return first_error;
+}
+
+void
+RtdChannelsStopContinuous(rtd_channels_t* channels)
+{
+  if (channels == NULL) {
+    return;
+  }
+  for (uint8_t i = 0; i < channels->count; ++i) {
+    (void)Max31865StopContinuous(channels->readers[i]);
+  }
+}
+
+void
+RtdChannelsRead(rtd_channels_t* channels,
+                max31865_sample_t* samples_out,
+                esp_err_t* results_out)
+{
+  if (channels == NULL || samples_out == NULL || results_out == NULL) {
+    return;
+  }
+  const int64_t start_us = esp_timer_get_time();
+  const uint8_t count = channels->count;
+
+  if (count == 1) {
+    results_out[0] = Max31865ReadOnce(channels->readers[0], &samples_out[0]);
+  } else {
+    // Chips in auto-convert skip Begin/Trigger; their latest free-running
+    // conversion is read in the last pass.
+    uint32_t settle_ms = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+      max31865_reader_t* reader = channels->readers[i];
+      if (reader->continuous) {
+        results_out[i] = ESP_OK;
+        continue;
+      }
+      results_out[i] = Max31865OneShotBegin(reader);
+      if (reader->bias_settle_ms > settle_ms) {
+        settle_ms = reader->bias_settle_ms;
+      }
+    }
+    if (settle_ms > 0) {
+      vTaskDelay(pdMS_TO_TICKS(settle_ms));
+    }
+    for (uint8_t i = 0; i < count; ++i) {
+      if (!channels->readers[i]->continuous && results_out[i] == ESP_OK) {
+        results_out[i] = Max31865OneShotTrigger(channels->readers[i]);
+      }
+    }
+    for (uint8_t i = 0; i < count; ++i) {
+      max31865_reader_t* reader = channels->readers[i];
+      if (results_out[i] != ESP_OK) {
+        continue;
+      }
+      results_out[i] = reader->continuous
+                         ? Max31865ReadContinuous(reader, &samples_out[i])
+                         : Max31865OneShotFinish(reader, &samples_out[i]);
+    }
+  }
+
+  channels->cycles++;
+  channels->last_cycle_us = (int32_t)(esp_timer_get_time() - start_us);
+}
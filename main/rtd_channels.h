@@ -0,0 +1,57 @@
+#ifndef PT100_LOGGER_RTD_CHANNELS_H_
+#define PT100_LOGGER_RTD_CHANNELS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/spi_master.h"
+#include "esp_err.h"
+#include "max31865_reader.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Channel ids fit the 4-bit channel field of log_record_t flags; keep the
+// count small enough that one pipelined cycle stays near a single read.
+#define RTD_CHANNELS_MAX 8
+
+  // Several MAX31865 boards on one SPI bus, one chip select each. A read
+  // converts all of them at once: bias on every chip, one settle delay,
+  // trigger every chip, then collect the results in turn. A cycle costs
+  // about one conversion plus a short SPI burst per channel, so N channels
+  // sample close to N times the single-channel rate.
+  typedef struct
+  {
+    max31865_reader_t* readers[RTD_CHANNELS_MAX]; // [0] = primary
+    max31865_reader_t extra[RTD_CHANNELS_MAX - 1];
+    uint8_t count;
+    uint32_t cycles;
+    int32_t last_cycle_us; // duration of the last RtdChannelsRead()
+  } rtd_channels_t;
+
+  // primary is the already-initialized channel 0 reader. extra_cs_list is
+  // a comma-separated list of chip selects for channels 1.. (may be empty);
+  // each is initialized on host with the primary's Kconfig settings.
+  // Channels that fail to initialize are skipped with a warning.
+  esp_err_t RtdChannelsInit(rtd_channels_t* channels,
+                            max31865_reader_t* primary,
+                            spi_host_device_t host,
+                            const char* extra_cs_list);
+
+  // Starts/stops auto-convert on every channel.
+  esp_err_t RtdChannelsStartContinuous(rtd_channels_t* channels);
+  void RtdChannelsStopContinuous(rtd_channels_t* channels);
+
+  // Reads every channel. samples_out and results_out need count entries;
+  // results_out[i] is that channel's read result.
+  void RtdChannelsRead(rtd_channels_t* channels,
+                       max31865_sample_t* samples_out,
+                       esp_err_t* results_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_RTD_CHANNELS_H_
@@ -0,0 +1,32 @@
+#include "rtd_lut.h"
+
+#include <math.h>
+
+uint64_t
+RtdLutCodeScale(double rref_ohm, double r0_ohm)
+{
+  if (rref_ohm <= 0.0 || r0_ohm <= 0.0) {
+    return 0;
+  }
+  // steps = code / 2^15 * Rref / R0 * 2^STEP_SHIFT, kept in Q32.
+  return (uint64_t)llround(ldexp(rref_ohm / r0_ohm,
+                                 RTD_LUT_STEP_SHIFT + 32 - 15));
+}
+
+int32_t
+RtdLutCodeToMilliC(uint16_t adc_code, uint64_t code_scale)
+{
+  const int64_t position = (int64_t)((uint64_t)adc_code * code_scale) -
+                           ((int64_t)RTD_LUT_FIRST_STEP << 32);
+  if (position <= 0) {
+    return kRtdLutMilliC[0];
+  }
+  const uint64_t index = (uint64_t)position >> 32;
+  if (index >= RTD_LUT_LENGTH - 1u) {
+    return kRtdLutMilliC[RTD_LUT_LENGTH - 1u];
+  }
+  const int64_t fraction_q16 = (int64_t)(((uint64_t)position >> 16) & 0xFFFFu);
+  const int32_t low = kRtdLutMilliC[index];
+  const int32_t high = kRtdLutMilliC[index + 1u];
+  return low + (int32_t)(((int64_t)(high - low) * fraction_q16 + 0x8000) >> 16);
+}
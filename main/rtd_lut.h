@@ -0,0 +1,35 @@
+#ifndef PT100_LOGGER_RTD_LUT_H_
+#define PT100_LOGGER_RTD_LUT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Inverse RTD table (IEC 60751 Callendar-Van Dusen) on a grid uniform in
+// R/R0, so one table serves PT100, PT500 and PT1000 with any Rref: entry i
+// is the temperature in milli-°C at
+//   R/R0 = (RTD_LUT_FIRST_STEP + i) / 2^RTD_LUT_STEP_SHIFT.
+// kRtdLutMilliC is generated at build time from these values by
+// host_tools/rtd_lut/gen_rtd_lut.py; change them here only.
+#define RTD_LUT_STEP_SHIFT 7
+#define RTD_LUT_FIRST_STEP 23 // R/R0 = 0.180, about -201 °C
+#define RTD_LUT_LENGTH 478    // up to R/R0 = 3.906, about 850 °C
+
+  extern const int32_t kRtdLutMilliC[RTD_LUT_LENGTH];
+
+  // Table steps per 15-bit ADC code in Q32, for RtdLutCodeToMilliC().
+  // Computed once per reader.
+  uint64_t RtdLutCodeScale(double rref_ohm, double r0_ohm);
+
+  // Direct index from the ADC code plus linear interpolation; integer only.
+  // Clamps to the table ends.
+  int32_t RtdLutCodeToMilliC(uint16_t adc_code, uint64_t code_scale);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_RTD_LUT_H_
@@ -1,20 +1,29 @@
 #include "runtime_manager.h"
 
+#include <dirent.h>
 #include <inttypes.h>
 #include <math.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "adaptive_rate.h"
+#include "alarm.h"
+#include "burst_capture.h"
 #include "calibration.h"
+#include "clock_sync.h"
 #include "data_csv.h"
 #include "data_port.h"
 #include "esp_log.h"
 #include "esp_mac.h"
 #include "esp_mesh_lite.h"
 #include "esp_mesh_lite_port.h"
+#include "esp_random.h"
 #include "esp_system.h"
+#include "esp_timer.h"
+#include "export_frame.h"
 #include "fram_i2c.h"
 #include "fram_log.h"
 #include "freertos/FreeRTOS.h"
@@ -23,16 +32,162 @@
 #include "i2c_bus.h"
 #include "max31865_reader.h"
 #include "max7219_display.h"
+#include "mesh_credit.h"
+#include "mesh_rejoin.h"
 #include "mesh_transport.h"
+#include "node_table.h"
+#include "record_compressor.h"
+#include "record_ring.h"
+#include "rtd_channels.h"
+#include "sample_filter.h"
+#include "sample_scheduler.h"
 #include "sd_logger.h"
 #include "time_sync.h"
+#include "uplink.h"
 #include "wifi_service.h"
 
 static const char* kTag = "runtime";
 static const uint32_t kSdFlushMaxRecordsPerPass = 100;
 static const uint32_t kSdFlushMaxMsPerPass = 50;
 static const uint32_t kSdFlushFailureBackoffMs = 5000;
-static const uint32_t kExportQueueDepth = 64;
+#ifdef CONFIG_APP_EXPORT_RING_RECORDS
+static const uint32_t kExportRingRecords = CONFIG_APP_EXPORT_RING_RECORDS;
+#else
+static const uint32_t kExportRingRecords = 1024;
+#endif
+// Data port batching: records already pending in the ring are packed into
+// one frame (or one block of CSV rows) per DataPortWrite().
+#define EXPORT_BATCH_MAX_RECORDS 64u
+#define EXPORT_FRAME_BUFFER_LEN EXPORT_FRAME_RECORDS_LEN(EXPORT_BATCH_MAX_RECORDS)
+#define EXPORT_OUT_BUFFER_LEN (EXPORT_FRAME_COBS_MAX(EXPORT_FRAME_BUFFER_LEN) + 1u)
+#define ALARM_QUEUE_LEN 16u
+#define ALARM_PENDING_MAX 8u
+#define MESH_RAM_BACKLOG_RECORDS 64u
+static const size_t kExportCsvRowMaxLen = 256;
+#ifdef CONFIG_APP_UPLINK_ENABLE
+static const bool kUplinkEnabled = true;
+static const char* kUplinkHost = CONFIG_APP_UPLINK_HOST;
+static const uint16_t kUplinkPort = CONFIG_APP_UPLINK_PORT;
+static const uint32_t kUplinkRetainRecords = CONFIG_APP_UPLINK_RETAIN_RECORDS;
+#else
+static const bool kUplinkEnabled = false;
+static const char* kUplinkHost = "";
+static const uint16_t kUplinkPort = 0;
+static const uint32_t kUplinkRetainRecords = 0;
+#endif
+#ifdef CONFIG_APP_UPLINK_FORMAT_CSV
+static const uplink_format_t kUplinkFormat = UPLINK_FORMAT_CSV;
+#else
+static const uplink_format_t kUplinkFormat = UPLINK_FORMAT_BINARY;
+#endif
+static const int64_t kExportNodesRepeatUs = 10 * 1000 * 1000;
+
+#ifdef CONFIG_APP_MESH_ACK_PERIOD_MS
+static const uint32_t kMeshAckPeriodMs = CONFIG_APP_MESH_ACK_PERIOD_MS;
+#else
+static const uint32_t kMeshAckPeriodMs = 5000;
+#endif
+static const uint32_t kMeshReorderTickMs = 250;
+#ifdef CONFIG_APP_MESH_CREDIT_FLOW_CONTROL
+static const bool kMeshCreditFlowControl = true;
+#else
+static const bool kMeshCreditFlowControl = false;
+#endif
+#ifdef CONFIG_APP_TIME_SYNC_PROBE_PERIOD_S
+static const uint32_t kTimeProbePeriodMs =
+  CONFIG_APP_TIME_SYNC_PROBE_PERIOD_S * 1000u;
+#else
+static const uint32_t kTimeProbePeriodMs = 16000;
+#endif
+#ifdef CONFIG_APP_TIME_SYNC_STEP_THRESHOLD_MS
+static const int64_t kTimeStepThresholdUs =
+  (int64_t)CONFIG_APP_TIME_SYNC_STEP_THRESHOLD_MS * 1000;
+#else
+static const int64_t kTimeStepThresholdUs = 128000;
+#endif
+static const uint32_t kTimeProbeFastPeriodMs = 2000;
+static const uint32_t kTimeProbeTimeoutMs = 1000;
+static const uint32_t kTimeLegacyRequestPeriodMs = 10000;
+// Root time service: reply/coalescing granularity, legacy request window,
+// and the cap on periodic broadcast backoff (period << shift).
+static const uint32_t kTimeServiceTickMs = 100;
+static const int64_t kTimeRequestCoalesceUs = 500 * 1000;
+static const uint32_t kTimeBroadcastMaxBackoffShift = 3;
+#ifdef CONFIG_APP_SAMPLE_ALIGN_TO_WALL_CLOCK
+static const bool kSampleAlignToWallClock = true;
+#else
+static const bool kSampleAlignToWallClock = false;
+#endif
+#ifdef CONFIG_APP_MESH_BACKFILL_RECORDS_PER_S
+static const uint32_t kMeshBackfillRecordsPerSec =
+  CONFIG_APP_MESH_BACKFILL_RECORDS_PER_S;
+#else
+static const uint32_t kMeshBackfillRecordsPerSec = 20;
+#endif
+#ifdef CONFIG_APP_MAX31865_CONTINUOUS
+static const bool kSensorContinuous = true;
+#else
+static const bool kSensorContinuous = false;
+#endif
+#ifdef CONFIG_APP_MAX31865_DRDY_GPIO
+static const int kSensorDrdyGpio = CONFIG_APP_MAX31865_DRDY_GPIO;
+#else
+static const int kSensorDrdyGpio = -1;
+#endif
+#ifdef CONFIG_APP_SENSOR_REPLAY
+static const bool kSensorReplay = true;
+static const char* kSensorReplayFile = CONFIG_APP_SENSOR_REPLAY_FILE;
+static const uint32_t kSensorReplaySpeed = CONFIG_APP_SENSOR_REPLAY_SPEED;
+// A replay reads its trace in SensorTask: ReadRow()'s line and column
+// buffers (~0.6 KB with its callers, -fstack-usage) plus fgets() through
+// FATFS and the SDSPI driver. status shows the measured headroom.
+static const uint32_t kSensorTaskStackBytes = 7168;
+#else
+static const bool kSensorReplay = false;
+static const char* kSensorReplayFile = "";
+static const uint32_t kSensorReplaySpeed = 1;
+static const uint32_t kSensorTaskStackBytes = 4096;
+#endif
+#ifdef CONFIG_APP_SENSOR_REPLAY_LOOP
+static const bool kSensorReplayLoop = true;
+#else
+static const bool kSensorReplayLoop = false;
+#endif
+#ifdef CONFIG_APP_RTD_EXTRA_CS_GPIOS
+static const char* kRtdExtraCsGpios = CONFIG_APP_RTD_EXTRA_CS_GPIOS;
+#else
+static const char* kRtdExtraCsGpios = "";
+#endif
+#ifdef CONFIG_APP_ALARMS
+static const bool kAlarmsEnabled = true;
+#else
+static const bool kAlarmsEnabled = false;
+#endif
+
+// Alarm event bound for the data port, with its origin.
+typedef struct
+{
+  alarm_event_t event;
+  uint8_t node_index;
+} alarm_queue_item_t;
+
+// Per RTD channel, owned by SensorTask.
+typedef struct
+{
+  // Sensor fault logging state (rate-limited).
+  bool fault_present;
+  uint8_t fault_status;
+  TickType_t fault_log_ticks;
+  alarm_state_t alarm_state;
+  calibration_fixed_t calibration; // integer form of the channel's model
+  sample_filter_t filter;
+  record_compressor_t compressor;
+  adaptive_rate_t rate;
+  // A fault since the last record; the next record reports it.
+  bool fault_pending;
+  esp_err_t fault_result;
+  max31865_sample_t fault_sample;
+} sensor_channel_state_t;
 
 typedef struct
 {
@@ -42,12 +197,30 @@ typedef struct
   fram_log_t fram_log;
   sd_logger_t sd_logger;
   max31865_reader_t sensor;
+  rtd_channels_t rtd_channels; // sensor is channel 0
+  max31865_replay_t sensor_replay[RTD_CHANNELS_MAX]; // APP_SENSOR_REPLAY
+  sensor_channel_state_t channel_state[RTD_CHANNELS_MAX];
   mesh_transport_t mesh;
   time_sync_t time_sync;
   i2c_bus_t i2c_bus;
 
   QueueHandle_t log_queue;
-  QueueHandle_t export_queue;
+  // Records bound for the host (local samples and, on the root, records
+  // from every leaf). ExportTask is one consumer; more can attach.
+  record_ring_t export_ring;
+  uint32_t export_consumer_id;
+  mesh_credit_t mesh_credit; // root: ring -> per-ACK-period send budget
+  // Alarm lane: events bypass log_queue and the ring. SensorTask owns the
+  // rules, per-channel state and the events the mesh refused (alarm_pending,
+  // retried on the next sample); alarm_queue feeds ExportTask ahead of
+  // records.
+  alarm_rules_t alarm_rules;
+  alarm_event_t alarm_pending[ALARM_PENDING_MAX];
+  uint32_t alarm_pending_count;
+  QueueHandle_t alarm_queue;
+  runtime_alarm_stats_t alarm_stats;
+  node_table_t node_table;
+  uint8_t local_node_index;
   uint8_t* batch_buffer;
   size_t batch_buffer_size;
 
@@ -64,19 +237,61 @@ typedef struct
   uint64_t last_overrun_records_total;
   uint64_t last_overrun_logged_total;
 
-  // Sensor fault logging state (rate-limited).
-  bool last_sensor_fault_present;
-  uint8_t last_sensor_fault_status;
-  TickType_t last_sensor_fault_log_ticks;
+  // Leaf store-and-forward: next record_id to send upstream. Reads come from
+  // the FRAM ring by record_id, independent of the SD read index.
+  uint64_t mesh_cursor_record_id;
+  uint64_t mesh_cursor_at_last_ack;
+  uint32_t mesh_backfill_tokens;
+  TickType_t mesh_backfill_refill_ticks;
+  uint32_t mesh_backfill_records_total;
+  uint32_t mesh_rewinds_total;
+  // Without FRAM: records not yet ACKed by the root, oldest at head. The
+  // first `sent` of them are on their way.
+  log_record_t mesh_ram_backlog[MESH_RAM_BACKLOG_RECORDS];
+  uint32_t mesh_ram_backlog_head;
+  uint32_t mesh_ram_backlog_count;
+  uint32_t mesh_ram_backlog_sent;
+  uint32_t mesh_ram_backlog_dropped;
+  TickType_t mesh_ram_backlog_log_ticks;
+
+  // Leaf two-way time sync estimator; owned by TimeSyncTask, snapshot for
+  // readers under clock_sync_lock.
+  clock_sync_t clock_sync;
+  portMUX_TYPE clock_sync_lock;
+
+  // Wall-clock-aligned sampling; stats and the current rate read under
+  // sample_timing_lock.
+  sample_scheduler_t sample_scheduler;
+  runtime_sample_rate_t sample_rate;
+  portMUX_TYPE sample_timing_lock;
+
+  // Burst capture: the ring is filled by SensorTask and written out by
+  // StorageTask once frozen. State changes, stats and trigger requests
+  // under burst_lock.
+  burst_capture_t burst;
+  portMUX_TYPE burst_lock;
+  uint8_t burst_trigger_request; // burst_trigger_source_t
+  bool burst_paused; // period does not divide the current sample period
+  uint32_t burst_next_id;        // 0 until the SD directory was scanned
+  uint8_t burst_write_attempts;
+  TickType_t burst_retry_ticks;
 
   char node_id_string[32];
 
+  // Root: what leaf records said about their clocks since the last time
+  // broadcast (LOG_RECORD_FLAG_TIME_VALID). Set in the Mesh-Lite RX context,
+  // taken by RootTimeService.
+  atomic_bool time_leaf_synced_seen;
+  atomic_bool time_leaf_unsynced_seen;
+
   TaskHandle_t sensor_task;
+  uint32_t sensor_stack_free; // least SensorTask stack left so far, bytes
   TaskHandle_t storage_task;
   TaskHandle_t export_task;
   TaskHandle_t time_sync_task;
   TaskHandle_t topology_task;
   TaskHandle_t display_task;
+  TaskHandle_t mesh_ack_task;
 
   bool initialized;
   bool is_running;
@@ -85,9 +300,18 @@ typedef struct
   bool data_streaming_enabled;
   bool log_quiet;
 
-  uint32_t export_dropped_count;
   uint32_t export_write_fail_count;
   bool csv_header_emitted;
+  // Binary export: selected format, frame sequence and node announcements.
+  // Frame buffers are only touched by ExportTask.
+  app_export_format_t export_format;
+  uint32_t export_frame_sequence;
+  uint32_t export_nodes_announced;
+  int64_t export_nodes_announced_us;
+  uint8_t export_frame[EXPORT_FRAME_BUFFER_LEN];
+  uint8_t export_out[EXPORT_OUT_BUFFER_LEN];
+  // Root TCP uplink (allocated on first start when configured).
+  uplink_t* uplink;
 
   max7219_display_t display;
   bool display_initialized;
@@ -98,12 +322,6 @@ typedef struct
   portMUX_TYPE last_temp_lock;
 } runtime_state_t;
 
-typedef struct
-{
-  log_record_t record;
-  char node_id[32];
-} export_item_t;
-
 static runtime_state_t g_state;
 static app_runtime_t g_runtime;
 static esp_err_t
@@ -117,19 +335,6 @@ MarkSdFailure(runtime_state_t* state,
               int errno_value,
               bool did_unmount);
 
-static const char*
-ConversionModeToString(uint8_t mode)
-{
-  switch ((max31865_conversion_t)mode) {
-    case kMax31865ConversionTablePt100:
-      return "TABLE";
-    case kMax31865ConversionCvdIterative:
-      return "CVD";
-    default:
-      return "UNKNOWN";
-  }
-}
-
 static bool
 DoubleNear(double a, double b)
 {
@@ -215,8 +420,10 @@ CalibrationContextMatches(const app_settings_t* settings,
     snprintf(reason_out,
              reason_out_len,
              "conversion mode changed (stored=%s current=%s)",
-             ConversionModeToString(stored->conversion_mode),
-             ConversionModeToString(current->conversion_mode));
+             Max31865ConversionName(
+               (max31865_conversion_t)stored->conversion_mode),
+             Max31865ConversionName(
+               (max31865_conversion_t)current->conversion_mode));
     return false;
   }
   if (stored->wires != current->wires) {
@@ -520,36 +727,57 @@ TryEmitCsvHeader(runtime_state_t* state)
   return true;
 }
 
-static void
+// false when the ring is full.
+static bool
 EnqueueExportRecord(runtime_state_t* state,
-                    const char* node_id,
+                    uint8_t node_index,
                     const log_record_t* record)
 {
-  if (state == NULL || record == NULL || state->export_queue == NULL) {
-    return;
-  }
-
-  export_item_t item;
-  memset(&item, 0, sizeof(item));
-  item.record = *record;
-  if (node_id != NULL) {
-    snprintf(item.node_id, sizeof(item.node_id), "%s", node_id);
-  }
-
-  if (xQueueSend(state->export_queue, &item, 0) != pdTRUE) {
-    state->export_dropped_count++;
+  if (state == NULL || record == NULL || state->export_ring.slots == NULL) {
+    return true;
   }
+  const esp_err_t push_result =
+    RecordRingPush(&state->export_ring, node_index, record);
+  NodeTableNoteRecord(&state->node_table,
+                      node_index,
+                      record,
+                      push_result != ESP_OK,
+                      esp_timer_get_time());
+  TaskHandle_t export_task = state->export_task;
+  if (push_result == ESP_OK && export_task != NULL) {
+    xTaskNotifyGive(export_task);
+  }
+  return push_result == ESP_OK;
 }
 
-static void
+// Runs in the Mesh-Lite RX context: intern the sender and hand the record to
+// the ring without formatting or blocking. A record the full ring refuses
+// is left to the transport, which has the node send it again.
+static bool
 RootRecordRxCallback(const pt100_mesh_addr_t* from,
                      const log_record_t* record,
                      void* context)
 {
-  (void)context;
-  char node_id[32];
-  FormatMacString(from->addr, node_id, sizeof(node_id));
-  EnqueueExportRecord(&g_state, node_id, record);
+  runtime_state_t* state = (runtime_state_t*)context;
+  uint8_t node_index = 0;
+  if (NodeTableIntern(&state->node_table, from, &node_index) != ESP_OK) {
+    // Not an export ring overflow: the sender has no node index.
+    if (NodeTableNoteRefused(&state->node_table, from)) {
+      char node_id[NODE_TABLE_ID_STRING_LEN];
+      FormatMacString(from->addr, node_id, sizeof(node_id));
+      ESP_LOGW(kTag,
+               "Node table full (%u nodes): dropping records from %s",
+               (unsigned)NODE_TABLE_MAX_NODES,
+               node_id);
+    }
+    return true; // a replay would not fit either
+  }
+  atomic_store_explicit((record->flags & LOG_RECORD_FLAG_TIME_VALID) != 0
+                          ? &state->time_leaf_synced_seen
+                          : &state->time_leaf_unsynced_seen,
+                        true,
+                        memory_order_relaxed);
+  return EnqueueExportRecord(state, node_index, record);
 }
 
 static esp_err_t
@@ -962,214 +1190,1395 @@ SdFlushWorkerTick(runtime_state_t* state,
 }
 
 static void
-SensorTask(void* context)
+AlarmRulesFromConfig(alarm_rules_t* rules)
+{
+  memset(rules, 0, sizeof(*rules));
+#ifdef CONFIG_APP_ALARMS
+  rules->fault_enabled = true;
+  rules->hysteresis_milli_c = CONFIG_APP_ALARM_HYSTERESIS_MILLI_C;
+  rules->rate_milli_c_per_min = CONFIG_APP_ALARM_RATE_MILLI_C_PER_MIN;
+  rules->rate_window_ms = CONFIG_APP_ALARM_RATE_WINDOW_S * 1000u;
+#endif
+#ifdef CONFIG_APP_ALARM_HIGH
+  rules->high_enabled = true;
+  rules->high_milli_c = CONFIG_APP_ALARM_HIGH_MILLI_C;
+#endif
+#ifdef CONFIG_APP_ALARM_LOW
+  rules->low_enabled = true;
+  rules->low_milli_c = CONFIG_APP_ALARM_LOW_MILLI_C;
+#endif
+}
+
+// Hands an alarm to ExportTask. Safe from the Mesh-Lite RX context.
+static void
+QueueAlarmForExport(runtime_state_t* state,
+                    uint8_t node_index,
+                    const alarm_event_t* event)
+{
+  const alarm_queue_item_t item = {
+    .event = *event,
+    .node_index = node_index,
+  };
+  if (state->alarm_queue == NULL ||
+      xQueueSend(state->alarm_queue, &item, 0) != pdTRUE) {
+    state->alarm_stats.dropped++;
+    return;
+  }
+  TaskHandle_t export_task = state->export_task;
+  if (export_task != NULL) {
+    xTaskNotifyGive(export_task);
+  }
+}
+
+// Mesh-Lite RX context, like RootRecordRxCallback.
+static void
+RootAlarmRxCallback(const pt100_mesh_addr_t* from,
+                    const alarm_event_t* event,
+                    void* context)
 {
   runtime_state_t* state = (runtime_state_t*)context;
+  uint8_t node_index = 0;
+  if (NodeTableIntern(&state->node_table, from, &node_index) != ESP_OK) {
+    state->alarm_stats.dropped++;
+    return;
+  }
+  QueueAlarmForExport(state, node_index, event);
+}
 
-  while (!state->stop_requested) {
-    const uint32_t period_ms = state->settings.log_period_ms;
+// Leaf: burst trigger from the root; taken by SensorTask at its next tick.
+static void
+LeafBurstTriggerCallback(void* context)
+{
+  (void)context;
+  RuntimeRequestBurstTrigger(BURST_TRIGGER_MESH);
+}
 
-    max31865_sample_t sample;
-    memset(&sample, 0, sizeof(sample));
-    esp_err_t result = Max31865ReadOnce(&state->sensor, &sample);
+// Leaf: sends held alarms in order; stops at the first the mesh refuses.
+static void
+AlarmFlushPending(runtime_state_t* state)
+{
+  uint32_t sent = 0;
+  while (sent < state->alarm_pending_count &&
+         MeshTransportSendAlarm(&state->mesh, &state->alarm_pending[sent]) ==
+           ESP_OK) {
+    sent++;
+  }
+  if (sent == 0) {
+    return;
+  }
+  state->alarm_stats.sent += sent;
+  state->alarm_pending_count -= sent;
+  memmove(state->alarm_pending,
+          state->alarm_pending + sent,
+          state->alarm_pending_count * sizeof(state->alarm_pending[0]));
+}
 
-    log_record_t record;
-    memset(&record, 0, sizeof(record));
-    int64_t epoch_sec = 0;
-    int32_t millis = 0;
-    TimeSyncGetNow(&epoch_sec, &millis);
-    const bool time_valid = TimeSyncIsSystemTimeValid();
-    record.timestamp_epoch_sec = time_valid ? epoch_sec : (int64_t)0;
-    record.timestamp_millis = time_valid ? millis : 0;
+static void
+HoldAlarm(runtime_state_t* state, const alarm_event_t* event)
+{
+  if (state->alarm_pending_count == ALARM_PENDING_MAX) {
+    // The oldest goes: a newer event for the same kind supersedes it.
+    memmove(state->alarm_pending,
+            state->alarm_pending + 1,
+            (ALARM_PENDING_MAX - 1u) * sizeof(state->alarm_pending[0]));
+    state->alarm_pending_count--;
+    state->alarm_stats.dropped++;
+  }
+  state->alarm_pending[state->alarm_pending_count++] = *event;
+}
 
-    if (result == ESP_OK) {
-      const double cal_c = CalibrationModelEvaluateWithPoints(
-        &state->settings.calibration,
-        sample.temperature_c,
-        state->settings.calibration_points,
-        state->settings.calibration_points_count);
-      record.raw_temp_milli_c = (int32_t)llround(sample.temperature_c * 1000.0);
-      CalWindowPushRawSample(record.raw_temp_milli_c);
-      record.temp_milli_c = (int32_t)llround(cal_c * 1000.0);
-      record.resistance_milli_ohm =
-        (int32_t)llround(sample.resistance_ohm * 1000.0);
-      if (sample.fault_present) {
-        record.flags |= LOG_RECORD_FLAG_SENSOR_FAULT;
-      }
-    } else {
-      record.flags |= LOG_RECORD_FLAG_SENSOR_FAULT;
-    }
+// Integer form of the channel's calibration, rebuilt when the model or
+// points changed.
+static const calibration_fixed_t*
+SyncChannelCalibration(runtime_state_t* state, uint8_t channel)
+{
+  calibration_fixed_t* fixed = &state->channel_state[channel].calibration;
+  if (channel == 0) {
+    CalibrationFixedSync(fixed,
+                         &state->settings.calibration,
+                         state->settings.calibration_points,
+                         state->settings.calibration_points_count);
+  } else {
+    CalibrationFixedSync(
+      fixed, &state->settings.channel_calibration[channel], NULL, 0);
+  }
+  return fixed;
+}
 
-    // Log sensor faults in a rate-limited way so operators see
-    // wiring/open/short issues without flooding the console.
-    const TickType_t now_ticks = xTaskGetTickCount();
-    if (result == ESP_OK && sample.fault_present) {
-      const bool changed =
-        !state->last_sensor_fault_present ||
-        state->last_sensor_fault_status != sample.fault_status;
-      const bool rate_ok =
-        (state->last_sensor_fault_log_ticks == 0) ||
-        (pdTICKS_TO_MS(now_ticks - state->last_sensor_fault_log_ticks) >=
-         5000u);
-      if (changed || rate_ok) {
-        ESP_LOGW(kTag,
-                 "MAX31865 fault: status=0x%02X res=%.3f ohm temp_c=%.2f",
-                 sample.fault_status,
-                 sample.resistance_ohm,
-                 sample.temperature_c);
-        state->last_sensor_fault_log_ticks = now_ticks;
-      }
-      state->last_sensor_fault_present = true;
-      state->last_sensor_fault_status = sample.fault_status;
-    } else if (result != ESP_OK) {
-      const bool changed = !state->last_sensor_fault_present ||
-                           state->last_sensor_fault_status != 0xFFu;
-      const bool rate_ok =
-        (state->last_sensor_fault_log_ticks == 0) ||
-        (pdTICKS_TO_MS(now_ticks - state->last_sensor_fault_log_ticks) >=
-         5000u);
-      if (changed || rate_ok) {
-        ESP_LOGW(kTag, "MAX31865 read failed: %s", esp_err_to_name(result));
-        state->last_sensor_fault_log_ticks = now_ticks;
-      }
-      state->last_sensor_fault_present = true;
-      state->last_sensor_fault_status = 0xFFu;
+// Runs in SensorTask on every raw sample, calibrated but ahead of the
+// filter chain and the record boundaries, so a short excursion is neither
+// smoothed away nor held back until the next record.
+static void
+EvaluateAlarms(runtime_state_t* state,
+               uint8_t channel,
+               esp_err_t result,
+               const max31865_sample_t* sample,
+               int64_t epoch_ms)
+{
+  const bool on_mesh = state->mesh_started && !state->mesh.is_root;
+  if (on_mesh) {
+    AlarmFlushPending(state);
+  }
+
+  const calibration_model_t* model =
+    (channel == 0) ? &state->settings.calibration
+                   : &state->settings.channel_calibration[channel];
+  const bool temp_valid = result == ESP_OK && !sample->fault_present;
+  int32_t temp_milli_c = sample->temp_milli_c;
+  if (temp_valid && model->is_valid) {
+    temp_milli_c = CalibrationFixedEvaluate(
+      SyncChannelCalibration(state, channel), temp_milli_c);
+  }
+  alarm_event_t events[ALARM_MAX_EVENTS_PER_SAMPLE];
+  const size_t count =
+    AlarmEvaluate(&state->channel_state[channel].alarm_state,
+                  &state->alarm_rules,
+                  temp_milli_c,
+                  temp_valid,
+                  esp_timer_get_time() / 1000,
+                  epoch_ms,
+                  events,
+                  ALARM_MAX_EVENTS_PER_SAMPLE);
+  for (size_t i = 0; i < count; ++i) {
+    const alarm_event_t* event = &events[i];
+    if (event->active) {
+      state->alarm_stats.raised++;
     } else {
-      if (state->last_sensor_fault_present) {
-        ESP_LOGW(kTag, "MAX31865 fault cleared");
+      state->alarm_stats.cleared++;
+    }
+    ESP_LOGW(kTag,
+             "alarm ch%u %s %s: value=%.3f limit=%.3f",
+             (unsigned)event->channel,
+             AlarmKindToString(event->kind),
+             event->active ? "raised" : "cleared",
+             event->value / 1000.0,
+             event->limit / 1000.0);
+    if (on_mesh) {
+      if (state->alarm_pending_count == 0 &&
+          MeshTransportSendAlarm(&state->mesh, event) == ESP_OK) {
+        state->alarm_stats.sent++;
+      } else {
+        HoldAlarm(state, event);
       }
-      state->last_sensor_fault_present = false;
-      state->last_sensor_fault_status = 0;
     }
+    QueueAlarmForExport(state, state->local_node_index, event);
+  }
+  state->alarm_stats.pending = state->alarm_pending_count;
+}
 
-    if (time_valid) {
-      record.flags |= LOG_RECORD_FLAG_TIME_VALID;
-    }
-    if (state->settings.calibration.is_valid) {
-      record.flags |= LOG_RECORD_FLAG_CAL_VALID;
-    }
-    if (state->sd_degraded) {
-      record.flags |= LOG_RECORD_FLAG_SD_ERROR;
-    }
-    if (state->fram_full) {
-      record.flags |= LOG_RECORD_FLAG_FRAM_FULL;
+// Fills the readings of one channel into record. Channel 0 uses the
+// calibration workflow model and points; other channels their own model.
+// Returns whether the temperature is valid.
+static bool
+BuildChannelRecord(runtime_state_t* state,
+                   uint8_t channel,
+                   esp_err_t result,
+                   const max31865_sample_t* sample,
+                   log_record_t* record)
+{
+  const calibration_model_t* model =
+    (channel == 0) ? &state->settings.calibration
+                   : &state->settings.channel_calibration[channel];
+  if (model->is_valid) {
+    record->flags |= LOG_RECORD_FLAG_CAL_VALID;
+  }
+  if (result != ESP_OK) {
+    record->flags |= LOG_RECORD_FLAG_SENSOR_FAULT;
+    return false;
+  }
+
+  const calibration_fixed_t* fixed = SyncChannelCalibration(state, channel);
+  record->raw_temp_milli_c = sample->temp_milli_c;
+  if (channel == 0) {
+    CalWindowPushRawSample(record->raw_temp_milli_c);
+  }
+  record->temp_milli_c = CalibrationFixedEvaluate(fixed, sample->temp_milli_c);
+  record->resistance_milli_ohm = sample->resistance_milli_ohm;
+  if (sample->fault_present) {
+    record->flags |= LOG_RECORD_FLAG_SENSOR_FAULT;
+    return false;
+  }
+  return true;
+}
+
+// Logs sensor faults in a rate-limited way so operators see
+// wiring/open/short issues without flooding the console.
+static void
+NoteSensorFault(runtime_state_t* state,
+                uint8_t channel,
+                esp_err_t result,
+                const max31865_sample_t* sample)
+{
+  sensor_channel_state_t* channel_state = &state->channel_state[channel];
+  const TickType_t now_ticks = xTaskGetTickCount();
+  const uint8_t status =
+    (result == ESP_OK) ? (sample->fault_present ? sample->fault_status : 0)
+                       : 0xFFu;
+  if (result == ESP_OK && !sample->fault_present) {
+    if (channel_state->fault_present) {
+      ESP_LOGW(kTag, "MAX31865 ch%u fault cleared", (unsigned)channel);
     }
-    if (MeshTransportIsConnected(&state->mesh)) {
-      record.flags |= LOG_RECORD_FLAG_MESH_CONNECTED;
+    channel_state->fault_present = false;
+    channel_state->fault_status = 0;
+    return;
+  }
+
+  const bool changed =
+    !channel_state->fault_present || channel_state->fault_status != status;
+  const bool rate_ok =
+    (channel_state->fault_log_ticks == 0) ||
+    (pdTICKS_TO_MS(now_ticks - channel_state->fault_log_ticks) >= 5000u);
+  if (changed || rate_ok) {
+    if (result == ESP_OK) {
+      ESP_LOGW(kTag,
+               "MAX31865 ch%u fault: status=0x%02X res=%.3f ohm temp_c=%.2f",
+               (unsigned)channel,
+               sample->fault_status,
+               sample->resistance_ohm,
+               sample->temperature_c);
+    } else {
+      ESP_LOGW(kTag,
+               "MAX31865 ch%u read failed: %s",
+               (unsigned)channel,
+               esp_err_to_name(result));
     }
+    channel_state->fault_log_ticks = now_ticks;
+  }
+  channel_state->fault_present = true;
+  channel_state->fault_status = status;
+}
+
+static bool
+SameFilterConfig(const sample_filter_config_t* a,
+                 const sample_filter_config_t* b)
+{
+  return a->median_n == b->median_n && a->decimation == b->decimation &&
+         a->cic_order == b->cic_order && a->ema_alpha_q16 == b->ema_alpha_q16;
+}
+
+static bool
+SameAdaptiveConfig(const adaptive_rate_config_t* a,
+                   const adaptive_rate_config_t* b)
+{
+  return a->enabled == b->enabled && a->fast_period_ms == b->fast_period_ms &&
+         a->rise_milli_c_per_min == b->rise_milli_c_per_min &&
+         a->dwell_ms == b->dwell_ms;
+}
+
+static bool
+SameBurstConfig(const burst_capture_config_t* a,
+                const burst_capture_config_t* b)
+{
+  return a->enabled == b->enabled && a->period_ms == b->period_ms &&
+         a->pre_ms == b->pre_ms && a->post_ms == b->post_ms &&
+         a->level_enabled == b->level_enabled &&
+         a->level_milli_c == b->level_milli_c &&
+         a->slope_milli_c_per_s == b->slope_milli_c_per_s;
+}
 
-    int32_t temp_milli_c = record.temp_milli_c;
-    if (!state->settings.calibration.is_valid) {
-      temp_milli_c = record.raw_temp_milli_c;
+// Re-sizes the burst ring after a config or channel count change. Waits
+// while a frozen burst is still to be written. The ring counts its windows
+// and slope in ticks of the burst period, so it pauses while that period
+// does not divide the sample period (log interval, decimation or adaptive
+// rate changed since it was set).
+static void
+ApplyBurstConfig(runtime_state_t* state,
+                 uint8_t channels,
+                 uint32_t sample_period_ms)
+{
+  burst_capture_config_t applied = state->settings.burst_capture;
+  const bool fits = !applied.enabled ||
+                    (applied.period_ms > 0 &&
+                     sample_period_ms % applied.period_ms == 0);
+  if (!fits) {
+    if (!state->burst_paused) {
+      ESP_LOGW(kTag,
+               "Burst capture paused: %u ms does not divide the sample "
+               "period (%u ms)",
+               (unsigned)applied.period_ms,
+               (unsigned)sample_period_ms);
     }
-    const bool temp_valid = (result == ESP_OK && !sample.fault_present);
+    applied.enabled = false;
+  } else if (state->burst_paused && applied.enabled) {
+    ESP_LOGI(kTag, "Burst capture resumed");
+  }
+  state->burst_paused = !fits;
+  burst_capture_t* burst = &state->burst;
+  if ((SameBurstConfig(&burst->config, &applied) &&
+       burst->channels == channels) ||
+      burst->state == BURST_CAPTURE_FROZEN) {
+    return;
+  }
+  if (burst->ring != NULL && applied.enabled &&
+      BurstCaptureRingSamples(&applied, channels) == burst->capacity &&
+      burst->channels == channels) {
+    // Same ring size (e.g. only a trigger changed): keep the samples.
+    taskENTER_CRITICAL(&state->burst_lock);
+    burst->config = applied;
+    taskEXIT_CRITICAL(&state->burst_lock);
+    return;
+  }
+  taskENTER_CRITICAL(&state->burst_lock);
+  burst_sample_t* ring = burst->ring;
+  burst->ring = NULL; // Push is a no-op until the new ring is in place
+  taskEXIT_CRITICAL(&state->burst_lock);
+  free(ring);
 
-    taskENTER_CRITICAL(&state->last_temp_lock);
-    state->last_temp_milli_c = temp_milli_c;
-    state->last_temp_valid = temp_valid;
-    state->last_flags = record.flags;
-    state->last_update_ticks = xTaskGetTickCount();
-    taskEXIT_CRITICAL(&state->last_temp_lock);
+  burst_capture_t fresh;
+  memset(&fresh, 0, sizeof(fresh));
+  const esp_err_t result = BurstCaptureInit(&fresh, &applied, channels);
+  if (result != ESP_OK) {
+    ESP_LOGW(kTag,
+             "Burst ring (%u samples) unavailable: %s",
+             (unsigned)BurstCaptureRingSamples(&applied, channels),
+             esp_err_to_name(result));
+  } else if (applied.enabled && !fresh.in_psram) {
+    ESP_LOGW(kTag, "Burst ring in internal RAM (no PSRAM)");
+  }
+  taskENTER_CRITICAL(&state->burst_lock);
+  fresh.stats = burst->stats;
+  *burst = fresh;
+  taskEXIT_CRITICAL(&state->burst_lock);
+}
 
-    (void)xQueueSend(state->log_queue, &record, 0);
-    vTaskDelay(pdMS_TO_TICKS(period_ms));
+// Feeds one tick of every channel to the burst ring, with any trigger the
+// console or the mesh asked for since the last tick.
+static void
+PushBurstTick(runtime_state_t* state,
+              const max31865_sample_t* samples,
+              const esp_err_t* results,
+              int64_t epoch_ms,
+              int64_t mono_ms)
+{
+  burst_sample_t tick[RTD_CHANNELS_MAX];
+  const uint8_t count = state->burst.channels;
+  for (uint8_t ch = 0; ch < count; ++ch) {
+    const bool ok = results[ch] == ESP_OK && !samples[ch].fault_present;
+    tick[ch].epoch_ms = epoch_ms;
+    tick[ch].mono_ms = mono_ms;
+    tick[ch].raw_milli_c = samples[ch].temp_milli_c;
+    tick[ch].temp_milli_c =
+      ok ? CalibrationFixedEvaluate(SyncChannelCalibration(state, ch),
+                                    samples[ch].temp_milli_c)
+         : samples[ch].temp_milli_c;
+    tick[ch].resistance_milli_ohm = samples[ch].resistance_milli_ohm;
+    tick[ch].channel = ch;
+    tick[ch].fault = !ok;
+  }
+  taskENTER_CRITICAL(&state->burst_lock);
+  const uint8_t trigger = state->burst_trigger_request;
+  state->burst_trigger_request = BURST_TRIGGER_NONE;
+  const bool frozen = BurstCapturePush(&state->burst, tick, trigger);
+  taskEXIT_CRITICAL(&state->burst_lock);
+  if (frozen) {
+    ESP_LOGI(kTag,
+             "Burst frozen: %s trigger, %u samples",
+             BurstTriggerSourceToString(state->burst.trigger_source),
+             (unsigned)BurstCaptureFrozenCount(&state->burst));
   }
+}
 
-  state->sensor_task = NULL;
-  vTaskDelete(NULL);
+static bool
+SameCompressionConfig(const record_compression_config_t* a,
+                      const record_compression_config_t* b)
+{
+  return a->mode == b->mode && a->error_milli_c == b->error_milli_c &&
+         a->heartbeat_ms == b->heartbeat_ms;
 }
 
+// Hands a channel's record to storage through its compressor.
 static void
-ExportTask(void* context)
+QueueRecord(runtime_state_t* state,
+            sensor_channel_state_t* channel_state,
+            const log_record_t* record,
+            int64_t mono_ms)
 {
-  runtime_state_t* state = (runtime_state_t*)context;
+  log_record_t kept[RECORD_COMPRESSION_MAX_OUT];
+  const size_t count =
+    RecordCompressorPush(&channel_state->compressor, record, mono_ms, kept);
+  for (size_t i = 0; i < count; ++i) {
+    (void)xQueueSend(state->log_queue, &kept[i], 0);
+  }
+}
 
-  while (!state->stop_requested ||
-         (state->export_queue != NULL &&
-          uxQueueMessagesWaiting(state->export_queue) > 0)) {
-    export_item_t item;
-    if (state->export_queue != NULL &&
-        xQueueReceive(state->export_queue, &item, pdMS_TO_TICKS(500)) ==
-          pdTRUE) {
-      if (!state->data_streaming_enabled) {
-        continue;
-      }
-      if (!TryEmitCsvHeader(state)) {
-        vTaskDelay(pdMS_TO_TICKS(50));
-        continue;
-      }
-      if (!CsvWriteRow(CsvDataPortWriter, NULL, &item.record, item.node_id)) {
-        state->export_write_fail_count++;
-        vTaskDelay(pdMS_TO_TICKS(50));
-      }
-    }
+// Queues the record a compressor still holds back.
+static void
+FlushCompressor(runtime_state_t* state, sensor_channel_state_t* channel_state)
+{
+  log_record_t held;
+  if (RecordCompressorFlush(&channel_state->compressor, &held)) {
+    (void)xQueueSend(state->log_queue, &held, 0);
   }
+}
 
-  state->export_task = NULL;
-  vTaskDelete(NULL);
+// Runs one channel's sample through its filter chain. Returns true with
+// *record_sample set when the channel has a record for this boundary.
+static bool
+FilterChannelSample(sensor_channel_state_t* channel_state,
+                    esp_err_t result,
+                    const max31865_sample_t* sample,
+                    bool record_due,
+                    esp_err_t* record_result_out,
+                    max31865_sample_t* record_sample)
+{
+  sample_filter_t* filter = &channel_state->filter;
+  sample_filter_value_t filtered = { 0 };
+  bool filtered_ready = false;
+  if (result == ESP_OK && !sample->fault_present) {
+    const sample_filter_value_t input = {
+      .temp_milli_c = sample->temp_milli_c,
+      .resistance_milli_ohm = sample->resistance_milli_ohm,
+    };
+    filtered_ready = SampleFilterPush(filter, &input, &filtered);
+    if (record_due && !filtered_ready) {
+      // The decimator block is out of phase with the record boundaries
+      // (start, clock step, missed boundary): start over on this one.
+      SampleFilterRestartBlock(filter);
+    }
+  } else {
+    SampleFilterReset(filter);
+    channel_state->fault_pending = true;
+    channel_state->fault_result = result;
+    channel_state->fault_sample = *sample;
+  }
+  if (!record_due) {
+    return false;
+  }
+  if (channel_state->fault_pending) {
+    channel_state->fault_pending = false;
+    *record_result_out = channel_state->fault_result;
+    *record_sample = channel_state->fault_sample;
+    return true;
+  }
+  if (!filtered_ready) {
+    return false; // still filling after a fault or a restart
+  }
+  *record_result_out = ESP_OK;
+  *record_sample = *sample;
+  record_sample->temp_milli_c = filtered.temp_milli_c;
+  record_sample->resistance_milli_ohm = filtered.resistance_milli_ohm;
+  return true;
 }
 
 static void
-StorageTask(void* context)
+SensorTask(void* context)
 {
   runtime_state_t* state = (runtime_state_t*)context;
-  state->last_flush_ticks = xTaskGetTickCount();
+  sample_scheduler_t* scheduler = &state->sample_scheduler;
 
-  while (!state->stop_requested ||
-         uxQueueMessagesWaiting(state->log_queue) > 0) {
-    log_record_t record;
-    if (xQueueReceive(state->log_queue, &record, pdMS_TO_TICKS(500)) ==
-        pdTRUE) {
-      esp_err_t id_result = FramLogAssignRecordIds(&state->fram_log, &record);
-      if (id_result != ESP_OK) {
-        ESP_LOGE(
-          kTag, "Failed to assign record id: %s", esp_err_to_name(id_result));
-      }
+  esp_err_t init_result =
+    SampleSchedulerInit(scheduler, xTaskGetCurrentTaskHandle());
+  if (init_result != ESP_OK) {
+    // Wait() falls back to vTaskDelay without a timer.
+    ESP_LOGW(kTag,
+             "Sample timer unavailable: %s",
+             esp_err_to_name(init_result));
+  }
+  if (kSensorContinuous) {
+    // Bias stays on while logging; one-shot reads resume when we stop.
+    esp_err_t continuous_result =
+      RtdChannelsStartContinuous(&state->rtd_channels);
+    if (continuous_result != ESP_OK) {
+      ESP_LOGW(kTag,
+               "MAX31865 continuous mode unavailable: %s",
+               esp_err_to_name(continuous_result));
+    }
+  }
 
-      if (state->fram_i2c.initialized) {
-        esp_err_t append_result = FramLogAppend(&state->fram_log, &record);
-        if (append_result != ESP_OK) {
-          ESP_LOGE(
-            kTag, "FRAM append failed: %s", esp_err_to_name(append_result));
-        } else {
-          state->sd_flush_records_since++;
-        }
-        const uint64_t overrun_after =
-          FramLogGetOverrunRecordsTotal(&state->fram_log);
-        const size_t fram_count = FramLogGetCountRecords(&state->fram_log);
-        const size_t fram_capacity =
-          FramLogGetCapacityRecords(&state->fram_log);
-        const TickType_t now_ticks = xTaskGetTickCount();
-        LogFramOverrunWarning(
-          state, overrun_after, fram_count, fram_capacity, now_ticks);
-        state->last_overrun_records_total = overrun_after;
-        UpdateFramFillState(state);
-        if (state->fram_full) {
-          record.flags |= LOG_RECORD_FLAG_FRAM_FULL;
-        }
+  uint32_t decimation_phase = 0;
+  uint32_t burst_phase = 0;
+  adaptive_rate_config_t adaptive_config = state->settings.adaptive_rate;
+  bool fast = false;
+  while (!state->stop_requested) {
+    if (!SameAdaptiveConfig(&adaptive_config, &state->settings.adaptive_rate)) {
+      adaptive_config = state->settings.adaptive_rate;
+      fast = false;
+      for (uint8_t ch = 0; ch < state->rtd_channels.count; ++ch) {
+        AdaptiveRateInit(&state->channel_state[ch].rate);
       }
+    }
+    // Adaptive rate swaps the log period for the fast one while any
+    // channel's temperature moves.
+    const uint32_t slow_period_ms = state->settings.log_period_ms;
+    const uint32_t period_ms =
+      (adaptive_config.enabled && fast) ? adaptive_config.fast_period_ms
+                                        : slow_period_ms;
+    sample_filter_config_t filter_config = state->settings.sample_filter;
+    const record_compression_config_t compression_config =
+      state->settings.record_compression;
+    // With decimation the sensor runs faster and the filters turn each
+    // log period's samples into one record.
+    uint32_t sample_period_ms =
+      SampleFilterSamplePeriodMs(&filter_config, period_ms);
+    if (sample_period_ms == 0) {
+      // Not a divisor of the period (the console refuses that): no
+      // decimation rather than records off the boundaries.
+      filter_config.decimation = 1;
+      sample_period_ms = period_ms;
+    }
+    // Burst capture ticks faster still; samples in between only feed the
+    // burst ring.
+    ApplyBurstConfig(state, state->rtd_channels.count, sample_period_ms);
+    const bool burst_active = state->burst.ring != NULL;
+    const uint32_t tick_ms =
+      burst_active ? state->burst.config.period_ms : sample_period_ms;
+
+    // Every node samples on the same epoch boundaries once its clock is
+    // disciplined, so rows from different nodes join on the timestamp.
+    int64_t boundary_us = 0;
+    const bool aligned =
+      SampleSchedulerWait(scheduler,
+                          tick_ms,
+                          kSampleAlignToWallClock && TimeSyncIsSystemTimeValid(),
+                          &boundary_us);
+    if (state->stop_requested) {
+      break;
+    }
 
-      if (!state->mesh.is_root && MeshTransportIsConnected(&state->mesh)) {
-        (void)MeshTransportSendRecord(&state->mesh, &record);
+    // All channels convert together and share the timestamp.
+    rtd_channels_t* channels = &state->rtd_channels;
+    max31865_sample_t samples[RTD_CHANNELS_MAX];
+    esp_err_t results[RTD_CHANNELS_MAX];
+    memset(samples, 0, sizeof(samples));
+    RtdChannelsRead(channels, samples, results);
+    // The reads are the deepest calls, with a replay above all.
+    state->sensor_stack_free = (uint32_t)uxTaskGetStackHighWaterMark(NULL);
+    const int64_t mono_ms = esp_timer_get_time() / 1000;
+
+    log_record_t stamp;
+    memset(&stamp, 0, sizeof(stamp));
+    // Unaligned samples carry the time the conversion finished (the DRDY
+    // edge when wired), not the end of the SPI read.
+    int64_t conversion_us = 0;
+    for (uint8_t ch = 0; ch < channels->count && conversion_us == 0; ++ch) {
+      if (results[ch] == ESP_OK) {
+        conversion_us = samples[ch].conversion_us;
       }
+    }
+    int64_t epoch_us = TimeSyncGetEpochUs();
+    if (conversion_us > 0) {
+      epoch_us -= esp_timer_get_time() - conversion_us;
+    }
+    int64_t epoch_sec = epoch_us / 1000000;
+    int32_t millis = (int32_t)((epoch_us % 1000000) / 1000);
+    const bool time_valid = TimeSyncIsSystemTimeValid();
+    if (aligned && time_valid) {
+      epoch_sec = boundary_us / 1000000;
+      millis = (int32_t)((boundary_us % 1000000) / 1000);
+    }
+    stamp.timestamp_epoch_sec = time_valid ? epoch_sec : (int64_t)0;
+    stamp.timestamp_millis = time_valid ? millis : 0;
 
-      EnqueueExportRecord(state, state->node_id_string, &record);
+    const int64_t epoch_ms = time_valid ? epoch_sec * 1000 + millis : 0;
+    if (kAlarmsEnabled) {
+      for (uint8_t ch = 0; ch < channels->count; ++ch) {
+        EvaluateAlarms(state, ch, results[ch], &samples[ch], epoch_ms);
+      }
+    }
+    if (burst_active) {
+      PushBurstTick(state, samples, results, epoch_ms, mono_ms);
+    }
+    bool sample_due = true;
+    if (tick_ms != sample_period_ms) {
+      burst_phase = (burst_phase + 1u) % (sample_period_ms / tick_ms);
+      sample_due =
+        (aligned && time_valid)
+          ? (boundary_us % ((int64_t)sample_period_ms * 1000) == 0)
+          : (burst_phase == 0);
     }
 
-    const TickType_t now_ticks = xTaskGetTickCount();
-    const bool periodic_due =
-      (pdTICKS_TO_MS(now_ticks - state->last_flush_ticks) >=
-       state->settings.sd_flush_period_ms);
-    const uint32_t buffered = FramLogGetBufferedRecords(&state->fram_log);
-    const bool watermark_hit =
-      buffered >= state->settings.fram_flush_watermark_records;
+    taskENTER_CRITICAL(&state->sample_timing_lock);
+    SampleSchedulerMarkSampled(scheduler, TimeSyncGetEpochUs());
+    state->sample_rate.period_ms = period_ms;
+    state->sample_rate.fast = period_ms != slow_period_ms;
+    taskEXIT_CRITICAL(&state->sample_timing_lock);
+    if (!sample_due) {
+      continue;
+    }
 
-    if (periodic_due) {
-      state->sd_flush_pending = true;
-      state->last_flush_ticks = now_ticks;
+    if (time_valid) {
+      stamp.flags |= LOG_RECORD_FLAG_TIME_VALID;
     }
-    if (watermark_hit) {
-      state->sd_flush_pending = true;
+    if (state->sd_degraded) {
+      stamp.flags |= LOG_RECORD_FLAG_SD_ERROR;
+    }
+    if (state->fram_full) {
+      stamp.flags |= LOG_RECORD_FLAG_FRAM_FULL;
+    }
+    if (MeshTransportIsConnected(&state->mesh)) {
+      stamp.flags |= LOG_RECORD_FLAG_MESH_CONNECTED;
+    }
+    if (period_ms != slow_period_ms) {
+      stamp.flags |= LOG_RECORD_FLAG_FAST_RATE;
+    }
+
+    // Records stay on log-period boundaries (wall-clock ones when aligned).
+    bool record_due = true;
+    if (filter_config.decimation > 1) {
+      decimation_phase = (decimation_phase + 1u) % filter_config.decimation;
+      record_due = (aligned && time_valid)
+                     ? (boundary_us % ((int64_t)period_ms * 1000) == 0)
+                     : (decimation_phase == 0);
+    }
+
+    bool rate_updated = false;
+    bool want_fast = false;
+    for (uint8_t ch = 0; ch < channels->count; ++ch) {
+      sensor_channel_state_t* channel_state = &state->channel_state[ch];
+      if (!SameFilterConfig(&channel_state->filter.config, &filter_config)) {
+        SampleFilterInit(&channel_state->filter, &filter_config);
+      }
+      if (!SameCompressionConfig(&channel_state->compressor.config,
+                                 &compression_config)) {
+        FlushCompressor(state, channel_state);
+        RecordCompressorInit(&channel_state->compressor, &compression_config);
+      }
+      NoteSensorFault(state, ch, results[ch], &samples[ch]);
+      esp_err_t record_result = ESP_OK;
+      max31865_sample_t record_sample;
+      if (!FilterChannelSample(channel_state,
+                               results[ch],
+                               &samples[ch],
+                               record_due,
+                               &record_result,
+                               &record_sample)) {
+        continue;
+      }
+
+      log_record_t record = stamp;
+      record.flags |= (uint16_t)((unsigned)ch << LOG_RECORD_CHANNEL_SHIFT);
+      const bool temp_valid =
+        BuildChannelRecord(state, ch, record_result, &record_sample, &record);
+
+      const bool cal_valid = (record.flags & LOG_RECORD_FLAG_CAL_VALID) != 0;
+      const int32_t temp_milli_c =
+        cal_valid ? record.temp_milli_c : record.raw_temp_milli_c;
+      if (adaptive_config.enabled) {
+        want_fast |= AdaptiveRateUpdate(&channel_state->rate,
+                                        &adaptive_config,
+                                        temp_milli_c,
+                                        temp_valid,
+                                        mono_ms,
+                                        slow_period_ms);
+        rate_updated = true;
+      }
+
+      if (ch == 0) {
+        taskENTER_CRITICAL(&state->last_temp_lock);
+        state->last_temp_milli_c = temp_milli_c;
+        state->last_temp_valid = temp_valid;
+        state->last_flags = record.flags;
+        state->last_update_ticks = xTaskGetTickCount();
+        taskEXIT_CRITICAL(&state->last_temp_lock);
+      }
+
+      QueueRecord(state, channel_state, &record, mono_ms);
+    }
+    if (rate_updated) {
+      fast = want_fast;
+    }
+  }
+
+  for (uint8_t ch = 0; ch < state->rtd_channels.count; ++ch) {
+    FlushCompressor(state, &state->channel_state[ch]);
+  }
+  RtdChannelsStopContinuous(&state->rtd_channels);
+  SampleSchedulerDeinit(scheduler);
+  state->sensor_task = NULL;
+  vTaskDelete(NULL);
+}
+
+// Formats first plus whatever is already pending into one block of rows.
+static bool
+ExportCsvBatch(runtime_state_t* state, const record_ring_item_t* first)
+{
+  char* out = (char*)state->export_out;
+  size_t used = 0;
+  uint32_t rows = 0;
+  record_ring_item_t item = *first;
+  for (;;) {
+    const node_table_entry_t* node =
+      NodeTableGet(&state->node_table, item.node_index);
+    size_t written = 0;
+    if (CsvFormatRow(&item.record,
+                     (node != NULL) ? node->id_string : "",
+                     out + used,
+                     sizeof(state->export_out) - used,
+                     &written)) {
+      used += written;
+    }
+    rows++;
+    if (rows >= EXPORT_BATCH_MAX_RECORDS ||
+        sizeof(state->export_out) - used < kExportCsvRowMaxLen ||
+        !RecordRingPop(&state->export_ring, state->export_consumer_id, &item)) {
+      break;
+    }
+  }
+  return used == 0 || CsvDataPortWriter(out, used, NULL);
+}
+
+static bool
+ExportWriteFrame(runtime_state_t* state,
+                 export_frame_writer_t* writer,
+                 bool leading_delimiter)
+{
+  // A lone 0x00 first ends whatever partial frame the host was assembling.
+  size_t offset = 0;
+  if (leading_delimiter) {
+    state->export_out[offset++] = 0;
+  }
+  const size_t encoded = ExportFrameWriterFinish(
+    writer, state->export_out + offset, sizeof(state->export_out) - offset);
+  state->export_frame_sequence++; // consumed even on failure: host sees a gap
+  if (encoded == 0) {
+    return false;
+  }
+  size_t written = 0;
+  return DataPortWrite((const char*)state->export_out,
+                       offset + encoded,
+                       &written) == ESP_OK;
+}
+
+// Announces index -> MAC for every interned node; the host needs this to
+// name records and may attach at any time, so it repeats periodically.
+static bool
+ExportBinaryNodes(runtime_state_t* state, bool resync)
+{
+  const uint32_t count = NodeTableCount(&state->node_table);
+  uint32_t index = 0;
+  do {
+    export_frame_writer_t writer;
+    if (ExportFrameWriterInit(&writer,
+                              state->export_frame,
+                              sizeof(state->export_frame),
+                              EXPORT_FRAME_TYPE_NODES,
+                              state->export_frame_sequence) != ESP_OK) {
+      return false;
+    }
+    while (index < count && !ExportFrameWriterIsFull(&writer)) {
+      const node_table_entry_t* node =
+        NodeTableGet(&state->node_table, (uint8_t)index);
+      if (node != NULL) {
+        (void)ExportFrameWriterAddNode(&writer, (uint8_t)index, &node->addr);
+      }
+      index++;
+    }
+    if (!ExportWriteFrame(state, &writer, resync)) {
+      return false;
+    }
+    resync = false;
+  } while (index < count);
+
+  state->export_nodes_announced = count;
+  state->export_nodes_announced_us = esp_timer_get_time();
+  return true;
+}
+
+// Announces nodes first when the host may not know them all yet.
+static bool
+ExportBinaryNodesIfDue(runtime_state_t* state, bool* resync)
+{
+  if (*resync ||
+      NodeTableCount(&state->node_table) != state->export_nodes_announced ||
+      esp_timer_get_time() - state->export_nodes_announced_us >=
+        kExportNodesRepeatUs) {
+    if (!ExportBinaryNodes(state, *resync)) {
+      return false;
+    }
+    *resync = false;
+  }
+  return true;
+}
+
+static bool
+ExportBinaryBatch(runtime_state_t* state,
+                  const record_ring_item_t* first,
+                  bool* resync)
+{
+  if (!ExportBinaryNodesIfDue(state, resync)) {
+    return false;
+  }
+
+  export_frame_writer_t writer;
+  if (ExportFrameWriterInit(&writer,
+                            state->export_frame,
+                            sizeof(state->export_frame),
+                            EXPORT_FRAME_TYPE_RECORDS,
+                            state->export_frame_sequence) != ESP_OK) {
+    return false;
+  }
+  record_ring_item_t item = *first;
+  for (;;) {
+    (void)ExportFrameWriterAddRecord(&writer, item.node_index, &item.record);
+    if (ExportFrameWriterIsFull(&writer) ||
+        !RecordRingPop(&state->export_ring, state->export_consumer_id, &item)) {
+      break;
+    }
+  }
+  return ExportWriteFrame(state, &writer, false);
+}
+
+static void
+NoteAlarmExported(runtime_state_t* state, const alarm_event_t* event)
+{
+  state->alarm_stats.exported++;
+  if (event->epoch_ms <= 0 || !TimeSyncIsSystemTimeValid()) {
+    return;
+  }
+  const int64_t latency_ms = TimeSyncGetEpochUs() / 1000 - event->epoch_ms;
+  const uint32_t clamped =
+    (latency_ms < 0) ? 0u
+    : (latency_ms > (int64_t)UINT32_MAX) ? UINT32_MAX
+                                         : (uint32_t)latency_ms;
+  state->alarm_stats.latency_last_ms = clamped;
+  if (clamped > state->alarm_stats.latency_max_ms) {
+    state->alarm_stats.latency_max_ms = clamped;
+  }
+}
+
+// Writes every queued alarm before the next record batch, so an alarm waits
+// behind at most the batch already being written.
+static void
+ExportAlarms(runtime_state_t* state,
+             app_export_format_t format,
+             bool* resync)
+{
+  alarm_queue_item_t item;
+  if (state->alarm_queue == NULL ||
+      xQueuePeek(state->alarm_queue, &item, 0) != pdTRUE) {
+    return;
+  }
+  if (!state->data_streaming_enabled) {
+    while (xQueueReceive(state->alarm_queue, &item, 0) == pdTRUE) {
+    }
+    return;
+  }
+
+  if (format == APP_EXPORT_FORMAT_BINARY) {
+    if (!ExportBinaryNodesIfDue(state, resync)) {
+      state->export_write_fail_count++;
+      return;
+    }
+    export_frame_writer_t writer;
+    if (ExportFrameWriterInit(&writer,
+                              state->export_frame,
+                              sizeof(state->export_frame),
+                              EXPORT_FRAME_TYPE_ALARMS,
+                              state->export_frame_sequence) != ESP_OK) {
+      return;
+    }
+    alarm_event_t written[ALARM_QUEUE_LEN];
+    uint32_t count = 0;
+    while (count < ALARM_QUEUE_LEN && !ExportFrameWriterIsFull(&writer) &&
+           xQueueReceive(state->alarm_queue, &item, 0) == pdTRUE) {
+      (void)ExportFrameWriterAddAlarm(&writer, item.node_index, &item.event);
+      written[count++] = item.event;
+    }
+    if (!ExportWriteFrame(state, &writer, false)) {
+      state->export_write_fail_count++;
+      return;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      NoteAlarmExported(state, &written[i]);
+    }
+    return;
+  }
+
+  if (!TryEmitCsvHeader(state)) {
+    return;
+  }
+  while (xQueueReceive(state->alarm_queue, &item, 0) == pdTRUE) {
+    const node_table_entry_t* node =
+      NodeTableGet(&state->node_table, item.node_index);
+    char line[kExportCsvRowMaxLen];
+    size_t length = 0;
+    if (!CsvFormatAlarm(&item.event,
+                        (node != NULL) ? node->id_string : "",
+                        line,
+                        sizeof(line),
+                        &length)) {
+      continue;
+    }
+    if (!CsvDataPortWriter(line, length, NULL)) {
+      state->export_write_fail_count++;
+      continue;
+    }
+    NoteAlarmExported(state, &item.event);
+  }
+}
+
+static void
+ExportTask(void* context)
+{
+  runtime_state_t* state = (runtime_state_t*)context;
+
+  const uint32_t consumer = state->export_consumer_id;
+  app_export_format_t active_format = state->export_format;
+  bool resync = true;
+
+  while (!state->stop_requested ||
+         RecordRingPending(&state->export_ring, consumer) > 0) {
+    const app_export_format_t format = state->export_format;
+    if (format != active_format) {
+      active_format = format;
+      resync = true;
+    }
+    ExportAlarms(state, format, &resync);
+
+    record_ring_item_t item;
+    if (!RecordRingPop(&state->export_ring, consumer, &item)) {
+      (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500));
+      continue;
+    }
+    if (!state->data_streaming_enabled) {
+      resync = true;
+      continue;
+    }
+
+    bool written = false;
+    if (format == APP_EXPORT_FORMAT_BINARY) {
+      written = ExportBinaryBatch(state, &item, &resync);
+    } else {
+      if (!TryEmitCsvHeader(state)) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+        continue;
+      }
+      written = ExportCsvBatch(state, &item);
+    }
+    if (!written) {
+      state->export_write_fail_count++;
+      vTaskDelay(pdMS_TO_TICKS(50));
+    }
+  }
+
+  state->export_task = NULL;
+  vTaskDelete(NULL);
+}
+
+static bool
+MeshCursorUsesFram(const runtime_state_t* state)
+{
+  return state->fram_i2c.initialized && state->fram_log.mounted;
+}
+
+// Sends the unsent part of the RAM backlog in order until the transport
+// refuses one. Sent records stay until the root ACKs them.
+static void
+MeshRamBacklogDrain(runtime_state_t* state)
+{
+  while (state->mesh_ram_backlog_sent < state->mesh_ram_backlog_count) {
+    const uint32_t index =
+      (state->mesh_ram_backlog_head + state->mesh_ram_backlog_sent) %
+      MESH_RAM_BACKLOG_RECORDS;
+    const log_record_t* record = &state->mesh_ram_backlog[index];
+    if (MeshTransportQueueRecord(&state->mesh, record) != ESP_OK) {
+      return;
+    }
+    state->mesh_ram_backlog_sent++;
+    state->mesh_cursor_record_id = record->record_id + 1u;
+  }
+}
+
+// Drops the oldest backlog entry, which has been sent or ACKed.
+static void
+MeshRamBacklogPop(runtime_state_t* state)
+{
+  state->mesh_ram_backlog_head =
+    (state->mesh_ram_backlog_head + 1u) % MESH_RAM_BACKLOG_RECORDS;
+  state->mesh_ram_backlog_count--;
+  if (state->mesh_ram_backlog_sent > 0) {
+    state->mesh_ram_backlog_sent--;
+  }
+}
+
+// Holds a record until the root ACKs it. When full the oldest goes; a
+// record that never left is counted as dropped, logged at most every 5 s.
+static void
+MeshRamBacklogPush(runtime_state_t* state, const log_record_t* record)
+{
+  if (state->mesh_ram_backlog_count == MESH_RAM_BACKLOG_RECORDS) {
+    if (state->mesh_ram_backlog_sent == 0) {
+      state->mesh_ram_backlog_dropped++;
+    }
+    MeshRamBacklogPop(state);
+    const TickType_t now_ticks = xTaskGetTickCount();
+    if (state->mesh_ram_backlog_log_ticks == 0 ||
+        pdTICKS_TO_MS(now_ticks - state->mesh_ram_backlog_log_ticks) >=
+          5000u) {
+      ESP_LOGW(kTag,
+               "mesh RAM backlog full (no FRAM): %u records dropped so far",
+               (unsigned)state->mesh_ram_backlog_dropped);
+      state->mesh_ram_backlog_log_ticks = now_ticks;
+    }
+  }
+  const uint32_t tail =
+    (state->mesh_ram_backlog_head + state->mesh_ram_backlog_count) %
+    MESH_RAM_BACKLOG_RECORDS;
+  state->mesh_ram_backlog[tail] = *record;
+  state->mesh_ram_backlog_count++;
+}
+
+static void
+MeshForwardLiveRecord(runtime_state_t* state, const log_record_t* record)
+{
+  if (!MeshTransportIsConnected(&state->mesh)) {
+    return; // stays in FRAM; MeshBackfillPump replays it after reconnect
+  }
+  // Without FRAM every record waits in the RAM backlog, behind any it
+  // already holds, until the root ACKs it; with FRAM, the cursor stays put
+  // and the pump sends it once credit is back.
+  if (!MeshCursorUsesFram(state)) {
+    MeshRamBacklogPush(state, record);
+    MeshRamBacklogDrain(state);
+    return;
+  }
+  // Send from memory only when the cursor is caught up; otherwise the pump
+  // reaches this record in order.
+  if (state->mesh_cursor_record_id == record->record_id) {
+    if (MeshTransportQueueRecord(&state->mesh, record) == ESP_OK) {
+      state->mesh_cursor_record_id++;
+    }
+  }
+}
+
+static void
+MeshApplyAck(runtime_state_t* state)
+{
+  uint64_t acked = 0;
+  if (!MeshTransportTakeAck(&state->mesh, &acked)) {
+    return;
+  }
+  const uint64_t resume = acked + 1u;
+  while (state->mesh_ram_backlog_count > 0 &&
+         state->mesh_ram_backlog[state->mesh_ram_backlog_head].record_id <=
+           acked) {
+    MeshRamBacklogPop(state);
+  }
+  // Records sent before the previous ACK have had a full ACK period to
+  // arrive. Only rewind when the root is missing some of those, so frames
+  // still in flight (held by relays, too) are not replayed needlessly. The
+  // mark starts at the boot cursor, so the first ACK still rewinds over
+  // anything the root lacks from before this boot.
+  if (resume < state->mesh_cursor_at_last_ack) {
+    if (resume < state->mesh_cursor_record_id) {
+      ESP_LOGD(kTag,
+               "mesh rewind %" PRIu64 " -> %" PRIu64,
+               state->mesh_cursor_record_id,
+               resume);
+      state->mesh_cursor_record_id = resume;
+      state->mesh_ram_backlog_sent = 0;
+      state->mesh_rewinds_total++;
+    }
+  }
+  state->mesh_cursor_at_last_ack = state->mesh_cursor_record_id;
+}
+
+// Backfill rate: the configured limit, lowered to the root's credit grant
+// (records per minute, rounded up) so the pump does not outrun it.
+static uint32_t
+MeshBackfillRate(runtime_state_t* state)
+{
+  const uint32_t grant = MeshTransportCreditGrant(&state->mesh);
+  if (grant == MESH_TRANSPORT_CREDIT_UNLIMITED) {
+    return kMeshBackfillRecordsPerSec;
+  }
+  const uint32_t granted_per_s = (grant + 59u) / 60u;
+  return (granted_per_s < kMeshBackfillRecordsPerSec) ? granted_per_s
+                                                      : kMeshBackfillRecordsPerSec;
+}
+
+static void
+MeshBackfillPump(runtime_state_t* state)
+{
+  if (!MeshTransportIsConnected(&state->mesh)) {
+    return;
+  }
+  if (!MeshCursorUsesFram(state)) {
+    MeshRamBacklogDrain(state);
+    return;
+  }
+
+  const uint32_t rate = MeshBackfillRate(state);
+  const TickType_t now_ticks = xTaskGetTickCount();
+  const uint32_t elapsed_ms =
+    pdTICKS_TO_MS(now_ticks - state->mesh_backfill_refill_ticks);
+  const uint32_t refill = (elapsed_ms * rate) / 1000u;
+  if (refill > 0) {
+    state->mesh_backfill_tokens += refill;
+    if (state->mesh_backfill_tokens > rate) {
+      state->mesh_backfill_tokens = rate;
+    }
+    state->mesh_backfill_refill_ticks = now_ticks;
+  }
+
+  const uint64_t next_record_id = FramLogNextRecordId(&state->fram_log);
+  while (state->mesh_backfill_tokens > 0 &&
+         state->mesh_cursor_record_id < next_record_id) {
+    log_record_t record;
+    esp_err_t peek_result = FramLogPeekRetainedRecordId(
+      &state->fram_log, state->mesh_cursor_record_id, &record);
+    if (peek_result == ESP_ERR_NOT_FOUND) {
+      const uint64_t oldest = FramLogOldestRetainedRecordId(&state->fram_log);
+      if (oldest == 0 || oldest <= state->mesh_cursor_record_id) {
+        break; // not appended yet
+      }
+      ESP_LOGW(kTag,
+               "mesh backfill gap: records %" PRIu64 "..%" PRIu64
+               " no longer in FRAM",
+               state->mesh_cursor_record_id,
+               oldest - 1u);
+      if (MeshTransportSendGap(&state->mesh, oldest) != ESP_OK) {
+        break;
+      }
+      state->mesh_cursor_record_id = oldest;
+      continue;
+    }
+    if (peek_result != ESP_OK) {
+      // Unreadable slot: let the root step over this single record.
+      if (MeshTransportSendGap(&state->mesh,
+                               state->mesh_cursor_record_id + 1u) != ESP_OK) {
+        break;
+      }
+      state->mesh_cursor_record_id++;
+      continue;
+    }
+    if (MeshTransportQueueRecord(&state->mesh, &record) != ESP_OK) {
+      break; // offline or out of credit: resume from here later
+    }
+    state->mesh_cursor_record_id++;
+    state->mesh_backfill_tokens--;
+    state->mesh_backfill_records_total++;
+  }
+}
+
+static const uint8_t kBurstWriteMaxAttempts = 3;
+static const uint32_t kBurstWriteRetryMs = 10000;
+static const size_t kBurstChunkBytes = 16384;
+static const size_t kBurstRowMaxLen = 96;
+
+// Highest burst file id on the card, 0 when there are none.
+static uint32_t
+LastBurstId(const runtime_state_t* state)
+{
+  char dir_path[48];
+  snprintf(dir_path,
+           sizeof(dir_path),
+           "%s/%s",
+           state->sd_logger.mount_point,
+           BURST_CAPTURE_DIR);
+  uint32_t last = 0;
+  DIR* dir = opendir(dir_path);
+  if (dir == NULL) {
+    return 0;
+  }
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    uint32_t id = 0;
+    if (BurstCaptureParseFileName(entry->d_name, &id) && id > last) {
+      last = id;
+    }
+  }
+  closedir(dir);
+  return last;
+}
+
+// StorageTask: writes a frozen burst to its own file through the verified
+// append, then re-arms. The daily log and FRAM are not involved; a failed
+// write is retried a few times, then the burst is dropped.
+static void
+WriteFrozenBurst(runtime_state_t* state)
+{
+  taskENTER_CRITICAL(&state->burst_lock);
+  const bool frozen = state->burst.state == BURST_CAPTURE_FROZEN;
+  taskEXIT_CRITICAL(&state->burst_lock);
+  if (!frozen || !state->sd_logger.is_mounted) {
+    return;
+  }
+  const TickType_t now_ticks = xTaskGetTickCount();
+  if (state->burst_retry_ticks != 0 &&
+      (int32_t)(now_ticks - state->burst_retry_ticks) < 0) {
+    return;
+  }
+  char* chunk = (char*)malloc(kBurstChunkBytes);
+  if (chunk == NULL) {
+    return;
+  }
+  if (state->burst_next_id == 0) {
+    state->burst_next_id = LastBurstId(state) + 1u;
+  }
+  char name[32];
+  BurstCaptureFileName(state->burst_next_id, name, sizeof(name));
+  char path[48];
+  snprintf(path, sizeof(path), "%s/%s", BURST_CAPTURE_DIR, name);
+
+  const burst_capture_t* burst = &state->burst;
+  const uint32_t count = BurstCaptureFrozenCount(burst);
+  int written = snprintf(
+    chunk,
+    kBurstChunkBytes,
+    "# burst %" PRIu32 " trigger=%s channel=%u trigger_epoch_ms=%" PRId64
+    " period_ms=%" PRIu32 " pre_ms=%" PRIu32 " post_ms=%" PRIu32 "\n"
+    "epoch_ms,offset_ms,channel,raw_milli_c,temp_milli_c,"
+    "resistance_milli_ohm,fault\n",
+    state->burst_next_id,
+    BurstTriggerSourceToString(burst->trigger_source),
+    (unsigned)burst->trigger_channel,
+    burst->trigger_epoch_ms,
+    burst->config.period_ms,
+    burst->config.pre_ms,
+    burst->config.post_ms);
+  size_t used = (written > 0) ? (size_t)written : 0;
+  esp_err_t result = ESP_OK;
+  SdCsvAppendDiagnostics diag = { 0 };
+  for (uint32_t i = 0; i < count && result == ESP_OK; ++i) {
+    if (kBurstChunkBytes - used < kBurstRowMaxLen) {
+      result = SdLoggerAppendVerifiedFile(
+        &state->sd_logger, path, (const uint8_t*)chunk, used, &diag);
+      used = 0;
+    }
+    const burst_sample_t* sample = BurstCaptureFrozenSample(burst, i);
+    written = snprintf(chunk + used,
+                       kBurstChunkBytes - used,
+                       "%" PRId64 ",%" PRId64 ",%u,%" PRId32 ",%" PRId32
+                       ",%" PRId32 ",%u\n",
+                       sample->epoch_ms,
+                       sample->mono_ms - burst->trigger_mono_ms,
+                       (unsigned)sample->channel,
+                       sample->raw_milli_c,
+                       sample->temp_milli_c,
+                       sample->resistance_milli_ohm,
+                       sample->fault ? 1u : 0u);
+    if (written > 0) {
+      used += (size_t)written;
+    }
+  }
+  if (result == ESP_OK && used > 0) {
+    result = SdLoggerAppendVerifiedFile(
+      &state->sd_logger, path, (const uint8_t*)chunk, used, &diag);
+  }
+  free(chunk);
+
+  if (result != ESP_OK) {
+    char full_path[80];
+    snprintf(full_path,
+             sizeof(full_path),
+             "%s/%s",
+             state->sd_logger.mount_point,
+             path);
+    (void)remove(full_path); // no partial bursts on the card
+    const bool give_up =
+      ++state->burst_write_attempts >= kBurstWriteMaxAttempts;
+    ESP_LOGW(kTag,
+             "Burst write to %s failed (%s%s%s)%s",
+             path,
+             esp_err_to_name(result),
+             (diag.operation != NULL) ? ", " : "",
+             (diag.operation != NULL) ? diag.operation : "",
+             give_up ? "; dropped" : "; will retry");
+    taskENTER_CRITICAL(&state->burst_lock);
+    state->burst.stats.write_failures++;
+    if (give_up) {
+      BurstCaptureRearm(&state->burst);
+    }
+    taskEXIT_CRITICAL(&state->burst_lock);
+    if (give_up) {
+      state->burst_write_attempts = 0;
+      state->burst_retry_ticks = 0;
+    } else {
+      state->burst_retry_ticks =
+        now_ticks + pdMS_TO_TICKS(kBurstWriteRetryMs);
+    }
+    return;
+  }
+
+  ESP_LOGI(kTag, "Burst written: %s (%u samples)", path, (unsigned)count);
+  state->burst_next_id++;
+  state->burst_write_attempts = 0;
+  state->burst_retry_ticks = 0;
+  taskENTER_CRITICAL(&state->burst_lock);
+  state->burst.stats.written++;
+  BurstCaptureRearm(&state->burst);
+  taskEXIT_CRITICAL(&state->burst_lock);
+}
+
+static void
+StorageTask(void* context)
+{
+  runtime_state_t* state = (runtime_state_t*)context;
+  state->last_flush_ticks = xTaskGetTickCount();
+  state->mesh_cursor_record_id = FramLogNextRecordId(&state->fram_log);
+  state->mesh_cursor_at_last_ack = state->mesh_cursor_record_id;
+  state->mesh_backfill_tokens = 0;
+  state->mesh_backfill_refill_ticks = state->last_flush_ticks;
+
+  while (!state->stop_requested ||
+         uxQueueMessagesWaiting(state->log_queue) > 0) {
+    log_record_t record;
+    uint32_t wait_ms = 500;
+    const uint32_t mesh_due_ms = MeshTransportMsUntilFlushDue(&state->mesh);
+    if (mesh_due_ms < wait_ms) {
+      wait_ms = mesh_due_ms;
+    }
+    if (xQueueReceive(state->log_queue, &record, pdMS_TO_TICKS(wait_ms)) ==
+        pdTRUE) {
+      esp_err_t id_result = FramLogAssignRecordIds(&state->fram_log, &record);
+      if (id_result != ESP_OK) {
+        ESP_LOGE(
+          kTag, "Failed to assign record id: %s", esp_err_to_name(id_result));
+      }
+
+      if (state->fram_i2c.initialized) {
+        esp_err_t append_result = FramLogAppend(&state->fram_log, &record);
+        if (append_result != ESP_OK) {
+          ESP_LOGE(
+            kTag, "FRAM append failed: %s", esp_err_to_name(append_result));
+        } else {
+          state->sd_flush_records_since++;
+        }
+        const uint64_t overrun_after =
+          FramLogGetOverrunRecordsTotal(&state->fram_log);
+        const size_t fram_count = FramLogGetCountRecords(&state->fram_log);
+        const size_t fram_capacity =
+          FramLogGetCapacityRecords(&state->fram_log);
+        const TickType_t now_ticks = xTaskGetTickCount();
+        LogFramOverrunWarning(
+          state, overrun_after, fram_count, fram_capacity, now_ticks);
+        state->last_overrun_records_total = overrun_after;
+        UpdateFramFillState(state);
+        if (state->fram_full) {
+          record.flags |= LOG_RECORD_FLAG_FRAM_FULL;
+        }
+      }
+      // Flags are final: the CRC travels with the record to the root.
+      LogRecordSeal(&record);
+
+      if (!state->mesh.is_root) {
+        MeshForwardLiveRecord(state, &record);
+      }
+
+      EnqueueExportRecord(state, state->local_node_index, &record);
+    }
+
+    if (!state->mesh.is_root) {
+      MeshApplyAck(state);
+      MeshBackfillPump(state);
+      (void)MeshTransportFlushIfDue(&state->mesh);
+    }
+
+    const TickType_t now_ticks = xTaskGetTickCount();
+    const bool periodic_due =
+      (pdTICKS_TO_MS(now_ticks - state->last_flush_ticks) >=
+       state->settings.sd_flush_period_ms);
+    const uint32_t buffered = FramLogGetBufferedRecords(&state->fram_log);
+    const bool watermark_hit =
+      buffered >= state->settings.fram_flush_watermark_records;
+
+    if (periodic_due) {
+      state->sd_flush_pending = true;
+      state->last_flush_ticks = now_ticks;
+    }
+    if (watermark_hit) {
+      state->sd_flush_pending = true;
     }
 
     if (state->sd_flush_pending) {
@@ -1195,6 +2604,8 @@ StorageTask(void* context)
       }
     }
 
+    WriteFrozenBurst(state);
+
     if (!state->sd_logger.is_mounted) {
       state->sd_was_mounted = false;
     } else if (!state->sd_was_mounted) {
@@ -1202,41 +2613,214 @@ StorageTask(void* context)
     }
   }
 
+  if (!state->mesh.is_root) {
+    (void)MeshTransportFlushRecords(&state->mesh);
+  }
+
   if (state->sd_logger.is_mounted) {
     (void)SdFlushWorkerTick(
       state, kSdFlushMaxRecordsPerPass, kSdFlushMaxMsPerPass, NULL, NULL);
   }
+  WriteFrozenBurst(state);
 
   state->storage_task = NULL;
   vTaskDelete(NULL);
 }
 
+// Leaf: one two-way exchange with the root, applied to the system clock.
+// Returns true when a reply arrived.
+static bool
+MeshTimeProbeRound(runtime_state_t* state)
+{
+  if (!MeshTransportIsConnected(&state->mesh) ||
+      MeshTransportSendTimeProbe(&state->mesh) != ESP_OK) {
+    return false;
+  }
+  clock_sync_sample_t sample;
+  const TickType_t start_ticks = xTaskGetTickCount();
+  while (!MeshTransportTakeTimeSample(&state->mesh, &sample)) {
+    if (state->stop_requested ||
+        (xTaskGetTickCount() - start_ticks) >=
+          pdMS_TO_TICKS(kTimeProbeTimeoutMs)) {
+      return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+
+  // A slew from an earlier round may still be running (a large one takes
+  // longer than the fast period). Stop it and hand the estimator what it
+  // did not apply; the new sample already measured the clock without it.
+  int64_t unapplied_us = 0;
+  (void)TimeSyncSlewSystemUs(0, &unapplied_us);
+
+  // The next sample is due after the fast period while the window fills,
+  // which is when feed-forward matters least; use the steady period.
+  int64_t correction_us = 0;
+  taskENTER_CRITICAL(&state->clock_sync_lock);
+  ClockSyncNoteUnapplied(&state->clock_sync, unapplied_us);
+  const clock_sync_action_t action =
+    ClockSyncAddSample(&state->clock_sync,
+                       &sample,
+                       (int64_t)kTimeProbePeriodMs * 1000,
+                       &correction_us);
+  if (action == CLOCK_SYNC_ACTION_NONE) {
+    // Rejected sample: let the interrupted slew finish after all.
+    ClockSyncNoteUnapplied(&state->clock_sync, -unapplied_us);
+  }
+  taskEXIT_CRITICAL(&state->clock_sync_lock);
+
+  if (action == CLOCK_SYNC_ACTION_STEP) {
+    ESP_LOGI(kTag,
+             "Time sync: stepping clock by %lld us",
+             (long long)correction_us);
+    (void)TimeSyncStepSystemUs(correction_us, true, &state->time_sync);
+  } else if (action == CLOCK_SYNC_ACTION_SLEW) {
+    (void)TimeSyncSlewSystemUs(correction_us, NULL);
+  } else if (unapplied_us != 0) {
+    (void)TimeSyncSlewSystemUs(unapplied_us, NULL);
+  }
+  return true;
+}
+
+// +/-25% jitter so leaves that booted together do not stay in lockstep.
+static uint32_t
+JitteredMs(uint32_t base_ms)
+{
+  const uint32_t span_ms = base_ms / 2u;
+  if (span_ms == 0) {
+    return base_ms;
+  }
+  return base_ms - span_ms / 2u + (esp_random() % (span_ms + 1u));
+}
+
+// Root: replies to probes, one coalesced broadcast per burst of legacy
+// requests, and periodic broadcasts. Leaves ignore a broadcast unless they
+// are unsynced or off by seconds, so the period backs off while their
+// records report a valid clock and returns to the base period when one
+// reports otherwise or a node joins.
+static void
+RootTimeService(runtime_state_t* state)
+{
+  const int64_t base_period_us = (int64_t)CONFIG_APP_TIME_SYNC_PERIOD_S * 1000000;
+  int64_t next_broadcast_us = 0;
+  uint32_t backoff_shift = 0;
+  uint32_t known_nodes = NodeTableCount(&state->node_table);
+
+  while (!state->stop_requested) {
+    (void)MeshTransportFlushTimeReplies(&state->mesh);
+
+    const int64_t now_us = esp_timer_get_time();
+    bool restart = false;
+    const uint32_t node_count = NodeTableCount(&state->node_table);
+    if (node_count != known_nodes) {
+      // New node: it may be unsynced and not ask (two-way sync firmware).
+      known_nodes = node_count;
+      restart = true;
+    }
+    if (backoff_shift > 0 &&
+        atomic_load_explicit(&state->time_leaf_unsynced_seen,
+                             memory_order_relaxed)) {
+      restart = true;
+    }
+    if (MeshTransportTakeTimeRequests(&state->mesh, kTimeRequestCoalesceUs)) {
+      // Somebody is unsynced (boot, new node): answer and restart backoff.
+      restart = true;
+    }
+    if (restart) {
+      backoff_shift = 0;
+      next_broadcast_us = now_us;
+    }
+
+    if (now_us >= next_broadcast_us && TimeSyncIsSystemTimeValid() &&
+        MeshTransportIsConnected(&state->mesh)) {
+      // Reports since the last broadcast set the next interval: any
+      // unsynced leaf holds the base period, synced leaves alone back off,
+      // and no reports at all keep the interval as it is.
+      const bool unsynced = atomic_exchange_explicit(
+        &state->time_leaf_unsynced_seen, false, memory_order_relaxed);
+      const bool synced = atomic_exchange_explicit(
+        &state->time_leaf_synced_seen, false, memory_order_relaxed);
+      if (unsynced || restart) {
+        backoff_shift = 0;
+      } else if (synced && backoff_shift < kTimeBroadcastMaxBackoffShift) {
+        backoff_shift++;
+      }
+      const int64_t now_seconds = (int64_t)time(NULL);
+      (void)MeshTransportBroadcastTime(&state->mesh, now_seconds);
+      next_broadcast_us = now_us + (base_period_us << backoff_shift);
+    }
+    vTaskDelay(pdMS_TO_TICKS(kTimeServiceTickMs));
+  }
+}
+
 static void
 TimeSyncTask(void* context)
 {
   runtime_state_t* state = (runtime_state_t*)context;
 
   if (state->settings.node_role == APP_NODE_ROLE_SENSOR) {
-    while (!TimeSyncIsSystemTimeValid() && !state->stop_requested) {
-      if (MeshTransportIsConnected(&state->mesh)) {
-        (void)MeshTransportRequestTime(&state->mesh);
+    TickType_t last_legacy_request_ticks = 0;
+    bool legacy_requested = false;
+    vTaskDelay(pdMS_TO_TICKS(esp_random() % kTimeProbeFastPeriodMs));
+    while (!state->stop_requested) {
+      const bool have_sample = MeshTimeProbeRound(state);
+      if (!have_sample && !TimeSyncIsSystemTimeValid() &&
+          MeshTransportIsConnected(&state->mesh)) {
+        // Roots without two-way sync still answer the legacy request.
+        const TickType_t now_ticks = xTaskGetTickCount();
+        if (!legacy_requested ||
+            (now_ticks - last_legacy_request_ticks) >=
+              pdMS_TO_TICKS(JitteredMs(kTimeLegacyRequestPeriodMs))) {
+          (void)MeshTransportRequestTime(&state->mesh);
+          last_legacy_request_ticks = now_ticks;
+          legacy_requested = true;
+        }
       }
-      vTaskDelay(pdMS_TO_TICKS(10 * 1000));
+      taskENTER_CRITICAL(&state->clock_sync_lock);
+      const bool window_full =
+        state->clock_sync.window_count >= CLOCK_SYNC_WINDOW;
+      taskEXIT_CRITICAL(&state->clock_sync_lock);
+      vTaskDelay(pdMS_TO_TICKS(JitteredMs(
+        window_full ? kTimeProbePeriodMs : kTimeProbeFastPeriodMs)));
     }
   }
 
   if (state->settings.node_role == APP_NODE_ROLE_ROOT) {
-    while (!state->stop_requested) {
-      if (TimeSyncIsSystemTimeValid() &&
-          MeshTransportIsConnected(&state->mesh)) {
-        const int64_t now_seconds = (int64_t)time(NULL);
-        (void)MeshTransportBroadcastTime(&state->mesh, now_seconds);
+    RootTimeService(state);
+  }
+
+  state->time_sync_task = NULL;
+  vTaskDelete(NULL);
+}
+
+// Root only: releases records held in the per-node reorder windows and
+// broadcasts ACKs (with credit grants) every kMeshAckPeriodMs.
+static void
+MeshAckTask(void* context)
+{
+  runtime_state_t* state = (runtime_state_t*)context;
+  TickType_t last_ack_ticks = xTaskGetTickCount();
+  MeshCreditInit(&state->mesh_credit, &state->export_ring);
+
+  while (!state->stop_requested) {
+    MeshTransportReorderTick(&state->mesh);
+    const TickType_t now_ticks = xTaskGetTickCount();
+    if ((now_ticks - last_ack_ticks) >= pdMS_TO_TICKS(kMeshAckPeriodMs)) {
+      last_ack_ticks = now_ticks;
+      if (kMeshCreditFlowControl) {
+        MeshTransportSetCreditBudget(
+          &state->mesh,
+          MeshCreditUpdate(
+            &state->mesh_credit, &state->export_ring, kMeshAckPeriodMs));
+      }
+      if (MeshTransportIsConnected(&state->mesh)) {
+        (void)MeshTransportBroadcastAcks(&state->mesh);
       }
-      vTaskDelay(pdMS_TO_TICKS(CONFIG_APP_TIME_SYNC_PERIOD_S * 1000));
     }
+    vTaskDelay(pdMS_TO_TICKS(kMeshReorderTickMs));
   }
 
-  state->time_sync_task = NULL;
+  state->mesh_ack_task = NULL;
   vTaskDelete(NULL);
 }
 
@@ -1254,6 +2838,7 @@ TopologyTask(void* context)
     char parent_str[20] = "unknown";
 
     if (MeshTransportIsStarted(&state->mesh)) {
+      MeshRejoinSaveParent();
       layer = esp_mesh_lite_get_level();
       mesh_lite_ap_record_t ap_record = { 0 };
       if (esp_mesh_lite_get_ap_record(&ap_record) == ESP_OK) {
@@ -1329,6 +2914,10 @@ InitializeRuntimeStruct(void)
   memset(&g_state, 0, sizeof(g_state));
   memset(&g_runtime, 0, sizeof(g_runtime));
   g_state.last_temp_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  g_state.clock_sync_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  g_state.sample_timing_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  g_state.burst_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  ClockSyncInit(&g_state.clock_sync, kTimeStepThresholdUs);
 
   g_runtime.settings = &g_state.settings;
   g_runtime.fram_i2c = &g_state.fram_i2c;
@@ -1336,6 +2925,7 @@ InitializeRuntimeStruct(void)
   g_runtime.fram_log = &g_state.fram_log;
   g_runtime.sd_logger = &g_state.sd_logger;
   g_runtime.sensor = &g_state.sensor;
+  g_runtime.rtd_channels = &g_state.rtd_channels;
   g_runtime.mesh = &g_state.mesh;
   g_runtime.time_sync = &g_state.time_sync;
   g_runtime.i2c_bus = &g_state.i2c_bus;
@@ -1343,7 +2933,8 @@ InitializeRuntimeStruct(void)
   g_runtime.flush_callback = &RuntimeFlushToSd;
   g_runtime.flush_context = &g_state;
   g_runtime.fram_full = &g_state.fram_full;
-  g_runtime.export_dropped_count = &g_state.export_dropped_count;
+  g_runtime.export_ring = &g_state.export_ring;
+  g_runtime.node_table = &g_state.node_table;
   g_runtime.export_write_fail_count = &g_state.export_write_fail_count;
 }
 
@@ -1353,6 +2944,36 @@ RuntimeGetRuntime(void)
   return g_state.initialized ? &g_runtime : NULL;
 }
 
+// Swaps every channel's chip for the trace on the SD card, each channel
+// replaying its own rows, so the logger runs without probes.
+static void
+AttachSensorReplay(runtime_state_t* state)
+{
+  char path[96];
+  snprintf(path,
+           sizeof(path),
+           "%s/%s",
+           state->sd_logger.mount_point,
+           kSensorReplayFile);
+  rtd_channels_t* channels = &state->rtd_channels;
+  for (uint8_t ch = 0; ch < channels->count; ++ch) {
+    max31865_replay_t* replay = &state->sensor_replay[ch];
+    esp_err_t result = Max31865ReplayOpen(
+      replay, path, (int8_t)ch, kSensorReplaySpeed, kSensorReplayLoop);
+    if (result == ESP_OK) {
+      result = Max31865ReaderAttachReplay(channels->readers[ch], replay);
+    }
+    if (result != ESP_OK) {
+      Max31865ReplayClose(replay);
+      ESP_LOGE(kTag,
+               "Replay of %s on channel %u failed: %s",
+               path,
+               (unsigned)ch,
+               esp_err_to_name(result));
+    }
+  }
+}
+
 esp_err_t
 RuntimeManagerInit(void)
 {
@@ -1368,6 +2989,10 @@ RuntimeManagerInit(void)
     ESP_LOGE(kTag, "esp_read_mac failed: %s", esp_err_to_name(mac_result));
   }
   FormatMacString(mac, g_state.node_id_string, sizeof(g_state.node_id_string));
+  NodeTableInit(&g_state.node_table);
+  const pt100_mesh_addr_t local_addr = Pt100MeshAddrFromMac(mac);
+  (void)NodeTableIntern(
+    &g_state.node_table, &local_addr, &g_state.local_node_index);
 
   esp_err_t settings_result = AppSettingsLoad(&g_state.settings);
   if (settings_result != ESP_OK) {
@@ -1378,6 +3003,13 @@ RuntimeManagerInit(void)
       kTag, "AppSettingsLoad failed: %s", esp_err_to_name(settings_result));
   }
   AppSettingsApplyTimeZone(&g_state.settings);
+  g_state.export_format = g_state.settings.export_format;
+  if (DataPortSetBaudRate(g_state.settings.data_baud_rate) != ESP_OK) {
+    ESP_LOGW(kTag,
+             "Invalid data port baud %u; keeping %u",
+             (unsigned)g_state.settings.data_baud_rate,
+             (unsigned)DataPortGetBaudRate());
+  }
 
 #if CONFIG_APP_MAX7219_ENABLE
   max7219_display_config_t display_config = {
@@ -1493,6 +3125,22 @@ RuntimeManagerInit(void)
     ESP_LOGE(
       kTag, "Max31865ReaderInit failed: %s", esp_err_to_name(sensor_result));
   }
+  if (sensor_result == ESP_OK && kSensorDrdyGpio >= 0 && !kSensorReplay) {
+    esp_err_t drdy_result =
+      Max31865ReaderAttachDrdy(&g_state.sensor, kSensorDrdyGpio);
+    if (drdy_result != ESP_OK) {
+      ESP_LOGW(kTag,
+               "DRDY on GPIO %d unavailable (%s); polling instead",
+               kSensorDrdyGpio,
+               esp_err_to_name(drdy_result));
+    }
+  }
+  // Channel 0 is logged (as faults) even when its init failed.
+  (void)RtdChannelsInit(
+    &g_state.rtd_channels, &g_state.sensor, spi_host, kRtdExtraCsGpios);
+  if (kSensorReplay) {
+    AttachSensorReplay(&g_state);
+  }
   if (sensor_result == ESP_OK && g_state.settings.calibration.is_valid) {
     calibration_context_t current_context;
     AppSettingsBuildCalibrationContextFromReader(&current_context,
@@ -1506,7 +3154,9 @@ RuntimeManagerInit(void)
     }
   }
 
-  g_state.log_queue = xQueueCreate(64, sizeof(log_record_t));
+  // One record per channel each sample period.
+  g_state.log_queue =
+    xQueueCreate(64u * g_state.rtd_channels.count, sizeof(log_record_t));
   if (g_state.log_queue == NULL) {
     if (first_error == ESP_OK) {
       first_error = ESP_ERR_NO_MEM;
@@ -1514,12 +3164,32 @@ RuntimeManagerInit(void)
     ESP_LOGE(kTag, "Failed to create log queue");
   }
 
-  g_state.export_queue = xQueueCreate(kExportQueueDepth, sizeof(export_item_t));
-  if (g_state.export_queue == NULL) {
+  AlarmRulesFromConfig(&g_state.alarm_rules);
+  if (kAlarmsEnabled) {
+    g_state.alarm_queue =
+      xQueueCreate(ALARM_QUEUE_LEN, sizeof(alarm_queue_item_t));
+    if (g_state.alarm_queue == NULL) {
+      // Alarms still go into the records; only the fast lane is lost.
+      ESP_LOGE(kTag, "Failed to create alarm queue");
+    }
+  }
+
+  esp_err_t ring_result =
+    RecordRingInit(&g_state.export_ring, kExportRingRecords);
+  if (ring_result == ESP_OK) {
+    ring_result =
+      RecordRingAttachConsumer(&g_state.export_ring, &g_state.export_consumer_id);
+  }
+  if (ring_result != ESP_OK) {
     if (first_error == ESP_OK) {
-      first_error = ESP_ERR_NO_MEM;
+      first_error = ring_result;
     }
-    ESP_LOGE(kTag, "Failed to create export queue");
+    ESP_LOGE(kTag, "Failed to create export ring: %s", esp_err_to_name(ring_result));
+  } else {
+    ESP_LOGI(kTag,
+             "Export ring: %u records (%s)",
+             (unsigned)g_state.export_ring.capacity,
+             g_state.export_ring.in_psram ? "PSRAM" : "internal RAM");
   }
 
   g_state.initialized = true;
@@ -1539,6 +3209,46 @@ EnsureSdMounted(void)
   }
 }
 
+// Root: stream the export ring to the configured TCP collector as well.
+static void
+StartUplink(runtime_state_t* state)
+{
+  if (!kUplinkEnabled || kUplinkHost[0] == '\0') {
+    return;
+  }
+  if (state->uplink == NULL) {
+    const node_table_entry_t* local =
+      NodeTableGet(&state->node_table, state->local_node_index);
+    if (local == NULL) {
+      return;
+    }
+    uplink_config_t config = {
+      .port = kUplinkPort,
+      .format = kUplinkFormat,
+      .retain_records = kUplinkRetainRecords,
+    };
+    strlcpy(config.host, kUplinkHost, sizeof(config.host));
+    uplink_t* uplink = (uplink_t*)calloc(1, sizeof(*uplink));
+    esp_err_t result = (uplink != NULL)
+                         ? UplinkInit(uplink,
+                                      &config,
+                                      &state->export_ring,
+                                      &state->node_table,
+                                      &local->addr)
+                         : ESP_ERR_NO_MEM;
+    if (result != ESP_OK) {
+      ESP_LOGE(kTag, "Uplink init failed: %s", esp_err_to_name(result));
+      free(uplink);
+      return;
+    }
+    state->uplink = uplink;
+  }
+  esp_err_t result = UplinkStart(state->uplink);
+  if (result != ESP_OK) {
+    ESP_LOGE(kTag, "Uplink start failed: %s", esp_err_to_name(result));
+  }
+}
+
 esp_err_t
 RuntimeStart(void)
 {
@@ -1549,13 +3259,14 @@ RuntimeStart(void)
     return ESP_OK;
   }
   if (g_state.sensor_task != NULL || g_state.storage_task != NULL ||
-      g_state.time_sync_task != NULL || g_state.topology_task != NULL) {
+      g_state.time_sync_task != NULL || g_state.topology_task != NULL ||
+      g_state.mesh_ack_task != NULL) {
     return ESP_ERR_INVALID_STATE;
   }
   if (g_state.log_queue == NULL) {
     return ESP_ERR_NO_MEM;
   }
-  if (g_state.export_queue == NULL) {
+  if (g_state.export_ring.slots == NULL) {
     return ESP_ERR_NO_MEM;
   }
   if (g_state.batch_buffer == NULL || g_state.batch_buffer_size == 0) {
@@ -1572,6 +3283,18 @@ RuntimeStart(void)
   g_state.last_overrun_log_ticks = 0;
   g_state.last_overrun_records_total = 0;
   g_state.last_overrun_logged_total = 0;
+  memset(g_state.channel_state, 0, sizeof(g_state.channel_state));
+  memset(&g_state.sample_rate, 0, sizeof(g_state.sample_rate));
+  for (uint8_t ch = 0; ch < RTD_CHANNELS_MAX; ++ch) {
+    AlarmStateInit(&g_state.channel_state[ch].alarm_state, ch);
+    SampleFilterInit(&g_state.channel_state[ch].filter,
+                     &g_state.settings.sample_filter);
+    RecordCompressorInit(&g_state.channel_state[ch].compressor,
+                         &g_state.settings.record_compression);
+    AdaptiveRateInit(&g_state.channel_state[ch].rate);
+  }
+  g_state.alarm_pending_count = 0;
+  memset(&g_state.alarm_stats, 0, sizeof(g_state.alarm_stats));
 
   EnsureSdMounted();
   g_state.sd_was_mounted = g_state.sd_logger.is_mounted;
@@ -1618,10 +3341,24 @@ RuntimeStart(void)
                          router_ssid,
                          router_password,
                          is_root ? &RootRecordRxCallback : NULL,
-                         NULL,
+                         &g_state,
                          &g_state.time_sync);
     if (mesh_result == ESP_OK) {
       g_state.mesh_started = true;
+      if (is_root && kAlarmsEnabled) {
+        MeshTransportSetAlarmCallback(
+          &g_state.mesh, &RootAlarmRxCallback, &g_state);
+      }
+      if (!is_root) {
+        MeshTransportSetBurstTriggerCallback(
+          &g_state.mesh, &LeafBurstTriggerCallback, &g_state);
+      }
+      esp_err_t rejoin_result = MeshRejoinStart(&g_state.mesh);
+      if (rejoin_result != ESP_OK) {
+        ESP_LOGW(kTag,
+                 "Mesh fast rejoin unavailable: %s",
+                 esp_err_to_name(rejoin_result));
+      }
     } else {
       ESP_LOGE(kTag, "Mesh start failed: %s", esp_err_to_name(mesh_result));
       (void)WifiServiceRelease();
@@ -1629,6 +3366,10 @@ RuntimeStart(void)
     }
   }
 
+  if (g_state.mesh.is_root && !router_disabled) {
+    StartUplink(&g_state);
+  }
+
   if (g_state.mesh.is_root) {
     esp_err_t sntp_result =
       TimeSyncStartSntpAndWait(CONFIG_APP_SNTP_SERVER, 30 * 1000);
@@ -1657,10 +3398,16 @@ RuntimeStart(void)
   BaseType_t export_created = pdPASS;
   BaseType_t time_created = pdPASS;
   BaseType_t topology_created = pdPASS;
+  BaseType_t mesh_ack_created = pdPASS;
 
   if (role == APP_NODE_ROLE_SENSOR) {
     sensor_created = xTaskCreate(
-      &SensorTask, "sensor", 4096, &g_state, 5, &g_state.sensor_task);
+      &SensorTask,
+      "sensor",
+      kSensorTaskStackBytes,
+      &g_state,
+      5,
+      &g_state.sensor_task);
     storage_created = xTaskCreate(
       &StorageTask, "storage", 6144, &g_state, 6, &g_state.storage_task);
   }
@@ -1675,18 +3422,23 @@ RuntimeStart(void)
       &TimeSyncTask, "time_sync", 4096, &g_state, 4, &g_state.time_sync_task);
   }
 
+  if (role == APP_NODE_ROLE_ROOT) {
+    mesh_ack_created = xTaskCreate(
+      &MeshAckTask, "mesh_ack", 4096, &g_state, 4, &g_state.mesh_ack_task);
+  }
+
   topology_created = xTaskCreate(
     &TopologyTask, "topology", 3072, &g_state, 3, &g_state.topology_task);
 
   if (sensor_created != pdPASS || storage_created != pdPASS ||
       export_created != pdPASS || time_created != pdPASS ||
-      topology_created != pdPASS) {
+      topology_created != pdPASS || mesh_ack_created != pdPASS) {
     g_state.stop_requested = true;
     g_state.is_running = false;
     const TickType_t wait_start = xTaskGetTickCount();
     while ((g_state.sensor_task != NULL || g_state.storage_task != NULL ||
             g_state.export_task != NULL || g_state.time_sync_task != NULL ||
-            g_state.topology_task != NULL) &&
+            g_state.topology_task != NULL || g_state.mesh_ack_task != NULL) &&
            (pdTICKS_TO_MS(xTaskGetTickCount() - wait_start) < 1000)) {
       vTaskDelay(pdMS_TO_TICKS(50));
     }
@@ -1713,12 +3465,14 @@ RuntimeStop(void)
   const TickType_t wait_start = xTaskGetTickCount();
   while ((g_state.sensor_task != NULL || g_state.storage_task != NULL ||
           g_state.export_task != NULL || g_state.time_sync_task != NULL ||
-          g_state.topology_task != NULL) &&
+          g_state.topology_task != NULL || g_state.mesh_ack_task != NULL) &&
          (pdTICKS_TO_MS(xTaskGetTickCount() - wait_start) < 5000)) {
     vTaskDelay(pdMS_TO_TICKS(50));
   }
+  UplinkStop(g_state.uplink);
 
   if (g_state.mesh_started) {
+    MeshRejoinStop();
     (void)MeshTransportStop(&g_state.mesh);
     g_state.mesh_started = false;
     (void)WifiServiceRelease();
@@ -1726,7 +3480,10 @@ RuntimeStop(void)
 
   SdLoggerClose(&g_state.sd_logger);
   (void)xQueueReset(g_state.log_queue);
-  (void)xQueueReset(g_state.export_queue);
+  if (g_state.alarm_queue != NULL) {
+    (void)xQueueReset(g_state.alarm_queue);
+  }
+  RecordRingReset(&g_state.export_ring);
   return ESP_OK;
 }
 
@@ -1767,7 +3524,9 @@ RuntimeEnableDataStreaming(bool enabled)
       g_state.data_streaming_enabled = false;
       return;
     }
-    (void)TryEmitCsvHeader(&g_state);
+    if (g_state.export_format == APP_EXPORT_FORMAT_CSV) {
+      (void)TryEmitCsvHeader(&g_state);
+    }
     return;
   }
   g_state.data_streaming_enabled = enabled;
@@ -1779,6 +3538,22 @@ RuntimeIsDataStreamingEnabled(void)
   return g_state.data_streaming_enabled;
 }
 
+void
+RuntimeSetExportFormat(app_export_format_t format)
+{
+  if (format == APP_EXPORT_FORMAT_CSV && g_state.export_format != format) {
+    g_state.csv_header_emitted = false; // a new CSV stream gets its header
+  }
+  g_state.export_format = format;
+  g_state.settings.export_format = format;
+}
+
+app_export_format_t
+RuntimeGetExportFormat(void)
+{
+  return g_state.export_format;
+}
+
 void
 RuntimeSetLogPolicyRun(void)
 {
@@ -1814,3 +3589,151 @@ RuntimeSdBackoffUntilTicks(void)
 {
   return (uint32_t)g_state.sd_backoff_until_ticks;
 }
+
+bool
+RuntimeGetClockSync(clock_sync_t* out)
+{
+  if (out == NULL) {
+    return false;
+  }
+  taskENTER_CRITICAL(&g_state.clock_sync_lock);
+  *out = g_state.clock_sync;
+  taskEXIT_CRITICAL(&g_state.clock_sync_lock);
+  return out->locked;
+}
+
+void
+RuntimeGetSampleTimingStats(sample_timing_stats_t* out)
+{
+  if (out == NULL) {
+    return;
+  }
+  taskENTER_CRITICAL(&g_state.sample_timing_lock);
+  *out = g_state.sample_scheduler.stats;
+  taskEXIT_CRITICAL(&g_state.sample_timing_lock);
+}
+
+uint32_t
+RuntimeSensorStackFree(void)
+{
+  return g_state.sensor_stack_free;
+}
+
+bool
+RuntimeGetUplinkStats(uplink_stats_t* out)
+{
+  if (out == NULL || g_state.uplink == NULL) {
+    return false;
+  }
+  UplinkGetStats(g_state.uplink, out);
+  return true;
+}
+
+void
+RuntimeGetMeshForwardStats(runtime_mesh_forward_stats_t* out)
+{
+  if (out == NULL) {
+    return;
+  }
+  memset(out, 0, sizeof(*out));
+  if (!g_state.is_running || g_state.mesh.is_root) {
+    return;
+  }
+  const uint64_t next_record_id = FramLogNextRecordId(&g_state.fram_log);
+  if (!MeshCursorUsesFram(&g_state)) {
+    out->backlog_records =
+      g_state.mesh_ram_backlog_count - g_state.mesh_ram_backlog_sent;
+  } else if (next_record_id > g_state.mesh_cursor_record_id) {
+    out->backlog_records = next_record_id - g_state.mesh_cursor_record_id;
+  }
+  out->backfill_records_total = g_state.mesh_backfill_records_total;
+  out->rewinds_total = g_state.mesh_rewinds_total;
+  out->ram_backlog_dropped = g_state.mesh_ram_backlog_dropped;
+}
+
+bool
+RuntimeGetSampleFilterStats(uint8_t channel, sample_filter_stats_t* out)
+{
+  if (out == NULL || channel >= g_state.rtd_channels.count) {
+    return false;
+  }
+  *out = g_state.channel_state[channel].filter.stats;
+  return true;
+}
+
+void
+RuntimeGetSampleRate(runtime_sample_rate_t* out)
+{
+  if (out == NULL) {
+    return;
+  }
+  taskENTER_CRITICAL(&g_state.sample_timing_lock);
+  *out = g_state.sample_rate;
+  taskEXIT_CRITICAL(&g_state.sample_timing_lock);
+  if (out->period_ms == 0) {
+    out->period_ms = g_state.settings.log_period_ms; // not sampling yet
+  }
+}
+
+bool
+RuntimeGetAdaptiveRate(uint8_t channel, adaptive_rate_t* out)
+{
+  if (out == NULL || channel >= g_state.rtd_channels.count) {
+    return false;
+  }
+  *out = g_state.channel_state[channel].rate;
+  return true;
+}
+
+bool
+RuntimeGetRecordCompressionStats(uint8_t channel,
+                                 record_compression_stats_t* out)
+{
+  if (out == NULL || channel >= g_state.rtd_channels.count) {
+    return false;
+  }
+  *out = g_state.channel_state[channel].compressor.stats;
+  return true;
+}
+
+bool
+RuntimeRequestBurstTrigger(uint8_t source)
+{
+  bool accepted = false;
+  taskENTER_CRITICAL(&g_state.burst_lock);
+  if (g_state.burst.ring != NULL) {
+    g_state.burst_trigger_request = source;
+    accepted = true;
+  }
+  taskEXIT_CRITICAL(&g_state.burst_lock);
+  return accepted;
+}
+
+void
+RuntimeGetBurstStatus(runtime_burst_status_t* out)
+{
+  if (out == NULL) {
+    return;
+  }
+  memset(out, 0, sizeof(*out));
+  taskENTER_CRITICAL(&g_state.burst_lock);
+  const burst_capture_t* burst = &g_state.burst;
+  out->active = burst->ring != NULL;
+  out->paused = g_state.burst_paused;
+  out->in_psram = burst->in_psram;
+  out->state = burst->state;
+  out->ring_samples = burst->capacity;
+  out->ring_fill = burst->count;
+  out->stats = burst->stats;
+  taskEXIT_CRITICAL(&g_state.burst_lock);
+}
+
+void
+RuntimeGetAlarmStats(runtime_alarm_stats_t* out)
+{
+  if (out == NULL) {
+    return;
+  }
+  *out = g_state.alarm_stats;
+  out->pending = g_state.alarm_pending_count;
+}
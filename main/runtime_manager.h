@@ -3,7 +3,10 @@
 
 #include <stdbool.h>
 
+#include "adaptive_rate.h"
 #include "app_settings.h"
+#include "burst_capture.h"
+#include "clock_sync.h"
 #include "esp_err.h"
 #include "fram_i2c.h"
 #include "fram_io.h"
@@ -11,8 +14,15 @@
 #include "i2c_bus.h"
 #include "max31865_reader.h"
 #include "mesh_transport.h"
+#include "node_table.h"
+#include "record_compressor.h"
+#include "record_ring.h"
+#include "rtd_channels.h"
+#include "sample_filter.h"
+#include "sample_scheduler.h"
 #include "sd_logger.h"
 #include "time_sync.h"
+#include "uplink.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +36,7 @@ extern "C" {
     fram_log_t* fram_log;
     sd_logger_t* sd_logger;
     max31865_reader_t* sensor;
+    rtd_channels_t* rtd_channels;
     mesh_transport_t* mesh;
     time_sync_t* time_sync;
     i2c_bus_t* i2c_bus;
@@ -33,10 +44,48 @@ extern "C" {
     esp_err_t (*flush_callback)(void* context);
     void* flush_context;
     bool* fram_full;
-    uint32_t* export_dropped_count;
+    record_ring_t* export_ring;
+    node_table_t* node_table;
     uint32_t* export_write_fail_count;
   } app_runtime_t;
 
+  typedef struct
+  {
+    uint64_t backlog_records; // leaf: records not yet sent upstream
+    uint32_t backfill_records_total;
+    uint32_t rewinds_total;
+    uint32_t ram_backlog_dropped; // no FRAM: unsent records lost when full
+  } runtime_mesh_forward_stats_t;
+
+  typedef struct
+  {
+    uint32_t raised;
+    uint32_t cleared;
+    uint32_t sent;            // leaf: handed to the mesh
+    uint32_t dropped;         // pending list or export queue full
+    uint32_t pending;         // leaf: waiting for the mesh link
+    uint32_t exported;        // written to the data port
+    uint32_t latency_last_ms; // sample time -> data port write
+    uint32_t latency_max_ms;
+  } runtime_alarm_stats_t;
+
+  typedef struct
+  {
+    uint32_t period_ms; // records are this far apart
+    bool fast;          // adaptive fast period in use
+  } runtime_sample_rate_t;
+
+  typedef struct
+  {
+    bool active; // ring allocated and filling
+    bool paused; // enabled, but the period does not divide the sample period
+    bool in_psram;
+    uint8_t state; // burst_capture_state_t
+    uint32_t ring_samples;
+    uint32_t ring_fill;
+    burst_capture_stats_t stats;
+  } runtime_burst_status_t;
+
   esp_err_t RuntimeManagerInit(void);
 
   const app_runtime_t* RuntimeGetRuntime(void);
@@ -55,6 +104,12 @@ extern "C" {
 
   bool RuntimeIsDataStreamingEnabled(void);
 
+  // Data port format (CSV rows or binary COBS frames); takes effect with the
+  // next exported batch. Persisting it is the caller's job.
+  void RuntimeSetExportFormat(app_export_format_t format);
+
+  app_export_format_t RuntimeGetExportFormat(void);
+
   void RuntimeSetLogPolicyRun(void);
 
   void RuntimeSetLogPolicyDiag(void);
@@ -67,6 +122,44 @@ extern "C" {
 
   uint32_t RuntimeSdBackoffUntilTicks(void);
 
+  void RuntimeGetMeshForwardStats(runtime_mesh_forward_stats_t* out);
+
+  // Leaf: snapshot of the two-way time sync estimator. Returns true once the
+  // clock has been disciplined at least once.
+  bool RuntimeGetClockSync(clock_sync_t* out);
+
+  // Wall-clock sampling jitter of this node's sensor task.
+  void RuntimeGetSampleTimingStats(sample_timing_stats_t* out);
+
+  // Least stack SensorTask has had left, in bytes; 0 before its first read.
+  uint32_t RuntimeSensorStackFree(void);
+
+  // Filter chain counters of one RTD channel; false past the last channel.
+  bool RuntimeGetSampleFilterStats(uint8_t channel,
+                                   sample_filter_stats_t* out);
+
+  // Record compressor counters of one RTD channel; false past the last one.
+  bool RuntimeGetRecordCompressionStats(uint8_t channel,
+                                        record_compression_stats_t* out);
+
+  // Current record period; the log period unless adaptive rate has sped up.
+  void RuntimeGetSampleRate(runtime_sample_rate_t* out);
+
+  // Adaptive rate tracker of one RTD channel; false past the last channel.
+  bool RuntimeGetAdaptiveRate(uint8_t channel, adaptive_rate_t* out);
+
+  // Asks the sensor task for a burst capture at its next tick. False when
+  // burst capture is not running.
+  bool RuntimeRequestBurstTrigger(uint8_t source);
+
+  void RuntimeGetBurstStatus(runtime_burst_status_t* out);
+
+  // Alarm lane counters; latency is measured where alarms are exported.
+  void RuntimeGetAlarmStats(runtime_alarm_stats_t* out);
+
+  // Root: TCP collector uplink counters. False when no uplink is configured.
+  bool RuntimeGetUplinkStats(uplink_stats_t* out);
+
 #ifdef __cplusplus
 }
 #endif
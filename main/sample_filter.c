@@ -0,0 +1,227 @@
+#include "sample_filter.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Index into the per-value state arrays.
+enum
+{
+  kTemp = 0,
+  kResistance = 1,
+};
+
+void
+SampleFilterConfigInitDefault(sample_filter_config_t* config)
+{
+  if (config == NULL) {
+    return;
+  }
+  memset(config, 0, sizeof(*config));
+  config->median_n = 1;
+  config->decimation = 1;
+  config->cic_order = 1;
+  config->ema_alpha_q16 = 0;
+}
+
+bool
+SampleFilterConfigIsValid(const sample_filter_config_t* config)
+{
+  return config != NULL && config->median_n >= 1 &&
+         config->median_n <= SAMPLE_FILTER_MEDIAN_MAX &&
+         (config->median_n % 2u) == 1u && config->decimation >= 1 &&
+         config->decimation <= SAMPLE_FILTER_DECIMATION_MAX &&
+         config->cic_order >= 1 &&
+         config->cic_order <= SAMPLE_FILTER_CIC_ORDER_MAX &&
+         config->ema_alpha_q16 <= SAMPLE_FILTER_EMA_ALPHA_ONE;
+}
+
+uint32_t
+SampleFilterSamplePeriodMs(const sample_filter_config_t* config,
+                           uint32_t log_period_ms)
+{
+  const uint32_t decimation =
+    (config != NULL && config->decimation > 1) ? config->decimation : 1u;
+  return (log_period_ms % decimation == 0) ? log_period_ms / decimation : 0;
+}
+
+void
+SampleFilterInit(sample_filter_t* filter, const sample_filter_config_t* config)
+{
+  if (filter == NULL) {
+    return;
+  }
+  memset(filter, 0, sizeof(*filter));
+  if (SampleFilterConfigIsValid(config)) {
+    filter->config = *config;
+  } else {
+    SampleFilterConfigInitDefault(&filter->config);
+  }
+}
+
+void
+SampleFilterRestartBlock(sample_filter_t* filter)
+{
+  if (filter == NULL || filter->block_fill == 0) {
+    return;
+  }
+  filter->stats.discarded_blocks++;
+  memset(filter->integrator, 0, sizeof(filter->integrator));
+  memset(filter->comb_delay, 0, sizeof(filter->comb_delay));
+  filter->block_fill = 0;
+  filter->blocks = 0;
+}
+
+void
+SampleFilterReset(sample_filter_t* filter)
+{
+  if (filter == NULL) {
+    return;
+  }
+  if (filter->median_count == 0 && !filter->ema_valid &&
+      filter->block_fill == 0 && filter->blocks == 0) {
+    return; // nothing held
+  }
+  filter->median_count = 0;
+  filter->median_next = 0;
+  filter->ema_valid = false;
+  memset(filter->integrator, 0, sizeof(filter->integrator));
+  memset(filter->comb_delay, 0, sizeof(filter->comb_delay));
+  filter->block_fill = 0;
+  filter->blocks = 0;
+  filter->stats.resets++;
+}
+
+static void
+NoteStage(sample_filter_stage_stats_t* stats, int32_t input, int32_t output)
+{
+  const int64_t delta = (int64_t)output - input;
+  const int32_t magnitude =
+    (int32_t)((delta < 0) ? ((-delta > INT32_MAX) ? INT32_MAX : -delta)
+                          : ((delta > INT32_MAX) ? INT32_MAX : delta));
+  stats->out++;
+  if (magnitude > stats->max_abs_delta_milli_c) {
+    stats->max_abs_delta_milli_c = magnitude;
+  }
+  stats->mean_abs_delta_milli_c +=
+    (magnitude - stats->mean_abs_delta_milli_c) / 16;
+}
+
+// Sliding median of the last median_n samples (fewer while it fills).
+static void
+MedianStage(sample_filter_t* filter, int32_t values[2])
+{
+  const uint8_t size = filter->config.median_n;
+  for (int v = 0; v < 2; ++v) {
+    filter->median_window[v][filter->median_next] = values[v];
+  }
+  filter->median_next = (uint8_t)((filter->median_next + 1u) % size);
+  if (filter->median_count < size) {
+    filter->median_count++;
+  }
+  const uint8_t count = filter->median_count;
+  for (int v = 0; v < 2; ++v) {
+    int32_t sorted[SAMPLE_FILTER_MEDIAN_MAX];
+    for (uint8_t i = 0; i < count; ++i) {
+      const int32_t value = filter->median_window[v][i];
+      uint8_t j = i;
+      while (j > 0 && sorted[j - 1] > value) {
+        sorted[j] = sorted[j - 1];
+        --j;
+      }
+      sorted[j] = value;
+    }
+    values[v] = sorted[(count - 1u) / 2u];
+  }
+}
+
+static void
+EmaStage(sample_filter_t* filter, int32_t values[2])
+{
+  const int64_t alpha = filter->config.ema_alpha_q16;
+  for (int v = 0; v < 2; ++v) {
+    const int64_t input_q16 = (int64_t)values[v] * 65536;
+    if (!filter->ema_valid) {
+      filter->ema_q16[v] = input_q16;
+    } else {
+      filter->ema_q16[v] += ((input_q16 - filter->ema_q16[v]) * alpha) >> 16;
+    }
+    values[v] = (int32_t)((filter->ema_q16[v] + 0x8000) >> 16);
+  }
+  filter->ema_valid = true;
+}
+
+// CIC decimator (differential delay 1): integrators at the input rate,
+// combs at the output rate, gain decimation^order. Returns true at the end
+// of a block once the combs hold a full impulse response.
+static bool
+DecimatorStage(sample_filter_t* filter, int32_t values[2])
+{
+  const uint8_t order = filter->config.cic_order;
+  for (int v = 0; v < 2; ++v) {
+    uint64_t carry = (uint64_t)(int64_t)values[v];
+    for (uint8_t stage = 0; stage < order; ++stage) {
+      filter->integrator[stage][v] += carry;
+      carry = filter->integrator[stage][v];
+    }
+  }
+  if (++filter->block_fill < filter->config.decimation) {
+    return false;
+  }
+  filter->block_fill = 0;
+
+  int64_t gain = 1;
+  for (uint8_t stage = 0; stage < order; ++stage) {
+    gain *= filter->config.decimation;
+  }
+  for (int v = 0; v < 2; ++v) {
+    uint64_t comb = filter->integrator[order - 1u][v];
+    for (uint8_t stage = 0; stage < order; ++stage) {
+      const uint64_t delayed = filter->comb_delay[stage][v];
+      filter->comb_delay[stage][v] = comb;
+      comb -= delayed;
+    }
+    const int64_t sum = (int64_t)comb;
+    values[v] = (int32_t)((sum + ((sum < 0) ? -gain : gain) / 2) / gain);
+  }
+  if (filter->blocks < order) {
+    filter->blocks++;
+  }
+  return filter->blocks >= order;
+}
+
+bool
+SampleFilterPush(sample_filter_t* filter,
+                 const sample_filter_value_t* input,
+                 sample_filter_value_t* output)
+{
+  if (filter == NULL || input == NULL || output == NULL) {
+    return false;
+  }
+  int32_t values[2];
+  values[kTemp] = input->temp_milli_c;
+  values[kResistance] = input->resistance_milli_ohm;
+
+  if (filter->config.median_n > 1) {
+    const int32_t before = values[kTemp];
+    filter->stats.median.in++;
+    MedianStage(filter, values);
+    NoteStage(&filter->stats.median, before, values[kTemp]);
+  }
+  if (filter->config.ema_alpha_q16 > 0) {
+    const int32_t before = values[kTemp];
+    filter->stats.ema.in++;
+    EmaStage(filter, values);
+    NoteStage(&filter->stats.ema, before, values[kTemp]);
+  }
+  if (filter->config.decimation > 1) {
+    const int32_t before = values[kTemp];
+    filter->stats.decimator.in++;
+    if (!DecimatorStage(filter, values)) {
+      return false;
+    }
+    NoteStage(&filter->stats.decimator, before, values[kTemp]);
+  }
+  output->temp_milli_c = values[kTemp];
+  output->resistance_milli_ohm = values[kResistance];
+  return true;
+}
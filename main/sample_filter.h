@@ -0,0 +1,104 @@
+#ifndef PT100_LOGGER_SAMPLE_FILTER_H_
+#define PT100_LOGGER_SAMPLE_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Filter chain between acquisition and record creation, one per RTD
+// channel: median-of-N (spike rejection), then EMA, then a CIC decimator
+// that turns R samples into one record. Integer only, no allocation; it
+// works on the uncalibrated milli-°C and the milli-ohm of each sample.
+
+#define SAMPLE_FILTER_MEDIAN_MAX 9
+#define SAMPLE_FILTER_DECIMATION_MAX 64
+#define SAMPLE_FILTER_CIC_ORDER_MAX 3
+#define SAMPLE_FILTER_EMA_ALPHA_ONE 65536u // alpha = 1.0 in Q16
+
+  // A stage is off at median_n 1, ema_alpha_q16 0 and decimation 1.
+  typedef struct
+  {
+    uint8_t median_n;       // odd
+    uint8_t decimation;     // samples per record
+    uint8_t cic_order;      // 1 = boxcar average
+    uint32_t ema_alpha_q16; // weight of the new sample
+  } sample_filter_config_t;
+
+  typedef struct
+  {
+    int32_t temp_milli_c;
+    int32_t resistance_milli_ohm;
+  } sample_filter_value_t;
+
+  // Temperature deltas are output minus latest input of the stage.
+  typedef struct
+  {
+    uint32_t in;
+    uint32_t out;
+    int32_t max_abs_delta_milli_c;
+    int32_t mean_abs_delta_milli_c; // exponential average
+  } sample_filter_stage_stats_t;
+
+  typedef struct
+  {
+    sample_filter_stage_stats_t median;
+    sample_filter_stage_stats_t ema;
+    sample_filter_stage_stats_t decimator;
+    uint32_t resets;           // state dropped after a sensor fault
+    uint32_t discarded_blocks; // partial blocks dropped to realign records
+  } sample_filter_stats_t;
+
+  typedef struct
+  {
+    sample_filter_config_t config;
+    int32_t median_window[2][SAMPLE_FILTER_MEDIAN_MAX];
+    uint8_t median_count;
+    uint8_t median_next;
+    bool ema_valid;
+    int64_t ema_q16[2];
+    // CIC state; wraps modulo 2^64, which the combs undo.
+    uint64_t integrator[SAMPLE_FILTER_CIC_ORDER_MAX][2];
+    uint64_t comb_delay[SAMPLE_FILTER_CIC_ORDER_MAX][2];
+    uint8_t block_fill;
+    uint8_t blocks; // completed since the last restart, up to cic_order
+    sample_filter_stats_t stats;
+  } sample_filter_t;
+
+  // Every stage off: one record per sample, unchanged.
+  void SampleFilterConfigInitDefault(sample_filter_config_t* config);
+
+  bool SampleFilterConfigIsValid(const sample_filter_config_t* config);
+
+  // Sample period that gives one record per log_period_ms; 0 when the
+  // decimation does not divide the log period.
+  uint32_t SampleFilterSamplePeriodMs(const sample_filter_config_t* config,
+                                      uint32_t log_period_ms);
+
+  // Clears state and stats; an invalid config turns every stage off.
+  void SampleFilterInit(sample_filter_t* filter,
+                        const sample_filter_config_t* config);
+
+  // Drops all state (keeps config and stats), e.g. after a sensor fault so
+  // the next record is not built from readings on both sides of it.
+  void SampleFilterReset(sample_filter_t* filter);
+
+  // Drops a partial decimator block so the next block starts with the next
+  // sample. Does nothing on a block boundary.
+  void SampleFilterRestartBlock(sample_filter_t* filter);
+
+  // Feeds one sample. Returns true with *output set when a record is due:
+  // every sample without decimation, else at the end of each block once the
+  // CIC has seen cic_order blocks.
+  bool SampleFilterPush(sample_filter_t* filter,
+                        const sample_filter_value_t* input,
+                        sample_filter_value_t* output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_SAMPLE_FILTER_H_
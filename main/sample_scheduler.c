@@ -0,0 +1,151 @@
+#include "sample_scheduler.h"
+
+#include <string.h>
+
+#include "time_sync.h"
+
+// Never wake earlier than this before a boundary, whatever the read time.
+static const int64_t kMaxLeadUs = 500 * 1000;
+// Slack on top of the expected delay before giving up on the timer.
+static const uint32_t kWaitSlackMs = 1000;
+
+static void
+OnSampleTimer(void* arg)
+{
+  sample_scheduler_t* scheduler = (sample_scheduler_t*)arg;
+  if (scheduler->task != NULL) {
+    xTaskNotifyGive(scheduler->task);
+  }
+}
+
+static int32_t
+ClampToI32(int64_t value)
+{
+  if (value > INT32_MAX) {
+    return INT32_MAX;
+  }
+  if (value < -INT32_MAX) {
+    return -INT32_MAX;
+  }
+  return (int32_t)value;
+}
+
+esp_err_t
+SampleSchedulerInit(sample_scheduler_t* scheduler, TaskHandle_t task)
+{
+  if (scheduler == NULL || task == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(scheduler, 0, sizeof(*scheduler));
+  scheduler->task = task;
+  const esp_timer_create_args_t args = {
+    .callback = &OnSampleTimer,
+    .arg = scheduler,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "sample",
+  };
+  return esp_timer_create(&args, &scheduler->timer);
+}
+
+void
+SampleSchedulerDeinit(sample_scheduler_t* scheduler)
+{
+  if (scheduler == NULL || scheduler->timer == NULL) {
+    return;
+  }
+  (void)esp_timer_stop(scheduler->timer);
+  (void)esp_timer_delete(scheduler->timer);
+  scheduler->timer = NULL;
+}
+
+int64_t
+SampleSchedulerNextBoundaryUs(int64_t now_us, uint32_t period_ms)
+{
+  const int64_t period_us = (int64_t)period_ms * 1000;
+  if (period_us <= 0) {
+    return now_us;
+  }
+  return (now_us / period_us + 1) * period_us;
+}
+
+bool
+SampleSchedulerWait(sample_scheduler_t* scheduler,
+                    uint32_t period_ms,
+                    bool time_valid,
+                    int64_t* boundary_us_out)
+{
+  int64_t delay_us = (int64_t)period_ms * 1000;
+  scheduler->aligned = time_valid;
+
+  if (time_valid) {
+    int64_t lead_us = scheduler->stats.read_duration_us;
+    if (lead_us > kMaxLeadUs) {
+      lead_us = kMaxLeadUs;
+    }
+    const int64_t now_wall_us = TimeSyncGetEpochUs();
+    int64_t boundary_us =
+      SampleSchedulerNextBoundaryUs(now_wall_us + lead_us, period_ms);
+    if (scheduler->previous_boundary_us != 0 &&
+        boundary_us > scheduler->previous_boundary_us) {
+      const int64_t period_us = (int64_t)period_ms * 1000;
+      const int64_t skipped =
+        (boundary_us - scheduler->previous_boundary_us) / period_us - 1;
+      if (skipped > 0 && skipped < INT32_MAX) {
+        scheduler->stats.missed_boundaries += (uint32_t)skipped;
+      }
+    }
+    scheduler->boundary_us = boundary_us;
+    delay_us = boundary_us - lead_us - now_wall_us;
+  } else {
+    scheduler->previous_boundary_us = 0;
+  }
+
+  (void)ulTaskNotifyTake(pdTRUE, 0); // drop a stale wake
+  if (delay_us > 0) {
+    if (scheduler->timer != NULL &&
+        esp_timer_start_once(scheduler->timer, (uint64_t)delay_us) == ESP_OK) {
+      (void)ulTaskNotifyTake(
+        pdTRUE, pdMS_TO_TICKS((uint32_t)(delay_us / 1000) + kWaitSlackMs));
+      (void)esp_timer_stop(scheduler->timer);
+    } else {
+      // Tick resolution, but never spin if the timer is unavailable.
+      vTaskDelay(pdMS_TO_TICKS((uint32_t)(delay_us / 1000)) + 1);
+    }
+  }
+  scheduler->wake_started_us = esp_timer_get_time();
+
+  if (boundary_us_out != NULL) {
+    *boundary_us_out = scheduler->boundary_us;
+  }
+  return time_valid;
+}
+
+void
+SampleSchedulerMarkSampled(sample_scheduler_t* scheduler, int64_t now_wall_us)
+{
+  sample_timing_stats_t* stats = &scheduler->stats;
+  stats->samples++;
+
+  const int64_t duration_us = esp_timer_get_time() - scheduler->wake_started_us;
+  if (stats->read_duration_us == 0) {
+    stats->read_duration_us = ClampToI32(duration_us);
+  } else {
+    stats->read_duration_us = ClampToI32(
+      stats->read_duration_us + (duration_us - stats->read_duration_us) / 8);
+  }
+
+  if (!scheduler->aligned) {
+    return;
+  }
+  stats->aligned_samples++;
+  scheduler->previous_boundary_us = scheduler->boundary_us;
+
+  const int32_t jitter_us = ClampToI32(now_wall_us - scheduler->boundary_us);
+  const int32_t abs_jitter_us = (jitter_us < 0) ? -jitter_us : jitter_us;
+  stats->last_jitter_us = jitter_us;
+  if (abs_jitter_us > stats->max_abs_jitter_us) {
+    stats->max_abs_jitter_us = abs_jitter_us;
+  }
+  stats->mean_abs_jitter_us +=
+    (abs_jitter_us - stats->mean_abs_jitter_us) / 16;
+}
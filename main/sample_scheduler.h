@@ -0,0 +1,71 @@
+#ifndef PT100_LOGGER_SAMPLE_SCHEDULER_H_
+#define PT100_LOGGER_SAMPLE_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // Sample timing as seen by the sensor task. Jitter is the completion time
+  // of the reading minus the wall-clock boundary it is stamped with.
+  typedef struct
+  {
+    uint32_t samples;
+    uint32_t aligned_samples;   // stamped with a wall-clock boundary
+    uint32_t missed_boundaries; // boundaries skipped because a read overran
+    int32_t last_jitter_us;
+    int32_t max_abs_jitter_us;
+    int32_t mean_abs_jitter_us; // exponential average
+    int32_t read_duration_us;   // exponential average, used as wake lead
+  } sample_timing_stats_t;
+
+  // Fires the owning task on absolute wall-clock boundaries (multiples of
+  // the period since the epoch, e.g. every 1000 ms at :000) using an
+  // esp_timer one-shot re-armed each period against the disciplined system
+  // clock. The wake is advanced by the average read duration so the reading
+  // completes on the boundary.
+  typedef struct
+  {
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+    int64_t boundary_us; // wall-clock boundary of the current sample
+    int64_t previous_boundary_us;
+    bool aligned;
+    int64_t wake_started_us; // esp_timer time when the read began
+    sample_timing_stats_t stats;
+  } sample_scheduler_t;
+
+  // task is notified (xTaskNotifyGive) at each wake.
+  esp_err_t SampleSchedulerInit(sample_scheduler_t* scheduler,
+                                TaskHandle_t task);
+
+  void SampleSchedulerDeinit(sample_scheduler_t* scheduler);
+
+  // First boundary strictly after now_us on a period_ms grid since epoch.
+  int64_t SampleSchedulerNextBoundaryUs(int64_t now_us, uint32_t period_ms);
+
+  // Blocks until the next sample is due. With a valid clock the sample is
+  // stamped with the boundary (*boundary_us_out, true); otherwise it waits
+  // a plain period_ms and returns false.
+  bool SampleSchedulerWait(sample_scheduler_t* scheduler,
+                           uint32_t period_ms,
+                           bool time_valid,
+                           int64_t* boundary_us_out);
+
+  // Call right after the reading completes to update the jitter stats.
+  void SampleSchedulerMarkSampled(sample_scheduler_t* scheduler,
+                                  int64_t now_wall_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_SAMPLE_SCHEDULER_H_
@@ -11,8 +11,16 @@
 #include "data_csv.h"
 #include "esp_log.h"
 #include "esp_vfs_fat.h"
+#include "rtd_channels.h"
 
 static const char* kTag = "sd_logger";
+// The daily log, a burst file and console reads, with room to spare. A
+// sensor replay adds one handle on the trace per RTD channel.
+#ifdef CONFIG_APP_SENSOR_REPLAY
+static const int kMaxOpenFiles = 5 + RTD_CHANNELS_MAX;
+#else
+static const int kMaxOpenFiles = 5;
+#endif
 
 static size_t
 DefaultOr(const size_t value, const size_t fallback)
@@ -104,7 +112,7 @@ SdLoggerMountInternal(sd_logger_t* logger,
 
   esp_vfs_fat_sdmmc_mount_config_t mount_config = {
     .format_if_mount_failed = format_if_mount_failed,
-    .max_files = 5,
+    .max_files = kMaxOpenFiles,
     .allocation_unit_size = 16 * 1024,
   };
 
@@ -283,6 +291,53 @@ SdLoggerAppendVerifiedBatch(sd_logger_t* logger,
   return result;
 }
 
+esp_err_t
+SdLoggerAppendVerifiedFile(sd_logger_t* logger,
+                           const char* relative_path,
+                           const uint8_t* bytes,
+                           size_t length_bytes,
+                           SdCsvAppendDiagnostics* diag_out)
+{
+  if (logger == NULL || relative_path == NULL || bytes == NULL ||
+      length_bytes == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!logger->is_mounted) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  char path[128];
+  const int path_len = snprintf(
+    path, sizeof(path), "%s/%s", logger->mount_point, relative_path);
+  if (path_len <= 0 || (size_t)path_len >= sizeof(path)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  char* slash = strrchr(path, '/');
+  if (slash != NULL && slash > path + strlen(logger->mount_point)) {
+    *slash = '\0';
+    if (mkdir(path, 0775) != 0 && errno != EEXIST) {
+      ESP_LOGE(
+        kTag, "mkdir failed for %s: %s (%d)", path, strerror(errno), errno);
+      return ESP_FAIL;
+    }
+    *slash = '/';
+  }
+
+  FILE* file = fopen(path, "a+b");
+  if (file == NULL) {
+    ESP_LOGE(
+      kTag, "fopen failed for %s: %s (%d)", path, strerror(errno), errno);
+    return ESP_FAIL;
+  }
+  fseek(file, 0, SEEK_END);
+  esp_err_t result =
+    SdCsvAppendBatchWithReadbackVerify(file, bytes, length_bytes, diag_out);
+  if (fclose(file) != 0 && result == ESP_OK) {
+    result = ESP_FAIL;
+  }
+  return result;
+}
+
 void
 SdLoggerClose(sd_logger_t* logger)
 {
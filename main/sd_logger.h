@@ -67,6 +67,15 @@ esp_err_t SdLoggerAppendVerifiedBatch(sd_logger_t* logger,
                                       uint64_t last_record_id_in_batch,
                                       SdCsvAppendDiagnostics* diag_out);
 
+// Append to a file other than the daily CSV (path relative to the mount
+// point, parent directory created if missing) with the same read-back
+// verification. On failure the file is left at its original size.
+esp_err_t SdLoggerAppendVerifiedFile(sd_logger_t* logger,
+                                     const char* relative_path,
+                                     const uint8_t* bytes,
+                                     size_t length_bytes,
+                                     SdCsvAppendDiagnostics* diag_out);
+
 void SdLoggerClose(sd_logger_t* logger);
 
 static inline uint64_t
@@ -219,6 +219,57 @@ TimeSyncGetNow(int64_t* epoch_seconds_out, int32_t* millis_out)
   }
 }
 
+int64_t
+TimeSyncGetEpochUs(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+esp_err_t
+TimeSyncStepSystemUs(int64_t delta_us,
+                     bool update_rtc,
+                     const time_sync_t* time_sync)
+{
+  const int64_t target_us = TimeSyncGetEpochUs() + delta_us;
+  struct timeval tv = {
+    .tv_sec = (time_t)(target_us / 1000000),
+    .tv_usec = (suseconds_t)(target_us % 1000000),
+  };
+  if (settimeofday(&tv, NULL) != 0) {
+    return ESP_FAIL;
+  }
+  // Drop any slew still in progress; it was computed for the old clock.
+  (void)adjtime(&(struct timeval){ 0 }, NULL);
+
+  if (update_rtc && time_sync != NULL) {
+    (void)TimeSyncSetRtcFromSystem(time_sync);
+  }
+  return ESP_OK;
+}
+
+esp_err_t
+TimeSyncSlewSystemUs(int64_t delta_us, int64_t* unapplied_us_out)
+{
+  struct timeval delta = {
+    .tv_sec = (time_t)(delta_us / 1000000),
+    .tv_usec = (suseconds_t)(delta_us % 1000000),
+  };
+  struct timeval olddelta = { 0 };
+  if (unapplied_us_out != NULL) {
+    *unapplied_us_out = 0;
+  }
+  if (adjtime(&delta, &olddelta) != 0) {
+    return ESP_FAIL;
+  }
+  if (unapplied_us_out != NULL) {
+    *unapplied_us_out =
+      (int64_t)olddelta.tv_sec * 1000000 + (int64_t)olddelta.tv_usec;
+  }
+  return ESP_OK;
+}
+
 static bool
 LocalTmFieldsMatch(const struct tm* left, const struct tm* right)
 {
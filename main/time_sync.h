@@ -41,6 +41,20 @@ extern "C"
                                    bool update_rtc,
                                    const time_sync_t* time_sync);
 
+  // System clock as epoch microseconds (UTC).
+  int64_t TimeSyncGetEpochUs(void);
+
+  // Moves the system clock by delta_us at once and cancels pending slews.
+  esp_err_t TimeSyncStepSystemUs(int64_t delta_us,
+                                 bool update_rtc,
+                                 const time_sync_t* time_sync);
+
+  // Slews the system clock by delta_us via adjtime() (no jumps, timestamps
+  // stay monotonic). Replaces any slew still in progress; the part of it not
+  // yet applied goes to *unapplied_us_out (optional). ESP-IDF slews at about
+  // 1/64, so 100 ms takes over 6 s.
+  esp_err_t TimeSyncSlewSystemUs(int64_t delta_us, int64_t* unapplied_us_out);
+
   // Check if system clock is plausibly set (year >= 2023).
   bool TimeSyncIsSystemTimeValid(void);
 
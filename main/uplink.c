@@ -0,0 +1,711 @@
+#include "uplink.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "data_csv.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "export_frame.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+
+static const char* kTag = "uplink";
+static const uint32_t kConnectTimeoutMs = 5000;
+static const uint32_t kHandshakeTimeoutMs = 5000;
+static const uint32_t kBackoffMinMs = 1000;
+static const uint32_t kBackoffMaxMs = 30000;
+static const uint32_t kIdlePollMs = 20;
+// select() slice; the ring is drained between slices so a blocked socket
+// never holds the shared export ring.
+static const uint32_t kWaitSliceMs = 50;
+static const int64_t kStallTimeoutUs = 30 * 1000 * 1000;
+static const uint32_t kStopWaitMs = 3000;
+static const uint32_t kMinRetainRecords = 64;
+static const size_t kCsvRowMaxLen = 256;
+
+#define UPLINK_BATCH_MAX_RECORDS 64u
+#define UPLINK_FRAME_BUFFER_LEN EXPORT_FRAME_RECORDS_LEN(UPLINK_BATCH_MAX_RECORDS)
+#define UPLINK_OUT_BUFFER_LEN EXPORT_FRAME_COBS_MAX(UPLINK_FRAME_BUFFER_LEN)
+
+static uint32_t
+RoundDownPowerOfTwo(uint32_t value)
+{
+  uint32_t result = 1;
+  while (result <= value / 2u) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// Signed distance so comparisons survive position wrap-around.
+static int32_t
+PosDiff(uint32_t a, uint32_t b)
+{
+  return (int32_t)(a - b);
+}
+
+static void
+WindowAppend(uplink_t* uplink, const record_ring_item_t* item)
+{
+  if (uplink->window_end - uplink->window_start > uplink->window_mask) {
+    if (PosDiff(uplink->window_start, uplink->sent_end) >= 0) {
+      taskENTER_CRITICAL(&uplink->stats_lock);
+      uplink->stats.records_dropped++;
+      taskEXIT_CRITICAL(&uplink->stats_lock);
+    }
+    if (uplink->send_pos == uplink->window_start) {
+      uplink->send_pos++;
+    }
+    uplink->window_start++;
+  }
+  uplink->window[uplink->window_end & uplink->window_mask] = *item;
+  uplink->window_end++;
+}
+
+static void
+DrainRing(uplink_t* uplink)
+{
+  if (!uplink->consumer_attached) {
+    return;
+  }
+  record_ring_item_t item;
+  for (uint32_t count = 0; count <= uplink->window_mask &&
+                           RecordRingPop(uplink->ring, uplink->consumer_id, &item);
+       ++count) {
+    WindowAppend(uplink, &item);
+  }
+  taskENTER_CRITICAL(&uplink->stats_lock);
+  uplink->stats.window_pending = uplink->window_end - uplink->send_pos;
+  taskEXIT_CRITICAL(&uplink->stats_lock);
+}
+
+// Waits for the socket in short slices, draining the ring in between.
+static bool
+WaitSocket(uplink_t* uplink, bool readable, uint32_t timeout_ms)
+{
+  const int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+  for (;;) {
+    const int64_t remaining_us = deadline_us - esp_timer_get_time();
+    if (remaining_us <= 0 || uplink->stop_requested) {
+      return false;
+    }
+    const uint32_t slice_ms = (remaining_us < (int64_t)kWaitSliceMs * 1000)
+                                ? (uint32_t)(remaining_us / 1000) + 1u
+                                : kWaitSliceMs;
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(uplink->sock, &set);
+    struct timeval timeout = {
+      .tv_sec = 0,
+      .tv_usec = (long)slice_ms * 1000,
+    };
+    const int ready = select(uplink->sock + 1,
+                             readable ? &set : NULL,
+                             readable ? NULL : &set,
+                             NULL,
+                             &timeout);
+    if (ready > 0) {
+      return true;
+    }
+    if (ready < 0 && errno != EINTR) {
+      return false;
+    }
+    DrainRing(uplink);
+  }
+}
+
+static bool
+SendAll(uplink_t* uplink, const char* data, size_t len, uint32_t timeout_ms)
+{
+  size_t sent = 0;
+  while (sent < len) {
+    const ssize_t result =
+      send(uplink->sock, data + sent, len - sent, MSG_DONTWAIT);
+    if (result > 0) {
+      sent += (size_t)result;
+      continue;
+    }
+    if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (!WaitSocket(uplink, false, timeout_ms)) {
+        return false;
+      }
+      continue;
+    }
+    return false;
+  }
+  return true;
+}
+
+static void
+CloseConnection(uplink_t* uplink)
+{
+  if (uplink->sock >= 0) {
+    close(uplink->sock);
+    uplink->sock = -1;
+  }
+  uplink->out_len = 0;
+  uplink->out_sent = 0;
+
+  taskENTER_CRITICAL(&uplink->stats_lock);
+  if (uplink->stats.connected) {
+    uplink->stats.disconnects++;
+  }
+  uplink->stats.connected = false;
+  taskEXIT_CRITICAL(&uplink->stats_lock);
+
+  uplink->next_attempt_us =
+    esp_timer_get_time() + (int64_t)uplink->backoff_ms * 1000;
+  uplink->backoff_ms = (uplink->backoff_ms >= kBackoffMaxMs / 2u)
+                         ? kBackoffMaxMs
+                         : uplink->backoff_ms * 2u;
+}
+
+static bool
+OpenSocket(uplink_t* uplink)
+{
+  char port[8];
+  snprintf(port, sizeof(port), "%u", (unsigned)uplink->config.port);
+  const struct addrinfo hints = {
+    .ai_family = AF_INET,
+    .ai_socktype = SOCK_STREAM,
+  };
+  struct addrinfo* address = NULL;
+  if (getaddrinfo(uplink->config.host, port, &hints, &address) != 0 ||
+      address == NULL) {
+    return false;
+  }
+
+  uplink->sock =
+    socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+  if (uplink->sock < 0) {
+    freeaddrinfo(address);
+    return false;
+  }
+  (void)fcntl(uplink->sock, F_SETFL, fcntl(uplink->sock, F_GETFL, 0) | O_NONBLOCK);
+  const int connected =
+    connect(uplink->sock, address->ai_addr, address->ai_addrlen);
+  freeaddrinfo(address);
+  if (connected != 0) {
+    if (errno != EINPROGRESS ||
+        !WaitSocket(uplink, false, kConnectTimeoutMs)) {
+      return false;
+    }
+    int error = 0;
+    socklen_t error_len = sizeof(error);
+    if (getsockopt(uplink->sock, SOL_SOCKET, SO_ERROR, &error, &error_len) !=
+          0 ||
+        error != 0) {
+      return false;
+    }
+  }
+
+  const int enable = 1;
+  (void)setsockopt(
+    uplink->sock, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+  (void)setsockopt(
+    uplink->sock, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  return true;
+}
+
+static void
+HandleResumeLine(uplink_t* uplink, const char* line)
+{
+  unsigned int mac[6];
+  uint64_t next_record_id = 0;
+  if (sscanf(line,
+             "RESUME %2x:%2x:%2x:%2x:%2x:%2x %" SCNu64,
+             &mac[0],
+             &mac[1],
+             &mac[2],
+             &mac[3],
+             &mac[4],
+             &mac[5],
+             &next_record_id) != 7 ||
+      uplink->resume_count >= NODE_TABLE_MAX_NODES) {
+    return;
+  }
+  uplink_resume_t* resume = &uplink->resume[uplink->resume_count++];
+  for (int index = 0; index < 6; ++index) {
+    resume->addr.addr[index] = (uint8_t)mac[index];
+  }
+  resume->next_record_id = next_record_id;
+}
+
+// Sends the hello line and collects RESUME lines until READY.
+static bool
+Handshake(uplink_t* uplink)
+{
+  const uint8_t* mac = uplink->root_addr.addr;
+  char hello[80];
+  const int hello_len =
+    snprintf(hello,
+             sizeof(hello),
+             "PT100-UPLINK %d %02X:%02X:%02X:%02X:%02X:%02X %s\n",
+             UPLINK_PROTOCOL_VERSION,
+             mac[0],
+             mac[1],
+             mac[2],
+             mac[3],
+             mac[4],
+             mac[5],
+             (uplink->config.format == UPLINK_FORMAT_CSV) ? "csv" : "binary");
+  if (!SendAll(uplink, hello, (size_t)hello_len, kHandshakeTimeoutMs)) {
+    return false;
+  }
+
+  uplink->resume_count = 0;
+  memset(uplink->resume_resolved, 0, sizeof(uplink->resume_resolved));
+
+  char line[96];
+  size_t used = 0;
+  const int64_t deadline_us =
+    esp_timer_get_time() + (int64_t)kHandshakeTimeoutMs * 1000;
+  for (;;) {
+    const int64_t remaining_us = deadline_us - esp_timer_get_time();
+    if (remaining_us <= 0 ||
+        !WaitSocket(uplink, true, (uint32_t)(remaining_us / 1000) + 1u)) {
+      return false;
+    }
+    const ssize_t received =
+      recv(uplink->sock, line + used, sizeof(line) - 1u - used, MSG_DONTWAIT);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      continue;
+    }
+    if (received <= 0) {
+      return false;
+    }
+    used += (size_t)received;
+
+    char* newline = NULL;
+    while ((newline = memchr(line, '\n', used)) != NULL) {
+      *newline = '\0';
+      if (newline > line && newline[-1] == '\r') {
+        newline[-1] = '\0';
+      }
+      if (strcmp(line, "READY") == 0) {
+        return true;
+      }
+      HandleResumeLine(uplink, line);
+      const size_t consumed = (size_t)(newline + 1 - line);
+      memmove(line, newline + 1, used - consumed);
+      used -= consumed;
+    }
+    if (used >= sizeof(line) - 1u) {
+      return false; // no line this long in the protocol
+    }
+  }
+}
+
+static void
+TryConnect(uplink_t* uplink)
+{
+  if (!OpenSocket(uplink) || !Handshake(uplink)) {
+    taskENTER_CRITICAL(&uplink->stats_lock);
+    uplink->stats.connect_failures++;
+    taskEXIT_CRITICAL(&uplink->stats_lock);
+    CloseConnection(uplink);
+    return;
+  }
+
+  // New session: replay the window, re-announce nodes, restart CSV.
+  uplink->send_pos = uplink->window_start;
+  uplink->nodes_announced = 0;
+  uplink->out_len = 0;
+  uplink->out_sent = 0;
+  uplink->backoff_ms = kBackoffMinMs;
+  uplink->last_progress_us = esp_timer_get_time();
+  if (uplink->config.format == UPLINK_FORMAT_CSV) {
+    size_t written = 0;
+    if (CsvFormatHeader((char*)uplink->out, UPLINK_OUT_BUFFER_LEN, &written)) {
+      uplink->out_len = written;
+    }
+  }
+
+  taskENTER_CRITICAL(&uplink->stats_lock);
+  uplink->stats.connects++;
+  uplink->stats.connected = true;
+  taskEXIT_CRITICAL(&uplink->stats_lock);
+  ESP_LOGI(kTag,
+           "Connected to %s:%u (%u RESUME entries)",
+           uplink->config.host,
+           (unsigned)uplink->config.port,
+           (unsigned)uplink->resume_count);
+}
+
+static uint64_t
+ResumeFrom(uplink_t* uplink, uint32_t node_index)
+{
+  if (node_index >= NODE_TABLE_MAX_NODES) {
+    return 0;
+  }
+  if (!uplink->resume_resolved[node_index]) {
+    const node_table_entry_t* node =
+      NodeTableGet(uplink->node_table, node_index);
+    if (node == NULL) {
+      return 0;
+    }
+    uint64_t next_record_id = 0;
+    for (uint32_t index = 0; index < uplink->resume_count; ++index) {
+      if (memcmp(&uplink->resume[index].addr, &node->addr, sizeof(node->addr)) ==
+          0) {
+        next_record_id = uplink->resume[index].next_record_id;
+        break;
+      }
+    }
+    uplink->resume_from[node_index] = next_record_id;
+    uplink->resume_resolved[node_index] = true;
+  }
+  return uplink->resume_from[node_index];
+}
+
+// Next window record the collector still needs; false when none is queued.
+static bool
+NextRecord(uplink_t* uplink, record_ring_item_t* item_out)
+{
+  uint32_t skipped = 0;
+  bool found = false;
+  while (uplink->send_pos != uplink->window_end) {
+    const record_ring_item_t* item =
+      &uplink->window[uplink->send_pos & uplink->window_mask];
+    if (item->record.record_id >= ResumeFrom(uplink, item->node_index)) {
+      *item_out = *item;
+      found = true;
+      break;
+    }
+    uplink->send_pos++;
+    skipped++;
+  }
+  if (skipped > 0) {
+    taskENTER_CRITICAL(&uplink->stats_lock);
+    uplink->stats.records_skipped += skipped;
+    taskEXIT_CRITICAL(&uplink->stats_lock);
+  }
+  return found;
+}
+
+static void
+NoteSent(uplink_t* uplink)
+{
+  const bool replayed = PosDiff(uplink->send_pos, uplink->sent_end) < 0;
+  uplink->send_pos++;
+  if (!replayed) {
+    uplink->sent_end = uplink->send_pos;
+  }
+  taskENTER_CRITICAL(&uplink->stats_lock);
+  uplink->stats.records_sent++;
+  if (replayed) {
+    uplink->stats.records_replayed++;
+  }
+  taskEXIT_CRITICAL(&uplink->stats_lock);
+}
+
+static bool
+BuildNodesFrame(uplink_t* uplink)
+{
+  const uint32_t count = NodeTableCount(uplink->node_table);
+  export_frame_writer_t writer;
+  if (ExportFrameWriterInit(&writer,
+                            uplink->frame,
+                            UPLINK_FRAME_BUFFER_LEN,
+                            EXPORT_FRAME_TYPE_NODES,
+                            uplink->frame_sequence) != ESP_OK) {
+    return false;
+  }
+  while (uplink->nodes_announced < count &&
+         !ExportFrameWriterIsFull(&writer)) {
+    const uint8_t index = (uint8_t)uplink->nodes_announced;
+    const node_table_entry_t* node = NodeTableGet(uplink->node_table, index);
+    if (node != NULL) {
+      (void)ExportFrameWriterAddNode(&writer, index, &node->addr);
+    }
+    uplink->nodes_announced++;
+  }
+  uplink->out_len =
+    ExportFrameWriterFinish(&writer, uplink->out, UPLINK_OUT_BUFFER_LEN);
+  uplink->out_sent = 0;
+  uplink->frame_sequence++;
+  return uplink->out_len > 0;
+}
+
+static bool
+BuildRecordsFrame(uplink_t* uplink)
+{
+  export_frame_writer_t writer;
+  if (ExportFrameWriterInit(&writer,
+                            uplink->frame,
+                            UPLINK_FRAME_BUFFER_LEN,
+                            EXPORT_FRAME_TYPE_RECORDS,
+                            uplink->frame_sequence) != ESP_OK) {
+    return false;
+  }
+  record_ring_item_t item;
+  while (!ExportFrameWriterIsFull(&writer) && NextRecord(uplink, &item)) {
+    (void)ExportFrameWriterAddRecord(&writer, item.node_index, &item.record);
+    NoteSent(uplink);
+  }
+  if (writer.count == 0) {
+    return true; // everything queued was already held by the collector
+  }
+  uplink->out_len =
+    ExportFrameWriterFinish(&writer, uplink->out, UPLINK_OUT_BUFFER_LEN);
+  uplink->out_sent = 0;
+  uplink->frame_sequence++;
+  taskENTER_CRITICAL(&uplink->stats_lock);
+  uplink->stats.frames_sent++;
+  taskEXIT_CRITICAL(&uplink->stats_lock);
+  return uplink->out_len > 0;
+}
+
+static bool
+BuildCsvBlock(uplink_t* uplink)
+{
+  char* out = (char*)uplink->out;
+  size_t used = 0;
+  uint32_t rows = 0;
+  record_ring_item_t item;
+  while (rows < UPLINK_BATCH_MAX_RECORDS &&
+         UPLINK_OUT_BUFFER_LEN - used >= kCsvRowMaxLen &&
+         NextRecord(uplink, &item)) {
+    const node_table_entry_t* node =
+      NodeTableGet(uplink->node_table, item.node_index);
+    size_t written = 0;
+    if (CsvFormatRow(&item.record,
+                     (node != NULL) ? node->id_string : "",
+                     out + used,
+                     UPLINK_OUT_BUFFER_LEN - used,
+                     &written)) {
+      used += written;
+    }
+    NoteSent(uplink);
+    rows++;
+  }
+  uplink->out_len = used;
+  uplink->out_sent = 0;
+  if (rows > 0) {
+    taskENTER_CRITICAL(&uplink->stats_lock);
+    uplink->stats.frames_sent++;
+    taskEXIT_CRITICAL(&uplink->stats_lock);
+  }
+  return true;
+}
+
+// One step of the connected state machine. False means drop the connection.
+static bool
+Pump(uplink_t* uplink, bool* idle_out)
+{
+  *idle_out = false;
+  const int64_t now_us = esp_timer_get_time();
+
+  if (uplink->out_sent < uplink->out_len) {
+    const ssize_t result = send(uplink->sock,
+                                uplink->out + uplink->out_sent,
+                                uplink->out_len - uplink->out_sent,
+                                MSG_DONTWAIT);
+    if (result > 0) {
+      uplink->out_sent += (size_t)result;
+      uplink->last_progress_us = now_us;
+      taskENTER_CRITICAL(&uplink->stats_lock);
+      uplink->stats.bytes_sent += (uint64_t)result;
+      taskEXIT_CRITICAL(&uplink->stats_lock);
+      return true;
+    }
+    if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Backpressure: the collector is behind. Keep draining the ring into
+      // the window (evicting its oldest records) rather than stalling it.
+      if (now_us - uplink->last_progress_us > kStallTimeoutUs) {
+        return false;
+      }
+      (void)WaitSocket(uplink, false, kWaitSliceMs);
+      return true;
+    }
+    return false;
+  }
+
+  if (uplink->config.format == UPLINK_FORMAT_BINARY &&
+      uplink->nodes_announced < NodeTableCount(uplink->node_table)) {
+    return BuildNodesFrame(uplink);
+  }
+
+  if (uplink->send_pos == uplink->window_end) {
+    // Nothing to send: notice a collector that went away.
+    char discard[32];
+    const ssize_t received =
+      recv(uplink->sock, discard, sizeof(discard), MSG_DONTWAIT);
+    if (received == 0 ||
+        (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      return false;
+    }
+    uplink->last_progress_us = now_us;
+    *idle_out = true;
+    return true;
+  }
+
+  return (uplink->config.format == UPLINK_FORMAT_CSV)
+           ? BuildCsvBlock(uplink)
+           : BuildRecordsFrame(uplink);
+}
+
+static void
+UplinkTask(void* context)
+{
+  uplink_t* uplink = (uplink_t*)context;
+
+  while (!uplink->stop_requested) {
+    DrainRing(uplink);
+    if (uplink->sock < 0) {
+      if (esp_timer_get_time() < uplink->next_attempt_us) {
+        vTaskDelay(pdMS_TO_TICKS(kIdlePollMs));
+        continue;
+      }
+      TryConnect(uplink);
+      continue;
+    }
+    bool idle = false;
+    if (!Pump(uplink, &idle)) {
+      ESP_LOGW(kTag,
+               "Connection to %s:%u lost",
+               uplink->config.host,
+               (unsigned)uplink->config.port);
+      CloseConnection(uplink);
+      continue;
+    }
+    if (idle) {
+      vTaskDelay(pdMS_TO_TICKS(kIdlePollMs));
+    }
+  }
+
+  CloseConnection(uplink);
+  uplink->task = NULL;
+  vTaskDelete(NULL);
+}
+
+esp_err_t
+UplinkInit(uplink_t* uplink,
+           const uplink_config_t* config,
+           record_ring_t* ring,
+           node_table_t* node_table,
+           const pt100_mesh_addr_t* root_addr)
+{
+  if (uplink == NULL || config == NULL || ring == NULL || node_table == NULL ||
+      root_addr == NULL || config->host[0] == '\0' || config->port == 0 ||
+      config->retain_records < kMinRetainRecords) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(uplink, 0, sizeof(*uplink));
+  uplink->config = *config;
+  uplink->config.host[sizeof(uplink->config.host) - 1] = '\0';
+  uplink->config.retain_records = RoundDownPowerOfTwo(config->retain_records);
+  uplink->window_mask = uplink->config.retain_records - 1u;
+  uplink->ring = ring;
+  uplink->node_table = node_table;
+  uplink->root_addr = *root_addr;
+  uplink->sock = -1;
+  uplink->backoff_ms = kBackoffMinMs;
+  uplink->stats_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+
+  uplink->window = (record_ring_item_t*)heap_caps_calloc(
+    uplink->config.retain_records,
+    sizeof(record_ring_item_t),
+    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (uplink->window == NULL) {
+    uplink->window = (record_ring_item_t*)calloc(uplink->config.retain_records,
+                                                 sizeof(record_ring_item_t));
+  }
+  uplink->frame = (uint8_t*)malloc(UPLINK_FRAME_BUFFER_LEN);
+  uplink->out = (uint8_t*)malloc(UPLINK_OUT_BUFFER_LEN);
+  if (uplink->window == NULL || uplink->frame == NULL || uplink->out == NULL) {
+    UplinkDeinit(uplink);
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+esp_err_t
+UplinkStart(uplink_t* uplink)
+{
+  if (uplink == NULL || uplink->window == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (uplink->task != NULL) {
+    return ESP_OK;
+  }
+  esp_err_t result =
+    RecordRingAttachConsumer(uplink->ring, &uplink->consumer_id);
+  if (result != ESP_OK) {
+    return result;
+  }
+  uplink->consumer_attached = true;
+  uplink->stop_requested = false;
+  uplink->next_attempt_us = 0;
+  if (xTaskCreate(&UplinkTask, "uplink", 4096, uplink, 3, &uplink->task) !=
+      pdPASS) {
+    uplink->task = NULL;
+    RecordRingDetachConsumer(uplink->ring, uplink->consumer_id);
+    uplink->consumer_attached = false;
+    return ESP_ERR_NO_MEM;
+  }
+  ESP_LOGI(kTag,
+           "Uplink to %s:%u (%s, window=%u records)",
+           uplink->config.host,
+           (unsigned)uplink->config.port,
+           (uplink->config.format == UPLINK_FORMAT_CSV) ? "csv" : "binary",
+           (unsigned)uplink->config.retain_records);
+  return ESP_OK;
+}
+
+void
+UplinkStop(uplink_t* uplink)
+{
+  if (uplink == NULL || uplink->task == NULL) {
+    return;
+  }
+  uplink->stop_requested = true;
+  const TickType_t wait_start = xTaskGetTickCount();
+  while (uplink->task != NULL &&
+         pdTICKS_TO_MS(xTaskGetTickCount() - wait_start) < kStopWaitMs) {
+    vTaskDelay(pdMS_TO_TICKS(kIdlePollMs));
+  }
+  if (uplink->consumer_attached) {
+    RecordRingDetachConsumer(uplink->ring, uplink->consumer_id);
+    uplink->consumer_attached = false;
+  }
+}
+
+void
+UplinkDeinit(uplink_t* uplink)
+{
+  if (uplink == NULL) {
+    return;
+  }
+  UplinkStop(uplink);
+  free(uplink->window);
+  free(uplink->frame);
+  free(uplink->out);
+  uplink->window = NULL;
+  uplink->frame = NULL;
+  uplink->out = NULL;
+}
+
+bool
+UplinkIsRunning(const uplink_t* uplink)
+{
+  return uplink != NULL && uplink->task != NULL;
+}
+
+void
+UplinkGetStats(uplink_t* uplink, uplink_stats_t* stats_out)
+{
+  if (uplink == NULL || stats_out == NULL) {
+    return;
+  }
+  taskENTER_CRITICAL(&uplink->stats_lock);
+  *stats_out = uplink->stats;
+  taskEXIT_CRITICAL(&uplink->stats_lock);
+}
@@ -0,0 +1,137 @@
+#ifndef PT100_LOGGER_UPLINK_H_
+#define PT100_LOGGER_UPLINK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mesh_addr.h"
+#include "node_table.h"
+#include "record_ring.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Root uplink: streams export-ring records over TCP to a host collector.
+//
+// Session handshake (text lines, '\n' terminated):
+//   root      -> collector: "PT100-UPLINK <version> <root MAC> binary|csv"
+//   collector -> root:      "RESUME <node MAC> <next record_id>" (0..n)
+//   collector -> root:      "READY"
+// The stream that follows is the data port format: COBS export frames
+// (export_frame.h) or a CSV header plus rows. Records below a node's RESUME
+// id are not sent.
+//
+// The uplink is its own export-ring consumer and keeps the most recent
+// records in a replay window. Each session starts by replaying that window,
+// so records sent while a connection was dying, or queued while it was
+// down, reach the collector once it is back. A slow or absent collector
+// only evicts from the window; it never holds the shared ring.
+#define UPLINK_PROTOCOL_VERSION 1
+#define UPLINK_HOST_MAX_LEN 64
+
+  typedef enum
+  {
+    UPLINK_FORMAT_BINARY = 0,
+    UPLINK_FORMAT_CSV = 1,
+  } uplink_format_t;
+
+  typedef struct
+  {
+    char host[UPLINK_HOST_MAX_LEN]; // name or dotted IPv4
+    uint16_t port;
+    uplink_format_t format;
+    uint32_t retain_records; // replay window (rounded down to a power of 2)
+  } uplink_config_t;
+
+  typedef struct
+  {
+    bool connected;
+    uint32_t connects;
+    uint32_t connect_failures;
+    uint32_t disconnects;
+    uint32_t frames_sent;
+    uint64_t bytes_sent;
+    uint32_t records_sent;
+    uint32_t records_replayed; // sent again at the start of a session
+    uint32_t records_skipped;  // already held by the collector (RESUME)
+    uint32_t records_dropped;  // evicted from the window before sending
+    uint32_t window_pending;   // queued, not yet sent
+  } uplink_stats_t;
+
+  typedef struct
+  {
+    pt100_mesh_addr_t addr;
+    uint64_t next_record_id;
+  } uplink_resume_t;
+
+  typedef struct
+  {
+    uplink_config_t config;
+    record_ring_t* ring;
+    node_table_t* node_table;
+    pt100_mesh_addr_t root_addr;
+
+    TaskHandle_t task;
+    volatile bool stop_requested;
+    uint32_t consumer_id;
+    bool consumer_attached;
+    int sock;
+    int64_t next_attempt_us;
+    uint32_t backoff_ms;
+    int64_t last_progress_us;
+
+    // Replay window over absolute positions [window_start, window_end);
+    // send_pos is the next record to send this session.
+    record_ring_item_t* window;
+    uint32_t window_start;
+    uint32_t window_end;
+    uint32_t send_pos;
+    uint32_t sent_end; // positions below this went out in some session
+    uint32_t window_mask;
+
+    // RESUME ids from the collector, resolved lazily per node index.
+    uplink_resume_t resume[NODE_TABLE_MAX_NODES];
+    uint32_t resume_count;
+    uint64_t resume_from[NODE_TABLE_MAX_NODES];
+    bool resume_resolved[NODE_TABLE_MAX_NODES];
+
+    uint32_t nodes_announced;
+    uint32_t frame_sequence;
+    uint8_t* frame;
+    uint8_t* out;
+    size_t out_len;
+    size_t out_sent;
+
+    portMUX_TYPE stats_lock;
+    uplink_stats_t stats;
+  } uplink_t;
+
+  esp_err_t UplinkInit(uplink_t* uplink,
+                       const uplink_config_t* config,
+                       record_ring_t* ring,
+                       node_table_t* node_table,
+                       const pt100_mesh_addr_t* root_addr);
+
+  // Attaches a ring consumer and starts the uplink task.
+  esp_err_t UplinkStart(uplink_t* uplink);
+
+  // Stops the task (waits up to a few seconds), closes the connection and
+  // detaches from the ring. The replay window is kept for the next start.
+  void UplinkStop(uplink_t* uplink);
+
+  void UplinkDeinit(uplink_t* uplink);
+
+  bool UplinkIsRunning(const uplink_t* uplink);
+
+  void UplinkGetStats(uplink_t* uplink, uplink_stats_t* stats_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PT100_LOGGER_UPLINK_H_